@@ -0,0 +1,192 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------------------
+ * Cliente HTTP persistente para a API de chat (OpenAI-compatível),
+ * compartilhado pelas firmwares S3 e P4.
+ *
+ * - Transporte próprio (socket + mbedTLS, HTTP/1.1 mínimo). A sessão TLS
+ *   de cada handshake fica em memória RTC e, antes do deep sleep, em NVS:
+ *   a primeira conexão após o wake faz handshake abreviado.
+ * - Corpo da requisição enviado em streaming: o JSON é gerado com
+ *   marcadores no lugar dos blobs binários (áudio/imagem), que são
+ *   codificados em base64 por blocos direto no socket.
+ * - Resposta SSE ("stream": true) processada de forma incremental, com
+ *   callback a cada fragmento de texto.
+ * - Conexão mantida entre interações (keep-alive), descartada se o
+ *   servidor a fechou ou se ficou ociosa demais.
+ * - Pre-warm opcional: abre a conexão em paralelo com a captura.
+ *
+ * O módulo guarda estado global e não é reentrante: uma requisição por vez.
+ * ----------------------------------------------------------------------- */
+
+/** Marcadores dos blobs dentro do JSON, na ordem em que aparecem. */
+#define AI_REQUEST_BLOB0_MARKER "@@AI_BLOB_0@@"
+#define AI_REQUEST_BLOB1_MARKER "@@AI_BLOB_1@@"
+#define AI_REQUEST_MAX_BLOBS 2
+
+/** Bloco de entrada do base64 (múltiplo de 3: sem padding intermediário). */
+#define AI_B64_CHUNK_IN 768
+#define AI_B64_CHUNK_OUT ((AI_B64_CHUNK_IN / 3) * 4)
+
+/** Pedaço de um blob não contíguo (ex.: segmentos do buffer de áudio). */
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+} ai_iov_t;
+
+typedef struct {
+  const uint8_t *data; /* pode ser NULL com len 0 (enviado depois) */
+  size_t len;          /* com iov: soma dos pedaços */
+  bool raw; /* data já pronto para o JSON (base64 ou texto escapado):
+               enviado como está, sem codificação */
+  const ai_iov_t *iov; /* não NULL: blob em pedaços, codificado em base64
+                          em sequência sem cópia (data e raw ignorados) */
+  size_t iov_count;
+} ai_blob_t;
+
+/**
+ * @brief Requisição pronta para envio: trechos de texto intercalados com
+ *        blobs codificados em base64 durante o envio.
+ *
+ * text[0] blob[0] text[1] (blob[1] text[2]). Como base64 nunca precisa de
+ * escape JSON, o corpo enviado é idêntico ao JSON com os blobs inline.
+ */
+typedef struct {
+  char *json; /* JSON completo com os marcadores (dono) */
+  size_t num_blobs;
+  ai_blob_t blobs[AI_REQUEST_MAX_BLOBS];
+  const char *text[AI_REQUEST_MAX_BLOBS + 1]; /* apontam para dentro de json */
+  size_t text_len[AI_REQUEST_MAX_BLOBS + 1];
+} ai_request_t;
+
+typedef struct {
+  const char *url;   /* endpoint de chat completions */
+  const char *token; /* Bearer token; NULL ou "" omite Authorization */
+  int timeout_ms;
+} ai_client_cfg_t;
+
+/**
+ * @brief Callback de texto incremental da resposta SSE.
+ * @param frag      Fragmento recebido neste evento.
+ * @param text      Texto acumulado até agora (terminado em '\0').
+ */
+typedef void (*ai_client_delta_cb_t)(const char *frag, size_t frag_len,
+                                     const char *text, size_t text_len,
+                                     void *user_ctx);
+
+/** Codificador base64 incremental que envia cada bloco como chunk HTTP. */
+typedef struct {
+  uint8_t in[AI_B64_CHUNK_IN];
+  size_t in_len;
+  unsigned char out[AI_B64_CHUNK_OUT + 1];
+  bool plain; /* envia os blocos sem o framing chunked (Content-Length) */
+} ai_b64_stream_t;
+
+/* -----------------------------------------------------------------------
+ * Requisição
+ * ----------------------------------------------------------------------- */
+
+/**
+ * @brief Divide um JSON impresso pelo cJSON nos marcadores de blob.
+ *
+ * Assume a posse de @p json (liberado com cJSON_free/free em
+ * ai_request_free). Usa a última ocorrência de cada marcador, para não
+ * colidir com texto do histórico que contenha a mesma sequência.
+ */
+esp_err_t ai_request_init(ai_request_t *req, char *json,
+                          const ai_blob_t *blobs, size_t num_blobs);
+
+/** @brief Tamanho exato do corpo HTTP (Content-Length). */
+size_t ai_request_content_length(const ai_request_t *req);
+
+void ai_request_free(ai_request_t *req);
+
+/* -----------------------------------------------------------------------
+ * Envio
+ * ----------------------------------------------------------------------- */
+
+/**
+ * @brief Abre a requisição POST no cliente persistente.
+ * @param content_len Tamanho do corpo; < 0 abre em modo chunked.
+ */
+esp_err_t ai_client_begin(const ai_client_cfg_t *cfg, int content_len);
+
+esp_err_t ai_client_write(const void *data, size_t len);
+esp_err_t ai_client_write_chunk(const void *data, size_t len);
+/** @brief Envia o chunk final ("0\r\n\r\n") do corpo chunked. */
+esp_err_t ai_client_end_chunked(void);
+
+/** @brief Envia o corpo completo da requisição (com ou sem chunked). */
+esp_err_t ai_client_write_request(const ai_request_t *req, bool chunked);
+
+esp_err_t ai_b64_stream_push(ai_b64_stream_t *st, const uint8_t *data,
+                             size_t len);
+/** @brief Codifica o restante (com padding) e envia como chunk. */
+esp_err_t ai_b64_stream_flush(ai_b64_stream_t *st);
+
+/**
+ * @brief Lê o status e o stream SSE da requisição enviada.
+ *
+ * Depois de uma resposta completa a conexão fica aberta para a próxima
+ * requisição (keep-alive); erro ou timeout a fecham.
+ *
+ * O texto de choices[0].delta.content (ou delta.audio.transcript) é
+ * acumulado em @p out_text e repassado a @p on_delta a cada evento. Quando
+ * um fragmento não cabe em @p out_text_len, ele e todos os seguintes são
+ * descartados e não chegam a @p on_delta: o que foi repassado é sempre
+ * igual a @p out_text.
+ *
+ * Eventos com linha maior que o buffer de montagem (4 KB) são descartados
+ * inteiros, nunca parseados truncados.
+ *
+ * @return ESP_OK com texto, ESP_ERR_NOT_FOUND se a resposta veio vazia,
+ *         ESP_ERR_INVALID_SIZE se algum evento foi descartado por tamanho
+ *         (o texto parcial fica em @p out_text).
+ */
+esp_err_t ai_client_finish(char *out_text, size_t out_text_len,
+                           int *http_code, ai_client_delta_cb_t on_delta,
+                           void *user_ctx);
+
+/** @brief Derruba a conexão atual (corpo incompleto / erro). */
+void ai_client_abort(void);
+
+/**
+ * @brief Prepara o deep sleep: fecha a conexão (e um pre-warm pendente) e
+ *        grava a sessão TLS em NVS para o próximo boot.
+ */
+void ai_client_suspend(void);
+
+/**
+ * @brief begin + corpo + finish. Usa a conexão do pre-warm se houver.
+ */
+esp_err_t ai_client_post(const ai_client_cfg_t *cfg, const ai_request_t *req,
+                         char *out_text, size_t out_text_len, int *http_code,
+                         ai_client_delta_cb_t on_delta, void *user_ctx);
+
+/* -----------------------------------------------------------------------
+ * Pre-warm
+ * ----------------------------------------------------------------------- */
+
+/**
+ * @brief Abre a próxima requisição (DNS + TCP + TLS + cabeçalhos, corpo
+ *        chunked) numa task auxiliar, em paralelo com a captura.
+ *
+ * A conexão é assumida pelo próximo ai_client_post().
+ */
+void ai_client_prewarm_start(const ai_client_cfg_t *cfg);
+
+/** @brief Fecha uma conexão pre-warm não utilizada. */
+void ai_client_prewarm_cancel(void);
+
+#ifdef __cplusplus
+}
+#endif
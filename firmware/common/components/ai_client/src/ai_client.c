@@ -0,0 +1,1381 @@
+#include "ai_client.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ai_conn.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mbedtls/base64.h"
+
+static const char *TAG = "ai_client";
+
+#define AI_CLIENT_URL_MAX 512
+#define AI_HTTP_RX_BUF 1024
+#define AI_HTTP_TX_BUF 2048
+#define AI_HTTP_LINE_MAX 256
+#define AI_HTTP_DRAIN_MAX (16 * 1024)
+#define AI_KEEPALIVE_IDLE_MAX_MS (60 * 1000)
+#define AI_SSE_LINE_BUF 4096
+#define AI_PREWARM_TASK_STACK_SIZE (6 * 1024)
+#define AI_PREWARM_TASK_PRIORITY 4
+
+/* -----------------------------------------------------------------------
+ * Persistent HTTP connection
+ *
+ * HTTP/1.1 minimo sobre ai_conn (socket + mbedTLS): so POST, corpo com
+ * Content-Length ou chunked, resposta com Content-Length, chunked ou ate o
+ * fechamento. O esp_http_client nao expoe a sessao TLS nem o socket; com o
+ * transporte proprio a sessao e salva/restaurada atraves do deep sleep (ver
+ * ai_conn.c) e o cliente sabe se o handshake foi de fato abreviado.
+ *
+ * A conexao fica aberta depois de uma resposta completa (keep-alive): a
+ * proxima interacao pula DNS, TCP e TLS. Antes de reutilizar, uma conexao
+ * ociosa ha mais de AI_KEEPALIVE_IDLE_MAX_MS ou com EOF/dado pendente
+ * (servidor ja fechou) e trocada por uma nova; se mesmo assim a reutilizada
+ * falhar antes do status, ai_client_post repete uma vez em conexao nova.
+ * Erro ou timeout sempre fecham a conexao.
+ *
+ * As escritas passam por um buffer de AI_HTTP_TX_BUF: cabecalhos, linha de
+ * tamanho, dados e CRLF de cada chunk saem num unico registro TLS em vez de
+ * tres.
+ * ----------------------------------------------------------------------- */
+
+typedef enum {
+  AI_BODY_LENGTH,      /* Content-Length */
+  AI_BODY_CHUNKED,     /* Transfer-Encoding: chunked */
+  AI_BODY_UNTIL_CLOSE, /* sem framing: ate o servidor fechar */
+} ai_body_mode_t;
+
+typedef struct {
+  char url[AI_CLIENT_URL_MAX];
+  bool tls;
+  char host[AI_CONN_HOST_MAX];
+  uint16_t port;
+  const char *path; /* aponta para dentro de url */
+
+  uint8_t tx[AI_HTTP_TX_BUF];
+  size_t tx_len;
+  uint8_t rx[AI_HTTP_RX_BUF];
+  size_t rx_pos;
+  size_t rx_len;
+
+  ai_body_mode_t body_mode;
+  uint64_t body_left; /* LENGTH: resto do corpo; CHUNKED: resto do chunk */
+  bool chunk_crlf;    /* CRLF apos os dados do chunk ainda nao lido */
+  bool body_done;
+  bool keep_alive; /* servidor aceita reutilizar a conexao */
+
+  int64_t idle_since_us; /* conexao ociosa desde (0 = em uso) */
+  bool reused;           /* requisicao atual em conexao reutilizada */
+} ai_http_t;
+
+static ai_http_t *s_http = NULL;
+
+void ai_client_abort(void) {
+  ai_conn_close();
+  if (s_http) {
+    s_http->tx_len = 0;
+    s_http->rx_pos = s_http->rx_len = 0;
+    s_http->idle_since_us = 0;
+  }
+}
+
+/* http[s]://host[:porta][/caminho] */
+static esp_err_t ai_url_parse(ai_http_t *h, const char *url) {
+  if (strlcpy(h->url, url, sizeof(h->url)) >= sizeof(h->url)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const char *p = h->url;
+  if (strncasecmp(p, "https://", 8) == 0) {
+    h->tls = true;
+    h->port = 443;
+    p += 8;
+  } else if (strncasecmp(p, "http://", 7) == 0) {
+    h->tls = false;
+    h->port = 80;
+    p += 7;
+  } else {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const size_t host_len = strcspn(p, ":/?");
+  if (host_len == 0 || host_len >= sizeof(h->host)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memcpy(h->host, p, host_len);
+  h->host[host_len] = '\0';
+  p += host_len;
+  if (*p == ':') {
+    char *end = NULL;
+    const unsigned long port = strtoul(p + 1, &end, 10);
+    if (end == p + 1 || port == 0 || port > 65535) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    h->port = (uint16_t)port;
+    p = end;
+  }
+  h->path = (*p == '/') ? p : "/";
+  return ESP_OK;
+}
+
+static esp_err_t ai_client_ensure(const ai_client_cfg_t *cfg) {
+  if (!s_http) {
+    /* buffers de rx/tx no heap para nao pesar na .bss/stack */
+    s_http = calloc(1, sizeof(ai_http_t));
+    if (!s_http) {
+      return ESP_ERR_NO_MEM;
+    }
+  } else if (strcmp(s_http->url, cfg->url) == 0) {
+    return ESP_OK; /* URL unchanged */
+  }
+  ai_conn_close();
+  esp_err_t err = ai_url_parse(s_http, cfg->url);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Invalid URL: %s", cfg->url);
+    s_http->url[0] = '\0';
+    return err;
+  }
+  ESP_LOGI(TAG, "HTTP client initialized: %s", cfg->url);
+  return ESP_OK;
+}
+
+static esp_err_t ai_http_flush(void) {
+  if (s_http->tx_len == 0) {
+    return ESP_OK;
+  }
+  const esp_err_t err = ai_conn_write(s_http->tx, s_http->tx_len);
+  s_http->tx_len = 0;
+  return err;
+}
+
+esp_err_t ai_client_write(const void *data, size_t len) {
+  if (!s_http || !ai_conn_is_open()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const uint8_t *p = (const uint8_t *)data;
+  while (len > 0) {
+    if (s_http->tx_len == 0 && len >= sizeof(s_http->tx)) {
+      return ai_conn_write(p, len); /* bloco grande: direto */
+    }
+    size_t n = sizeof(s_http->tx) - s_http->tx_len;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(s_http->tx + s_http->tx_len, p, n);
+    s_http->tx_len += n;
+    p += n;
+    len -= n;
+    if (s_http->tx_len == sizeof(s_http->tx)) {
+      esp_err_t err = ai_http_flush();
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+  }
+  return ESP_OK;
+}
+
+static esp_err_t ai_client_write_str(const char *s) {
+  return ai_client_write(s, strlen(s));
+}
+
+static esp_err_t ai_client_write_head(const ai_client_cfg_t *cfg,
+                                      int content_len) {
+  char line[AI_HTTP_LINE_MAX];
+  esp_err_t err = ai_client_write_str("POST ");
+  if (err == ESP_OK) {
+    err = ai_client_write_str(s_http->path);
+  }
+  if (err == ESP_OK) {
+    const bool default_port = s_http->port == (s_http->tls ? 443 : 80);
+    if (default_port) {
+      snprintf(line, sizeof(line), " HTTP/1.1\r\nHost: %s\r\n", s_http->host);
+    } else {
+      snprintf(line, sizeof(line), " HTTP/1.1\r\nHost: %s:%u\r\n",
+               s_http->host, (unsigned)s_http->port);
+    }
+    err = ai_client_write_str(line);
+  }
+  if (err == ESP_OK) {
+    err = ai_client_write_str("User-Agent: ESP32 HTTP Client/1.0\r\n"
+                              "Content-Type: application/json\r\n");
+  }
+  /* Skip Authorization header for local servers (Ollama, etc.) that
+   * don't require authentication. */
+  if (err == ESP_OK && cfg->token && cfg->token[0] != '\0') {
+    err = ai_client_write_str("Authorization: Bearer ");
+    if (err == ESP_OK) {
+      err = ai_client_write_str(cfg->token);
+    }
+    if (err == ESP_OK) {
+      err = ai_client_write_str("\r\n");
+    }
+  }
+  if (err == ESP_OK) {
+    if (content_len < 0) {
+      snprintf(line, sizeof(line), "Transfer-Encoding: chunked\r\n\r\n");
+    } else {
+      snprintf(line, sizeof(line), "Content-Length: %d\r\n\r\n", content_len);
+    }
+    err = ai_client_write_str(line);
+  }
+  return err;
+}
+
+/* Reutiliza a conexao ociosa se ainda serve; senao abre outra. */
+static esp_err_t ai_client_connect(const ai_client_cfg_t *cfg) {
+  if (ai_conn_is_open()) {
+    const uint32_t idle_ms =
+        (uint32_t)((esp_timer_get_time() - s_http->idle_since_us) / 1000);
+    if (s_http->idle_since_us != 0 && idle_ms < AI_KEEPALIVE_IDLE_MAX_MS &&
+        ai_conn_is_alive()) {
+      ESP_LOGI(TAG, "Reusing connection (idle %u ms)", (unsigned)idle_ms);
+      s_http->idle_since_us = 0;
+      s_http->reused = true;
+      return ESP_OK;
+    }
+    ESP_LOGI(TAG, "Idle connection %s, reconnecting",
+             idle_ms >= AI_KEEPALIVE_IDLE_MAX_MS ? "too old" : "closed");
+    ai_client_abort();
+  }
+  s_http->reused = false;
+
+  const ai_conn_cfg_t conn_cfg = {
+      .host = s_http->host,
+      .port = s_http->port,
+      .tls = s_http->tls,
+      .timeout_ms = cfg->timeout_ms,
+  };
+  ai_conn_info_t info;
+  s_http->tx_len = 0;
+  s_http->rx_pos = s_http->rx_len = 0;
+  return ai_conn_open(&conn_cfg, &info);
+}
+
+esp_err_t ai_client_begin(const ai_client_cfg_t *cfg, int content_len) {
+  if (!cfg || !cfg->url) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t err = ai_client_ensure(cfg);
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  err = ai_client_connect(cfg);
+  if (err == ESP_OK) {
+    err = ai_client_write_head(cfg, content_len);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "HTTP open failed: %s", esp_err_to_name(err));
+    ai_client_abort();
+  }
+  return err;
+}
+
+void ai_client_suspend(void) {
+  ai_client_prewarm_cancel();
+  ai_client_abort();
+  ai_conn_session_persist();
+}
+
+/* -----------------------------------------------------------------------
+ * Streaming request body
+ * ----------------------------------------------------------------------- */
+
+static size_t ai_base64_encoded_len(size_t data_len) {
+  return ((data_len + 2) / 3) * 4;
+}
+
+esp_err_t ai_request_init(ai_request_t *req, char *json,
+                          const ai_blob_t *blobs, size_t num_blobs) {
+  static const char *const markers[AI_REQUEST_MAX_BLOBS] = {
+      AI_REQUEST_BLOB0_MARKER, AI_REQUEST_BLOB1_MARKER};
+
+  if (!req || !json || num_blobs > AI_REQUEST_MAX_BLOBS ||
+      (num_blobs > 0 && !blobs)) {
+    free(json);
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(req, 0, sizeof(*req));
+  req->json = json;
+  req->num_blobs = num_blobs;
+
+  const char *text = json;
+  for (size_t i = 0; i < num_blobs; i++) {
+    if (!blobs[i].data && !blobs[i].iov && blobs[i].len > 0) {
+      ai_request_free(req);
+      return ESP_ERR_INVALID_ARG;
+    }
+    /* Ultima ocorrencia: os blobs sao as ultimas strings da arvore */
+    const char *marker = NULL;
+    for (const char *p = strstr(text, markers[i]); p;
+         p = strstr(p + 1, markers[i])) {
+      marker = p;
+    }
+    if (!marker) {
+      ai_request_free(req);
+      return ESP_FAIL;
+    }
+    req->text[i] = text;
+    req->text_len[i] = (size_t)(marker - text);
+    req->blobs[i] = blobs[i];
+    text = marker + strlen(markers[i]);
+  }
+  req->text[num_blobs] = text;
+  req->text_len[num_blobs] = strlen(text);
+  return ESP_OK;
+}
+
+size_t ai_request_content_length(const ai_request_t *req) {
+  size_t len = 0;
+  for (size_t i = 0; i <= req->num_blobs; i++) {
+    len += req->text_len[i];
+  }
+  for (size_t i = 0; i < req->num_blobs; i++) {
+    len += (req->blobs[i].raw && !req->blobs[i].iov)
+               ? req->blobs[i].len
+               : ai_base64_encoded_len(req->blobs[i].len);
+  }
+  return len;
+}
+
+void ai_request_free(ai_request_t *req) {
+  if (req) {
+    free(req->json);
+    memset(req, 0, sizeof(*req));
+  }
+}
+
+esp_err_t ai_client_write_chunk(const void *data, size_t len) {
+  if (len == 0) {
+    return ESP_OK;
+  }
+  char size_line[12];
+  int n = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned)len);
+  esp_err_t err = ai_client_write(size_line, (size_t)n);
+  if (err == ESP_OK) {
+    err = ai_client_write(data, len);
+  }
+  if (err == ESP_OK) {
+    err = ai_client_write("\r\n", 2);
+  }
+  return err;
+}
+
+esp_err_t ai_client_end_chunked(void) {
+  esp_err_t err = ai_client_write("0\r\n\r\n", 5);
+  return (err == ESP_OK) ? ai_http_flush() : err;
+}
+
+esp_err_t ai_b64_stream_flush(ai_b64_stream_t *st) {
+  if (st->in_len == 0) {
+    return ESP_OK;
+  }
+  size_t b64_len = 0;
+  if (mbedtls_base64_encode(st->out, sizeof(st->out), &b64_len, st->in,
+                            st->in_len) != 0) {
+    return ESP_FAIL;
+  }
+  st->in_len = 0;
+  return st->plain ? ai_client_write(st->out, b64_len)
+                   : ai_client_write_chunk(st->out, b64_len);
+}
+
+esp_err_t ai_b64_stream_push(ai_b64_stream_t *st, const uint8_t *data,
+                             size_t len) {
+  while (len > 0) {
+    size_t n = sizeof(st->in) - st->in_len;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(st->in + st->in_len, data, n);
+    st->in_len += n;
+    data += n;
+    len -= n;
+    if (st->in_len == sizeof(st->in)) {
+      esp_err_t err = ai_b64_stream_flush(st);
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+  }
+  return ESP_OK;
+}
+
+/* Blob com Content-Length conhecido: blocos de AI_B64_CHUNK_IN bytes
+ * codificados direto no socket. */
+static esp_err_t ai_client_write_blob(const ai_blob_t *blob,
+                                      unsigned char *b64) {
+  for (size_t off = 0; off < blob->len; off += AI_B64_CHUNK_IN) {
+    size_t n = blob->len - off;
+    if (n > AI_B64_CHUNK_IN) {
+      n = AI_B64_CHUNK_IN;
+    }
+    size_t b64_len = 0;
+    if (mbedtls_base64_encode(b64, AI_B64_CHUNK_OUT + 1, &b64_len,
+                              blob->data + off, n) != 0) {
+      return ESP_FAIL;
+    }
+    esp_err_t err = ai_client_write(b64, b64_len);
+    if (err != ESP_OK) {
+      return err;
+    }
+  }
+  return ESP_OK;
+}
+
+/* Blob em pedaços: o acumulador do stream mantem os blocos em multiplos de
+ * 3 bytes entre um pedaco e outro (sem padding no meio). */
+static esp_err_t ai_client_write_blob_iov(const ai_blob_t *blob,
+                                          ai_b64_stream_t *b64) {
+  esp_err_t err = ESP_OK;
+  for (size_t i = 0; i < blob->iov_count && err == ESP_OK; i++) {
+    err = ai_b64_stream_push(b64, blob->iov[i].data, blob->iov[i].len);
+  }
+  if (err == ESP_OK) {
+    err = ai_b64_stream_flush(b64);
+  }
+  return err;
+}
+
+esp_err_t ai_client_write_request(const ai_request_t *req, bool chunked) {
+  if (!req || !req->json) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  /* Pico de memoria: um bloco de codificacao, independente do tamanho dos
+   * blobs. */
+  ai_b64_stream_t *b64 = calloc(1, sizeof(ai_b64_stream_t));
+  if (!b64) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  esp_err_t err = ESP_OK;
+  for (size_t i = 0; i <= req->num_blobs && err == ESP_OK; i++) {
+    err = chunked ? ai_client_write_chunk(req->text[i], req->text_len[i])
+                  : ai_client_write(req->text[i], req->text_len[i]);
+    if (err != ESP_OK || i == req->num_blobs) {
+      break;
+    }
+    if (req->blobs[i].iov) {
+      b64->plain = !chunked;
+      err = ai_client_write_blob_iov(&req->blobs[i], b64);
+    } else if (req->blobs[i].raw) {
+      err = chunked ? ai_client_write_chunk(req->blobs[i].data,
+                                            req->blobs[i].len)
+                    : ai_client_write(req->blobs[i].data, req->blobs[i].len);
+    } else if (chunked) {
+      err = ai_b64_stream_push(b64, req->blobs[i].data, req->blobs[i].len);
+      if (err == ESP_OK) {
+        err = ai_b64_stream_flush(b64);
+      }
+    } else {
+      err = ai_client_write_blob(&req->blobs[i], b64->out);
+    }
+  }
+  if (err == ESP_OK) {
+    err = chunked ? ai_client_end_chunked() : ai_http_flush();
+  }
+  free(b64);
+  return err;
+}
+
+/* -----------------------------------------------------------------------
+ * HTTP response
+ * ----------------------------------------------------------------------- */
+
+/* Garante ao menos um byte no rx. ESP_ERR_INVALID_RESPONSE: EOF. */
+static esp_err_t ai_http_fill(void) {
+  if (s_http->rx_pos < s_http->rx_len) {
+    return ESP_OK;
+  }
+  size_t got = 0;
+  esp_err_t err = ai_conn_read(s_http->rx, sizeof(s_http->rx), &got);
+  if (err != ESP_OK) {
+    return err;
+  }
+  if (got == 0) {
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  s_http->rx_pos = 0;
+  s_http->rx_len = got;
+  return ESP_OK;
+}
+
+/* Linha terminada em LF, sem o CR; o excesso de linhas longas e descartado
+ * (cabecalhos que nao interessam). */
+static esp_err_t ai_http_read_line(char *line, size_t cap) {
+  size_t n = 0;
+  for (;;) {
+    esp_err_t err = ai_http_fill();
+    if (err != ESP_OK) {
+      return err;
+    }
+    const char c = (char)s_http->rx[s_http->rx_pos++];
+    if (c == '\n') {
+      break;
+    }
+    if (n < cap - 1) {
+      line[n++] = c;
+    }
+  }
+  if (n > 0 && line[n - 1] == '\r') {
+    n--;
+  }
+  line[n] = '\0';
+  return ESP_OK;
+}
+
+static bool ai_http_has_token(const char *value, const char *token) {
+  const size_t n = strlen(token);
+  for (; *value; value++) {
+    if (strncasecmp(value, token, n) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Le status e cabecalhos, pulando respostas 1xx (100 Continue). */
+static esp_err_t ai_http_read_head(int *status) {
+  char line[AI_HTTP_LINE_MAX];
+  for (;;) {
+    esp_err_t err = ai_http_read_line(line, sizeof(line));
+    if (err != ESP_OK) {
+      return err;
+    }
+    int major = 0;
+    int minor = 0;
+    if (sscanf(line, "HTTP/%d.%d %d", &major, &minor, status) != 3) {
+      ESP_LOGE(TAG, "Bad status line: %.64s", line);
+      return ESP_ERR_INVALID_RESPONSE;
+    }
+    s_http->keep_alive = (major == 1 && minor >= 1);
+    s_http->body_mode = AI_BODY_UNTIL_CLOSE;
+    s_http->body_left = 0;
+    s_http->chunk_crlf = false;
+    s_http->body_done = false;
+
+    while ((err = ai_http_read_line(line, sizeof(line))) == ESP_OK &&
+           line[0] != '\0') {
+      char *value = strchr(line, ':');
+      if (!value) {
+        continue;
+      }
+      *value++ = '\0';
+      while (*value == ' ' || *value == '\t') {
+        value++;
+      }
+      if (strcasecmp(line, "Content-Length") == 0 &&
+          s_http->body_mode != AI_BODY_CHUNKED) {
+        s_http->body_mode = AI_BODY_LENGTH;
+        s_http->body_left = strtoull(value, NULL, 10);
+      } else if (strcasecmp(line, "Transfer-Encoding") == 0 &&
+                 ai_http_has_token(value, "chunked")) {
+        s_http->body_mode = AI_BODY_CHUNKED;
+        s_http->body_left = 0;
+      } else if (strcasecmp(line, "Connection") == 0) {
+        if (ai_http_has_token(value, "close")) {
+          s_http->keep_alive = false;
+        } else if (ai_http_has_token(value, "keep-alive")) {
+          s_http->keep_alive = true;
+        }
+      }
+    }
+    if (err != ESP_OK) {
+      return err;
+    }
+    if (*status >= 200 || *status < 100) {
+      break;
+    }
+  }
+  if (*status == 204 || *status == 304) {
+    s_http->body_mode = AI_BODY_LENGTH;
+    s_http->body_left = 0;
+  }
+  if (s_http->body_mode == AI_BODY_UNTIL_CLOSE) {
+    s_http->keep_alive = false;
+  }
+  s_http->body_done =
+      (s_http->body_mode == AI_BODY_LENGTH && s_http->body_left == 0);
+  return ESP_OK;
+}
+
+/* Proximo chunk: le o CRLF do anterior e a linha de tamanho. Chunk 0 encerra
+ * o corpo (trailers descartados). */
+static esp_err_t ai_http_next_chunk(void) {
+  char line[AI_HTTP_LINE_MAX];
+  esp_err_t err;
+  if (s_http->chunk_crlf) {
+    if ((err = ai_http_read_line(line, sizeof(line))) != ESP_OK) {
+      return err;
+    }
+    s_http->chunk_crlf = false;
+  }
+  if ((err = ai_http_read_line(line, sizeof(line))) != ESP_OK) {
+    return err;
+  }
+  char *end = NULL;
+  s_http->body_left = strtoull(line, &end, 16);
+  if (end == line) {
+    ESP_LOGE(TAG, "Bad chunk size line: %.32s", line);
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+  if (s_http->body_left > 0) {
+    s_http->chunk_crlf = true;
+    return ESP_OK;
+  }
+  do {
+    err = ai_http_read_line(line, sizeof(line));
+  } while (err == ESP_OK && line[0] != '\0');
+  s_http->body_done = (err == ESP_OK);
+  return err;
+}
+
+/* Le ate len bytes do corpo, sem o framing. *got = 0 no fim do corpo. */
+static esp_err_t ai_http_read_body(char *buf, size_t len, size_t *got) {
+  *got = 0;
+  if (s_http->body_done) {
+    return ESP_OK;
+  }
+  if (s_http->body_mode == AI_BODY_CHUNKED && s_http->body_left == 0) {
+    esp_err_t err = ai_http_next_chunk();
+    if (err != ESP_OK || s_http->body_done) {
+      return err;
+    }
+  }
+  esp_err_t err = ai_http_fill();
+  if (err == ESP_ERR_INVALID_RESPONSE &&
+      s_http->body_mode == AI_BODY_UNTIL_CLOSE) {
+    s_http->body_done = true; /* EOF e o fim do corpo */
+    return ESP_OK;
+  }
+  if (err != ESP_OK) {
+    return err;
+  }
+  size_t n = s_http->rx_len - s_http->rx_pos;
+  if (n > len) {
+    n = len;
+  }
+  if (s_http->body_mode != AI_BODY_UNTIL_CLOSE && n > s_http->body_left) {
+    n = (size_t)s_http->body_left;
+  }
+  memcpy(buf, s_http->rx + s_http->rx_pos, n);
+  s_http->rx_pos += n;
+  if (s_http->body_mode != AI_BODY_UNTIL_CLOSE) {
+    s_http->body_left -= n;
+    if (s_http->body_mode == AI_BODY_LENGTH && s_http->body_left == 0) {
+      s_http->body_done = true;
+    }
+  }
+  *got = n;
+  return ESP_OK;
+}
+
+/* Descarta o resto do corpo (ate AI_HTTP_DRAIN_MAX) para poder reutilizar
+ * a conexao. */
+static bool ai_http_drain(void) {
+  char buf[256];
+  size_t total = 0;
+  size_t got = 0;
+  while (!s_http->body_done && total < AI_HTTP_DRAIN_MAX) {
+    if (ai_http_read_body(buf, sizeof(buf), &got) != ESP_OK || got == 0) {
+      break;
+    }
+    total += got;
+  }
+  return s_http->body_done;
+}
+
+/* Fim da troca: mantem a conexao so apos uma resposta completa que o
+ * servidor permite reutilizar; erro ou timeout fecham. */
+static void ai_http_end(bool clean) {
+  if (clean && s_http->keep_alive && ai_http_drain() &&
+      s_http->rx_pos == s_http->rx_len) {
+    s_http->idle_since_us = esp_timer_get_time();
+    return;
+  }
+  ai_client_abort();
+}
+
+/* -----------------------------------------------------------------------
+ * SSE delta scanner
+ *
+ * Cada evento "data:" traz um chunk pequeno e de forma fixa
+ * ({"choices":[{"delta":{"content":"..."}}]}); montar a arvore cJSON por
+ * evento aloca dezenas de nos no heap so para ler uma string. O scanner
+ * percorre o JSON direto no line_buf, sem alocar, ate choices[0].delta
+ * .content (ou .audio.transcript) e decodifica a string no proprio buffer.
+ * O documento inteiro e validado antes (mesma gramatica que o cJSON aceita):
+ * o scanner nunca aceita um chunk que o cJSON rejeitaria. Formas nao
+ * reconhecidas caem no caminho cJSON.
+ * ----------------------------------------------------------------------- */
+
+typedef enum {
+  AI_SSE_SCAN_TEXT,    /* fragmento encontrado */
+  AI_SSE_SCAN_EMPTY,   /* forma reconhecida, sem texto (role, finish...) */
+  AI_SSE_SCAN_UNKNOWN, /* usar cJSON */
+} ai_sse_scan_result_t;
+
+#define AI_SSE_SCAN_MAX_DEPTH 16
+
+static char *ai_scan_ws(char *p) {
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+    p++;
+  }
+  return p;
+}
+
+static int ai_scan_hex4(const char *p) {
+  int v = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = p[i];
+    v <<= 4;
+    if (c >= '0' && c <= '9') {
+      v |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      v |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      v |= c - 'A' + 10;
+    } else {
+      return -1;
+    }
+  }
+  return v;
+}
+
+/* p aponta para '"'. Valida os escapes e retorna o ponteiro apos a aspa de
+ * fechamento, ou NULL se a string for invalida. */
+static char *ai_scan_string(char *p) {
+  p++;
+  while (*p && *p != '"') {
+    if (*p == '\\') {
+      p++;
+      if (*p == 'u') {
+        if (ai_scan_hex4(p + 1) < 0) {
+          return NULL;
+        }
+        p += 4;
+      } else if (*p == '\0' || !strchr("\"\\/bfnrt", *p)) {
+        return NULL;
+      }
+    }
+    p++;
+  }
+  return (*p == '"') ? p + 1 : NULL;
+}
+
+static char *ai_scan_digits(char *p) {
+  char *start = p;
+  while (*p >= '0' && *p <= '9') {
+    p++;
+  }
+  return (p > start) ? p : NULL;
+}
+
+/* true, false, null ou numero JSON (-?int(.frac)?(e[+-]?exp)?). */
+static char *ai_scan_literal(char *p) {
+  static const char *const words[] = {"true", "false", "null"};
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    const size_t n = strlen(words[i]);
+    if (strncmp(p, words[i], n) == 0) {
+      return p + n;
+    }
+  }
+  if (*p == '-') {
+    p++;
+  }
+  if (!(p = ai_scan_digits(p))) {
+    return NULL;
+  }
+  if (*p == '.' && !(p = ai_scan_digits(p + 1))) {
+    return NULL;
+  }
+  if (*p == 'e' || *p == 'E') {
+    p++;
+    if (*p == '+' || *p == '-') {
+      p++;
+    }
+    p = ai_scan_digits(p);
+  }
+  return p;
+}
+
+static char *ai_scan_value(char *p, int depth) {
+  p = ai_scan_ws(p);
+  if (*p == '"') {
+    return ai_scan_string(p);
+  }
+  if (*p == '{' || *p == '[') {
+    if (depth >= AI_SSE_SCAN_MAX_DEPTH) {
+      return NULL;
+    }
+    const char close = (*p == '{') ? '}' : ']';
+    const bool is_obj = (*p == '{');
+    p = ai_scan_ws(p + 1);
+    if (*p == close) {
+      return p + 1;
+    }
+    for (;;) {
+      if (is_obj) {
+        if (*p != '"' || !(p = ai_scan_string(p))) {
+          return NULL;
+        }
+        p = ai_scan_ws(p);
+        if (*p++ != ':') {
+          return NULL;
+        }
+      }
+      if (!(p = ai_scan_value(p, depth + 1))) {
+        return NULL;
+      }
+      p = ai_scan_ws(p);
+      if (*p == ',') {
+        p = ai_scan_ws(p + 1);
+      } else if (*p == close) {
+        return p + 1;
+      } else {
+        return NULL;
+      }
+    }
+  }
+  return ai_scan_literal(p);
+}
+
+/* Procura key no objeto em obj ('{'). Retorna o inicio do valor, NULL se a
+ * chave nao existe e *bad = true se o objeto e invalido. */
+static char *ai_scan_member(char *obj, const char *key, bool *bad) {
+  const size_t key_len = strlen(key);
+  char *p = ai_scan_ws(obj);
+  if (*p != '{') {
+    *bad = true;
+    return NULL;
+  }
+  p = ai_scan_ws(p + 1);
+  while (*p == '"') {
+    char *k = p + 1;
+    char *end = ai_scan_string(p);
+    if (!end) {
+      break;
+    }
+    p = ai_scan_ws(end);
+    if (*p++ != ':') {
+      break;
+    }
+    p = ai_scan_ws(p);
+    if ((size_t)(end - 1 - k) == key_len && memcmp(k, key, key_len) == 0) {
+      return p;
+    }
+    if (!(p = ai_scan_value(p, 1))) {
+      break;
+    }
+    p = ai_scan_ws(p);
+    if (*p == ',') {
+      p = ai_scan_ws(p + 1);
+    } else if (*p == '}') {
+      return NULL;
+    } else {
+      break;
+    }
+  }
+  if (*p != '}') {
+    *bad = true;
+  }
+  return NULL;
+}
+
+static void ai_scan_put_utf8(char **dst, uint32_t cp) {
+  char *d = *dst;
+  if (cp < 0x80) {
+    *d++ = (char)cp;
+  } else if (cp < 0x800) {
+    *d++ = (char)(0xC0 | (cp >> 6));
+    *d++ = (char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    *d++ = (char)(0xE0 | (cp >> 12));
+    *d++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+    *d++ = (char)(0x80 | (cp & 0x3F));
+  } else {
+    *d++ = (char)(0xF0 | (cp >> 18));
+    *d++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+    *d++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+    *d++ = (char)(0x80 | (cp & 0x3F));
+  }
+  *dst = d;
+}
+
+/* Decodifica no lugar a string (ja validada) que comeca em p ('"'). O texto
+ * decodificado nunca e maior que o original, entao cabe no mesmo buffer. */
+static size_t ai_scan_unescape(char *p) {
+  char *src = p + 1;
+  char *dst = p;
+  while (*src != '"') {
+    if (*src != '\\') {
+      *dst++ = *src++;
+      continue;
+    }
+    src++;
+    char c = *src++;
+    switch (c) {
+    case 'b': *dst++ = '\b'; break;
+    case 'f': *dst++ = '\f'; break;
+    case 'n': *dst++ = '\n'; break;
+    case 'r': *dst++ = '\r'; break;
+    case 't': *dst++ = '\t'; break;
+    case 'u': {
+      uint32_t cp = (uint32_t)ai_scan_hex4(src);
+      src += 4;
+      /* Par surrogate UTF-16 (emojis etc.) */
+      if (cp >= 0xD800 && cp <= 0xDBFF && src[0] == '\\' && src[1] == 'u') {
+        int lo = ai_scan_hex4(src + 2);
+        if (lo >= 0xDC00 && lo <= 0xDFFF) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint32_t)lo - 0xDC00);
+          src += 6;
+        }
+      }
+      if (cp >= 0xD800 && cp <= 0xDFFF) {
+        cp = 0xFFFD; /* surrogate isolado */
+      }
+      ai_scan_put_utf8(&dst, cp);
+      break;
+    }
+    default: *dst++ = c; break; /* " \ / */
+    }
+  }
+  *dst = '\0';
+  return (size_t)(dst - p);
+}
+
+/* Valor de texto nao vazio em v (string); NULL/"" contam como ausentes. */
+static bool ai_scan_has_text(char *v) {
+  return v && v[0] == '"' && v[1] != '"';
+}
+
+static ai_sse_scan_result_t ai_sse_scan_delta(char *data, const char **frag,
+                                              size_t *frag_len) {
+  /* Documento completo e valido, sem lixo depois: um chunk truncado ou
+   * malformado vai para o cJSON, que o rejeita. */
+  char *end = ai_scan_value(data, 0);
+  if (!end || *ai_scan_ws(end) != '\0') {
+    return AI_SSE_SCAN_UNKNOWN;
+  }
+
+  bool bad = false;
+  char *choices = ai_scan_member(data, "choices", &bad);
+  if (!choices) {
+    return AI_SSE_SCAN_UNKNOWN; /* erro, forma diferente ou JSON invalido */
+  }
+  if (*choices != '[') {
+    return AI_SSE_SCAN_UNKNOWN;
+  }
+  char *c0 = ai_scan_ws(choices + 1);
+  if (*c0 == ']') {
+    return AI_SSE_SCAN_EMPTY; /* chunk de usage com choices vazio */
+  }
+  char *delta = ai_scan_member(c0, "delta", &bad);
+  if (bad || !delta || *delta != '{') {
+    return bad ? AI_SSE_SCAN_UNKNOWN : AI_SSE_SCAN_EMPTY;
+  }
+
+  /* Standard text models: delta.content */
+  char *text = ai_scan_member(delta, "content", &bad);
+  if (!bad && !ai_scan_has_text(text)) {
+    /* gpt-4o-audio-preview: delta.audio.transcript */
+    char *audio = ai_scan_member(delta, "audio", &bad);
+    text = (!bad && audio && *audio == '{')
+               ? ai_scan_member(audio, "transcript", &bad)
+               : NULL;
+  }
+  if (bad) {
+    return AI_SSE_SCAN_UNKNOWN;
+  }
+  if (!ai_scan_has_text(text)) {
+    return AI_SSE_SCAN_EMPTY;
+  }
+  if (!ai_scan_string(text)) {
+    return AI_SSE_SCAN_UNKNOWN; /* escape invalido: cJSON decide */
+  }
+  *frag_len = ai_scan_unescape(text);
+  *frag = text;
+  return AI_SSE_SCAN_TEXT;
+}
+
+/* -----------------------------------------------------------------------
+ * SSE streaming parser
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  char *text; /* buffer do chamador: texto acumulado */
+  size_t text_cap;
+  size_t text_len;
+  bool text_full; /* um fragmento nao coube: o resto e descartado */
+  char line_buf[AI_SSE_LINE_BUF]; /* current SSE line assembly buffer */
+  size_t line_buf_pos;
+  bool line_overflow; /* linha atual passou de AI_SSE_LINE_BUF */
+  bool done;          /* [DONE] received */
+  uint32_t events_dropped; /* eventos descartados por tamanho */
+  uint32_t events_scanned; /* eventos lidos pelo scanner */
+  uint32_t events_cjson;   /* eventos que precisaram do cJSON */
+  uint32_t parse_us;       /* tempo total de parse */
+  ai_client_delta_cb_t on_delta;
+  void *user_ctx;
+} ai_sse_ctx_t;
+
+/* Caminho generico: arvore cJSON completa. */
+static const char *ai_sse_cjson_delta(const cJSON *chunk) {
+  cJSON *choices = cJSON_GetObjectItemCaseSensitive(chunk, "choices");
+  if (!cJSON_IsArray(choices)) {
+    return NULL;
+  }
+  cJSON *c0 = cJSON_GetArrayItem(choices, 0);
+  cJSON *delta = cJSON_GetObjectItemCaseSensitive(c0, "delta");
+  if (!delta) {
+    return NULL;
+  }
+  /* Standard text models: delta.content */
+  cJSON *content = cJSON_GetObjectItemCaseSensitive(delta, "content");
+  if (cJSON_IsString(content) && content->valuestring &&
+      content->valuestring[0]) {
+    return content->valuestring;
+  }
+  /* gpt-4o-audio-preview: delta.audio.transcript */
+  cJSON *audio = cJSON_GetObjectItemCaseSensitive(delta, "audio");
+  if (audio) {
+    cJSON *tr = cJSON_GetObjectItemCaseSensitive(audio, "transcript");
+    if (cJSON_IsString(tr) && tr->valuestring && tr->valuestring[0]) {
+      return tr->valuestring;
+    }
+  }
+  return NULL;
+}
+
+static void ai_sse_on_data(ai_sse_ctx_t *ctx, char *data) {
+  if (strcmp(data, "[DONE]") == 0) {
+    ctx->done = true;
+    return;
+  }
+
+  const int64_t t0 = esp_timer_get_time();
+  const char *frag = NULL;
+  size_t fl = 0;
+  cJSON *chunk = NULL;
+  if (ai_sse_scan_delta(data, &frag, &fl) == AI_SSE_SCAN_UNKNOWN) {
+    ctx->events_cjson++;
+    chunk = cJSON_Parse(data);
+    frag = chunk ? ai_sse_cjson_delta(chunk) : NULL;
+    fl = frag ? strlen(frag) : 0;
+  } else {
+    ctx->events_scanned++;
+  }
+  ctx->parse_us += (uint32_t)(esp_timer_get_time() - t0);
+
+  /* So repassa o que entrou no texto: quem mostra o stream (a GUI) termina
+   * com exatamente o texto final, sem buracos de fragmentos que nao
+   * couberam nem sobra alem do limite do chamador. */
+  if (frag && fl > 0 && !ctx->text_full) {
+    if (ctx->text_len + fl < ctx->text_cap) {
+      memcpy(ctx->text + ctx->text_len, frag, fl);
+      ctx->text_len += fl;
+      ctx->text[ctx->text_len] = '\0';
+      if (ctx->on_delta) {
+        ctx->on_delta(frag, fl, ctx->text, ctx->text_len, ctx->user_ctx);
+      }
+    } else {
+      ctx->text_full = true;
+      ESP_LOGW(TAG, "Response text truncated at %u bytes",
+               (unsigned)ctx->text_len);
+    }
+  }
+
+  cJSON_Delete(chunk);
+}
+
+/* Linha completa. SSE permite "data:" com ou sem espaco. */
+static void ai_sse_on_line(ai_sse_ctx_t *ctx) {
+  char *line = ctx->line_buf;
+  const bool is_data = strncmp(line, "data:", 5) == 0;
+  if (ctx->line_overflow) {
+    /* Truncar e parsear daria texto errado (ou um prefixo "valido"):
+     * o evento inteiro e descartado e a resposta sinaliza o erro. */
+    if (is_data) {
+      ctx->events_dropped++;
+      ESP_LOGW(TAG, "SSE event over %u bytes dropped",
+               (unsigned)AI_SSE_LINE_BUF - 1);
+    }
+    return;
+  }
+  if (is_data) {
+    ai_sse_on_data(ctx, line + ((line[5] == ' ') ? 6 : 5));
+  }
+}
+
+static void ai_sse_feed(ai_sse_ctx_t *ctx, const char *buf, int len) {
+  for (int i = 0; i < len && !ctx->done; i++) {
+    char c = buf[i];
+    if (c == '\n') {
+      /* strip trailing \r */
+      if (ctx->line_buf_pos > 0 &&
+          ctx->line_buf[ctx->line_buf_pos - 1] == '\r') {
+        ctx->line_buf_pos--;
+      }
+      ctx->line_buf[ctx->line_buf_pos] = '\0';
+      ai_sse_on_line(ctx);
+      ctx->line_buf_pos = 0;
+      ctx->line_overflow = false;
+    } else if (ctx->line_buf_pos < AI_SSE_LINE_BUF - 1) {
+      ctx->line_buf[ctx->line_buf_pos++] = c;
+    } else {
+      ctx->line_overflow = true;
+    }
+  }
+}
+
+/* *no_response: nada chegou do servidor (conexao reutilizada que ja estava
+ * morta); o chamador pode repetir a requisicao. */
+static esp_err_t ai_client_read_response(char *out_text, size_t out_text_len,
+                                         int *http_code,
+                                         ai_client_delta_cb_t on_delta,
+                                         void *user_ctx, bool *no_response) {
+  *no_response = false;
+  if (!out_text || out_text_len == 0 || !http_code) {
+    ai_client_abort();
+    return ESP_ERR_INVALID_ARG;
+  }
+  *http_code = 0;
+  out_text[0] = '\0';
+  if (!s_http || !ai_conn_is_open()) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  esp_err_t err = ai_http_flush();
+  if (err == ESP_OK) {
+    err = ai_http_read_head(http_code);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "HTTP fetch headers failed: %s", esp_err_to_name(err));
+    *no_response = (err == ESP_ERR_INVALID_RESPONSE || err == ESP_FAIL) &&
+                   *http_code == 0;
+    ai_client_abort();
+    return ESP_FAIL;
+  }
+
+  char read_buf[512];
+  size_t rd = 0;
+  if (*http_code < 200 || *http_code >= 300) {
+    ai_http_read_body(read_buf, sizeof(read_buf) - 1, &rd);
+    read_buf[rd] = '\0';
+    ESP_LOGE(TAG, "AI HTTP status=%d body=%.200s", *http_code, read_buf);
+    ai_http_end(true);
+    return ESP_FAIL;
+  }
+
+  /* line_buf[4096] no heap para não pressionar a stack das tasks de app. */
+  ai_sse_ctx_t *sse = calloc(1, sizeof(ai_sse_ctx_t));
+  if (!sse) {
+    ai_client_abort();
+    return ESP_ERR_NO_MEM;
+  }
+  sse->text = out_text;
+  sse->text_cap = out_text_len;
+  sse->on_delta = on_delta;
+  sse->user_ctx = user_ctx;
+
+  while (!sse->done) {
+    err = ai_http_read_body(read_buf, sizeof(read_buf), &rd);
+    if (err != ESP_OK || rd == 0) {
+      break; /* erro ou fim do corpo */
+    }
+    ai_sse_feed(sse, read_buf, (int)rd);
+  }
+  /* Depois do [DONE] o corpo ainda tem o chunk final: ai_http_end drena
+   * antes de deixar a conexao ociosa. */
+  ai_http_end(err == ESP_OK);
+
+  ESP_LOGI(TAG, "SSE: %u events (%u scanned, %u cJSON), parse %u us",
+           (unsigned)(sse->events_scanned + sse->events_cjson),
+           (unsigned)sse->events_scanned, (unsigned)sse->events_cjson,
+           (unsigned)sse->parse_us);
+  const bool has_text = (sse->text_len > 0);
+  const uint32_t dropped = sse->events_dropped;
+  free(sse);
+
+  if (dropped > 0) {
+    /* Texto parcial fica em out_text, mas a resposta esta incompleta */
+    ESP_LOGE(TAG, "SSE: %u truncated event(s), response incomplete",
+             (unsigned)dropped);
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (has_text)
+    return ESP_OK;
+  return (err == ESP_OK) ? ESP_ERR_NOT_FOUND : err;
+}
+
+esp_err_t ai_client_finish(char *out_text, size_t out_text_len,
+                           int *http_code, ai_client_delta_cb_t on_delta,
+                           void *user_ctx) {
+  bool no_response;
+  return ai_client_read_response(out_text, out_text_len, http_code, on_delta,
+                                 user_ctx, &no_response);
+}
+
+/* -----------------------------------------------------------------------
+ * Connection pre-warm
+ *
+ * Depois de um idle timeout ou de um deep sleep, o primeiro open paga DNS +
+ * TCP + handshake TLS completo (~1 s no log tecnico). A task auxiliar abre
+ * a requisicao em paralelo com a captura (corpo chunked, tamanho ainda
+ * desconhecido); ai_client_post assume essa conexao e so envia o corpo.
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  bool active;                /* task iniciada e conexao ainda nao usada */
+  ai_client_cfg_t cfg;        /* strings apontam para a config do app */
+  esp_err_t err;              /* resultado do open (valido apos done_sem) */
+  TickType_t start_tick;
+  TickType_t ready_tick;
+  SemaphoreHandle_t done_sem; /* sinalizado quando o open termina */
+  uint32_t hits;
+  uint32_t misses;
+} ai_prewarm_t;
+
+static ai_prewarm_t s_prewarm;
+
+static void ai_prewarm_task(void *arg) {
+  (void)arg;
+  s_prewarm.err = ai_client_begin(&s_prewarm.cfg, -1);
+  s_prewarm.ready_tick = xTaskGetTickCount();
+  xSemaphoreGive(s_prewarm.done_sem);
+  vTaskDelete(NULL);
+}
+
+void ai_client_prewarm_start(const ai_client_cfg_t *cfg) {
+  if (!cfg || !cfg->url || s_prewarm.active) {
+    return;
+  }
+  if (!s_prewarm.done_sem) {
+    s_prewarm.done_sem = xSemaphoreCreateBinary();
+    if (!s_prewarm.done_sem) {
+      return;
+    }
+  }
+  s_prewarm.cfg = *cfg;
+  s_prewarm.err = ESP_FAIL;
+  s_prewarm.start_tick = xTaskGetTickCount();
+  if (xTaskCreatePinnedToCore(ai_prewarm_task, "ai_prewarm",
+                              AI_PREWARM_TASK_STACK_SIZE, NULL,
+                              AI_PREWARM_TASK_PRIORITY, NULL, 1) != pdPASS) {
+    ESP_LOGW(TAG, "Pre-warm task not started");
+    return;
+  }
+  s_prewarm.active = true;
+}
+
+/* Aguarda o pre-warm e assume a conexao. Retorna true se a requisicao ja
+ * esta aberta em modo chunked e so falta o corpo. */
+static bool ai_prewarm_claim(void) {
+  if (!s_prewarm.active) {
+    return false;
+  }
+  const TickType_t claim_tick = xTaskGetTickCount();
+  xSemaphoreTake(s_prewarm.done_sem, portMAX_DELAY);
+  s_prewarm.active = false;
+
+  const uint32_t connect_ms =
+      (uint32_t)pdTICKS_TO_MS(s_prewarm.ready_tick - s_prewarm.start_tick);
+  if (s_prewarm.err != ESP_OK) {
+    s_prewarm.misses++;
+    ESP_LOGW(TAG, "Pre-warm miss: %s after %u ms (hits=%u misses=%u)",
+             esp_err_to_name(s_prewarm.err), (unsigned)connect_ms,
+             (unsigned)s_prewarm.hits, (unsigned)s_prewarm.misses);
+    return false;
+  }
+
+  s_prewarm.hits++;
+  const TickType_t waited = xTaskGetTickCount() - claim_tick;
+  if (waited > 0) {
+    ESP_LOGI(TAG,
+             "Pre-warm partial hit: connect %u ms, waited %u ms "
+             "(hits=%u misses=%u)",
+             (unsigned)connect_ms, (unsigned)pdTICKS_TO_MS(waited),
+             (unsigned)s_prewarm.hits, (unsigned)s_prewarm.misses);
+  } else {
+    ESP_LOGI(TAG,
+             "Pre-warm hit: connect %u ms, ready %u ms before use "
+             "(hits=%u misses=%u)",
+             (unsigned)connect_ms,
+             (unsigned)pdTICKS_TO_MS(claim_tick - s_prewarm.ready_tick),
+             (unsigned)s_prewarm.hits, (unsigned)s_prewarm.misses);
+  }
+  return true;
+}
+
+void ai_client_prewarm_cancel(void) {
+  if (!s_prewarm.active) {
+    return;
+  }
+  xSemaphoreTake(s_prewarm.done_sem, portMAX_DELAY);
+  s_prewarm.active = false;
+  if (s_prewarm.err == ESP_OK) {
+    ai_client_abort();
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * HTTP POST (streaming, persistent client)
+ * ----------------------------------------------------------------------- */
+
+esp_err_t ai_client_post(const ai_client_cfg_t *cfg, const ai_request_t *req,
+                         char *out_text, size_t out_text_len, int *http_code,
+                         ai_client_delta_cb_t on_delta, void *user_ctx) {
+  if (!cfg || !req || !req->json || !out_text || !http_code) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *http_code = 0;
+
+  const size_t content_len = ai_request_content_length(req);
+  bool prewarmed = ai_prewarm_claim();
+  for (int attempt = 0;; attempt++) {
+    esp_err_t err = ESP_OK;
+    if (!prewarmed) {
+      err = ai_client_begin(cfg, (int)content_len);
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+    /* Servidor pode fechar uma conexao ociosa a qualquer momento: se a
+     * reutilizada falhar antes de responder, uma nova tentativa. */
+    const bool retry = s_http->reused && attempt == 0;
+
+    const TickType_t upload_start = xTaskGetTickCount();
+    err = ai_client_write_request(req, prewarmed);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "HTTP write failed: %s", esp_err_to_name(err));
+      ai_client_abort();
+      if (retry) {
+        ESP_LOGW(TAG, "Reused connection failed, retrying on a new one");
+        prewarmed = false;
+        continue;
+      }
+      return err;
+    }
+    ESP_LOGI(TAG, "Request body streamed: %u bytes in %u ms",
+             (unsigned)content_len,
+             (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - upload_start));
+
+    bool no_response = false;
+    err = ai_client_read_response(out_text, out_text_len, http_code, on_delta,
+                                  user_ctx, &no_response);
+    if (no_response && retry) {
+      ESP_LOGW(TAG, "Reused connection failed, retrying on a new one");
+      prewarmed = false;
+      continue;
+    }
+    return err;
+  }
+}
@@ -0,0 +1,612 @@
+#include "ai_conn.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#ifndef AI_CONN_TLS
+#ifdef ESP_PLATFORM
+#define AI_CONN_TLS 1
+#else
+#define AI_CONN_TLS 0 /* host: so http://, salvo o teste de sessao TLS */
+#endif
+#endif
+
+#if AI_CONN_TLS
+#include "esp_crt_bundle.h"
+#include "esp_rom_crc.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl.h"
+#include "nvs.h"
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const char *TAG = "ai_conn";
+
+#define AI_CONN_KEEPALIVE_IDLE_S 5
+#define AI_CONN_KEEPALIVE_INTERVAL_S 5
+#define AI_CONN_KEEPALIVE_COUNT 3
+
+typedef struct {
+  int fd;
+  bool tls;
+  int timeout_ms;
+  char host[AI_CONN_HOST_MAX];
+  uint16_t port;
+#if AI_CONN_TLS
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_config conf;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_entropy_context entropy;
+#endif
+} ai_conn_t;
+
+static ai_conn_t s_conn = {.fd = -1};
+static RTC_DATA_ATTR ai_conn_tls_stats_t s_tls_stats; /* acumulado entre wakes */
+
+/* Espera o socket ficar pronto para leitura ou escrita.
+ * 1: pronto, 0: timeout, -1: erro. timeout_ms < 0 espera sem limite. */
+static int ai_conn_wait(int fd, bool write, int timeout_ms) {
+  fd_set set;
+  int n;
+  do {
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    n = select(fd + 1, write ? NULL : &set, write ? &set : NULL, NULL,
+               timeout_ms < 0 ? NULL : &tv);
+  } while (n < 0 && errno == EINTR);
+  return n;
+}
+
+static void ai_conn_set_sockopts(int fd, int timeout_ms) {
+  const int one = 1;
+  const int idle = AI_CONN_KEEPALIVE_IDLE_S;
+  const int interval = AI_CONN_KEEPALIVE_INTERVAL_S;
+  const int count = AI_CONN_KEEPALIVE_COUNT;
+  setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+  setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+  setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+  setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+  /* Escritas bloqueantes com limite: um servidor que para de ler nao
+   * prende a task de upload para sempre. */
+  const struct timeval tv = {
+      .tv_sec = timeout_ms / 1000,
+      .tv_usec = (timeout_ms % 1000) * 1000,
+  };
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static int ai_conn_tcp_connect(const char *host, uint16_t port,
+                               int timeout_ms) {
+  const struct addrinfo hints = {
+      .ai_family = AF_UNSPEC,
+      .ai_socktype = SOCK_STREAM,
+  };
+  struct addrinfo *res = NULL;
+  char port_str[6];
+  snprintf(port_str, sizeof(port_str), "%u", (unsigned)port);
+  const int gai = getaddrinfo(host, port_str, &hints, &res);
+  if (gai != 0 || !res) {
+    ESP_LOGE(TAG, "DNS lookup failed for %s (%d)", host, gai);
+    return -1;
+  }
+
+  int fd = -1;
+  for (struct addrinfo *ai = res; ai && fd < 0; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    /* connect nao bloqueante para respeitar o timeout */
+    const int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int ret = connect(fd, ai->ai_addr, ai->ai_addrlen);
+    if (ret < 0 && errno == EINPROGRESS &&
+        ai_conn_wait(fd, true, timeout_ms) > 0) {
+      int so_err = 0;
+      socklen_t so_len = sizeof(so_err);
+      getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_err, &so_len);
+      ret = so_err ? -1 : 0;
+    }
+    if (ret == 0) {
+      fcntl(fd, F_SETFL, flags);
+    } else {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+
+  if (fd < 0) {
+    ESP_LOGE(TAG, "Connect to %s:%u failed", host, (unsigned)port);
+    return -1;
+  }
+  ai_conn_set_sockopts(fd, timeout_ms);
+  return fd;
+}
+
+#if AI_CONN_TLS
+/* -----------------------------------------------------------------------
+ * TLS session cache
+ *
+ * A sessao (ticket ou ID + master secret) do ultimo handshake e serializada
+ * com mbedtls_ssl_session_save numa copia RTC_NOINIT, que sobrevive ao deep
+ * sleep e a resets por software. Antes do sleep ai_conn_session_persist()
+ * grava a mesma copia em NVS; no boot frio (RTC invalida) o primeiro
+ * connect le de la. O CRC descarta lixo da RTC apos power-on.
+ *
+ * Com relogio valido, sessoes mais velhas que AI_TLS_SESSION_MAX_AGE_S nem
+ * sao oferecidas; sem relogio o servidor decide (recusa = handshake
+ * completo, contado como miss).
+ * ----------------------------------------------------------------------- */
+
+#define AI_TLS_SESSION_MAX_LEN 2048
+#define AI_TLS_SESSION_MAX_AGE_S (24 * 60 * 60)
+#define AI_TLS_CACHE_MAGIC 0x41495453u /* "AITS" */
+#define AI_TLS_CLOCK_VALID 1700000000  /* time() abaixo disso: sem relogio */
+#define AI_TLS_NVS_NAMESPACE "ai_tls"
+#define AI_TLS_NVS_KEY "session"
+
+typedef struct {
+  uint32_t magic;
+  uint32_t crc; /* de saved_at ate data[len] */
+  int64_t saved_at;
+  uint16_t port;
+  uint16_t len;
+  char host[AI_CONN_HOST_MAX];
+  uint8_t data[AI_TLS_SESSION_MAX_LEN];
+} ai_tls_cache_t;
+
+#define AI_TLS_CACHE_HDR_LEN offsetof(ai_tls_cache_t, data)
+#define AI_TLS_CACHE_CRC_OFS offsetof(ai_tls_cache_t, saved_at)
+
+static RTC_NOINIT_ATTR ai_tls_cache_t s_tls_cache;
+static bool s_tls_cache_checked; /* RTC validada (ou NVS lida) neste boot */
+
+static uint32_t ai_tls_cache_crc(const ai_tls_cache_t *c) {
+  return esp_rom_crc32_le(0, (const uint8_t *)c + AI_TLS_CACHE_CRC_OFS,
+                          AI_TLS_CACHE_HDR_LEN - AI_TLS_CACHE_CRC_OFS + c->len);
+}
+
+static bool ai_tls_cache_valid(const ai_tls_cache_t *c) {
+  return c->magic == AI_TLS_CACHE_MAGIC && c->len > 0 &&
+         c->len <= AI_TLS_SESSION_MAX_LEN &&
+         c->host[AI_CONN_HOST_MAX - 1] == '\0' && c->crc == ai_tls_cache_crc(c);
+}
+
+static void ai_tls_cache_drop(void) { s_tls_cache.magic = 0; }
+
+/* Primeiro uso no boot: RTC (wake do deep sleep) ou NVS (boot frio). */
+static void ai_tls_cache_restore(void) {
+  if (s_tls_cache_checked) {
+    return;
+  }
+  s_tls_cache_checked = true;
+  if (ai_tls_cache_valid(&s_tls_cache)) {
+    ESP_LOGI(TAG, "TLS session for %s restored from RTC", s_tls_cache.host);
+    return;
+  }
+  ai_tls_cache_drop();
+
+  nvs_handle_t nvs;
+  if (nvs_open(AI_TLS_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+    return;
+  }
+  size_t size = sizeof(s_tls_cache);
+  const esp_err_t err = nvs_get_blob(nvs, AI_TLS_NVS_KEY, &s_tls_cache, &size);
+  nvs_close(nvs);
+  if (err == ESP_OK && size >= AI_TLS_CACHE_HDR_LEN &&
+      ai_tls_cache_valid(&s_tls_cache) &&
+      size == AI_TLS_CACHE_HDR_LEN + s_tls_cache.len) {
+    ESP_LOGI(TAG, "TLS session for %s restored from NVS", s_tls_cache.host);
+  } else {
+    ai_tls_cache_drop();
+  }
+}
+
+static bool ai_tls_cache_fresh(const ai_tls_cache_t *c) {
+  const time_t now = time(NULL);
+  if (now < AI_TLS_CLOCK_VALID || c->saved_at < AI_TLS_CLOCK_VALID) {
+    return true;
+  }
+  return (int64_t)now - c->saved_at <= AI_TLS_SESSION_MAX_AGE_S;
+}
+
+/* Oferece a sessao guardada para host:port. Retorna true se oferecida. */
+static bool ai_tls_cache_apply(mbedtls_ssl_context *ssl, const char *host,
+                               uint16_t port) {
+  ai_tls_cache_restore();
+  if (s_tls_cache.magic != AI_TLS_CACHE_MAGIC || s_tls_cache.port != port ||
+      strcmp(s_tls_cache.host, host) != 0) {
+    return false;
+  }
+  if (!ai_tls_cache_fresh(&s_tls_cache)) {
+    ESP_LOGI(TAG, "TLS session expired");
+    ai_tls_cache_drop();
+    return false;
+  }
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  const bool ok =
+      mbedtls_ssl_session_load(&session, s_tls_cache.data, s_tls_cache.len) ==
+          0 &&
+      mbedtls_ssl_set_session(ssl, &session) == 0;
+  mbedtls_ssl_session_free(&session);
+  if (!ok) {
+    /* ex.: gravada por outra versao/config do mbedTLS */
+    ESP_LOGW(TAG, "Stored TLS session unusable, dropped");
+    ai_tls_cache_drop();
+  }
+  return ok;
+}
+
+/* O tamanho e consultado antes (buffer NULL): uma sessao que nao cabe no
+ * slot e reportada com o tamanho pedido, nao como falha generica. Com
+ * MBEDTLS_SSL_KEEP_PEER_CERTIFICATE a sessao leva o certificado DER do
+ * servidor e passa facil de AI_TLS_SESSION_MAX_LEN (ver sdkconfig). */
+static void ai_tls_cache_store(mbedtls_ssl_context *ssl, const char *host,
+                               uint16_t port) {
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  size_t len = 0;
+  int ret = mbedtls_ssl_get_session(ssl, &session);
+  if (ret == 0) {
+    ret = mbedtls_ssl_session_save(&session, NULL, 0, &len);
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL &&
+        len <= sizeof(s_tls_cache.data)) {
+      ret = mbedtls_ssl_session_save(&session, s_tls_cache.data,
+                                     sizeof(s_tls_cache.data), &len);
+    }
+  }
+  mbedtls_ssl_session_free(&session);
+  if (ret != 0 || len == 0) {
+    ESP_LOGW(TAG, "TLS session not cached (-0x%04x, needs %u of %u bytes)",
+             (unsigned)-ret, (unsigned)len, (unsigned)sizeof(s_tls_cache.data));
+    s_tls_stats.session_len = 0;
+    ai_tls_cache_drop();
+    return;
+  }
+  s_tls_stats.session_len = (uint32_t)len;
+  s_tls_cache.saved_at = (int64_t)time(NULL);
+  s_tls_cache.port = port;
+  s_tls_cache.len = (uint16_t)len;
+  memset(s_tls_cache.host, 0, sizeof(s_tls_cache.host));
+  strlcpy(s_tls_cache.host, host, sizeof(s_tls_cache.host));
+  s_tls_cache.crc = ai_tls_cache_crc(&s_tls_cache);
+  s_tls_cache.magic = AI_TLS_CACHE_MAGIC;
+  s_tls_cache_checked = true;
+}
+
+void ai_conn_session_persist(void) {
+  if (!ai_tls_cache_valid(&s_tls_cache)) {
+    return;
+  }
+  nvs_handle_t nvs;
+  esp_err_t err = nvs_open(AI_TLS_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(nvs, AI_TLS_NVS_KEY, &s_tls_cache,
+                       AI_TLS_CACHE_HDR_LEN + s_tls_cache.len);
+    if (err == ESP_OK) {
+      err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "TLS session not saved to NVS: %s", esp_err_to_name(err));
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * TLS over the socket
+ * ----------------------------------------------------------------------- */
+
+static int ai_conn_bio_send(void *ctx, const unsigned char *buf, size_t len) {
+  const int fd = *(const int *)ctx;
+  const int n = send(fd, buf, len, MSG_NOSIGNAL);
+  if (n < 0) {
+    /* EAGAIN num socket bloqueante = SO_SNDTIMEO esgotado */
+    return (errno == EINTR) ? MBEDTLS_ERR_SSL_WANT_WRITE
+                            : MBEDTLS_ERR_NET_SEND_FAILED;
+  }
+  return n;
+}
+
+static int ai_conn_bio_recv(void *ctx, unsigned char *buf, size_t len,
+                            uint32_t timeout_ms) {
+  const int fd = *(const int *)ctx;
+  const int ready = ai_conn_wait(fd, false, timeout_ms ? (int)timeout_ms : -1);
+  if (ready == 0) {
+    return MBEDTLS_ERR_SSL_TIMEOUT;
+  }
+  if (ready < 0) {
+    return MBEDTLS_ERR_NET_RECV_FAILED;
+  }
+  const int n = recv(fd, buf, len, 0);
+  if (n < 0) {
+    return (errno == EINTR || errno == EAGAIN) ? MBEDTLS_ERR_SSL_WANT_READ
+                                               : MBEDTLS_ERR_NET_RECV_FAILED;
+  }
+  return n;
+}
+
+static void ai_conn_tls_free(ai_conn_t *c) {
+  mbedtls_ssl_free(&c->ssl);
+  mbedtls_ssl_config_free(&c->conf);
+  mbedtls_ctr_drbg_free(&c->drbg);
+  mbedtls_entropy_free(&c->entropy);
+}
+
+static esp_err_t ai_conn_tls_handshake(ai_conn_t *c, const char *host,
+                                       uint16_t port, ai_conn_info_t *info) {
+  mbedtls_ssl_init(&c->ssl);
+  mbedtls_ssl_config_init(&c->conf);
+  mbedtls_ctr_drbg_init(&c->drbg);
+  mbedtls_entropy_init(&c->entropy);
+
+  int ret = mbedtls_ctr_drbg_seed(&c->drbg, mbedtls_entropy_func, &c->entropy,
+                                  NULL, 0);
+  if (ret == 0) {
+    ret = mbedtls_ssl_config_defaults(&c->conf, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret != 0) {
+    ESP_LOGE(TAG, "TLS setup failed: -0x%04x", (unsigned)-ret);
+    return ESP_FAIL;
+  }
+  mbedtls_ssl_conf_authmode(&c->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  mbedtls_ssl_conf_rng(&c->conf, mbedtls_ctr_drbg_random, &c->drbg);
+  mbedtls_ssl_conf_read_timeout(&c->conf, (uint32_t)c->timeout_ms);
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+  mbedtls_ssl_conf_session_tickets(&c->conf,
+                                   MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  if (esp_crt_bundle_attach(&c->conf) != ESP_OK) {
+    ESP_LOGE(TAG, "Certificate bundle attach failed");
+    return ESP_FAIL;
+  }
+  ret = mbedtls_ssl_setup(&c->ssl, &c->conf);
+  if (ret == 0) {
+    ret = mbedtls_ssl_set_hostname(&c->ssl, host);
+  }
+  if (ret != 0) {
+    ESP_LOGE(TAG, "TLS setup failed: -0x%04x", (unsigned)-ret);
+    return ESP_FAIL;
+  }
+  mbedtls_ssl_set_bio(&c->ssl, &c->fd, ai_conn_bio_send, NULL,
+                      ai_conn_bio_recv);
+
+  const bool offered = ai_tls_cache_apply(&c->ssl, host, port);
+
+  /* Handshake passo a passo: no handshake abreviado o cliente nunca passa
+   * por SERVER_CERTIFICATE (nem cadeia X.509 nem ECDHE). E a unica forma
+   * confiavel de saber se o servidor aceitou a sessao oferecida. */
+  bool saw_certificate = false;
+  while (!mbedtls_ssl_is_handshake_over(&c->ssl)) {
+    if (c->ssl.MBEDTLS_PRIVATE(state) == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+      saw_certificate = true;
+    }
+    ret = mbedtls_ssl_handshake_step(&c->ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      continue;
+    }
+    if (ret != 0) {
+      ESP_LOGE(TAG, "TLS handshake with %s failed: -0x%04x", host,
+               (unsigned)-ret);
+      if (offered) {
+        ai_tls_cache_drop(); /* nao insistir com uma sessao suspeita */
+      }
+      return ESP_FAIL;
+    }
+  }
+
+  if (!offered) {
+    info->session = AI_CONN_SESSION_NONE;
+    s_tls_stats.full++;
+  } else if (!saw_certificate) {
+    info->session = AI_CONN_SESSION_RESUMED;
+    s_tls_stats.resumed++;
+  } else {
+    info->session = AI_CONN_SESSION_REJECTED;
+    s_tls_stats.rejected++;
+  }
+  ai_tls_cache_store(&c->ssl, host, port);
+  return ESP_OK;
+}
+
+static const char *ai_conn_session_name(ai_conn_session_t s) {
+  switch (s) {
+  case AI_CONN_SESSION_RESUMED: return "resumed";
+  case AI_CONN_SESSION_REJECTED: return "rejected";
+  default: return "none";
+  }
+}
+#else
+void ai_conn_session_persist(void) {}
+#endif /* AI_CONN_TLS */
+
+/* -----------------------------------------------------------------------
+ * Connection
+ * ----------------------------------------------------------------------- */
+
+esp_err_t ai_conn_open(const ai_conn_cfg_t *cfg, ai_conn_info_t *info) {
+  if (!cfg || !cfg->host || !info) {
+    return ESP_ERR_INVALID_ARG;
+  }
+#if !AI_CONN_TLS
+  if (cfg->tls) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+#endif
+  ai_conn_close();
+  memset(info, 0, sizeof(*info));
+
+  const int64_t t0 = esp_timer_get_time();
+  s_conn.fd = ai_conn_tcp_connect(cfg->host, cfg->port, cfg->timeout_ms);
+  if (s_conn.fd < 0) {
+    return ESP_FAIL;
+  }
+  const int64_t t1 = esp_timer_get_time();
+  info->connect_ms = (uint32_t)((t1 - t0) / 1000);
+  s_conn.tls = cfg->tls;
+  s_conn.timeout_ms = cfg->timeout_ms;
+  strlcpy(s_conn.host, cfg->host, sizeof(s_conn.host));
+  s_conn.port = cfg->port;
+
+#if AI_CONN_TLS
+  if (s_conn.tls) {
+    if (ai_conn_tls_handshake(&s_conn, cfg->host, cfg->port, info) != ESP_OK) {
+      ai_conn_close();
+      return ESP_FAIL;
+    }
+    info->handshake_ms = (uint32_t)((esp_timer_get_time() - t1) / 1000);
+    ESP_LOGI(TAG,
+             "Connected to %s: TCP %u ms, TLS %u ms (session %s, "
+             "hits=%u misses=%u cold=%u, cached %u B)",
+             cfg->host, (unsigned)info->connect_ms,
+             (unsigned)info->handshake_ms, ai_conn_session_name(info->session),
+             (unsigned)s_tls_stats.resumed, (unsigned)s_tls_stats.rejected,
+             (unsigned)s_tls_stats.full, (unsigned)s_tls_stats.session_len);
+    return ESP_OK;
+  }
+#endif
+  ESP_LOGI(TAG, "Connected to %s:%u in %u ms", cfg->host, (unsigned)cfg->port,
+           (unsigned)info->connect_ms);
+  return ESP_OK;
+}
+
+bool ai_conn_is_open(void) { return s_conn.fd >= 0; }
+
+bool ai_conn_is_alive(void) {
+  if (s_conn.fd < 0) {
+    return false;
+  }
+#if AI_CONN_TLS
+  if (s_conn.tls && mbedtls_ssl_get_bytes_avail(&s_conn.ssl) > 0) {
+    return false;
+  }
+#endif
+  return ai_conn_wait(s_conn.fd, false, 0) == 0;
+}
+
+esp_err_t ai_conn_write(const void *data, size_t len) {
+  if (s_conn.fd < 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const uint8_t *p = (const uint8_t *)data;
+  while (len > 0) {
+    int n;
+#if AI_CONN_TLS
+    if (s_conn.tls) {
+      n = mbedtls_ssl_write(&s_conn.ssl, p, len);
+      if (n == MBEDTLS_ERR_SSL_WANT_WRITE || n == MBEDTLS_ERR_SSL_WANT_READ) {
+        continue;
+      }
+    } else
+#endif
+    {
+      n = send(s_conn.fd, p, len, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+    }
+    if (n <= 0) {
+      ESP_LOGE(TAG, "Write failed (%d, errno %d)", n, errno);
+      return ESP_FAIL;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return ESP_OK;
+}
+
+esp_err_t ai_conn_read(void *buf, size_t len, size_t *got) {
+  *got = 0;
+  if (s_conn.fd < 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+#if AI_CONN_TLS
+  if (s_conn.tls) {
+    for (;;) {
+      const int n = mbedtls_ssl_read(&s_conn.ssl, buf, len);
+      if (n > 0) {
+        *got = (size_t)n;
+        return ESP_OK;
+      }
+      if (n == 0 || n == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        return ESP_OK; /* fim do stream */
+      }
+      if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        continue;
+      }
+#ifdef MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+      if (n == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET) {
+        /* TLS 1.3: o ticket chega depois do handshake */
+        ai_tls_cache_store(&s_conn.ssl, s_conn.host, s_conn.port);
+        continue;
+      }
+#endif
+      if (n == MBEDTLS_ERR_SSL_TIMEOUT) {
+        return ESP_ERR_TIMEOUT;
+      }
+      ESP_LOGE(TAG, "TLS read failed: -0x%04x", (unsigned)-n);
+      return ESP_FAIL;
+    }
+  }
+#endif
+  const int ready = ai_conn_wait(s_conn.fd, false, s_conn.timeout_ms);
+  if (ready == 0) {
+    return ESP_ERR_TIMEOUT;
+  }
+  int n;
+  do {
+    n = (ready > 0) ? (int)recv(s_conn.fd, buf, len, 0) : -1;
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    ESP_LOGE(TAG, "Read failed (errno %d)", errno);
+    return ESP_FAIL;
+  }
+  *got = (size_t)n;
+  return ESP_OK;
+}
+
+void ai_conn_close(void) {
+  if (s_conn.fd < 0) {
+    return;
+  }
+#if AI_CONN_TLS
+  if (s_conn.tls) {
+    mbedtls_ssl_close_notify(&s_conn.ssl);
+    ai_conn_tls_free(&s_conn);
+  }
+#endif
+  close(s_conn.fd);
+  s_conn.fd = -1;
+}
+
+void ai_conn_get_tls_stats(ai_conn_tls_stats_t *out) {
+  if (out) {
+    *out = s_tls_stats;
+  }
+}
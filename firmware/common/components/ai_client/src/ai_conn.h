@@ -0,0 +1,78 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------
+ * Conexao do ai_client: socket TCP e, para https, mbedTLS por cima.
+ *
+ * Uma conexao por vez (estado global, como o ai_client). Com TLS, a sessao
+ * de cada handshake e serializada (mbedtls_ssl_session_save) em memoria RTC
+ * e reapresentada no proximo connect ao mesmo host, inclusive depois de um
+ * deep sleep; ai_conn_session_persist() grava a mesma copia em NVS para
+ * sobreviver tambem a um corte de energia.
+ *
+ * Sem ESP_PLATFORM (testes no host) so http:// e suportado, a menos que o
+ * fonte seja compilado com AI_CONN_TLS=1 contra o mbedTLS do host
+ * (test_ai_tls_session).
+ * ----------------------------------------------------------------------- */
+
+#define AI_CONN_HOST_MAX 128
+
+typedef struct {
+  const char *host;
+  uint16_t port;
+  bool tls;
+  int timeout_ms; /* connect, handshake e cada leitura/escrita */
+} ai_conn_cfg_t;
+
+/** Resultado da sessao TLS no ultimo ai_conn_open(). */
+typedef enum {
+  AI_CONN_SESSION_NONE,     /* http, ou nenhuma sessao guardada (cold) */
+  AI_CONN_SESSION_RESUMED,  /* handshake abreviado: servidor aceitou */
+  AI_CONN_SESSION_REJECTED, /* sessao oferecida, handshake completo */
+} ai_conn_session_t;
+
+typedef struct {
+  uint32_t connect_ms;   /* DNS + TCP */
+  uint32_t handshake_ms; /* TLS (0 em http) */
+  ai_conn_session_t session;
+} ai_conn_info_t;
+
+/** Contadores acumulados entre wakes (memoria RTC). */
+typedef struct {
+  uint32_t resumed;  /* hit: handshake abreviado */
+  uint32_t rejected; /* miss: sessao oferecida e recusada/expirada */
+  uint32_t full;     /* sem sessao para oferecer */
+  uint32_t session_len; /* bytes da ultima sessao guardada (0: nao coube) */
+} ai_conn_tls_stats_t;
+
+esp_err_t ai_conn_open(const ai_conn_cfg_t *cfg, ai_conn_info_t *info);
+
+bool ai_conn_is_open(void);
+
+/**
+ * @brief Conexao aberta e ociosa sem nada pendente do servidor.
+ *
+ * Dado ou EOF chegando numa conexao ociosa (FIN, alerta TLS de
+ * close_notify) significa que o servidor a encerrou.
+ */
+bool ai_conn_is_alive(void);
+
+/** @brief Escreve tudo ou falha (timeout/erro). */
+esp_err_t ai_conn_write(const void *data, size_t len);
+
+/**
+ * @brief Le o que estiver disponivel (ate @p len).
+ * @return ESP_OK com *got = 0 no fim do stream, ESP_ERR_TIMEOUT, ESP_FAIL.
+ */
+esp_err_t ai_conn_read(void *buf, size_t len, size_t *got);
+
+void ai_conn_close(void);
+
+/** @brief Grava a sessao TLS guardada em NVS (antes do deep sleep). */
+void ai_conn_session_persist(void);
+
+void ai_conn_get_tls_stats(ai_conn_tls_stats_t *out);
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------------------
+ * Codificação do áudio enviado à API, compartilhada pelas firmwares S3 e P4.
+ *
+ * O PCM16 mono capturado vira base64 no corpo da requisição (+33%); em
+ * Wi-Fi fraco o upload domina o tempo da interação. Os codificadores abaixo
+ * reduzem o tamanho antes do base64:
+ *
+ * - IMA-ADPCM em WAV (wFormatTag 0x0011): 4 bits/amostra (~4:1), com perda.
+ * - FLAC, blocos fixos, LPC de ordem até 8 e resíduo em Rice: sem perda
+ *   (~1,6–2,2:1 em voz).
+ *
+ * Cada endpoint aceita formatos diferentes (OpenAI só "wav"/"mp3"; gateways
+ * como LiteLLM/Ollama repassam FLAC), por isso o formato vem da configuração
+ * (ai.audio_format). Os codificadores (flac_enc.c, ima_adpcm.c) são C
+ * portável e escrevem em buffer do chamador, inteiros ou um frame/bloco por
+ * vez; audio_codec.c acrescenta alocação, o stream e medição de tempo.
+ * ----------------------------------------------------------------------- */
+
+typedef enum {
+  AUDIO_CODEC_WAV_PCM16 = 0, /* WAV PCM sem compressão (padrão) */
+  AUDIO_CODEC_WAV_IMA_ADPCM,
+  AUDIO_CODEC_FLAC,
+} audio_codec_format_t;
+
+/** Amostras por bloco FLAC (último bloco pode ser menor). */
+#define AUDIO_FLAC_BLOCK_SIZE 4096
+/** Ordem máxima do preditor LPC do FLAC. */
+#define AUDIO_FLAC_MAX_LPC_ORDER 8
+/** Cabeçalho RIFF do IMA-ADPCM: fmt de 20 bytes + chunk fact. */
+#define AUDIO_IMA_ADPCM_HEADER_LEN 60
+/** Cabeçalho RIFF do WAV PCM (fmt de 16 bytes, sem chunks extras). */
+#define AUDIO_WAV_HEADER_LEN 44
+/** "fLaC" + cabeçalho do bloco de metadados + STREAMINFO. */
+#define AUDIO_FLAC_HEADER_LEN 42
+/** Maior frame FLAC de um bloco: VERBATIM + folga da estimativa do Rice. */
+#define AUDIO_FLAC_MAX_FRAME_LEN                                              \
+  (AUDIO_FLAC_BLOCK_SIZE * 2 + AUDIO_FLAC_BLOCK_SIZE / 8 + 64)
+
+/**
+ * @brief Converte o nome da configuração ("wav", "adpcm", "flac").
+ *        Nome vazio ou desconhecido resulta em AUDIO_CODEC_WAV_PCM16.
+ */
+audio_codec_format_t audio_codec_from_name(const char *name);
+
+/** @brief Nome curto do formato (para logs e para a configuração). */
+const char *audio_codec_name(audio_codec_format_t fmt);
+
+/**
+ * @brief Valor de input_audio.format na requisição: "wav" para os dois
+ *        formatos WAV, "flac" para FLAC.
+ */
+const char *audio_codec_api_format(audio_codec_format_t fmt);
+
+/* -----------------------------------------------------------------------
+ * Codificadores (C portável, sem alocação)
+ * ----------------------------------------------------------------------- */
+
+/** @brief Tamanho máximo do FLAC gerado para @p num_samples amostras. */
+size_t audio_flac_max_len(size_t num_samples);
+
+/**
+ * @brief Codifica PCM16 mono em um stream FLAC completo ("fLaC" +
+ *        STREAMINFO + frames).
+ *
+ * @return Bytes escritos em @p out, ou 0 se @p out_cap não bastar ou os
+ *         parâmetros forem inválidos.
+ */
+size_t audio_flac_encode(const int16_t *pcm, size_t num_samples,
+                         uint32_t sample_rate_hz, uint8_t *out,
+                         size_t out_cap);
+
+/**
+ * @brief Escreve "fLaC" + STREAMINFO em @p out (AUDIO_FLAC_HEADER_LEN
+ *        bytes) para um stream de @p num_samples amostras.
+ *
+ * Com @p min_frame / @p max_frame = 0 (tamanhos desconhecidos, permitido
+ * pelo formato) o cabeçalho pode ser escrito antes dos frames.
+ */
+void audio_flac_write_header(uint8_t *out, size_t num_samples,
+                             uint32_t sample_rate_hz, size_t min_frame,
+                             size_t max_frame);
+
+/**
+ * @brief Codifica um frame FLAC de @p n amostras (n <= AUDIO_FLAC_BLOCK_SIZE;
+ *        só o último frame do stream pode ser menor).
+ *
+ * @return Bytes escritos em @p out, ou 0 se @p out_cap não bastar.
+ */
+size_t audio_flac_encode_frame(const int16_t *pcm, size_t n,
+                               uint32_t frame_num, uint32_t sample_rate_hz,
+                               uint8_t *out, size_t out_cap);
+
+/**
+ * @brief Escreve o cabeçalho WAV PCM16 de AUDIO_WAV_HEADER_LEN bytes em
+ *        @p hdr (little-endian, independente do host).
+ *
+ * Usado tanto no envio à API quanto nos arquivos do cartão SD. Com
+ * @p pcm_bytes = UINT32_MAX o tamanho fica indefinido (envio em pipeline,
+ * tamanho só conhecido no fim).
+ */
+void audio_wav_pcm16_header(uint8_t *hdr, uint32_t pcm_bytes,
+                            uint32_t sample_rate_hz, uint16_t channels);
+
+/**
+ * @brief Bytes por bloco IMA-ADPCM usados para a taxa dada
+ *        (256 até 11 kHz, 512 até 22 kHz, 1024 acima).
+ */
+uint16_t audio_ima_adpcm_block_align(uint32_t sample_rate_hz);
+
+/** @brief Tamanho exato do WAV IMA-ADPCM para @p num_samples amostras. */
+size_t audio_ima_adpcm_wav_len(size_t num_samples, uint32_t sample_rate_hz);
+
+/**
+ * @brief Escreve o cabeçalho WAV IMA-ADPCM (AUDIO_IMA_ADPCM_HEADER_LEN
+ *        bytes) de um arquivo com @p num_samples amostras.
+ */
+void audio_ima_adpcm_write_header(uint8_t *hdr, size_t num_samples,
+                                  uint32_t sample_rate_hz);
+
+/**
+ * @brief Codifica um bloco IMA-ADPCM (audio_ima_adpcm_block_align() bytes)
+ *        com até um bloco de amostras; o resto do bloco é completado com
+ *        silêncio.
+ *
+ * @param index Índice do passo, levado de um bloco ao seguinte (0 no início).
+ */
+void audio_ima_adpcm_encode_block(const int16_t *pcm, size_t n,
+                                  uint32_t sample_rate_hz, int *index,
+                                  uint8_t *out);
+
+/** @brief Amostras por bloco IMA-ADPCM para a taxa dada. */
+size_t audio_ima_adpcm_block_samples(uint32_t sample_rate_hz);
+
+/**
+ * @brief Codifica PCM16 mono em um arquivo WAV IMA-ADPCM completo.
+ *
+ * @return Bytes escritos em @p out, ou 0 se @p out_cap não bastar ou os
+ *         parâmetros forem inválidos.
+ */
+size_t audio_ima_adpcm_wav_encode(const int16_t *pcm, size_t num_samples,
+                                  uint32_t sample_rate_hz, uint8_t *out,
+                                  size_t out_cap);
+
+/* -----------------------------------------------------------------------
+ * Interface de alto nível
+ * ----------------------------------------------------------------------- */
+
+/**
+ * @brief Codifica PCM16 mono no formato pedido num buffer novo (PSRAM,
+ *        com fallback para RAM interna) e registra taxa de compressão e
+ *        tempo de codificação por segundo de áudio.
+ *
+ * AUDIO_CODEC_WAV_PCM16 não é tratado aqui: o WAV PCM continua sendo
+ * montado pela app (retorna ESP_ERR_NOT_SUPPORTED).
+ *
+ * @param out     Buffer alocado (liberar com free()).
+ * @param out_len Bytes válidos em @p out.
+ */
+esp_err_t audio_codec_encode(audio_codec_format_t fmt, const int16_t *pcm,
+                             size_t num_samples, uint32_t sample_rate_hz,
+                             uint8_t **out, size_t *out_len);
+
+/* -----------------------------------------------------------------------
+ * Codificação em stream
+ *
+ * Para PCM que não está contíguo (ex.: gravação em segmentos do
+ * audio_pool): as amostras entram em pedaços de qualquer tamanho e os bytes
+ * codificados saem por um callback, um frame/bloco por vez, sem alocação.
+ * O total de amostras é fixado no início. ADPCM sai idêntico a
+ * audio_ima_adpcm_wav_encode(); no FLAC o STREAMINFO vai antes dos frames,
+ * com min/max do tamanho de frame = 0 (desconhecidos).
+ * ----------------------------------------------------------------------- */
+
+/**
+ * @brief Recebe os próximos bytes do stream codificado.
+ * @return false para abortar (ex.: sem espaço no destino).
+ */
+typedef bool (*audio_codec_sink_t)(void *ctx, const uint8_t *data,
+                                   size_t len);
+
+/** @brief Estado do codificador em stream (~17 KB; não colocar na stack). */
+typedef struct {
+  audio_codec_format_t fmt;
+  uint32_t sample_rate_hz;
+  size_t num_samples; /* total declarado no cabeçalho */
+  size_t fed;         /* amostras recebidas até agora */
+  size_t out_len;     /* bytes entregues ao sink */
+  audio_codec_sink_t sink;
+  void *sink_ctx;
+  uint32_t frame_num; /* FLAC */
+  int ima_index;      /* IMA-ADPCM */
+  size_t block_len;   /* amostras por frame/bloco */
+  size_t fill;        /* amostras acumuladas em pcm[] */
+  int64_t encode_us;  /* tempo de codificação (sem o sink) */
+  bool failed;
+  int16_t pcm[AUDIO_FLAC_BLOCK_SIZE];
+  uint8_t frame[AUDIO_FLAC_MAX_FRAME_LEN];
+} audio_codec_stream_t;
+
+/**
+ * @brief Inicia o stream e entrega o cabeçalho ao sink.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED para AUDIO_CODEC_WAV_PCM16,
+ *         ESP_ERR_INVALID_ARG para parâmetros inválidos (FLAC exige ao
+ *         menos 16 amostras), ESP_FAIL se o sink recusar.
+ */
+esp_err_t audio_codec_stream_begin(audio_codec_stream_t *st,
+                                   audio_codec_format_t fmt,
+                                   size_t num_samples, uint32_t sample_rate_hz,
+                                   audio_codec_sink_t sink, void *sink_ctx);
+
+/**
+ * @brief Codifica mais @p n amostras; frames/blocos completos vão ao sink.
+ *
+ * @return ESP_ERR_INVALID_SIZE se passar do total declarado, ESP_FAIL se o
+ *         sink recusar (o stream fica inválido).
+ */
+esp_err_t audio_codec_stream_write(audio_codec_stream_t *st,
+                                   const int16_t *pcm, size_t n);
+
+/**
+ * @brief Codifica o último frame/bloco e registra taxa e tempo, como
+ *        audio_codec_encode().
+ *
+ * @param out_len Total de bytes entregues ao sink (pode ser NULL).
+ * @return ESP_ERR_INVALID_STATE se faltarem amostras do total declarado.
+ */
+esp_err_t audio_codec_stream_end(audio_codec_stream_t *st, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,233 @@
+#include "audio_codec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "audio_codec";
+
+audio_codec_format_t audio_codec_from_name(const char *name) {
+  if (name) {
+    if (strcmp(name, "flac") == 0) {
+      return AUDIO_CODEC_FLAC;
+    }
+    if (strcmp(name, "adpcm") == 0 || strcmp(name, "ima_adpcm") == 0) {
+      return AUDIO_CODEC_WAV_IMA_ADPCM;
+    }
+  }
+  return AUDIO_CODEC_WAV_PCM16;
+}
+
+const char *audio_codec_name(audio_codec_format_t fmt) {
+  switch (fmt) {
+  case AUDIO_CODEC_WAV_IMA_ADPCM:
+    return "adpcm";
+  case AUDIO_CODEC_FLAC:
+    return "flac";
+  default:
+    return "wav";
+  }
+}
+
+const char *audio_codec_api_format(audio_codec_format_t fmt) {
+  return (fmt == AUDIO_CODEC_FLAC) ? "flac" : "wav";
+}
+
+/* Razao em relacao ao WAV PCM16 equivalente; tempo normalizado por segundo
+ * de audio para comparar taxas e duracoes diferentes. */
+static void audio_codec_log(audio_codec_format_t fmt, size_t num_samples,
+                            uint32_t sample_rate_hz, size_t len,
+                            int64_t elapsed_us) {
+  const size_t pcm_wav_len =
+      AUDIO_WAV_HEADER_LEN + num_samples * sizeof(int16_t);
+  const uint32_t audio_ms =
+      (uint32_t)(((uint64_t)num_samples * 1000U) / sample_rate_hz);
+  ESP_LOGI(TAG,
+           "%s: %u -> %u bytes (%.2f:1), %u ms of audio in %u ms "
+           "(%u ms per s)",
+           audio_codec_name(fmt), (unsigned)pcm_wav_len, (unsigned)len,
+           (double)pcm_wav_len / (double)len, (unsigned)audio_ms,
+           (unsigned)(elapsed_us / 1000),
+           audio_ms ? (unsigned)((elapsed_us / audio_ms)) : 0U);
+}
+
+esp_err_t audio_codec_encode(audio_codec_format_t fmt, const int16_t *pcm,
+                             size_t num_samples, uint32_t sample_rate_hz,
+                             uint8_t **out, size_t *out_len) {
+  if (!pcm || !out || !out_len || num_samples == 0 || sample_rate_hz == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  size_t cap;
+  switch (fmt) {
+  case AUDIO_CODEC_WAV_IMA_ADPCM:
+    cap = audio_ima_adpcm_wav_len(num_samples, sample_rate_hz);
+    break;
+  case AUDIO_CODEC_FLAC:
+    cap = audio_flac_max_len(num_samples);
+    break;
+  default:
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+
+  uint8_t *buf = heap_caps_malloc(cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) {
+    buf = heap_caps_malloc(cap, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+  if (!buf) {
+    ESP_LOGE(TAG, "no memory for %s output (%u bytes)", audio_codec_name(fmt),
+             (unsigned)cap);
+    return ESP_ERR_NO_MEM;
+  }
+
+  const int64_t t0 = esp_timer_get_time();
+  const size_t len =
+      (fmt == AUDIO_CODEC_FLAC)
+          ? audio_flac_encode(pcm, num_samples, sample_rate_hz, buf, cap)
+          : audio_ima_adpcm_wav_encode(pcm, num_samples, sample_rate_hz, buf,
+                                       cap);
+  const int64_t elapsed_us = esp_timer_get_time() - t0;
+  if (len == 0) {
+    ESP_LOGE(TAG, "%s encode failed", audio_codec_name(fmt));
+    free(buf);
+    return ESP_FAIL;
+  }
+
+  audio_codec_log(fmt, num_samples, sample_rate_hz, len, elapsed_us);
+
+  *out = buf;
+  *out_len = len;
+  return ESP_OK;
+}
+
+/* -----------------------------------------------------------------------
+ * Stream
+ * ----------------------------------------------------------------------- */
+
+static bool audio_stream_emit(audio_codec_stream_t *st, const uint8_t *data,
+                              size_t len) {
+  if (!st->sink(st->sink_ctx, data, len)) {
+    st->failed = true;
+    return false;
+  }
+  st->out_len += len;
+  return true;
+}
+
+/* Codifica as st->fill amostras acumuladas como um frame/bloco. */
+static bool audio_stream_flush_block(audio_codec_stream_t *st) {
+  const int64_t t0 = esp_timer_get_time();
+  size_t len;
+  if (st->fmt == AUDIO_CODEC_FLAC) {
+    len = audio_flac_encode_frame(st->pcm, st->fill, st->frame_num++,
+                                  st->sample_rate_hz, st->frame,
+                                  sizeof(st->frame));
+  } else {
+    audio_ima_adpcm_encode_block(st->pcm, st->fill, st->sample_rate_hz,
+                                 &st->ima_index, st->frame);
+    len = audio_ima_adpcm_block_align(st->sample_rate_hz);
+  }
+  st->encode_us += esp_timer_get_time() - t0;
+  st->fill = 0;
+  if (len == 0) {
+    st->failed = true;
+    return false;
+  }
+  return audio_stream_emit(st, st->frame, len);
+}
+
+esp_err_t audio_codec_stream_begin(audio_codec_stream_t *st,
+                                   audio_codec_format_t fmt,
+                                   size_t num_samples, uint32_t sample_rate_hz,
+                                   audio_codec_sink_t sink, void *sink_ctx) {
+  if (!st || !sink || num_samples == 0 || sample_rate_hz == 0 ||
+      num_samples > UINT32_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (fmt != AUDIO_CODEC_FLAC && fmt != AUDIO_CODEC_WAV_IMA_ADPCM) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  if (fmt == AUDIO_CODEC_FLAC &&
+      (num_samples < 16 || sample_rate_hz >= (1U << 20))) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  st->fmt = fmt;
+  st->sample_rate_hz = sample_rate_hz;
+  st->num_samples = num_samples;
+  st->fed = 0;
+  st->out_len = 0;
+  st->sink = sink;
+  st->sink_ctx = sink_ctx;
+  st->frame_num = 0;
+  st->ima_index = 0;
+  st->fill = 0;
+  st->encode_us = 0;
+  st->failed = false;
+
+  size_t hdr_len;
+  if (fmt == AUDIO_CODEC_FLAC) {
+    st->block_len = AUDIO_FLAC_BLOCK_SIZE;
+    audio_flac_write_header(st->frame, num_samples, sample_rate_hz, 0, 0);
+    hdr_len = AUDIO_FLAC_HEADER_LEN;
+  } else {
+    st->block_len = audio_ima_adpcm_block_samples(sample_rate_hz);
+    audio_ima_adpcm_write_header(st->frame, num_samples, sample_rate_hz);
+    hdr_len = AUDIO_IMA_ADPCM_HEADER_LEN;
+  }
+  return audio_stream_emit(st, st->frame, hdr_len) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t audio_codec_stream_write(audio_codec_stream_t *st,
+                                   const int16_t *pcm, size_t n) {
+  if (!st || (!pcm && n > 0)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (st->failed) {
+    return ESP_FAIL;
+  }
+  if (n > st->num_samples - st->fed) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  st->fed += n;
+  while (n > 0) {
+    size_t take = st->block_len - st->fill;
+    if (take > n) {
+      take = n;
+    }
+    memcpy(st->pcm + st->fill, pcm, take * sizeof(int16_t));
+    st->fill += take;
+    pcm += take;
+    n -= take;
+    /* o ultimo bloco fica para o stream_end (pode ser curto) */
+    if (st->fill == st->block_len && (n > 0 || st->fed < st->num_samples) &&
+        !audio_stream_flush_block(st)) {
+      return ESP_FAIL;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t audio_codec_stream_end(audio_codec_stream_t *st, size_t *out_len) {
+  if (!st) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (st->failed) {
+    return ESP_FAIL;
+  }
+  if (st->fed != st->num_samples) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (st->fill > 0 && !audio_stream_flush_block(st)) {
+    return ESP_FAIL;
+  }
+  audio_codec_log(st->fmt, st->num_samples, st->sample_rate_hz, st->out_len,
+                  st->encode_us);
+  if (out_len) {
+    *out_len = st->out_len;
+  }
+  return ESP_OK;
+}
@@ -0,0 +1,588 @@
+#include "audio_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+/* -----------------------------------------------------------------------
+ * Codificador FLAC (mono, 16 bits, blocos fixos)
+ *
+ * Para cada bloco sao avaliados os preditores FIXED de ordem 0..4 e LPC de
+ * ordem 1..AUDIO_FLAC_MAX_LPC_ORDER (autocorrelacao com janela de Welch +
+ * Levinson-Durbin, coeficientes quantizados em 12 bits). O custo de cada
+ * candidato e estimado pelo residuo em Rice com particionamento otimo; o
+ * mais barato (ou VERBATIM/CONSTANT) e escrito. O residuo e recalculado na
+ * escrita, assim o codificador nao precisa de buffers de trabalho: alem do
+ * buffer de saida usa ~1,5 KB de stack.
+ *
+ * O MD5 do STREAMINFO fica zerado ("nao calculado"), o que o formato
+ * permite.
+ * ----------------------------------------------------------------------- */
+
+#define FLAC_BPS 16
+#define FLAC_QLP_PRECISION 12
+#define FLAC_MAX_FIXED_ORDER 4
+#define FLAC_MAX_PARTITION_ORDER 6
+#define FLAC_MAX_RICE_PARAM 14 /* 15 = escape (nao usado) */
+#define FLAC_STREAMINFO_OFFSET 8
+
+/* -----------------------------------------------------------------------
+ * Escrita de bits (MSB primeiro)
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint8_t *buf;
+  size_t cap;
+  size_t pos; /* bytes completos escritos */
+  uint64_t acc;
+  unsigned nbits; /* bits pendentes em acc (< 8 entre chamadas) */
+  bool overflow;
+} flac_bw_t;
+
+static void flac_bw_put(flac_bw_t *bw, uint32_t val, unsigned bits) {
+  if (bits == 0) {
+    return;
+  }
+  if (bits < 32) {
+    val &= (1U << bits) - 1U;
+  }
+  bw->acc = (bw->acc << bits) | val;
+  bw->nbits += bits;
+  while (bw->nbits >= 8) {
+    bw->nbits -= 8;
+    if (bw->pos < bw->cap) {
+      bw->buf[bw->pos++] = (uint8_t)(bw->acc >> bw->nbits);
+    } else {
+      bw->overflow = true;
+    }
+  }
+  bw->acc &= (1U << bw->nbits) - 1U;
+}
+
+static void flac_bw_put_signed(flac_bw_t *bw, int32_t val, unsigned bits) {
+  flac_bw_put(bw, (uint32_t)val, bits);
+}
+
+static void flac_bw_put_rice(flac_bw_t *bw, uint32_t u, unsigned k) {
+  uint32_t q = u >> k;
+  while (q >= 24) {
+    flac_bw_put(bw, 0, 24);
+    q -= 24;
+  }
+  flac_bw_put(bw, 1, q + 1); /* q zeros e o bit de parada */
+  flac_bw_put(bw, u, k);
+}
+
+static void flac_bw_align(flac_bw_t *bw) {
+  if (bw->nbits) {
+    flac_bw_put(bw, 0, 8 - bw->nbits);
+  }
+}
+
+/* Numero de frame no formato "UTF-8" do FLAC. */
+static void flac_bw_put_utf8(flac_bw_t *bw, uint32_t v) {
+  if (v < 0x80) {
+    flac_bw_put(bw, v, 8);
+    return;
+  }
+  unsigned extra = (v < 0x800)       ? 1
+                   : (v < 0x10000)   ? 2
+                   : (v < 0x200000)  ? 3
+                   : (v < 0x4000000) ? 4
+                                     : 5;
+  const uint32_t lead_mask = (0xFF00U >> (extra + 1)) & 0xFFU;
+  flac_bw_put(bw, lead_mask | (v >> (6 * extra)), 8);
+  while (extra--) {
+    flac_bw_put(bw, 0x80 | ((v >> (6 * extra)) & 0x3F), 8);
+  }
+}
+
+static uint8_t flac_crc8(const uint8_t *p, size_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint16_t flac_crc16(const uint8_t *p, size_t len) {
+  uint16_t crc = 0;
+  while (len--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005)
+                           : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/* -----------------------------------------------------------------------
+ * Preditores
+ * ----------------------------------------------------------------------- */
+
+typedef enum {
+  FLAC_PRED_FIXED,
+  FLAC_PRED_LPC,
+} flac_pred_kind_t;
+
+typedef struct {
+  flac_pred_kind_t kind;
+  unsigned order;
+  int32_t qlp[AUDIO_FLAC_MAX_LPC_ORDER];
+  int shift;
+} flac_pred_t;
+
+static int32_t flac_residual(const flac_pred_t *pred, const int16_t *x,
+                             size_t i) {
+  if (pred->kind == FLAC_PRED_FIXED) {
+    switch (pred->order) {
+    case 0:
+      return x[i];
+    case 1:
+      return x[i] - x[i - 1];
+    case 2:
+      return x[i] - 2 * x[i - 1] + x[i - 2];
+    case 3:
+      return x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+    default:
+      return x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+    }
+  }
+  /* |qlp| < 2^11 e |x| <= 2^15: com ordem <= 8 a soma cabe em 2^29 */
+  int32_t sum = 0;
+  for (unsigned j = 0; j < pred->order; j++) {
+    sum += pred->qlp[j] * x[i - j - 1];
+  }
+  return x[i] - (sum >> pred->shift);
+}
+
+static uint32_t flac_zigzag(int32_t r) {
+  return (r >= 0) ? ((uint32_t)r << 1) : (((uint32_t)(-(r + 1)) << 1) | 1U);
+}
+
+/* Particionamento do residuo escolhido para um preditor. */
+typedef struct {
+  unsigned porder;
+  uint8_t rice[1U << FLAC_MAX_PARTITION_ORDER];
+  uint64_t bits; /* custo estimado do residuo */
+} flac_rice_plan_t;
+
+static unsigned flac_best_rice(uint64_t sum, size_t n, uint64_t *bits) {
+  unsigned k = 0;
+  uint64_t best = (uint64_t)n + sum;
+  while (k < FLAC_MAX_RICE_PARAM) {
+    const uint64_t next = (uint64_t)n * (k + 2) + (sum >> (k + 1));
+    if (next >= best) {
+      break;
+    }
+    best = next;
+    k++;
+  }
+  *bits = best;
+  return k;
+}
+
+static unsigned flac_max_porder(size_t n, unsigned order) {
+  unsigned p = 0;
+  while (p < FLAC_MAX_PARTITION_ORDER && ((n >> (p + 1)) << (p + 1)) == n &&
+         (n >> (p + 1)) > order) {
+    p++;
+  }
+  return p;
+}
+
+/* Soma dos valores zigzag por particao na ordem mais fina, depois junta as
+ * particoes duas a duas para avaliar as ordens menores. */
+static void flac_plan_residual(const flac_pred_t *pred, const int16_t *x,
+                               size_t n, flac_rice_plan_t *plan) {
+  uint64_t sums[1U << FLAC_MAX_PARTITION_ORDER];
+  const unsigned max_p = flac_max_porder(n, pred->order);
+  const size_t parts = (size_t)1U << max_p;
+  const size_t psize = n >> max_p;
+
+  for (size_t p = 0; p < parts; p++) {
+    const size_t start = (p == 0) ? pred->order : p * psize;
+    const size_t end = (p + 1) * psize;
+    uint64_t s = 0;
+    for (size_t i = start; i < end; i++) {
+      s += flac_zigzag(flac_residual(pred, x, i));
+    }
+    sums[p] = s;
+  }
+
+  plan->bits = UINT64_MAX;
+  for (int porder = (int)max_p; porder >= 0; porder--) {
+    const size_t cur_parts = (size_t)1U << porder;
+    const size_t cur_size = n >> porder;
+    uint64_t total = 0;
+    uint8_t rice[1U << FLAC_MAX_PARTITION_ORDER];
+    for (size_t p = 0; p < cur_parts; p++) {
+      const size_t count = (p == 0) ? cur_size - pred->order : cur_size;
+      uint64_t bits = 0;
+      rice[p] = (uint8_t)flac_best_rice(sums[p], count, &bits);
+      total += 4 + bits;
+    }
+    if (total < plan->bits) {
+      plan->bits = total;
+      plan->porder = (unsigned)porder;
+      memcpy(plan->rice, rice, cur_parts);
+    }
+    /* Junta pares para a proxima ordem (menor) */
+    for (size_t p = 0; p < cur_parts / 2; p++) {
+      sums[p] = sums[2 * p] + sums[2 * p + 1];
+    }
+  }
+  plan->bits += 2 + 4; /* metodo + ordem de particao */
+}
+
+/* Autocorrelacao com janela de Welch e Levinson-Durbin: lpc[o-1][0..o-1]
+ * recebe os coeficientes da ordem o. Retorna a maior ordem valida. */
+static unsigned flac_compute_lpc(const int16_t *x, size_t n, unsigned max_order,
+                                 float lpc[][AUDIO_FLAC_MAX_LPC_ORDER]) {
+  /* Acumulacao em float (FPU do ESP32); so o Levinson usa double. */
+  float r[AUDIO_FLAC_MAX_LPC_ORDER + 1] = {0};
+  float hist[AUDIO_FLAC_MAX_LPC_ORDER + 1] = {0};
+  const float c = (float)(n - 1) / 2.0f;
+  for (size_t i = 0; i < n; i++) {
+    const float t = ((float)i - c) / (c + 1.0f);
+    const float wx = (float)x[i] * (1.0f - t * t);
+    memmove(hist + 1, hist, max_order * sizeof(float));
+    hist[0] = wx;
+    for (unsigned lag = 0; lag <= max_order && lag <= i; lag++) {
+      r[lag] += wx * hist[lag];
+    }
+  }
+  if (r[0] <= 0.0f) {
+    return 0;
+  }
+
+  double a[AUDIO_FLAC_MAX_LPC_ORDER] = {0};
+  double err = r[0];
+  unsigned order;
+  for (order = 0; order < max_order; order++) {
+    double acc = r[order + 1];
+    for (unsigned j = 0; j < order; j++) {
+      acc -= a[j] * r[order - j];
+    }
+    const double k = acc / err;
+    double tmp[AUDIO_FLAC_MAX_LPC_ORDER];
+    for (unsigned j = 0; j < order; j++) {
+      tmp[j] = a[j] - k * a[order - 1 - j];
+    }
+    memcpy(a, tmp, order * sizeof(double));
+    a[order] = k;
+    err *= (1.0 - k * k);
+    for (unsigned j = 0; j <= order; j++) {
+      lpc[order][j] = (float)a[j];
+    }
+    if (err <= 0.0) {
+      return order + 1;
+    }
+  }
+  return order;
+}
+
+static bool flac_quantize_lpc(const float *coefs, unsigned order,
+                              flac_pred_t *pred) {
+  float cmax = 0.0f;
+  for (unsigned j = 0; j < order; j++) {
+    const float v = fabsf(coefs[j]);
+    if (v > cmax) {
+      cmax = v;
+    }
+  }
+  if (cmax <= 0.0f) {
+    return false;
+  }
+
+  int exp2 = 0;
+  frexpf(cmax, &exp2);
+  int shift = FLAC_QLP_PRECISION - exp2 - 1;
+  if (shift > 15) {
+    shift = 15;
+  } else if (shift < 0) {
+    return false;
+  }
+
+  const int32_t qmax = (1 << (FLAC_QLP_PRECISION - 1)) - 1;
+  const int32_t qmin = -(1 << (FLAC_QLP_PRECISION - 1));
+  float err = 0.0f;
+  for (unsigned j = 0; j < order; j++) {
+    err += coefs[j] * (float)(1 << shift);
+    int32_t q = (int32_t)lroundf(err);
+    if (q > qmax) {
+      q = qmax;
+    } else if (q < qmin) {
+      q = qmin;
+    }
+    err -= (float)q;
+    pred->qlp[j] = q;
+  }
+  pred->kind = FLAC_PRED_LPC;
+  pred->order = order;
+  pred->shift = shift;
+  return true;
+}
+
+static uint64_t flac_pred_header_bits(const flac_pred_t *pred) {
+  uint64_t bits = 8 + (uint64_t)pred->order * FLAC_BPS;
+  if (pred->kind == FLAC_PRED_LPC) {
+    bits += 4 + 5 + (uint64_t)pred->order * FLAC_QLP_PRECISION;
+  }
+  return bits;
+}
+
+/* -----------------------------------------------------------------------
+ * Frames
+ * ----------------------------------------------------------------------- */
+
+static unsigned flac_sample_rate_code(uint32_t rate) {
+  switch (rate) {
+  case 88200:
+    return 1;
+  case 176400:
+    return 2;
+  case 192000:
+    return 3;
+  case 8000:
+    return 4;
+  case 16000:
+    return 5;
+  case 22050:
+    return 6;
+  case 24000:
+    return 7;
+  case 32000:
+    return 8;
+  case 44100:
+    return 9;
+  case 48000:
+    return 10;
+  case 96000:
+    return 11;
+  default:
+    return 0; /* taxa lida do STREAMINFO */
+  }
+}
+
+static void flac_write_subframe(flac_bw_t *bw, const int16_t *x, size_t n) {
+  bool constant = true;
+  for (size_t i = 1; i < n && constant; i++) {
+    constant = (x[i] == x[0]);
+  }
+  if (constant) {
+    flac_bw_put(bw, 0x00, 8); /* CONSTANT */
+    flac_bw_put_signed(bw, x[0], FLAC_BPS);
+    return;
+  }
+
+  flac_pred_t best = {0};
+  flac_rice_plan_t best_plan = {0};
+  uint64_t best_bits = 8 + (uint64_t)n * FLAC_BPS; /* VERBATIM */
+  bool have_best = false;
+
+  flac_pred_t pred = {0};
+  flac_rice_plan_t plan;
+  for (unsigned order = 0; order <= FLAC_MAX_FIXED_ORDER && order < n;
+       order++) {
+    pred.kind = FLAC_PRED_FIXED;
+    pred.order = order;
+    flac_plan_residual(&pred, x, n, &plan);
+    const uint64_t bits = flac_pred_header_bits(&pred) + plan.bits;
+    if (bits < best_bits) {
+      best_bits = bits;
+      best = pred;
+      best_plan = plan;
+      have_best = true;
+    }
+  }
+
+  unsigned max_lpc = AUDIO_FLAC_MAX_LPC_ORDER;
+  if (max_lpc >= n) {
+    max_lpc = (unsigned)(n - 1);
+  }
+  float lpc[AUDIO_FLAC_MAX_LPC_ORDER][AUDIO_FLAC_MAX_LPC_ORDER];
+  const unsigned lpc_orders = flac_compute_lpc(x, n, max_lpc, lpc);
+  for (unsigned order = 1; order <= lpc_orders; order++) {
+    if (!flac_quantize_lpc(lpc[order - 1], order, &pred)) {
+      continue;
+    }
+    flac_plan_residual(&pred, x, n, &plan);
+    const uint64_t bits = flac_pred_header_bits(&pred) + plan.bits;
+    if (bits < best_bits) {
+      best_bits = bits;
+      best = pred;
+      best_plan = plan;
+      have_best = true;
+    }
+  }
+
+  if (!have_best) {
+    flac_bw_put(bw, 0x02, 8); /* VERBATIM */
+    for (size_t i = 0; i < n; i++) {
+      flac_bw_put_signed(bw, x[i], FLAC_BPS);
+    }
+    return;
+  }
+
+  if (best.kind == FLAC_PRED_FIXED) {
+    flac_bw_put(bw, (0x08 | best.order) << 1, 8);
+  } else {
+    flac_bw_put(bw, (0x20 | (best.order - 1)) << 1, 8);
+  }
+  for (unsigned i = 0; i < best.order; i++) {
+    flac_bw_put_signed(bw, x[i], FLAC_BPS);
+  }
+  if (best.kind == FLAC_PRED_LPC) {
+    flac_bw_put(bw, FLAC_QLP_PRECISION - 1, 4);
+    flac_bw_put_signed(bw, best.shift, 5);
+    for (unsigned j = 0; j < best.order; j++) {
+      flac_bw_put_signed(bw, best.qlp[j], FLAC_QLP_PRECISION);
+    }
+  }
+
+  flac_bw_put(bw, 0, 2); /* Rice com parametro de 4 bits */
+  flac_bw_put(bw, best_plan.porder, 4);
+  const size_t parts = (size_t)1U << best_plan.porder;
+  const size_t psize = n >> best_plan.porder;
+  for (size_t p = 0; p < parts; p++) {
+    const unsigned k = best_plan.rice[p];
+    flac_bw_put(bw, k, 4);
+    const size_t start = (p == 0) ? best.order : p * psize;
+    const size_t end = (p + 1) * psize;
+    for (size_t i = start; i < end; i++) {
+      flac_bw_put_rice(bw, flac_zigzag(flac_residual(&best, x, i)), k);
+    }
+  }
+}
+
+static size_t flac_write_frame(flac_bw_t *bw, const int16_t *x, size_t n,
+                               uint32_t frame_num, uint32_t sample_rate_hz) {
+  const size_t start = bw->pos;
+
+  unsigned bs_code;
+  if (n == AUDIO_FLAC_BLOCK_SIZE) {
+    bs_code = 12; /* 256 * 2^(12 - 8) = 4096 */
+  } else if (n <= 256) {
+    bs_code = 6; /* (n - 1) em 8 bits no fim do cabecalho */
+  } else {
+    bs_code = 7; /* (n - 1) em 16 bits */
+  }
+
+  flac_bw_put(bw, 0xFFF8, 16); /* sync + blocos fixos */
+  flac_bw_put(bw, bs_code, 4);
+  flac_bw_put(bw, flac_sample_rate_code(sample_rate_hz), 4);
+  flac_bw_put(bw, 0, 4); /* mono */
+  flac_bw_put(bw, 4, 3); /* 16 bits por amostra */
+  flac_bw_put(bw, 0, 1);
+  flac_bw_put_utf8(bw, frame_num);
+  if (bs_code == 6) {
+    flac_bw_put(bw, (uint32_t)(n - 1), 8);
+  } else if (bs_code == 7) {
+    flac_bw_put(bw, (uint32_t)(n - 1), 16);
+  }
+  if (bw->overflow) {
+    return 0;
+  }
+  flac_bw_put(bw, flac_crc8(bw->buf + start, bw->pos - start), 8);
+
+  flac_write_subframe(bw, x, n);
+  flac_bw_align(bw);
+  if (bw->overflow) {
+    return 0;
+  }
+  const uint16_t crc = flac_crc16(bw->buf + start, bw->pos - start);
+  flac_bw_put(bw, crc, 16);
+  return bw->overflow ? 0 : bw->pos - start;
+}
+
+/* -----------------------------------------------------------------------
+ * Stream
+ * ----------------------------------------------------------------------- */
+
+static void flac_put_be(uint8_t *p, uint64_t v, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; i++) {
+    p[i] = (uint8_t)(v >> (8 * (bytes - 1 - i)));
+  }
+}
+
+size_t audio_flac_max_len(size_t num_samples) {
+  const size_t blocks =
+      (num_samples + AUDIO_FLAC_BLOCK_SIZE - 1) / AUDIO_FLAC_BLOCK_SIZE;
+  return AUDIO_FLAC_HEADER_LEN + blocks * AUDIO_FLAC_MAX_FRAME_LEN;
+}
+
+void audio_flac_write_header(uint8_t *out, size_t num_samples,
+                             uint32_t sample_rate_hz, size_t min_frame,
+                             size_t max_frame) {
+  memcpy(out, "fLaC", 4);
+  out[4] = 0x80; /* ultimo bloco de metadados, tipo STREAMINFO */
+  flac_put_be(out + 5, 34, 3);
+
+  const size_t block =
+      (num_samples < AUDIO_FLAC_BLOCK_SIZE) ? num_samples
+                                            : AUDIO_FLAC_BLOCK_SIZE;
+  uint8_t *si = out + FLAC_STREAMINFO_OFFSET;
+  flac_put_be(si + 0, block, 2);
+  flac_put_be(si + 2, block, 2);
+  flac_put_be(si + 4, min_frame, 3);
+  flac_put_be(si + 7, max_frame, 3);
+  /* taxa (20 bits), canais - 1 (3 bits, mono = 0), bits - 1 (5 bits),
+   * total de amostras (36 bits) */
+  const uint64_t packed = ((uint64_t)sample_rate_hz << 44) |
+                          ((uint64_t)(FLAC_BPS - 1) << 36) |
+                          ((uint64_t)num_samples & 0xFFFFFFFFFULL);
+  flac_put_be(si + 10, packed, 8);
+  memset(si + 18, 0, 16); /* MD5 zerado */
+}
+
+size_t audio_flac_encode_frame(const int16_t *pcm, size_t n,
+                               uint32_t frame_num, uint32_t sample_rate_hz,
+                               uint8_t *out, size_t out_cap) {
+  if (!pcm || !out || n == 0 || n > AUDIO_FLAC_BLOCK_SIZE) {
+    return 0;
+  }
+  flac_bw_t bw = {.buf = out, .cap = out_cap, .pos = 0, .overflow = false};
+  return flac_write_frame(&bw, pcm, n, frame_num, sample_rate_hz);
+}
+
+size_t audio_flac_encode(const int16_t *pcm, size_t num_samples,
+                         uint32_t sample_rate_hz, uint8_t *out,
+                         size_t out_cap) {
+  if (!pcm || !out || num_samples < 16 || sample_rate_hz == 0 ||
+      sample_rate_hz >= (1U << 20) || out_cap < AUDIO_FLAC_HEADER_LEN) {
+    return 0;
+  }
+
+  flac_bw_t bw = {.buf = out,
+                  .cap = out_cap,
+                  .pos = AUDIO_FLAC_HEADER_LEN,
+                  .overflow = false};
+  size_t min_frame = SIZE_MAX;
+  size_t max_frame = 0;
+  uint32_t frame_num = 0;
+  for (size_t pos = 0; pos < num_samples; pos += AUDIO_FLAC_BLOCK_SIZE) {
+    size_t n = num_samples - pos;
+    if (n > AUDIO_FLAC_BLOCK_SIZE) {
+      n = AUDIO_FLAC_BLOCK_SIZE;
+    }
+    const size_t frame_len =
+        flac_write_frame(&bw, pcm + pos, n, frame_num++, sample_rate_hz);
+    if (frame_len == 0) {
+      return 0;
+    }
+    if (frame_len < min_frame) {
+      min_frame = frame_len;
+    }
+    if (frame_len > max_frame) {
+      max_frame = frame_len;
+    }
+  }
+
+  audio_flac_write_header(out, num_samples, sample_rate_hz, min_frame,
+                          max_frame);
+  return bw.pos;
+}
@@ -0,0 +1,183 @@
+#include "audio_codec.h"
+
+#include <string.h>
+
+/* -----------------------------------------------------------------------
+ * IMA-ADPCM (DVI) em WAV
+ *
+ * Blocos independentes de block_align bytes: cabecalho de 4 bytes (amostra
+ * inicial e indice do passo) seguido de (block_align - 4) * 2 amostras de 4
+ * bits, nibble baixo primeiro. O ultimo bloco e completado com silencio; o
+ * chunk "fact" informa o numero real de amostras.
+ * ----------------------------------------------------------------------- */
+
+static const int16_t k_ima_step[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const int8_t k_ima_index_adj[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static void ima_put_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void ima_put_le32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)((v >> 8) & 0xFF);
+  p[2] = (uint8_t)((v >> 16) & 0xFF);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static size_t ima_samples_per_block(uint16_t block_align) {
+  return (size_t)(block_align - 4) * 2 + 1;
+}
+
+/* Codifica uma amostra e atualiza o estado exatamente como o decodificador. */
+static uint8_t ima_encode_sample(int32_t sample, int32_t *predictor,
+                                 int *index) {
+  const int32_t step = k_ima_step[*index];
+  int32_t diff = sample - *predictor;
+  uint8_t code = 0;
+  if (diff < 0) {
+    code = 8;
+    diff = -diff;
+  }
+
+  int32_t delta = step >> 3;
+  if (diff >= step) {
+    code |= 4;
+    diff -= step;
+    delta += step;
+  }
+  if (diff >= (step >> 1)) {
+    code |= 2;
+    diff -= step >> 1;
+    delta += step >> 1;
+  }
+  if (diff >= (step >> 2)) {
+    code |= 1;
+    delta += step >> 2;
+  }
+
+  int32_t pred = *predictor + ((code & 8) ? -delta : delta);
+  if (pred > 32767) {
+    pred = 32767;
+  } else if (pred < -32768) {
+    pred = -32768;
+  }
+  *predictor = pred;
+
+  int next = *index + k_ima_index_adj[code & 7];
+  if (next < 0) {
+    next = 0;
+  } else if (next > 88) {
+    next = 88;
+  }
+  *index = next;
+  return code;
+}
+
+uint16_t audio_ima_adpcm_block_align(uint32_t sample_rate_hz) {
+  if (sample_rate_hz <= 11025) {
+    return 256;
+  }
+  if (sample_rate_hz <= 22050) {
+    return 512;
+  }
+  return 1024;
+}
+
+size_t audio_ima_adpcm_block_samples(uint32_t sample_rate_hz) {
+  return ima_samples_per_block(audio_ima_adpcm_block_align(sample_rate_hz));
+}
+
+size_t audio_ima_adpcm_wav_len(size_t num_samples, uint32_t sample_rate_hz) {
+  const uint16_t block_align = audio_ima_adpcm_block_align(sample_rate_hz);
+  const size_t spb = ima_samples_per_block(block_align);
+  const size_t blocks = (num_samples + spb - 1) / spb;
+  return AUDIO_IMA_ADPCM_HEADER_LEN + blocks * block_align;
+}
+
+void audio_ima_adpcm_write_header(uint8_t *hdr, size_t num_samples,
+                                  uint32_t sample_rate_hz) {
+  const size_t total = audio_ima_adpcm_wav_len(num_samples, sample_rate_hz);
+  const uint16_t block_align = audio_ima_adpcm_block_align(sample_rate_hz);
+  const size_t spb = ima_samples_per_block(block_align);
+  const uint32_t data_len = (uint32_t)(total - AUDIO_IMA_ADPCM_HEADER_LEN);
+  const uint32_t byte_rate =
+      (uint32_t)(((uint64_t)sample_rate_hz * block_align) / spb);
+
+  uint8_t *h = hdr;
+  memcpy(h + 0, "RIFF", 4);
+  ima_put_le32(h + 4, (uint32_t)(total - 8));
+  memcpy(h + 8, "WAVE", 4);
+  memcpy(h + 12, "fmt ", 4);
+  ima_put_le32(h + 16, 20);
+  ima_put_le16(h + 20, 0x0011); /* WAVE_FORMAT_IMA_ADPCM */
+  ima_put_le16(h + 22, 1);      /* mono */
+  ima_put_le32(h + 24, sample_rate_hz);
+  ima_put_le32(h + 28, byte_rate);
+  ima_put_le16(h + 32, block_align);
+  ima_put_le16(h + 34, 4); /* bits por amostra */
+  ima_put_le16(h + 36, 2); /* cbSize */
+  ima_put_le16(h + 38, (uint16_t)spb);
+  memcpy(h + 40, "fact", 4);
+  ima_put_le32(h + 44, 4);
+  ima_put_le32(h + 48, (uint32_t)num_samples);
+  memcpy(h + 52, "data", 4);
+  ima_put_le32(h + 56, data_len);
+}
+
+void audio_ima_adpcm_encode_block(const int16_t *pcm, size_t n,
+                                  uint32_t sample_rate_hz, int *index,
+                                  uint8_t *out) {
+  const size_t spb = audio_ima_adpcm_block_samples(sample_rate_hz);
+  /* Cabecalho do bloco: a primeira amostra vai sem codificar. O indice do
+   * passo continua do bloco anterior. */
+  int32_t predictor = pcm[0];
+  ima_put_le16(out, (uint16_t)(int16_t)predictor);
+  out[2] = (uint8_t)*index;
+  out[3] = 0;
+  uint8_t *nib = out + 4;
+  for (size_t i = 1; i < spb; i += 2) {
+    const int32_t sa = (i < n) ? pcm[i] : predictor;
+    const uint8_t lo = ima_encode_sample(sa, &predictor, index);
+    const int32_t sb = (i + 1 < n) ? pcm[i + 1] : predictor;
+    const uint8_t hi = ima_encode_sample(sb, &predictor, index);
+    *nib++ = (uint8_t)(lo | (hi << 4));
+  }
+}
+
+size_t audio_ima_adpcm_wav_encode(const int16_t *pcm, size_t num_samples,
+                                  uint32_t sample_rate_hz, uint8_t *out,
+                                  size_t out_cap) {
+  if (!pcm || !out || sample_rate_hz == 0 || num_samples == 0 ||
+      num_samples > UINT32_MAX) {
+    return 0;
+  }
+  const size_t total = audio_ima_adpcm_wav_len(num_samples, sample_rate_hz);
+  if (total > out_cap || total > UINT32_MAX) {
+    return 0;
+  }
+
+  audio_ima_adpcm_write_header(out, num_samples, sample_rate_hz);
+
+  const uint16_t block_align = audio_ima_adpcm_block_align(sample_rate_hz);
+  const size_t spb = ima_samples_per_block(block_align);
+  uint8_t *dst = out + AUDIO_IMA_ADPCM_HEADER_LEN;
+  int index = 0;
+  for (size_t pos = 0; pos < num_samples; pos += spb) {
+    audio_ima_adpcm_encode_block(pcm + pos, num_samples - pos, sample_rate_hz,
+                                 &index, dst);
+    dst += block_align;
+  }
+  return total;
+}
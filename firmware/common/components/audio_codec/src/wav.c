@@ -0,0 +1,38 @@
+#include "audio_codec.h"
+
+#include <string.h>
+
+static void wav_put_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void wav_put_le32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)((v >> 8) & 0xFF);
+  p[2] = (uint8_t)((v >> 16) & 0xFF);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+void audio_wav_pcm16_header(uint8_t *hdr, uint32_t pcm_bytes,
+                            uint32_t sample_rate_hz, uint16_t channels) {
+  const uint16_t block_align = (uint16_t)(channels * sizeof(int16_t));
+  /* Tamanho indefinido (UINT32_MAX) satura o RIFF em vez de estourar */
+  const uint32_t riff_size = (pcm_bytes > UINT32_MAX - 36)
+                                 ? UINT32_MAX
+                                 : 36 + pcm_bytes;
+
+  memcpy(hdr + 0, "RIFF", 4);
+  wav_put_le32(hdr + 4, riff_size);
+  memcpy(hdr + 8, "WAVE", 4);
+  memcpy(hdr + 12, "fmt ", 4);
+  wav_put_le32(hdr + 16, 16);
+  wav_put_le16(hdr + 20, 1); /* WAVE_FORMAT_PCM */
+  wav_put_le16(hdr + 22, channels);
+  wav_put_le32(hdr + 24, sample_rate_hz);
+  wav_put_le32(hdr + 28, sample_rate_hz * block_align);
+  wav_put_le16(hdr + 32, block_align);
+  wav_put_le16(hdr + 34, 16);
+  memcpy(hdr + 36, "data", 4);
+  wav_put_le32(hdr + 40, pcm_bytes);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Camera producer task and latest-frame mailbox.
+ *
+ * A task pinned to its own core captures, scales and publishes frames into a
+ * lock-free single-slot mailbox (triple buffer): the producer never waits
+ * for the display, the GUI picks up the newest frame at display rate and
+ * older unread frames are simply replaced (counted as dropped).
+ */
+
+#define APP_CAMERA_FRAME_W 240
+#define APP_CAMERA_FRAME_H 240
+#define APP_CAMERA_FRAME_BYTES (APP_CAMERA_FRAME_W * APP_CAMERA_FRAME_H * 2)
+
+typedef struct {
+  uint32_t published;      /* frames written to the mailbox */
+  uint32_t shown;          /* frames taken by the GUI */
+  uint32_t dropped;        /* published frames replaced before being shown */
+  uint32_t errors;         /* failed captures */
+  uint32_t fps_x10;        /* publish rate over the last window, x10 */
+  uint32_t latency_us;     /* dequeue -> taken by the GUI, last frame */
+  uint32_t latency_max_us; /* same, worst since start */
+} app_camera_stats_t;
+
+/**
+ * @brief Allocate the mailbox, start the (idle) camera task and hand the
+ *        mailbox to the GUI as its live-view source.
+ */
+esp_err_t app_camera_init(void);
+
+/**
+ * @brief Start or stop streaming. Stopping closes the camera session (DMA
+ *        buffers freed) once the frame in flight is done; the last frame
+ *        stays on screen.
+ */
+void app_camera_set_active(bool active);
+
+/**
+ * @brief Copy the newest published frame into @p dst, without waiting for
+ *        the camera.
+ *
+ * @param camera_order Convert back to camera byte order (for the JPEG
+ *                     encoder); false keeps LCD byte order.
+ * @param[out] sequence Frame number (optional).
+ * @return ESP_ERR_NOT_FOUND if nothing was published yet.
+ */
+esp_err_t app_camera_snapshot(uint8_t *dst, size_t dst_len, bool camera_order,
+                              uint32_t *sequence);
+
+void app_camera_get_stats(app_camera_stats_t *out);
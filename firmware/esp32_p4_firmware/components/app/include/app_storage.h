@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bsp.h"
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -44,17 +45,17 @@ bool app_storage_is_ready(void);
 void app_storage_mount_after_camera_init(void);
 
 /**
- * @brief Queue JPEG image for saving (buffered in PSRAM)
+ * @brief Queue JPEG image for saving (kept in PSRAM)
  *
- * This function copies the JPEG data to PSRAM buffer and queues it for
- * saving after the AI interaction completes. This avoids SDMMC/DMA conflicts
- * during network communication.
+ * Takes a reference to the encoded photo instead of copying it; the image
+ * is saved after the AI interaction completes, avoiding SDMMC/DMA conflicts
+ * during network communication, and the reference is dropped once it is
+ * written (or discarded). The caller keeps and releases its own reference.
  *
- * @param jpeg_data Pointer to JPEG data (will be copied to PSRAM)
- * @param jpeg_len Length of JPEG data in bytes
+ * @param jpeg Encoded photo (see bsp_camera_capture_vision_jpeg)
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t app_storage_queue_image(const uint8_t *jpeg_data, size_t jpeg_len);
+esp_err_t app_storage_queue_image(bsp_jpeg_t *jpeg);
 
 /**
  * @brief Process queued images and save to SD card
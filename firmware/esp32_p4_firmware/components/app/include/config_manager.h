@@ -18,6 +18,9 @@ extern "C" {
 #define CONFIG_AI_PERSONALITY_MAX 256
 #define CONFIG_AI_BASE_URL_MAX 128
 #define CONFIG_AI_MODEL_MAX 64
+#define CONFIG_AI_AUDIO_FORMAT_MAX 8
+#define CONFIG_CAMERA_JPEG_BUDGET_MIN_KB 16
+#define CONFIG_CAMERA_JPEG_BUDGET_MAX_KB 400
 
 /* -----------------------------------------------------------------------
  * Estrutura principal de configuração
@@ -32,11 +35,17 @@ typedef struct {
   char ai_personality[CONFIG_AI_PERSONALITY_MAX];
   char ai_base_url[CONFIG_AI_BASE_URL_MAX];
   char ai_model[CONFIG_AI_MODEL_MAX];
+  bool ai_single_request; /* Foto+Voz: áudio e imagem na mesma requisição */
+  char ai_audio_format[CONFIG_AI_AUDIO_FORMAT_MAX]; /* wav | adpcm | flac */
 
   /* Hardware */
   uint8_t volume;     /* 0–100 */
   uint8_t brightness; /* 0–100 */
 
+  /* Câmera (foto enviada à IA) */
+  uint16_t camera_vision_size;    /* lado da foto: 512, 768 ou 1024 px */
+  uint16_t camera_jpeg_budget_kb; /* tamanho alvo do JPEG */
+
   /* Estado interno */
   bool loaded; /* true se o arquivo foi lido com sucesso */
 } app_config_t;
@@ -76,8 +85,8 @@ esp_err_t config_manager_load(void);
 esp_err_t config_manager_save(void);
 
 /**
- * @brief Atualiza Wi-Fi, token e personalidade, depois chama
- * config_manager_save().
+ * @brief Atualiza Wi-Fi, token, personalidade, endpoint e modo Foto+Voz,
+ * depois chama config_manager_save().
  *
  * Conveniência para o handler do Captive Portal.
  */
@@ -85,7 +94,8 @@ esp_err_t config_manager_update_and_save(const char *ssid, const char *pass,
                                          const char *ai_token,
                                          const char *ai_personality,
                                          const char *ai_base_url,
-                                         const char *ai_model);
+                                         const char *ai_model,
+                                         bool ai_single_request);
 
 #ifdef __cplusplus
 }
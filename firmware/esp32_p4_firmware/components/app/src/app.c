@@ -9,28 +9,24 @@
 
 #include "cJSON.h"
 #include "driver/gpio.h"
-#include "esp_crt_bundle.h"
 #include "esp_heap_caps.h"
-#include "esp_http_client.h"
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "lwip/ip4_addr.h"
 #include "mbedtls/base64.h"
 
+#include "ai_client.h"
+#include "app_camera.h"
 #include "app_state.h"
 #include "app_storage.h"
+#include "audio_codec.h"
 #include "bsp.h"
 #include "captive_portal.h"
 #include "config_manager.h"
 #include "gui.h"
-#include "secret.h"
-
-/* Guard against stale header indexing/build cache in IDE; real declaration is
- * in gui.h. */
-esp_err_t gui_show_camera_preview_rgb565(const uint8_t *rgb565_data,
-                                         uint16_t width, uint16_t height);
 
 #define APP_TASK_STACK_SIZE (10 * 1024)
 #define APP_TASK_PRIORITY 5
@@ -42,7 +38,6 @@ esp_err_t gui_show_camera_preview_rgb565(const uint8_t *rgb565_data,
 #define APP_MAX_CAPTURE_MS 10000
 #define APP_MIN_CAPTURE_BYTES 24000
 #define APP_MODE_SELECT_TIMEOUT_MS 4000
-#define APP_PREVIEW_REFRESH_MS 220
 #define APP_RESPONSE_TEXT_MAX 512
 #define APP_RESPONSE_SCROLL_STEP_PX 22
 #define APP_RESPONSE_TEXT_MAX 512
@@ -81,13 +76,11 @@ static bool s_prev_btn2_pressed;
 static bool s_prev_btn3_pressed;
 static bool s_photo_capture_requested;
 static bool s_photo_locked;
-static TickType_t s_last_preview_ticks;
 static TickType_t s_last_encoder_press_ticks;
 static TickType_t s_last_photo_press_ticks;
 static TickType_t s_last_btn2_press_ticks;
 static TickType_t s_last_btn3_press_ticks;
-static uint8_t *s_locked_photo_jpeg;
-static size_t s_locked_photo_jpeg_len;
+static bsp_jpeg_t *s_locked_photo_jpeg; /* buffer do pool, por referencia */
 static TickType_t s_mode_select_last_activity_ticks;
 static app_interaction_mode_t s_interaction_mode =
     APP_INTERACTION_MODE_AUDIO_TEXT;
@@ -146,99 +139,46 @@ static void app_history_clear(void) {
 static TickType_t s_config_longpress_start = 0;
 static bool s_config_longpress_active = false;
 
-typedef struct {
-  char *data;
-  size_t len;
-  size_t cap;
-} app_http_response_t;
-
 static uint8_t *app_pcm16_to_wav(const uint8_t *pcm, size_t pcm_len,
                                  uint32_t sample_rate_hz, uint16_t channels,
-                                 uint16_t bits_per_sample, size_t *wav_len) {
-  if (!pcm || !wav_len || sample_rate_hz == 0 || channels == 0 ||
-      bits_per_sample == 0) {
+                                 size_t *wav_len) {
+  if (!pcm || !wav_len || sample_rate_hz == 0 || channels == 0) {
     return NULL;
   }
 
-  const uint32_t byte_rate = sample_rate_hz * channels * (bits_per_sample / 8);
-  const uint16_t block_align = channels * (bits_per_sample / 8);
-  const size_t total_len = 44 + pcm_len;
+  const size_t total_len = AUDIO_WAV_HEADER_LEN + pcm_len;
   uint8_t *wav = malloc(total_len);
   if (!wav) {
     return NULL;
   }
 
-  memcpy(wav + 0, "RIFF", 4);
-  uint32_t chunk_size = (uint32_t)(36 + pcm_len);
-  memcpy(wav + 4, &chunk_size, sizeof(uint32_t));
-  memcpy(wav + 8, "WAVE", 4);
-  memcpy(wav + 12, "fmt ", 4);
-  uint32_t subchunk1_size = 16;
-  memcpy(wav + 16, &subchunk1_size, sizeof(uint32_t));
-  uint16_t audio_format = 1;
-  memcpy(wav + 20, &audio_format, sizeof(uint16_t));
-  memcpy(wav + 22, &channels, sizeof(uint16_t));
-  memcpy(wav + 24, &sample_rate_hz, sizeof(uint32_t));
-  memcpy(wav + 28, &byte_rate, sizeof(uint32_t));
-  memcpy(wav + 32, &block_align, sizeof(uint16_t));
-  memcpy(wav + 34, &bits_per_sample, sizeof(uint16_t));
-  memcpy(wav + 36, "data", 4);
-  uint32_t subchunk2_size = (uint32_t)pcm_len;
-  memcpy(wav + 40, &subchunk2_size, sizeof(uint32_t));
-  memcpy(wav + 44, pcm, pcm_len);
+  audio_wav_pcm16_header(wav, (uint32_t)pcm_len, sample_rate_hz, channels);
+  memcpy(wav + AUDIO_WAV_HEADER_LEN, pcm, pcm_len);
 
   *wav_len = total_len;
   return wav;
 }
 
-static char *app_base64_encode(const uint8_t *data, size_t data_len) {
-  size_t out_len = 0;
-  int ret = mbedtls_base64_encode(NULL, 0, &out_len, data, data_len);
-  if (ret != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && ret != 0) {
-    return NULL;
-  }
-
-  char *out = malloc(out_len + 1);
-  if (!out) {
-    return NULL;
-  }
+static audio_codec_format_t app_audio_format(void) {
+  return audio_codec_from_name(config_manager_get()->ai_audio_format);
+}
 
-  ret = mbedtls_base64_encode((unsigned char *)out, out_len, &out_len, data,
-                              data_len);
-  if (ret != 0) {
-    free(out);
+/* Codifica o PCM16 mono no formato de ai.audio_format (WAV PCM, WAV
+ * IMA-ADPCM ou FLAC). O buffer retornado e liberado com free(). */
+static uint8_t *app_encode_audio(const uint8_t *pcm, size_t pcm_len,
+                                 uint32_t sample_rate_hz, size_t *out_len) {
+  const audio_codec_format_t fmt = app_audio_format();
+  if (fmt == AUDIO_CODEC_WAV_PCM16) {
+    return app_pcm16_to_wav(pcm, pcm_len, sample_rate_hz, 1, out_len);
+  }
+  uint8_t *out = NULL;
+  if (audio_codec_encode(fmt, (const int16_t *)pcm, pcm_len / sizeof(int16_t),
+                         sample_rate_hz, &out, out_len) != ESP_OK) {
     return NULL;
   }
-  out[out_len] = '\0';
   return out;
 }
 
-static esp_err_t app_http_append(app_http_response_t *resp, const char *data,
-                                 int len) {
-  if (!resp || !data || len <= 0) {
-    return ESP_OK;
-  }
-
-  const size_t required = resp->len + (size_t)len + 1;
-  if (required > resp->cap) {
-    size_t new_cap = (resp->cap == 0) ? 1024 : resp->cap * 2;
-    while (new_cap < required) {
-      new_cap *= 2;
-    }
-    char *new_data = realloc(resp->data, new_cap);
-    if (!new_data) {
-      return ESP_ERR_NO_MEM;
-    }
-    resp->data = new_data;
-    resp->cap = new_cap;
-  }
-
-  memcpy(resp->data + resp->len, data, (size_t)len);
-  resp->len += (size_t)len;
-  resp->data[resp->len] = '\0';
-  return ESP_OK;
-}
-
 static void app_utf8_to_ascii(char *text) {
   if (!text) {
     return;
@@ -357,46 +297,6 @@ static void app_utf8_to_ascii(char *text) {
   *dst = '\0';
 }
 
-static esp_err_t app_extract_response_text(const char *json, char *out_text,
-                                           size_t out_text_len) {
-  if (!json || !out_text || out_text_len == 0) {
-    return ESP_ERR_INVALID_ARG;
-  }
-
-  cJSON *root = cJSON_Parse(json);
-  if (!root) {
-    return ESP_FAIL;
-  }
-
-  const cJSON *choices = cJSON_GetObjectItemCaseSensitive(root, "choices");
-  if (cJSON_IsArray(choices)) {
-    cJSON *first_choice = cJSON_GetArrayItem(choices, 0);
-    cJSON *message = cJSON_GetObjectItemCaseSensitive(first_choice, "message");
-    cJSON *content = cJSON_GetObjectItemCaseSensitive(message, "content");
-
-    if (cJSON_IsString(content) && content->valuestring) {
-      strlcpy(out_text, content->valuestring, out_text_len);
-      cJSON_Delete(root);
-      return ESP_OK;
-    }
-
-    if (cJSON_IsArray(content)) {
-      cJSON *part = NULL;
-      cJSON_ArrayForEach(part, content) {
-        cJSON *text = cJSON_GetObjectItemCaseSensitive(part, "text");
-        if (cJSON_IsString(text) && text->valuestring) {
-          strlcpy(out_text, text->valuestring, out_text_len);
-          cJSON_Delete(root);
-          return ESP_OK;
-        }
-      }
-    }
-  }
-
-  cJSON_Delete(root);
-  return ESP_ERR_NOT_FOUND;
-}
-
 static const char *app_profile_name(app_expert_profile_t profile) {
   switch (profile) {
   case APP_EXPERT_PROFILE_AGRONOMO:
@@ -447,13 +347,21 @@ app_profile_transcription_terms(app_expert_profile_t profile) {
   }
 }
 
-static esp_err_t app_build_ai_request_json(
-    const char *model, const char *audio_b64, const char *image_data_url,
+static const char *const s_blob_markers[AI_REQUEST_MAX_BLOBS] = {
+    AI_REQUEST_BLOB0_MARKER, AI_REQUEST_BLOB1_MARKER};
+
+/* Monta o JSON com marcadores no lugar da imagem e/ou do audio, numerados a
+ * partir de first_marker (os anteriores ficam para o texto de contexto). */
+static esp_err_t app_build_ai_json(
+    const char *model, bool with_audio, bool with_image,
     const char *system_profile_text, const char *image_context_text,
-    const char *audio_context_text, bool inject_history, char **out_json) {
-  if (!model || !out_json) {
+    const char *audio_context_text, bool inject_history, size_t first_marker,
+    char **out_json) {
+  if (!model || !out_json || (!with_audio && !with_image) ||
+      first_marker + with_audio + with_image > AI_REQUEST_MAX_BLOBS) {
     return ESP_ERR_INVALID_ARG;
   }
+  size_t marker = first_marker;
 
   cJSON *root = cJSON_CreateObject();
   cJSON *messages = cJSON_CreateArray();
@@ -464,6 +372,7 @@ static esp_err_t app_build_ai_request_json(
   }
 
   cJSON_AddStringToObject(root, "model", model);
+  cJSON_AddBoolToObject(root, "stream", true);
   cJSON_AddItemToObject(root, "messages", messages);
 
   cJSON *system_msg = cJSON_CreateObject();
@@ -518,18 +427,30 @@ static esp_err_t app_build_ai_request_json(
   cJSON_AddStringToObject(user_msg, "role", "user");
   cJSON_AddItemToObject(user_msg, "content", user_content);
 
-  if (image_data_url) {
-    // Vision model path: image + text (audio is handled in a separate first
-    // cycle)
-    const char *vision_text = (image_context_text && image_context_text[0])
-                                  ? image_context_text
-                                  : "O que voce ve nesta imagem? Identifique "
-                                    "os elementos principais.";
-    cJSON *text_part = cJSON_CreateObject();
-    cJSON_AddStringToObject(text_part, "type", "text");
-    cJSON_AddStringToObject(text_part, "text", vision_text);
-    cJSON_AddItemToArray(user_content, text_part);
-
+  // Texto de contexto primeiro; depois imagem e/ou audio. Sem audio e o
+  // ciclo de visao do modo em duas etapas; com os dois e o modo de
+  // requisicao unica (modelo que aceita image_url e input_audio juntos).
+  const char *ctx_text;
+  if (with_image) {
+    ctx_text = (image_context_text && image_context_text[0])
+                   ? image_context_text
+                   : "O que voce ve nesta imagem? Identifique "
+                     "os elementos principais.";
+  } else {
+    ctx_text = (audio_context_text && audio_context_text[0])
+                   ? audio_context_text
+                   : "Ouca o audio e responda diretamente a pergunta do "
+                     "usuario.";
+  }
+  cJSON *ctx_part = cJSON_CreateObject();
+  cJSON_AddStringToObject(ctx_part, "type", "text");
+  cJSON_AddStringToObject(ctx_part, "text", ctx_text);
+  cJSON_AddItemToArray(user_content, ctx_part);
+
+  if (with_image) {
+    char image_url[64];
+    snprintf(image_url, sizeof(image_url), "data:image/jpeg;base64,%s",
+             s_blob_markers[marker++]);
     cJSON *image_part = cJSON_CreateObject();
     cJSON *image_obj = cJSON_CreateObject();
     if (!image_part || !image_obj) {
@@ -537,25 +458,13 @@ static esp_err_t app_build_ai_request_json(
       return ESP_ERR_NO_MEM;
     }
     cJSON_AddStringToObject(image_part, "type", "image_url");
-    cJSON_AddStringToObject(image_obj, "url", image_data_url);
+    cJSON_AddStringToObject(image_obj, "url", image_url);
     cJSON_AddItemToObject(image_part, "image_url", image_obj);
     cJSON_AddItemToArray(user_content, image_part);
-  } else {
-    // Audio-only path: keep original input_audio payload for OpenAI extension.
-    if (!audio_b64) {
-      cJSON_Delete(root);
-      return ESP_ERR_INVALID_ARG;
-    }
-
-    const char *audio_text =
-        (audio_context_text && audio_context_text[0])
-            ? audio_context_text
-            : "Ouca o audio e responda diretamente a pergunta do usuario.";
-    cJSON *ctx_part = cJSON_CreateObject();
-    cJSON_AddStringToObject(ctx_part, "type", "text");
-    cJSON_AddStringToObject(ctx_part, "text", audio_text);
-    cJSON_AddItemToArray(user_content, ctx_part);
+  }
 
+  if (with_audio) {
+    // input_audio payload (OpenAI extension)
     cJSON *audio_part = cJSON_CreateObject();
     cJSON *audio_obj = cJSON_CreateObject();
     if (!audio_part || !audio_obj) {
@@ -563,8 +472,9 @@ static esp_err_t app_build_ai_request_json(
       return ESP_ERR_NO_MEM;
     }
     cJSON_AddStringToObject(audio_part, "type", "input_audio");
-    cJSON_AddStringToObject(audio_obj, "format", "wav");
-    cJSON_AddStringToObject(audio_obj, "data", audio_b64);
+    cJSON_AddStringToObject(audio_obj, "format",
+                            audio_codec_api_format(app_audio_format()));
+    cJSON_AddStringToObject(audio_obj, "data", s_blob_markers[marker++]);
     cJSON_AddItemToObject(audio_part, "input_audio", audio_obj);
     cJSON_AddItemToArray(user_content, audio_part);
   }
@@ -581,6 +491,36 @@ static esp_err_t app_build_ai_request_json(
   return ESP_OK;
 }
 
+/* Os blobs (JPEG e/ou audio) entram no JSON como marcadores e sao codificados
+ * em base64 direto no socket pelo ai_client: sem copia base64 em memoria. */
+static esp_err_t app_build_ai_request_json(
+    const char *model, const ai_blob_t *audio, const ai_blob_t *image,
+    const char *system_profile_text, const char *image_context_text,
+    const char *audio_context_text, bool inject_history,
+    ai_request_t *out_req) {
+  if (!out_req) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  char *json = NULL;
+  esp_err_t err = app_build_ai_json(
+      model, audio != NULL, image != NULL, system_profile_text,
+      image_context_text, audio_context_text, inject_history, 0, &json);
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  /* Mesma ordem dos marcadores no JSON: imagem, depois audio */
+  ai_blob_t blobs[AI_REQUEST_MAX_BLOBS];
+  size_t num_blobs = 0;
+  if (image) {
+    blobs[num_blobs++] = *image;
+  }
+  if (audio) {
+    blobs[num_blobs++] = *audio;
+  }
+  return ai_request_init(out_req, json, blobs, num_blobs);
+}
+
 /* app_check_dns_ready has been removed because DNS pre-check is skipped
  * for arbitrary dynamic endpoints, the HTTP client will fail gracefully
  * if the host does not exist or network is unavailable. */
@@ -613,112 +553,350 @@ static bool app_log_network_status(void) {
   return true;
 }
 
-static esp_err_t app_http_post_json(const char *request_json,
-                                    app_http_response_t *resp, int *http_code) {
-  if (!request_json || !resp || !http_code) {
-    return ESP_ERR_INVALID_ARG;
-  }
-
-  *http_code = 0;
-  resp->data = NULL;
-  resp->len = 0;
-  resp->cap = 0;
+/* -----------------------------------------------------------------------
+ * Cliente de IA (ai_client compartilhado com o S3)
+ *
+ * Um cliente HTTP persistente com sessao TLS salva: a segunda requisicao do
+ * modo audio+imagem (e as interacoes seguintes) reconectam com handshake
+ * abreviado. A resposta chega via SSE e a resposta final e desenhada na tela
+ * conforme os fragmentos chegam.
+ * ----------------------------------------------------------------------- */
 
-  esp_http_client_config_t config = {
-      .url = config_manager_get()->ai_base_url,
-      .timeout_ms = APP_HTTP_TIMEOUT_MS,
-      .crt_bundle_attach = esp_crt_bundle_attach,
-  };
-  esp_http_client_handle_t client = esp_http_client_init(&config);
-  if (!client) {
-    return ESP_FAIL;
-  }
+typedef struct {
+  bool shown; /* painel ja trocado para a resposta */
+} app_ai_stream_ui_t;
+
+static void app_ai_client_cfg(ai_client_cfg_t *cfg) {
+  cfg->url = config_manager_get()->ai_base_url;
+  /* Use token from config (set via Captive Portal or settings.json) */
+  cfg->token = config_manager_get()->ai_token;
+  cfg->timeout_ms = APP_HTTP_TIMEOUT_MS;
+}
 
-  char auth_header[256];
-  snprintf(auth_header, sizeof(auth_header), "Bearer %s",
-           SECRET_OPENAI_API_KEY);
-  esp_http_client_set_method(client, HTTP_METHOD_POST);
-  esp_http_client_set_header(client, "Authorization", auth_header);
-  esp_http_client_set_header(client, "Content-Type", "application/json");
-  esp_http_client_set_post_field(client, request_json,
-                                 (int)strlen(request_json));
+/* Repassa cada fragmento do stream SSE para a tela; a GUI agrupa os
+ * fragmentos e redesenha no timer do LVGL. */
+static void app_ai_on_delta(const char *frag, size_t frag_len,
+                            const char *text, size_t text_len,
+                            void *user_ctx) {
+  app_ai_stream_ui_t *ui = (app_ai_stream_ui_t *)user_ctx;
+  if (!ui->shown) {
+    /* Primeiro fragmento: esconde a camera/foto e usa o painel completo */
+    gui_hide_camera_preview();
+    gui_set_response_compact(false);
+    gui_set_response("");
+    ui->shown = true;
+  }
+  gui_append_response(frag, frag_len);
+}
 
-  esp_err_t err = esp_http_client_open(client, strlen(request_json));
-  if (err != ESP_OK) {
-    esp_http_client_cleanup(client);
-    return err;
+static esp_err_t app_check_ai_credentials(char *out_text,
+                                          size_t out_text_len) {
+  /* Servidores locais (Ollama, etc.) nao requerem token. Usa prefixos apos
+   * "://" para evitar falsos positivos como "110.x.x.x". */
+  const char *cfg_token = config_manager_get()->ai_token;
+  const char *cfg_url = config_manager_get()->ai_base_url;
+  const char *url_host = strstr(cfg_url, "://");
+  url_host = url_host ? url_host + 3 : cfg_url;
+  bool is_local =
+      (strncmp(url_host, "localhost", 9) == 0 ||
+       strncmp(url_host, "127.0.0.1", 9) == 0 ||
+       strncmp(url_host, "192.168.", 8) == 0 ||
+       strncmp(url_host, "10.", 3) == 0 || strncmp(url_host, "172.", 4) == 0);
+  if ((!cfg_token || cfg_token[0] == '\0' ||
+       strcmp(cfg_token, "YOUR_API_KEY_HERE") == 0) &&
+      !is_local) {
+    strlcpy(out_text,
+            "Token nao configurado.\nAcesse o Portal para\nconfigurar a chave "
+            "de API.",
+            out_text_len);
+    return ESP_ERR_INVALID_STATE;
   }
+  return ESP_OK;
+}
 
-  int written =
-      esp_http_client_write(client, request_json, (int)strlen(request_json));
-  if (written < 0) {
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
-    return ESP_FAIL;
+/* Abre a conexao em paralelo com a captura de audio. */
+static void app_ai_prewarm_start(void) {
+  char msg[APP_RESPONSE_TEXT_MAX];
+  if (app_check_ai_credentials(msg, sizeof(msg)) != ESP_OK) {
+    return;
   }
+  ai_client_cfg_t cfg;
+  app_ai_client_cfg(&cfg);
+  ai_client_prewarm_start(&cfg);
+}
 
-  (void)esp_http_client_fetch_headers(client);
-  char read_buf[512];
-  while (1) {
-    int read = esp_http_client_read(client, read_buf, sizeof(read_buf));
-    if (read < 0) {
-      err = ESP_FAIL;
-      break;
-    }
-    if (read == 0) {
-      break;
-    }
-    err = app_http_append(resp, read_buf, read);
-    if (err != ESP_OK) {
-      break;
-    }
+/* Envia uma requisicao ja montada. stream_to_gui: desenha a resposta
+ * progressivamente (so na resposta final; a transcricao do ciclo 1 nao e
+ * mostrada). http_code_out pode ser NULL. */
+static esp_err_t app_post_ai_request(const ai_request_t *request,
+                                     const char *label, bool stream_to_gui,
+                                     char *out_text, size_t out_text_len,
+                                     int *http_code_out) {
+  ai_client_cfg_t cfg;
+  app_ai_client_cfg(&cfg);
+  app_ai_stream_ui_t ui = {0};
+  int http_code = 0;
+  const TickType_t t0 = xTaskGetTickCount();
+  esp_err_t err =
+      ai_client_post(&cfg, request, out_text, out_text_len, &http_code,
+                     stream_to_gui ? app_ai_on_delta : NULL, &ui);
+  if (http_code_out) {
+    *http_code_out = http_code;
   }
 
-  *http_code = esp_http_client_get_status_code(client);
-  esp_http_client_close(client);
-  esp_http_client_cleanup(client);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "AI request failed (http=%d): %s", http_code,
+             esp_err_to_name(err));
+  } else {
+    ESP_LOGI(TAG, "AI request (%s) done in %u ms", label,
+             (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - t0));
+  }
   return err;
 }
 
 static esp_err_t
-app_call_ai_once(const char *model, const char *audio_b64,
-                 const char *image_data_url, const char *system_profile_text,
+app_call_ai_once(const char *model, const ai_blob_t *audio,
+                 const ai_blob_t *image, const char *system_profile_text,
                  const char *image_context_text, const char *audio_context_text,
-                 bool inject_history, char *out_text, size_t out_text_len) {
+                 bool inject_history, bool stream_to_gui, char *out_text,
+                 size_t out_text_len, int *http_code_out) {
   if (!model || !out_text || out_text_len == 0) {
     return ESP_ERR_INVALID_ARG;
   }
 
-  char *request_json = NULL;
-  esp_err_t build_err = app_build_ai_request_json(
-      model, audio_b64, image_data_url, system_profile_text, image_context_text,
-      audio_context_text, inject_history, &request_json);
-  if (build_err != ESP_OK) {
-    return build_err;
+  ai_request_t request;
+  esp_err_t err = app_build_ai_request_json(
+      model, audio, image, system_profile_text, image_context_text,
+      audio_context_text, inject_history, &request);
+  if (err != ESP_OK) {
+    return err;
   }
 
-  app_http_response_t resp = {0};
-  int http_code = 0;
-  esp_err_t err = app_http_post_json(request_json, &resp, &http_code);
-  free(request_json);
+  err = app_post_ai_request(
+      &request, image ? (audio ? "audio+vision" : "vision") : "audio",
+      stream_to_gui, out_text, out_text_len, http_code_out);
+  ai_request_free(&request);
+  return err;
+}
 
-  if (err != ESP_OK) {
-    free(resp.data);
-    return err;
+/* -----------------------------------------------------------------------
+ * Foto+Voz em requisicao unica
+ *
+ * Com ai.single_request ativo, audio e imagem vao na mesma requisicao
+ * (input_audio + image_url) para o modelo configurado, eliminando o ciclo
+ * de transcricao: uma ida e volta em vez de duas. Se o servidor rejeitar o
+ * formato (modelo sem suporte a um dos dois), usa o caminho em duas etapas
+ * e nao tenta de novo ate reiniciar.
+ * ----------------------------------------------------------------------- */
+
+static bool s_single_request_rejected = false;
+
+static esp_err_t app_call_ai_single_request(const ai_blob_t *audio,
+                                            const ai_blob_t *image,
+                                            char *out_text,
+                                            size_t out_text_len,
+                                            int *http_code) {
+  char *prompt = malloc(APP_RESPONSE_TEXT_MAX * 2);
+  if (!prompt) {
+    return ESP_ERR_NO_MEM;
   }
-  if (http_code < 200 || http_code >= 300) {
-    ESP_LOGE(TAG, "AI HTTP status=%d body=%s", http_code,
-             resp.data ? resp.data : "(empty)");
-    free(resp.data);
-    return ESP_FAIL;
+  snprintf(
+      prompt, APP_RESPONSE_TEXT_MAX * 2,
+      "O audio contem a pergunta do usuario sobre a imagem.\n"
+      "INSTRUCOES:\n"
+      "1. Ouca a pergunta e responda diretamente usando o que voce ve na "
+      "imagem.\n"
+      "2. Se a pergunta e sobre identificar algo, diga o que e.\n"
+      "3. Se ha texto, numeros ou logos na imagem, leia-os.\n"
+      "4. Se a pergunta nao tem relacao com a imagem, "
+      "responda a pergunta mesmo assim usando seu conhecimento.\n"
+      "5. Se o audio estiver ruidoso, use o contexto para inferir a "
+      "intencao. Vocabulario tecnico esperado: %s.\n"
+      "6. Nunca diga apenas 'nao sei'. Sempre ofereca sua melhor analise.",
+      app_profile_transcription_terms(s_expert_profile));
+
+  esp_err_t err = app_call_ai_once(
+      config_manager_get()->ai_model, audio, image,
+      app_profile_system_prompt(s_expert_profile), prompt, NULL, true, true,
+      out_text, out_text_len, http_code);
+  free(prompt);
+  return err;
+}
+
+/* -----------------------------------------------------------------------
+ * Preparo da requisicao de visao (modo em duas etapas)
+ *
+ * Enquanto o ciclo 1 (transcricao) esta em voo na app_task (core 0), uma
+ * task no core 1 codifica o JPEG em base64 e serializa o JSON do ciclo 2
+ * (system prompt, historico e imagem) com um marcador no lugar da
+ * transcricao. Quando o ciclo 1 volta, so falta escapar a transcricao e
+ * enviar: o ciclo 2 sai sem trabalho de CPU no caminho critico.
+ * ----------------------------------------------------------------------- */
+
+#define APP_VISION_PREP_TASK_STACK_SIZE (6 * 1024)
+#define APP_VISION_PREP_TASK_PRIORITY 4
+
+typedef struct {
+  const uint8_t *jpeg; /* pertence ao chamador ate app_vision_prep_free */
+  size_t jpeg_len;
+  char *json;          /* marcador 0 = transcricao, marcador 1 = imagem */
+  unsigned char *image_b64;
+  size_t image_b64_len;
+  esp_err_t err;
+  uint32_t encode_ms;
+  uint32_t build_ms;
+  TickType_t ready_tick;
+  SemaphoreHandle_t done_sem;
+} app_vision_prep_t;
+
+static void app_format_vision_prompt(char *dst, size_t dst_len,
+                                     const char *question) {
+  snprintf(
+      dst, dst_len,
+      "O usuario perguntou: \"%s\"\n"
+      "INSTRUCOES:\n"
+      "1. Responda a pergunta diretamente usando o que voce ve na imagem.\n"
+      "2. Se a pergunta e sobre identificar algo, diga o que e.\n"
+      "3. Se ha texto, numeros ou logos na imagem, leia-os.\n"
+      "4. Se a pergunta nao tem relacao com a imagem, "
+      "responda a pergunta mesmo assim usando seu conhecimento.\n"
+      "5. Nunca diga apenas 'nao sei'. Sempre ofereca sua melhor analise.",
+      question);
+}
+
+static void app_vision_prep_task(void *arg) {
+  app_vision_prep_t *prep = (app_vision_prep_t *)arg;
+  TickType_t t0 = xTaskGetTickCount();
+
+  size_t b64_cap = ((prep->jpeg_len + 2) / 3) * 4 + 1;
+  prep->image_b64 =
+      heap_caps_malloc(b64_cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!prep->image_b64) {
+    prep->image_b64 = malloc(b64_cap);
+  }
+  esp_err_t err = prep->image_b64 ? ESP_OK : ESP_ERR_NO_MEM;
+  if (err == ESP_OK &&
+      mbedtls_base64_encode(prep->image_b64, b64_cap, &prep->image_b64_len,
+                            prep->jpeg, prep->jpeg_len) != 0) {
+    err = ESP_FAIL;
   }
+  prep->encode_ms = (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount() - t0);
 
-  err = app_extract_response_text(resp.data, out_text, out_text_len);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "AI parse error (%s), body=%s", esp_err_to_name(err),
-             resp.data ? resp.data : "(empty)");
+  t0 = xTaskGetTickCount();
+  if (err == ESP_OK) {
+    char *vision_prompt = malloc(APP_RESPONSE_TEXT_MAX * 2);
+    if (!vision_prompt) {
+      err = ESP_ERR_NO_MEM;
+    } else {
+      app_format_vision_prompt(vision_prompt, APP_RESPONSE_TEXT_MAX * 2,
+                               AI_REQUEST_BLOB0_MARKER);
+      err = app_build_ai_json(config_manager_get()->ai_model, false, true,
+                              app_profile_system_prompt(s_expert_profile),
+                              vision_prompt, NULL, true, 1, &prep->json);
+      free(vision_prompt);
+    }
   }
-  free(resp.data);
+  prep->build_ms = (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount() - t0);
+
+  prep->err = err;
+  prep->ready_tick = xTaskGetTickCount();
+  xSemaphoreGive(prep->done_sem);
+  vTaskDelete(NULL);
+}
+
+static void app_vision_prep_free(app_vision_prep_t *prep) {
+  if (!prep) {
+    return;
+  }
+  free(prep->json);
+  free(prep->image_b64);
+  if (prep->done_sem) {
+    vSemaphoreDelete(prep->done_sem);
+  }
+  free(prep);
+}
+
+/* Retorna NULL se a task nao puder ser criada; o chamador monta o ciclo 2
+ * no proprio fluxo. */
+static app_vision_prep_t *app_vision_prep_start(const ai_blob_t *image) {
+  app_vision_prep_t *prep = calloc(1, sizeof(app_vision_prep_t));
+  if (!prep) {
+    return NULL;
+  }
+  prep->jpeg = image->data;
+  prep->jpeg_len = image->len;
+  prep->err = ESP_FAIL;
+  prep->done_sem = xSemaphoreCreateBinary();
+  if (!prep->done_sem ||
+      xTaskCreatePinnedToCore(app_vision_prep_task, "vision_prep",
+                              APP_VISION_PREP_TASK_STACK_SIZE, prep,
+                              APP_VISION_PREP_TASK_PRIORITY, NULL,
+                              1) != pdPASS) {
+    app_vision_prep_free(prep);
+    return NULL;
+  }
+  return prep;
+}
+
+/* Texto escapado para dentro de uma string JSON (sem as aspas), ou NULL sem
+ * memoria. */
+static char *app_json_escape(const char *text, size_t *out_len) {
+  cJSON *str = cJSON_CreateString(text);
+  char *quoted = str ? cJSON_PrintUnformatted(str) : NULL;
+  cJSON_Delete(str);
+  if (!quoted) {
+    return NULL;
+  }
+  size_t n = strlen(quoted);
+  memmove(quoted, quoted + 1, n - 2);
+  quoted[n - 2] = '\0';
+  *out_len = n - 2;
+  return quoted;
+}
+
+/* Completa e envia o ciclo 2 preparado. ESP_ERR_INVALID_STATE indica que o
+ * preparo falhou e nada foi enviado. Libera prep em qualquer caso. */
+static esp_err_t app_vision_prep_send(app_vision_prep_t *prep,
+                                      const char *transcript, char *out_text,
+                                      size_t out_text_len) {
+  const TickType_t wait_start = xTaskGetTickCount();
+  xSemaphoreTake(prep->done_sem, portMAX_DELAY);
+  const TickType_t waited = xTaskGetTickCount() - wait_start;
+
+  if (prep->err != ESP_OK) {
+    ESP_LOGW(TAG, "Vision prep failed: %s", esp_err_to_name(prep->err));
+    app_vision_prep_free(prep);
+    return ESP_ERR_INVALID_STATE;
+  }
+  ESP_LOGI(TAG,
+           "Vision prep: base64 %u ms (%u -> %u bytes), JSON %u ms, %s %u ms",
+           (unsigned)prep->encode_ms, (unsigned)prep->jpeg_len,
+           (unsigned)prep->image_b64_len, (unsigned)prep->build_ms,
+           waited > 0 ? "cycle 2 waited" : "ready before cycle 1 by",
+           (unsigned)pdTICKS_TO_MS(waited > 0 ? waited
+                                              : wait_start - prep->ready_tick));
+
+  size_t transcript_len = 0;
+  char *escaped = app_json_escape(transcript, &transcript_len);
+  if (!escaped) {
+    app_vision_prep_free(prep);
+    return ESP_ERR_NO_MEM;
+  }
+
+  const ai_blob_t blobs[2] = {
+      {.data = (const uint8_t *)escaped, .len = transcript_len, .raw = true},
+      {.data = prep->image_b64, .len = prep->image_b64_len, .raw = true},
+  };
+  ai_request_t request;
+  esp_err_t err = ai_request_init(&request, prep->json, blobs, 2);
+  prep->json = NULL; /* posse transferida para request */
+  if (err == ESP_OK) {
+    err = app_post_ai_request(&request, "vision", true, out_text, out_text_len,
+                              NULL);
+    ai_request_free(&request);
+  }
+  free(escaped);
+  app_vision_prep_free(prep);
   return err;
 }
 
@@ -730,11 +908,9 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
     return ESP_ERR_INVALID_ARG;
   }
 
-  if (strcmp(SECRET_OPENAI_API_KEY, "YOUR_API_KEY_HERE") == 0) {
-    strlcpy(out_text,
-            "Configure SECRET_OPENAI_API_KEY em secret.h para habilitar IA.",
-            out_text_len);
-    return ESP_ERR_INVALID_STATE;
+  esp_err_t err = app_check_ai_credentials(out_text, out_text_len);
+  if (err != ESP_OK) {
+    return err;
   }
 
   if (!app_log_network_status()) {
@@ -749,24 +925,18 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
    * unreachable.
    */
 
-  char *audio_b64 = app_base64_encode(wav_data, wav_len);
-  if (!audio_b64) {
-    return ESP_ERR_NO_MEM;
-  }
-
-  char *image_data_url = NULL;
+  const ai_blob_t audio = {.data = wav_data, .len = wav_len};
+  ai_blob_t image = {0};
   if (jpeg_data && jpeg_len > 0) {
     // Validate JPEG: must start with FF D8 (SOI marker)
     if (jpeg_len < 4) {
       ESP_LOGE(TAG, "JPEG too small: %u bytes", (unsigned)jpeg_len);
-      free(audio_b64);
       return ESP_ERR_INVALID_ARG;
     }
 
     if (jpeg_data[0] != 0xFF || jpeg_data[1] != 0xD8) {
       ESP_LOGE(TAG, "Invalid JPEG start: 0x%02X%02X (expected FF D8)",
                jpeg_data[0], jpeg_data[1]);
-      free(audio_b64);
       return ESP_ERR_INVALID_ARG;
     }
 
@@ -775,44 +945,53 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
                     jpeg_data[jpeg_len - 1] == 0xD9);
     ESP_LOGI(TAG, "JPEG validated: %u bytes, start=FF D8, end=%s",
              (unsigned)jpeg_len, has_eoi ? "FF D9" : "missing");
+    image.data = jpeg_data;
+    image.len = jpeg_len;
+  }
 
-    char *image_b64 = app_base64_encode(jpeg_data, jpeg_len);
-    if (!image_b64) {
-      ESP_LOGE(TAG, "Failed to encode JPEG to Base64");
-      free(audio_b64);
-      return ESP_ERR_NO_MEM;
-    }
+  const char *audio_model =
+      (strcmp(config_manager_get()->ai_model, "gpt-4o") == 0)
+          ? APP_AI_MODEL_AUDIO_TEXT
+          : config_manager_get()->ai_model;
 
-    const char *prefix = "data:image/jpeg;base64,";
-    const size_t prefix_len = strlen(prefix);
-    const size_t image_b64_len = strlen(image_b64);
-    ESP_LOGI(TAG,
-             "JPEG Base64: %u bytes -> %u chars, data URL will be %u chars",
-             (unsigned)jpeg_len, (unsigned)image_b64_len,
-             (unsigned)(prefix_len + image_b64_len));
-
-    image_data_url = malloc(prefix_len + image_b64_len + 1);
-    if (!image_data_url) {
-      free(image_b64);
-      free(audio_b64);
-      return ESP_ERR_NO_MEM;
+  const TickType_t t0 = xTaskGetTickCount();
+  if (image.data && config_manager_get()->ai_single_request &&
+      !s_single_request_rejected) {
+    int http_code = 0;
+    err = app_call_ai_single_request(&audio, &image, out_text, out_text_len,
+                                     &http_code);
+    if (err == ESP_OK) {
+      ESP_LOGI(TAG, "Photo+Voice (single request) done in %u ms",
+               (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - t0));
+      app_history_add(NULL, out_text);
+      return ESP_OK;
+    }
+    /* Falha de rede/TLS ou de autenticacao: o caminho em duas etapas
+     * falharia da mesma forma */
+    if ((http_code == 0 && err != ESP_ERR_NOT_FOUND) || http_code == 401 ||
+        http_code == 403) {
+      return err;
     }
-    memcpy(image_data_url, prefix, prefix_len);
-    memcpy(image_data_url + prefix_len, image_b64, image_b64_len + 1);
-    image_data_url[prefix_len + image_b64_len] = '\0';
-    free(image_b64);
+    if (http_code >= 400 && http_code < 500) {
+      s_single_request_rejected = true;
+    }
+    ESP_LOGW(TAG, "Single request failed (http=%d); falling back to two-pass",
+             http_code);
+    out_text[0] = '\0';
   }
 
-  const bool use_vision_model = (image_data_url != NULL);
-  esp_err_t err = ESP_FAIL;
+  if (image.data) {
+    // Ciclo 2 preparado no outro core enquanto o ciclo 1 esta em voo
+    app_vision_prep_t *prep = app_vision_prep_start(&image);
 
-  if (use_vision_model) {
     // Ciclo 1: somente audio -> transcricao
     char transcript_text[APP_RESPONSE_TEXT_MAX] = {0};
     char *transcription_prompt = malloc(APP_RESPONSE_TEXT_MAX);
     if (!transcription_prompt) {
-      free(audio_b64);
-      free(image_data_url);
+      if (prep) {
+        xSemaphoreTake(prep->done_sem, portMAX_DELAY);
+        app_vision_prep_free(prep);
+      }
       return ESP_ERR_NO_MEM;
     }
     snprintf(transcription_prompt, APP_RESPONSE_TEXT_MAX,
@@ -822,20 +1001,13 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
              "Vocabulario tecnico esperado: %s.",
              app_profile_transcription_terms(s_expert_profile));
 
-    const char *audio_model =
-        (strcmp(config_manager_get()->ai_model, "gpt-4o") == 0)
-            ? APP_AI_MODEL_AUDIO_TEXT
-            : config_manager_get()->ai_model;
-    err = app_call_ai_once(audio_model, audio_b64, NULL,
+    err = app_call_ai_once(audio_model, &audio, NULL,
                            app_profile_system_prompt(s_expert_profile), NULL,
-                           transcription_prompt, false, transcript_text,
-                           sizeof(transcript_text));
+                           transcription_prompt, false, false, transcript_text,
+                           sizeof(transcript_text), NULL);
     free(transcription_prompt);
-    // CRITICO: libera audio_b64 logo apos o ciclo 1 para aliviar memoria
-    // interna ANTES de abrir a segunda conexao HTTPS (ciclo 2 - visao).
-    // O audio_b64 pode ter centenas de KB e concorre com o contexto TLS.
-    free(audio_b64);
-    audio_b64 = NULL;
+    const uint32_t cycle1_ms =
+        (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount() - t0);
 
     if (err != ESP_OK || transcript_text[0] == '\0') {
       strlcpy(transcript_text, "Descreva o que voce ve na imagem",
@@ -844,29 +1016,29 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
     }
 
     // Ciclo 2: modelo de visao com imagem + texto da transcricao
-    char *vision_prompt = malloc(APP_RESPONSE_TEXT_MAX * 2);
-    if (!vision_prompt) {
-      free(image_data_url);
-      return ESP_ERR_NO_MEM;
+    err = ESP_ERR_INVALID_STATE;
+    if (prep) {
+      err = app_vision_prep_send(prep, transcript_text, out_text,
+                                 out_text_len);
+    }
+    if (err == ESP_ERR_INVALID_STATE) {
+      char *vision_prompt = malloc(APP_RESPONSE_TEXT_MAX * 2);
+      if (!vision_prompt) {
+        return ESP_ERR_NO_MEM;
+      }
+      app_format_vision_prompt(vision_prompt, APP_RESPONSE_TEXT_MAX * 2,
+                               transcript_text);
+      err = app_call_ai_once(config_manager_get()->ai_model, NULL, &image,
+                             app_profile_system_prompt(s_expert_profile),
+                             vision_prompt, NULL, true, true, out_text,
+                             out_text_len, NULL);
+      free(vision_prompt);
     }
-    snprintf(
-        vision_prompt, APP_RESPONSE_TEXT_MAX * 2,
-        "O usuario perguntou: \"%s\"\n"
-        "INSTRUCOES:\n"
-        "1. Responda a pergunta diretamente usando o que voce ve na imagem.\n"
-        "2. Se a pergunta e sobre identificar algo, diga o que e.\n"
-        "3. Se ha texto, numeros ou logos na imagem, leia-os.\n"
-        "4. Se a pergunta nao tem relacao com a imagem, "
-        "responda a pergunta mesmo assim usando seu conhecimento.\n"
-        "5. Nunca diga apenas 'nao sei'. Sempre ofereca sua melhor analise.",
-        transcript_text);
-
-    err = app_call_ai_once(config_manager_get()->ai_model, NULL, image_data_url,
-                           app_profile_system_prompt(s_expert_profile),
-                           vision_prompt, NULL, true, out_text, out_text_len);
-    free(vision_prompt);
 
     if (err == ESP_OK) {
+      ESP_LOGI(TAG, "Photo+Voice (two-pass) done in %u ms (cycle 1 %u ms)",
+               (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - t0),
+               (unsigned)cycle1_ms);
       app_history_add(transcript_text, out_text);
     }
   } else {
@@ -874,8 +1046,6 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
     ESP_LOGI(TAG, "Audio-only path initiated");
     char *audio_only_prompt = malloc(APP_RESPONSE_TEXT_MAX);
     if (!audio_only_prompt) {
-      free(audio_b64);
-      free(image_data_url);
       return ESP_ERR_NO_MEM;
     }
     snprintf(audio_only_prompt, APP_RESPONSE_TEXT_MAX,
@@ -885,25 +1055,17 @@ static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
              "Nunca diga 'nao entendi' sem tentar responder. "
              "Vocabulario tecnico relevante: %s.",
              app_profile_transcription_terms(s_expert_profile));
-    const char *audio_model =
-        (strcmp(config_manager_get()->ai_model, "gpt-4o") == 0)
-            ? APP_AI_MODEL_AUDIO_TEXT
-            : config_manager_get()->ai_model;
-    err = app_call_ai_once(audio_model, audio_b64, NULL,
+    err = app_call_ai_once(audio_model, &audio, NULL,
                            app_profile_system_prompt(s_expert_profile), NULL,
-                           audio_only_prompt, true, out_text, out_text_len);
+                           audio_only_prompt, true, true, out_text,
+                           out_text_len, NULL);
     free(audio_only_prompt);
 
     if (err == ESP_OK) {
       app_history_add(NULL, out_text);
     }
-    // Libera audio_b64 apos uso
-    free(audio_b64);
-    audio_b64 = NULL;
   }
 
-  free(audio_b64); // seguro mesmo se ja foi liberado (NULL)
-  free(image_data_url);
   return err;
 }
 
@@ -1084,17 +1246,17 @@ static bool app_accept_button_edge(bool pressed_edge,
 }
 
 static void app_clear_locked_photo(void) {
-  free(s_locked_photo_jpeg);
+  bsp_jpeg_unref(s_locked_photo_jpeg);
   s_locked_photo_jpeg = NULL;
-  s_locked_photo_jpeg_len = 0;
   s_photo_capture_requested = false;
   s_photo_locked = false;
 }
 
-static void app_update_live_preview_if_needed(TickType_t now_ticks) {
+static void app_update_live_preview_if_needed(void) {
   if (app_storage_is_busy()) {
     if (s_preview_active) {
       s_preview_active = false;
+      app_camera_set_active(false);
       ESP_LOGI(TAG, "Camera preview paused while storage is busy");
     }
     return;
@@ -1107,6 +1269,7 @@ static void app_update_live_preview_if_needed(TickType_t now_ticks) {
     // Preview not needed - mark as inactive to free DMA
     if (s_preview_active) {
       s_preview_active = false;
+      app_camera_set_active(false);
       ESP_LOGI(TAG, "Camera preview disabled (state=%d) - DMA buffers freed",
                s_state);
       // Notify storage that preview is disabled - may have more DMA memory now
@@ -1118,113 +1281,80 @@ static void app_update_live_preview_if_needed(TickType_t now_ticks) {
   // Preview is needed - mark as active
   if (!s_preview_active) {
     s_preview_active = true;
+    /* Hide response panel so camera preview is fully visible. */
+    gui_set_response_panel_visible(false);
+    /* Captura, backoff de erros e entrega ao canvas ficam na task da camera
+     * (app_camera.c); aqui so liga e desliga o streaming. */
+    app_camera_set_active(true);
     ESP_LOGI(TAG, "Camera preview enabled - DMA buffers in use");
   }
 
-  if ((now_ticks - s_last_preview_ticks) <
-      pdMS_TO_TICKS(APP_PREVIEW_REFRESH_MS)) {
-    return;
-  }
-  s_last_preview_ticks = now_ticks;
-
-  /* Hide response panel so camera preview is fully visible. */
-  gui_set_response_panel_visible(false);
-
-  // CRITICAL: Protect against serial buffer overflow from camera init errors
-  // Add exponential backoff if camera keeps failing to prevent flooding serial
-  // port
-  static int s_camera_error_count = 0;
-  static TickType_t s_last_camera_error_ticks = 0;
-
-  uint8_t *preview_data = NULL;
-  uint16_t preview_w = 0;
-  uint16_t preview_h = 0;
-
-  static bool camera_vfs_registered = false;
-  static bool camera_init_failed_permanently = false;
-
-  esp_err_t camera_err = ESP_FAIL;
-
-  if (!camera_init_failed_permanently) {
-    if (!camera_vfs_registered) {
-      camera_err = bsp_camera_capture_preview_rgb565(&preview_data, &preview_w,
-                                                     &preview_h);
-      if (camera_err == ESP_OK) {
-        camera_vfs_registered = true;
-      } else {
-        // Wait longer before retrying to prevent VFS race
-        vTaskDelay(pdMS_TO_TICKS(1000));
-      }
-    } else {
-      camera_err = bsp_camera_capture_preview_rgb565(&preview_data, &preview_w,
-                                                     &preview_h);
+  // Try one early mount after camera is stable to avoid runtime mount
+  // failures due to heap fragmentation.
+  // Atraso intencional para o subsistema ISP e barramento LDO estabilizarem
+  // (so depois do primeiro frame publicado)
+  static bool s_mount_after_camera_done = false;
+  if (!s_mount_after_camera_done) {
+    app_camera_stats_t cam_stats;
+    app_camera_get_stats(&cam_stats);
+    if (cam_stats.published > 0) {
+      s_mount_after_camera_done = true;
+      vTaskDelay(pdMS_TO_TICKS(500));
+      app_storage_mount_after_camera_init();
     }
   }
+}
 
-  if (camera_err == ESP_OK) {
-    if (!camera_vfs_registered) {
-      camera_vfs_registered = true;
-    }
-    s_camera_error_count = 0; // Reset error counter on success
-
-    // Try one early mount after camera is stable to avoid runtime mount
-    // failures due to heap fragmentation.
-    // Atraso intencional para o subsistema ISP e barramento LDO estabilizarem
-    vTaskDelay(pdMS_TO_TICKS(500));
-    app_storage_mount_after_camera_init();
-
-    (void)gui_show_camera_preview_rgb565(preview_data, preview_w, preview_h);
+/* Fallback da foto: o ultimo frame do live view, o mesmo que esta na tela,
+ * sem esperar a camera. So com o streaming ligado (frame recente). */
+static esp_err_t app_encode_preview_snapshot(bsp_jpeg_t **jpeg) {
+  if (!s_preview_active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  uint8_t *frame = heap_caps_malloc(APP_CAMERA_FRAME_BYTES,
+                                    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!frame) {
+    return ESP_ERR_NO_MEM;
+  }
+  uint32_t sequence = 0;
+  esp_err_t err = app_camera_snapshot(frame, APP_CAMERA_FRAME_BYTES, true,
+                                      &sequence);
+  if (err == ESP_OK) {
+    err = bsp_jpeg_encode_rgb565(frame, APP_CAMERA_FRAME_W,
+                                 APP_CAMERA_FRAME_H, jpeg);
+  }
+  heap_caps_free(frame);
+  if (err == ESP_OK) {
+    ESP_LOGI(TAG, "Photo from live-view frame #%u", (unsigned)sequence);
   } else {
-    // Increment error counter and add delay to prevent serial buffer overflow
-    s_camera_error_count++;
-    TickType_t time_since_last_error = now_ticks - s_last_camera_error_ticks;
-
-    // Se falhar consecutivamente muitas vezes, desiste de tentar ligar a câmera
-    // este boot
-    if (s_camera_error_count > 20) {
-      camera_init_failed_permanently = true;
-    }
-
-    // Exponential backoff: delay increases with consecutive errors
-    // Max delay: 5 seconds to prevent overwhelming serial port
-    int delay_ms =
-        (s_camera_error_count < 10) ? (s_camera_error_count * 100) : 5000;
-
-    // Only delay if enough time has passed since last error (avoid blocking)
-    if (time_since_last_error > pdMS_TO_TICKS(delay_ms)) {
-      if (s_camera_error_count <= 3) {
-        // Log first few errors normally
-        ESP_LOGD(TAG, "Camera preview failed (count: %d): %s",
-                 s_camera_error_count, esp_err_to_name(camera_err));
-      } else if (s_camera_error_count == 4) {
-        // Log once when entering backoff mode
-        ESP_LOGW(TAG, "Camera init failing repeatedly, entering backoff mode "
-                      "to protect serial port");
-      }
-      // Don't spam serial port - errors are already logged by BSP
-      s_last_camera_error_ticks = now_ticks;
-    }
+    ESP_LOGW(TAG, "Live-view snapshot unavailable (%s)", esp_err_to_name(err));
   }
-  free(preview_data);
+  return err;
 }
 
 static void app_capture_and_lock_photo(void) {
   app_clear_locked_photo();
 
-  uint8_t *preview_data = NULL;
-  uint16_t preview_w = 0;
-  uint16_t preview_h = 0;
-  esp_err_t prev_err =
-      bsp_camera_capture_preview_rgb565(&preview_data, &preview_w, &preview_h);
-  if (prev_err == ESP_OK) {
-    (void)gui_show_camera_preview_rgb565(preview_data, preview_w, preview_h);
+  /* A foto para a IA sai de um frame inteiro do ISP, na resolucao e no
+   * orcamento de bytes do settings.json, nao da miniatura da tela. */
+  const app_config_t *cfg = config_manager_get();
+  const bsp_vision_cfg_t vision_cfg = {
+      .size_px = cfg->camera_vision_size,
+      .budget_bytes = (size_t)cfg->camera_jpeg_budget_kb * 1024,
+  };
+  bsp_vision_stats_t vision_stats = {0};
+  esp_err_t cam_err = bsp_camera_capture_vision_jpeg(
+      &vision_cfg, &s_locked_photo_jpeg, &vision_stats);
+  if (cam_err != ESP_OK) {
+    ESP_LOGW(TAG, "Vision capture failed (%s), using the preview frame",
+             esp_err_to_name(cam_err));
+    vision_stats.width = 0;
+    cam_err = app_encode_preview_snapshot(&s_locked_photo_jpeg);
+    if (cam_err != ESP_OK) {
+      cam_err = bsp_camera_capture_jpeg(&s_locked_photo_jpeg);
+    }
   }
-  free(preview_data);
-
-  esp_err_t cam_err =
-      bsp_camera_capture_jpeg(&s_locked_photo_jpeg, &s_locked_photo_jpeg_len);
-  if (cam_err != ESP_OK || !s_locked_photo_jpeg ||
-      s_locked_photo_jpeg_len == 0) {
+  if (cam_err != ESP_OK || !s_locked_photo_jpeg) {
     app_clear_locked_photo();
     gui_set_response_compact(true);
     gui_set_response("Erro ao capturar foto.\nTente novamente.");
@@ -1234,27 +1364,32 @@ static void app_capture_and_lock_photo(void) {
   s_photo_capture_requested = true;
   s_photo_locked = true;
   gui_set_response_compact(true);
-  gui_set_response("Foto OK!\nSegure encoder e fale.");
+  if (vision_stats.width > 0) {
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Foto OK! %upx, %u KB\nSegure encoder e fale.",
+             (unsigned)vision_stats.width,
+             (unsigned)((s_locked_photo_jpeg->len + 512) / 1024));
+    gui_set_response(msg);
+  } else {
+    gui_set_response("Foto OK!\nSegure encoder e fale.");
+  }
 }
 
 static esp_err_t app_do_interaction(void) {
   ESP_LOGI(TAG, "starting interaction in mode=%s",
            app_mode_name(s_interaction_mode));
 
-  uint8_t *jpeg_data = NULL;
-  size_t jpeg_len = 0;
+  /* A foto segue por referencia ate o base64 e a fila do SD, sem copia */
+  bsp_jpeg_t *jpeg = NULL;
   if (s_interaction_mode == APP_INTERACTION_MODE_AUDIO_IMAGE_TEXT) {
-    if (!s_photo_locked || !s_photo_capture_requested || !s_locked_photo_jpeg ||
-        s_locked_photo_jpeg_len == 0) {
+    if (!s_photo_locked || !s_photo_capture_requested || !s_locked_photo_jpeg) {
       gui_set_response_compact(true);
       gui_set_response("Capture foto primeiro.\n(Btn1)");
       app_set_state(APP_STATE_IDLE);
       return ESP_OK;
     }
-    jpeg_data = s_locked_photo_jpeg;
-    jpeg_len = s_locked_photo_jpeg_len;
+    jpeg = s_locked_photo_jpeg;
     s_locked_photo_jpeg = NULL;
-    s_locked_photo_jpeg_len = 0;
     s_photo_locked = false;
     s_photo_capture_requested = false;
   }
@@ -1268,9 +1403,11 @@ static esp_err_t app_do_interaction(void) {
   }
   if (!audio_buffer) {
     ESP_LOGE(TAG, "no memory for audio buffer");
+    bsp_jpeg_unref(jpeg);
     return ESP_ERR_NO_MEM;
   }
   app_set_state(APP_STATE_LISTENING);
+  app_ai_prewarm_start();
   size_t captured_bytes = 0;
   const TickType_t capture_start = xTaskGetTickCount();
   while (bsp_button_is_pressed() && (xTaskGetTickCount() - capture_start) <
@@ -1300,7 +1437,9 @@ static esp_err_t app_do_interaction(void) {
         &capture_cfg, audio_buffer + captured_bytes, remaining, &chunk_bytes);
     if (capture_err != ESP_OK) {
       ESP_LOGE(TAG, "audio capture failed: %s", esp_err_to_name(capture_err));
+      ai_client_prewarm_cancel();
       free(audio_buffer);
+      bsp_jpeg_unref(jpeg);
       return capture_err;
     }
     captured_bytes += chunk_bytes;
@@ -1313,13 +1452,16 @@ static esp_err_t app_do_interaction(void) {
     }
     gui_set_response("Fale por mais tempo\n(minimo 2 segundos).");
     app_set_state(APP_STATE_IDLE);
+    ai_client_prewarm_cancel();
     free(audio_buffer);
+    bsp_jpeg_unref(jpeg);
     return ESP_OK;
   }
 
   // Disable preview when starting interaction to free DMA memory
   if (s_preview_active) {
     s_preview_active = false;
+    app_camera_set_active(false);
     ESP_LOGI(TAG,
              "Camera preview disabled for interaction - DMA buffers freed");
   }
@@ -1328,15 +1470,20 @@ static esp_err_t app_do_interaction(void) {
 
   size_t wav_len = 0;
   uint8_t *wav_data =
-      app_pcm16_to_wav(audio_buffer, captured_bytes, 16000, 1, 16, &wav_len);
+      app_encode_audio(audio_buffer, captured_bytes, 16000, &wav_len);
   if (!wav_data) {
+    ai_client_prewarm_cancel();
     free(audio_buffer);
+    bsp_jpeg_unref(jpeg);
     return ESP_ERR_NO_MEM;
   }
 
   char ai_response[APP_RESPONSE_TEXT_MAX];
   esp_err_t ai_err = app_call_ai_with_audio(
-      wav_data, wav_len, jpeg_data, jpeg_len, ai_response, sizeof(ai_response));
+      wav_data, wav_len, jpeg ? jpeg->data : NULL, jpeg ? jpeg->len : 0,
+      ai_response, sizeof(ai_response));
+  /* Falhas antes do envio deixam o pre-warm sem uso */
+  ai_client_prewarm_cancel();
   free(wav_data);
 
   // --- Save audio to SD card (WAV, opportunistic) ---
@@ -1352,17 +1499,17 @@ static esp_err_t app_do_interaction(void) {
     }
   }
 
-  // Queue JPEG for saving after AI interaction (buffered in PSRAM)
+  // Queue JPEG for saving after AI interaction (kept in PSRAM)
   // This avoids SDMMC/DMA conflicts during network communication
   // Images will be saved after AI response is received
-  if (jpeg_data && jpeg_len > 0) {
-    esp_err_t queue_err = app_storage_queue_image(jpeg_data, jpeg_len);
+  if (jpeg) {
+    esp_err_t queue_err = app_storage_queue_image(jpeg);
     if (queue_err != ESP_OK) {
       ESP_LOGW(TAG, "Failed to queue image for saving: %s",
                esp_err_to_name(queue_err));
     }
   }
-  free(jpeg_data);
+  bsp_jpeg_unref(jpeg);
 
   /* Hide camera / photo so the response is shown on a clean background. */
   gui_hide_camera_preview();
@@ -1576,7 +1723,7 @@ static void app_task(void *arg) {
           s_interaction_requested = false;
         }
 
-        app_update_live_preview_if_needed(xTaskGetTickCount());
+        app_update_live_preview_if_needed();
       }
 
       /* --------------------------------------------------------
@@ -1646,6 +1793,12 @@ esp_err_t app_init(void) {
                          MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
   }
 
+  esp_err_t camera_err = app_camera_init();
+  if (camera_err != ESP_OK) {
+    ESP_LOGW(TAG, "Camera task init failed: %s (no live preview)",
+             esp_err_to_name(camera_err));
+  }
+
   // Initialize storage subsystem
   esp_err_t storage_err = app_storage_init();
   if (storage_err != ESP_OK) {
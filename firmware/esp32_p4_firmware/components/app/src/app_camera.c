@@ -0,0 +1,261 @@
+#include "app_camera.h"
+
+#include <string.h>
+
+#include "bsp.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "gui.h"
+
+static const char *TAG = "app_camera";
+
+#define APP_CAMERA_TASK_STACK_SIZE (4 * 1024)
+#define APP_CAMERA_TASK_PRIORITY 4 // Below app_task: buttons stay responsive
+#define APP_CAMERA_TASK_CORE 1     // app_task and LVGL live on core 0
+#define APP_CAMERA_MIN_FRAME_US (33 * 1000) // ~30 fps, the display rate
+#define APP_CAMERA_FPS_WINDOW_US (5 * 1000 * 1000)
+#define APP_CAMERA_MAX_ERRORS 20 // Consecutive failures before giving up
+#define APP_CAMERA_BACKOFF_MAX_MS 5000
+#define APP_CAMERA_SNAPSHOT_TRIES 3
+
+/*
+ * Mailbox: three frames. The producer owns one (s_write_idx), the GUI owns
+ * the one on screen (s_read_idx) and the third sits in s_slot, tagged FRESH
+ * while it holds a frame the GUI has not taken yet. Both sides only ever
+ * exchange their own frame with the slot, so neither waits for the other.
+ *
+ * s_newest is (sequence << 2 | index) of the last published frame, for
+ * snapshots: that frame is not written again until a later publish has
+ * changed s_newest, so a copy taken while it stayed the same is consistent.
+ */
+#define SLOT_INDEX_MASK 0x3u
+#define SLOT_FRESH 0x4u
+
+static uint8_t *s_frames[3];
+static int64_t s_frame_captured_us[3];
+static uint32_t s_slot;
+static uint32_t s_newest; // 0: nothing published yet
+static uint32_t s_write_idx; // camera task only
+static uint32_t s_read_idx;  // GUI (LVGL task) only
+static bool s_active;
+static bool s_failed;
+static TaskHandle_t s_task;
+static app_camera_stats_t s_stats;
+
+static void app_camera_stat_add(uint32_t *counter, uint32_t n) {
+  __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+static void app_camera_publish(int64_t captured_us, uint32_t sequence) {
+  const uint32_t idx = s_write_idx;
+  s_frame_captured_us[idx] = captured_us;
+  const uint32_t prev =
+      __atomic_exchange_n(&s_slot, idx | SLOT_FRESH, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&s_newest, (sequence << 2) | idx, __ATOMIC_RELEASE);
+  /* Snapshot readers must see s_newest change before the producer starts
+   * overwriting the frame it got back. */
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  s_write_idx = prev & SLOT_INDEX_MASK;
+  if (prev & SLOT_FRESH) {
+    app_camera_stat_add(&s_stats.dropped, 1);
+  }
+  app_camera_stat_add(&s_stats.published, 1);
+}
+
+/* gui_preview_source_t: runs in the LVGL task. */
+static const uint8_t *app_camera_take_latest(void) {
+  if (!__atomic_load_n(&s_active, __ATOMIC_ACQUIRE) ||
+      !(__atomic_load_n(&s_slot, __ATOMIC_ACQUIRE) & SLOT_FRESH)) {
+    return NULL;
+  }
+  const uint32_t prev =
+      __atomic_exchange_n(&s_slot, s_read_idx, __ATOMIC_ACQ_REL);
+  s_read_idx = prev & SLOT_INDEX_MASK;
+
+  const uint32_t latency_us =
+      (uint32_t)(esp_timer_get_time() - s_frame_captured_us[s_read_idx]);
+  __atomic_store_n(&s_stats.latency_us, latency_us, __ATOMIC_RELAXED);
+  if (latency_us > __atomic_load_n(&s_stats.latency_max_us, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&s_stats.latency_max_us, latency_us, __ATOMIC_RELAXED);
+  }
+  app_camera_stat_add(&s_stats.shown, 1);
+  return s_frames[s_read_idx];
+}
+
+static void app_camera_log_stats(void) {
+  app_camera_stats_t st;
+  app_camera_get_stats(&st);
+  ESP_LOGI(TAG,
+           "published=%u shown=%u dropped=%u errors=%u fps=%u.%u "
+           "latency=%u us (max %u us)",
+           (unsigned)st.published, (unsigned)st.shown, (unsigned)st.dropped,
+           (unsigned)st.errors, (unsigned)(st.fps_x10 / 10),
+           (unsigned)(st.fps_x10 % 10), (unsigned)st.latency_us,
+           (unsigned)st.latency_max_us);
+}
+
+static void app_camera_task(void *arg) {
+  (void)arg;
+  uint32_t sequence = 0;
+  uint32_t errors_in_row = 0;
+  int64_t last_publish_us = 0;
+  int64_t window_start_us = 0;
+  uint32_t window_frames = 0;
+
+  for (;;) {
+    if (!__atomic_load_n(&s_active, __ATOMIC_ACQUIRE) || s_failed) {
+      if (bsp_camera_session_is_active()) {
+        bsp_camera_session_stop();
+        app_camera_log_stats();
+      }
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      window_start_us = 0;
+      continue;
+    }
+
+    /* Pace to the display rate: faster frames would only be dropped. */
+    const int64_t since_us = esp_timer_get_time() - last_publish_us;
+    if (since_us < APP_CAMERA_MIN_FRAME_US) {
+      const TickType_t wait = pdMS_TO_TICKS(
+          (uint32_t)((APP_CAMERA_MIN_FRAME_US - since_us) / 1000));
+      vTaskDelay(wait > 0 ? wait : 1);
+    }
+
+    int64_t captured_us = 0;
+    const esp_err_t err = bsp_camera_capture_preview_into(
+        s_frames[s_write_idx], APP_CAMERA_FRAME_W, APP_CAMERA_FRAME_H,
+        BSP_PREVIEW_SWAP_BYTES | BSP_PREVIEW_BOX_FILTER, &captured_us);
+    if (err != ESP_OK) {
+      app_camera_stat_add(&s_stats.errors, 1);
+      errors_in_row++;
+      if (errors_in_row > APP_CAMERA_MAX_ERRORS) {
+        ESP_LOGE(TAG, "camera failing repeatedly (%s), giving up this boot",
+                 esp_err_to_name(err));
+        s_failed = true;
+        continue;
+      }
+      if (errors_in_row <= 3) {
+        ESP_LOGD(TAG, "capture failed (count: %u): %s",
+                 (unsigned)errors_in_row, esp_err_to_name(err));
+      } else if (errors_in_row == 4) {
+        ESP_LOGW(TAG, "camera failing repeatedly, entering backoff mode");
+      }
+      // Exponential-ish backoff; wakes up early if streaming is turned off
+      const uint32_t delay_ms = (errors_in_row < 10) ? errors_in_row * 100
+                                                     : APP_CAMERA_BACKOFF_MAX_MS;
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(delay_ms));
+      continue;
+    }
+    errors_in_row = 0;
+    if (!__atomic_load_n(&s_active, __ATOMIC_ACQUIRE)) {
+      continue; // Turned off mid-capture: keep the frozen frame on screen
+    }
+
+    app_camera_publish(captured_us, ++sequence);
+    last_publish_us = esp_timer_get_time();
+
+    if (window_start_us == 0) {
+      window_start_us = last_publish_us;
+      window_frames = 0;
+    } else if (++window_frames,
+               last_publish_us - window_start_us >= APP_CAMERA_FPS_WINDOW_US) {
+      const uint32_t fps_x10 = (uint32_t)(
+          ((int64_t)window_frames * 10 * 1000000) /
+          (last_publish_us - window_start_us));
+      __atomic_store_n(&s_stats.fps_x10, fps_x10, __ATOMIC_RELAXED);
+      window_start_us = last_publish_us;
+      window_frames = 0;
+      ESP_LOGD(TAG, "%u.%u fps", (unsigned)(fps_x10 / 10),
+               (unsigned)(fps_x10 % 10));
+    }
+  }
+}
+
+esp_err_t app_camera_init(void) {
+  if (s_task) {
+    return ESP_OK;
+  }
+  for (int i = 0; i < 3; i++) {
+    s_frames[i] = heap_caps_malloc(APP_CAMERA_FRAME_BYTES,
+                                   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s_frames[i]) {
+      s_frames[i] = heap_caps_malloc(APP_CAMERA_FRAME_BYTES,
+                                     MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!s_frames[i]) {
+      for (int j = 0; j < i; j++) {
+        heap_caps_free(s_frames[j]);
+        s_frames[j] = NULL;
+      }
+      return ESP_ERR_NO_MEM;
+    }
+  }
+  s_write_idx = 0;
+  s_slot = 1;
+  s_read_idx = 2;
+
+  if (xTaskCreatePinnedToCore(app_camera_task, "camera",
+                              APP_CAMERA_TASK_STACK_SIZE, NULL,
+                              APP_CAMERA_TASK_PRIORITY, &s_task,
+                              APP_CAMERA_TASK_CORE) != pdPASS) {
+    return ESP_FAIL;
+  }
+  return gui_camera_preview_set_source(app_camera_take_latest);
+}
+
+void app_camera_set_active(bool active) {
+  if (__atomic_exchange_n(&s_active, active, __ATOMIC_ACQ_REL) == active) {
+    return;
+  }
+  if (s_task) {
+    xTaskNotifyGive(s_task);
+  }
+}
+
+esp_err_t app_camera_snapshot(uint8_t *dst, size_t dst_len, bool camera_order,
+                              uint32_t *sequence) {
+  if (!dst || dst_len < APP_CAMERA_FRAME_BYTES) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (int attempt = 0; attempt < APP_CAMERA_SNAPSHOT_TRIES; attempt++) {
+    const uint32_t newest = __atomic_load_n(&s_newest, __ATOMIC_ACQUIRE);
+    if (newest == 0) {
+      return ESP_ERR_NOT_FOUND;
+    }
+    const uint32_t *src = (const uint32_t *)s_frames[newest & SLOT_INDEX_MASK];
+    uint32_t *out = (uint32_t *)dst;
+    if (camera_order) {
+      for (size_t i = 0; i < APP_CAMERA_FRAME_BYTES / 4; i++) {
+        const uint32_t w = src[i];
+        out[i] = ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+      }
+    } else {
+      memcpy(out, src, APP_CAMERA_FRAME_BYTES);
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s_newest, __ATOMIC_RELAXED) == newest) {
+      if (sequence) {
+        *sequence = newest >> 2;
+      }
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_TIMEOUT;
+}
+
+void app_camera_get_stats(app_camera_stats_t *out) {
+  if (!out) {
+    return;
+  }
+  out->published = __atomic_load_n(&s_stats.published, __ATOMIC_RELAXED);
+  out->shown = __atomic_load_n(&s_stats.shown, __ATOMIC_RELAXED);
+  out->dropped = __atomic_load_n(&s_stats.dropped, __ATOMIC_RELAXED);
+  out->errors = __atomic_load_n(&s_stats.errors, __ATOMIC_RELAXED);
+  out->fps_x10 = __atomic_load_n(&s_stats.fps_x10, __ATOMIC_RELAXED);
+  out->latency_us = __atomic_load_n(&s_stats.latency_us, __ATOMIC_RELAXED);
+  out->latency_max_us =
+      __atomic_load_n(&s_stats.latency_max_us, __ATOMIC_RELAXED);
+}
@@ -1,5 +1,6 @@
 #include "app_storage.h"
 
+#include "audio_codec.h"
 #include "bsp/esp32_p4_eye.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
@@ -21,16 +22,14 @@ static bool s_sd_mounted = false;
 
 // PSRAM buffer for queued JPEG images (to avoid SDMMC conflicts during network
 // I/O)
-#define MAX_QUEUED_IMAGES 2        // Reduced to 2 for easier testing
-#define MAX_JPEG_SIZE (256 * 1024) // 256KB max per image
+#define MAX_QUEUED_IMAGES 2 // Reduced to 2 for easier testing
 #define INACTIVITY_TIMEOUT_MS                                                  \
   (10 * 1000) // 10 seconds of inactivity before saving
 #define MIN_QUEUE_FOR_IMMEDIATE_SAVE                                           \
   1 // Save immediately if queue is almost full (1 of 2)
 
 typedef struct {
-  uint8_t *data; // Allocated in PSRAM
-  size_t len;
+  bsp_jpeg_t *jpeg; // Reference held while queued (pooled PSRAM buffer)
   bool valid;
   time_t timestamp; // When image was queued
 } queued_image_t;
@@ -163,11 +162,8 @@ static void app_queue_clear(void) {
     return;
   }
   while (s_queue_count > 0) {
-    if (s_image_queue[s_queue_head].valid && s_image_queue[s_queue_head].data) {
-      free(s_image_queue[s_queue_head].data);
-      s_image_queue[s_queue_head].data = NULL;
-    }
-    s_image_queue[s_queue_head].len = 0;
+    bsp_jpeg_unref(s_image_queue[s_queue_head].jpeg);
+    s_image_queue[s_queue_head].jpeg = NULL;
     s_image_queue[s_queue_head].timestamp = 0;
     s_image_queue[s_queue_head].valid = false;
     s_queue_head = (s_queue_head + 1) % MAX_QUEUED_IMAGES;
@@ -191,8 +187,7 @@ static bool app_queue_pop(queued_image_t *out_item) {
   }
 
   *out_item = s_image_queue[s_queue_head];
-  s_image_queue[s_queue_head].data = NULL;
-  s_image_queue[s_queue_head].len = 0;
+  s_image_queue[s_queue_head].jpeg = NULL;
   s_image_queue[s_queue_head].timestamp = 0;
   s_image_queue[s_queue_head].valid = false;
   s_queue_head = (s_queue_head + 1) % MAX_QUEUED_IMAGES;
@@ -369,12 +364,12 @@ static void app_storage_process_queue_internal(void) {
 
   queued_image_t image_item = {0};
   while (app_queue_pop(&image_item)) {
-    if (!image_item.valid || !image_item.data || image_item.len == 0) {
+    if (!image_item.valid || !image_item.jpeg) {
       continue;
     }
 
     esp_err_t save_ret =
-        app_storage_save_image(image_item.data, image_item.len);
+        app_storage_save_image(image_item.jpeg->data, image_item.jpeg->len);
     if (save_ret == ESP_OK) {
       saved_count++;
     } else {
@@ -383,11 +378,10 @@ static void app_storage_process_queue_internal(void) {
                esp_err_to_name(save_ret));
     }
 
-    // Libera buffer PSRAM
-    free(image_item.data);
-    image_item.data = NULL;
+    // Devolve o buffer ao pool de JPEG
+    bsp_jpeg_unref(image_item.jpeg);
+    image_item.jpeg = NULL;
     image_item.valid = false;
-    image_item.len = 0;
   }
 
   ESP_LOGI(TAG, "Batch save complete (SD kept mounted): %d saved, %d failed",
@@ -628,14 +622,14 @@ esp_err_t app_storage_save_image(const uint8_t *jpeg_data, size_t jpeg_len) {
 
 bool app_storage_is_ready(void) { return bsp_sdcard_is_present(); }
 
-esp_err_t app_storage_queue_image(const uint8_t *jpeg_data, size_t jpeg_len) {
-  if (!jpeg_data || jpeg_len == 0) {
+esp_err_t app_storage_queue_image(bsp_jpeg_t *jpeg) {
+  if (!jpeg || !jpeg->data || jpeg->len == 0) {
     ESP_LOGE(TAG, "Invalid parameters for queue");
     return ESP_ERR_INVALID_ARG;
   }
 
   // Validate JPEG
-  if (!validate_jpeg(jpeg_data, jpeg_len)) {
+  if (!validate_jpeg(jpeg->data, jpeg->len)) {
     ESP_LOGE(TAG, "Invalid JPEG data (missing FF D8 marker)");
     return ESP_ERR_INVALID_ARG;
   }
@@ -650,48 +644,24 @@ esp_err_t app_storage_queue_image(const uint8_t *jpeg_data, size_t jpeg_len) {
   if (s_queue_count >= MAX_QUEUED_IMAGES) {
     ESP_LOGW(TAG, "Image queue full (%d images), dropping oldest",
              s_queue_count);
-    // Free oldest image
-    if (s_image_queue[s_queue_head].valid && s_image_queue[s_queue_head].data) {
-      free(s_image_queue[s_queue_head].data);
-      s_image_queue[s_queue_head].data = NULL;
-      s_image_queue[s_queue_head].valid = false;
-      s_image_queue[s_queue_head].len = 0;
-      s_image_queue[s_queue_head].timestamp = 0;
-    }
+    // Release oldest image
+    bsp_jpeg_unref(s_image_queue[s_queue_head].jpeg);
+    s_image_queue[s_queue_head].jpeg = NULL;
+    s_image_queue[s_queue_head].valid = false;
+    s_image_queue[s_queue_head].timestamp = 0;
     s_queue_head = (s_queue_head + 1) % MAX_QUEUED_IMAGES;
     s_queue_count--;
   }
 
-  // Check JPEG size limit
-  if (jpeg_len > MAX_JPEG_SIZE) {
-    ESP_LOGW(TAG, "JPEG too large (%u bytes, max %u), truncating",
-             (unsigned)jpeg_len, (unsigned)MAX_JPEG_SIZE);
-    jpeg_len = MAX_JPEG_SIZE;
-  }
-
-  // Allocate buffer in PSRAM for JPEG data
-  uint8_t *buffer =
-      heap_caps_malloc(jpeg_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!buffer) {
-    ESP_LOGE(TAG, "Failed to allocate PSRAM buffer for JPEG (%u bytes)",
-             (unsigned)jpeg_len);
-    xSemaphoreGive(s_queue_mutex);
-    return ESP_ERR_NO_MEM;
-  }
-
-  // Copy JPEG data to PSRAM buffer
-  memcpy(buffer, jpeg_data, jpeg_len);
-
   // Add to queue with timestamp
-  s_image_queue[s_queue_tail].data = buffer;
-  s_image_queue[s_queue_tail].len = jpeg_len;
+  s_image_queue[s_queue_tail].jpeg = bsp_jpeg_ref(jpeg);
   s_image_queue[s_queue_tail].valid = true;
   s_image_queue[s_queue_tail].timestamp = time(NULL);
   s_queue_tail = (s_queue_tail + 1) % MAX_QUEUED_IMAGES;
   s_queue_count++;
 
   ESP_LOGI(TAG, "JPEG queued in PSRAM (%u bytes, queue: %d/%d)",
-           (unsigned)jpeg_len, s_queue_count, MAX_QUEUED_IMAGES);
+           (unsigned)jpeg->len, s_queue_count, MAX_QUEUED_IMAGES);
 
   const bool trigger_immediate =
       (s_queue_count >= MIN_QUEUE_FOR_IMMEDIATE_SAVE);
@@ -730,60 +700,6 @@ int app_storage_get_queue_count(void) { return app_queue_get_count(); }
 
 bool app_storage_is_busy(void) { return s_storage_busy; }
 
-/* -----------------------------------------------------------------------
- * WAV helper – build a minimal 44-byte RIFF/PCM header in-place.
- * 16-bit, mono, PCM (format tag 1).
- * ----------------------------------------------------------------------- */
-static void build_wav_header(uint8_t *hdr, uint32_t pcm_bytes,
-                             uint32_t sample_rate_hz) {
-  const uint16_t num_channels = 1;
-  const uint16_t bits_per_sample = 16;
-  const uint32_t byte_rate =
-      sample_rate_hz * num_channels * (bits_per_sample / 8);
-  const uint16_t block_align = num_channels * (bits_per_sample / 8);
-  const uint32_t data_chunk_size = pcm_bytes;
-  const uint32_t riff_size =
-      36 + pcm_bytes; /* 36 = rest of header after RIFF */
-
-  /* RIFF chunk */
-  memcpy(hdr, "RIFF", 4);
-  hdr[4] = (uint8_t)(riff_size);
-  hdr[5] = (uint8_t)(riff_size >> 8);
-  hdr[6] = (uint8_t)(riff_size >> 16);
-  hdr[7] = (uint8_t)(riff_size >> 24);
-  memcpy(hdr + 8, "WAVE", 4);
-
-  /* fmt sub-chunk */
-  memcpy(hdr + 12, "fmt ", 4);
-  hdr[16] = 16;
-  hdr[17] = 0;
-  hdr[18] = 0;
-  hdr[19] = 0; /* sub-chunk size = 16 */
-  hdr[20] = 1;
-  hdr[21] = 0; /* PCM = 1 */
-  hdr[22] = (uint8_t)(num_channels);
-  hdr[23] = (uint8_t)(num_channels >> 8);
-  hdr[24] = (uint8_t)(sample_rate_hz);
-  hdr[25] = (uint8_t)(sample_rate_hz >> 8);
-  hdr[26] = (uint8_t)(sample_rate_hz >> 16);
-  hdr[27] = (uint8_t)(sample_rate_hz >> 24);
-  hdr[28] = (uint8_t)(byte_rate);
-  hdr[29] = (uint8_t)(byte_rate >> 8);
-  hdr[30] = (uint8_t)(byte_rate >> 16);
-  hdr[31] = (uint8_t)(byte_rate >> 24);
-  hdr[32] = (uint8_t)(block_align);
-  hdr[33] = (uint8_t)(block_align >> 8);
-  hdr[34] = (uint8_t)(bits_per_sample);
-  hdr[35] = (uint8_t)(bits_per_sample >> 8);
-
-  /* data sub-chunk */
-  memcpy(hdr + 36, "data", 4);
-  hdr[40] = (uint8_t)(data_chunk_size);
-  hdr[41] = (uint8_t)(data_chunk_size >> 8);
-  hdr[42] = (uint8_t)(data_chunk_size >> 16);
-  hdr[43] = (uint8_t)(data_chunk_size >> 24);
-}
-
 /* -----------------------------------------------------------------------
  * Ensure SD is mounted (reuses the already-mounted state to avoid DMA
  * fragmentation).  Returns ESP_OK only when mount is confirmed.
@@ -851,8 +767,8 @@ esp_err_t app_storage_save_audio(const uint8_t *pcm_data, size_t pcm_bytes,
   }
 
   /* Write WAV header */
-  uint8_t wav_hdr[44];
-  build_wav_header(wav_hdr, (uint32_t)pcm_bytes, sample_rate_hz);
+  uint8_t wav_hdr[AUDIO_WAV_HEADER_LEN];
+  audio_wav_pcm16_header(wav_hdr, (uint32_t)pcm_bytes, sample_rate_hz, 1);
   size_t hdr_written = fwrite(wav_hdr, 1, sizeof(wav_hdr), f);
 
   /* Write PCM payload */
@@ -46,6 +46,7 @@ static const char *s_html_page =
     "6px;"
     "border:1px solid #0f3460;background:#0f3460;color:#eee;font-size:14px}"
     "textarea{height:70px;resize:vertical}"
+    "input[type=checkbox]{width:auto;margin-right:8px}"
     "button{margin-top:18px;width:100%;padding:12px;background:#e94560;"
     "color:#fff;border:none;border-radius:8px;font-size:16px;cursor:pointer}"
     "button:hover{background:#c73652}"
@@ -64,6 +65,10 @@ static const char *s_html_page =
     "placeholder='https://api.openai.com/v1/chat/completions'>"
     "<label>Modelo da IA</label>"
     "<input name='model' maxlength='63' placeholder='gpt-4o'>"
+    "<label><input name='single_request' type='checkbox' value='1'>"
+    "Foto+Voz em uma requisi&ccedil;&atilde;o</label>"
+    "<p class='note'>Envia &aacute;udio e imagem juntos (mais r&aacute;pido). "
+    "Requer modelo que aceite os dois; sen&atilde;o usa duas etapas.</p>"
     "<label>Personalidade da IA</label>"
     "<textarea name='personality' maxlength='255'>"
     "Voce e um assistente inteligente e conciso.</textarea>"
@@ -255,6 +260,7 @@ static esp_err_t post_save_handler(httpd_req_t *req) {
   char personality[256] = {0};
   char base_url[128] = {0};
   char model[64] = {0};
+  char single_request[4] = {0};
 
   form_get_field(body, "ssid", ssid, sizeof(ssid));
   form_get_field(body, "pass", pass, sizeof(pass));
@@ -262,6 +268,9 @@ static esp_err_t post_save_handler(httpd_req_t *req) {
   form_get_field(body, "personality", personality, sizeof(personality));
   form_get_field(body, "base_url", base_url, sizeof(base_url));
   form_get_field(body, "model", model, sizeof(model));
+  /* Checkbox desmarcado nao e enviado pelo navegador */
+  form_get_field(body, "single_request", single_request,
+                 sizeof(single_request));
   free(body);
 
   if (strlen(ssid) == 0 || strlen(token) == 0) {
@@ -270,12 +279,15 @@ static esp_err_t post_save_handler(httpd_req_t *req) {
     return ESP_FAIL;
   }
 
-  ESP_LOGI(TAG, "POST /save => ssid='%s' token='%.8s...' url='%s' model='%s'",
-           ssid, token, base_url, model);
+  ESP_LOGI(TAG,
+           "POST /save => ssid='%s' token='%.8s...' url='%s' model='%s' "
+           "single_request=%s",
+           ssid, token, base_url, model, single_request[0] ? "on" : "off");
 
   esp_err_t save_err = config_manager_update_and_save(
       ssid, pass, token, strlen(personality) > 0 ? personality : NULL,
-      strlen(base_url) > 0 ? base_url : NULL, strlen(model) > 0 ? model : NULL);
+      strlen(base_url) > 0 ? base_url : NULL, strlen(model) > 0 ? model : NULL,
+      single_request[0] != '\0');
 
   if (save_err != ESP_OK) {
     ESP_LOGE(TAG, "Failed to save config: %s", esp_err_to_name(save_err));
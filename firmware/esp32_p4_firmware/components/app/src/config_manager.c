@@ -32,8 +32,13 @@ static app_config_t s_config = {
     .ai_base_url = "https://api.openai.com/v1/chat/completions",
     .ai_model = "gpt-4o", /* O modelo padrão de visão. Áudio usa preview
                              estático se não houver endpoint de áudio */
+    .ai_single_request = false,
+    .ai_audio_format = "wav",
     .volume = 70,
     .brightness = 85,
+    /* 768 px com ~90 KB: texto legivel sem pesar muito no upload */
+    .camera_vision_size = 768,
+    .camera_jpeg_budget_kb = 90,
     .loaded = false,
 };
 
@@ -153,6 +158,23 @@ esp_err_t config_manager_load(void) {
     if (cJSON_IsString(model) && model->valuestring && model->valuestring[0]) {
       strlcpy(s_config.ai_model, model->valuestring, sizeof(s_config.ai_model));
     }
+
+    /* single_request: so para modelos que aceitam input_audio e image_url
+     * na mesma mensagem */
+    const cJSON *single = cJSON_GetObjectItemCaseSensitive(ai, "single_request");
+    if (cJSON_IsBool(single)) {
+      s_config.ai_single_request = cJSON_IsTrue(single);
+    }
+
+    /* audio_format: "wav" (PCM), "adpcm" (IMA-ADPCM em WAV) ou "flac";
+     * depende do que o endpoint aceita */
+    const cJSON *audio_fmt =
+        cJSON_GetObjectItemCaseSensitive(ai, "audio_format");
+    if (cJSON_IsString(audio_fmt) && audio_fmt->valuestring &&
+        audio_fmt->valuestring[0]) {
+      strlcpy(s_config.ai_audio_format, audio_fmt->valuestring,
+              sizeof(s_config.ai_audio_format));
+    }
   }
 
   /* hardware */
@@ -168,6 +190,32 @@ esp_err_t config_manager_load(void) {
     }
   }
 
+  /* camera: resolucao e orcamento do JPEG de visao (upload x precisao) */
+  const cJSON *cam = cJSON_GetObjectItemCaseSensitive(root, "camera");
+  if (cam) {
+    const cJSON *size = cJSON_GetObjectItemCaseSensitive(cam, "vision_size");
+    if (cJSON_IsNumber(size)) {
+      if (size->valueint == 512 || size->valueint == 768 ||
+          size->valueint == 1024) {
+        s_config.camera_vision_size = (uint16_t)size->valueint;
+      } else {
+        ESP_LOGW(TAG, "camera.vision_size %d ignored (512, 768 or 1024)",
+                 size->valueint);
+      }
+    }
+    const cJSON *budget =
+        cJSON_GetObjectItemCaseSensitive(cam, "jpeg_budget_kb");
+    if (cJSON_IsNumber(budget)) {
+      int kb = budget->valueint;
+      if (kb < CONFIG_CAMERA_JPEG_BUDGET_MIN_KB) {
+        kb = CONFIG_CAMERA_JPEG_BUDGET_MIN_KB;
+      } else if (kb > CONFIG_CAMERA_JPEG_BUDGET_MAX_KB) {
+        kb = CONFIG_CAMERA_JPEG_BUDGET_MAX_KB;
+      }
+      s_config.camera_jpeg_budget_kb = (uint16_t)kb;
+    }
+  }
+
   cJSON_Delete(root);
 
   s_config.loaded = true;
@@ -204,6 +252,8 @@ esp_err_t config_manager_save(void) {
   cJSON_AddStringToObject(ai, "personality", s_config.ai_personality);
   cJSON_AddStringToObject(ai, "base_url", s_config.ai_base_url);
   cJSON_AddStringToObject(ai, "model", s_config.ai_model);
+  cJSON_AddBoolToObject(ai, "single_request", s_config.ai_single_request);
+  cJSON_AddStringToObject(ai, "audio_format", s_config.ai_audio_format);
   cJSON_AddItemToObject(root, "ai", ai);
 
   /* hardware */
@@ -212,6 +262,13 @@ esp_err_t config_manager_save(void) {
   cJSON_AddNumberToObject(hw, "brightness", s_config.brightness);
   cJSON_AddItemToObject(root, "hardware", hw);
 
+  /* camera */
+  cJSON *cam = cJSON_CreateObject();
+  cJSON_AddNumberToObject(cam, "vision_size", s_config.camera_vision_size);
+  cJSON_AddNumberToObject(cam, "jpeg_budget_kb",
+                          s_config.camera_jpeg_budget_kb);
+  cJSON_AddItemToObject(root, "camera", cam);
+
   char *json_str = cJSON_PrintUnformatted(root);
   cJSON_Delete(root);
 
@@ -250,7 +307,8 @@ esp_err_t config_manager_update_and_save(const char *ssid, const char *pass,
                                          const char *ai_token,
                                          const char *ai_personality,
                                          const char *ai_base_url,
-                                         const char *ai_model) {
+                                         const char *ai_model,
+                                         bool ai_single_request) {
   if (ssid)
     strlcpy(s_config.wifi_ssid, ssid, sizeof(s_config.wifi_ssid));
   if (pass)
@@ -264,6 +322,7 @@ esp_err_t config_manager_update_and_save(const char *ssid, const char *pass,
     strlcpy(s_config.ai_base_url, ai_base_url, sizeof(s_config.ai_base_url));
   if (ai_model)
     strlcpy(s_config.ai_model, ai_model, sizeof(s_config.ai_model));
+  s_config.ai_single_request = ai_single_request;
   s_config.loaded = true;
   return config_manager_save();
 }
@@ -26,9 +26,96 @@ bool bsp_button2_is_pressed(void); /* GPIO4 – scroll up   */
 bool bsp_button3_is_pressed(void); /* GPIO5 – scroll down */
 bool bsp_wifi_is_ready(void);
 int bsp_knob_consume_delta(void);
+
+/* Camera session: opened, negotiated and streaming once (ring of mmapped
+ * buffers); stays on until bsp_camera_session_stop(). Started on demand by
+ * the capture functions below. */
+typedef struct {
+  const uint8_t *data; /* mmapped frame, valid until release */
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytesperline;
+  uint32_t pixel_format; /* V4L2_PIX_FMT_RGB565 or V4L2_PIX_FMT_RGB24 */
+  uint32_t sequence;     /* frames handed out by this session */
+  uint32_t index;        /* ring slot */
+  int64_t timestamp_us;  /* esp_timer time the frame was dequeued */
+} bsp_camera_frame_t;
+
+esp_err_t bsp_camera_session_start(void);
+void bsp_camera_session_stop(void); /* streaming off, DMA buffers freed */
+bool bsp_camera_session_is_active(void);
+/* Latest completed frame (stale ones are requeued); timeout_ms < 0 uses the
+ * default. Hold it briefly: the session is locked until release. */
+esp_err_t bsp_camera_frame_acquire(bsp_camera_frame_t *frame, int timeout_ms);
+void bsp_camera_frame_release(bsp_camera_frame_t *frame);
+
+/* Flags for bsp_camera_capture_preview_rgb565(). Without them the output is
+ * nearest-neighbour in camera (little-endian RGB565) byte order. */
+#define BSP_PREVIEW_SWAP_BYTES (1u << 0) /* LCD byte order, for the GUI  */
+#define BSP_PREVIEW_BOX_FILTER (1u << 1) /* 2x2 average, less aliasing  */
+
+/* Scale the latest frame into a caller buffer (width * height * 2 bytes,
+ * 4-aligned, even width), e.g. the GUI back buffer: no allocation. */
+esp_err_t bsp_camera_capture_preview_into(uint8_t *dst, uint16_t width,
+                                          uint16_t height, uint32_t flags,
+                                          int64_t *timestamp_us);
+/* Same at 240x240 into a new heap buffer (caller frees). */
 esp_err_t bsp_camera_capture_preview_rgb565(uint8_t **rgb565_data,
-                                            uint16_t *width, uint16_t *height);
-esp_err_t bsp_camera_capture_jpeg(uint8_t **jpeg_data, size_t *jpeg_len);
+                                            uint16_t *width, uint16_t *height,
+                                            uint32_t flags);
+
+/* Encoded JPEG in a pooled, encoder-aligned buffer. Holders share it by
+ * reference count instead of copying: whoever keeps it past the call takes
+ * a reference (bsp_jpeg_ref) and every reference ends with bsp_jpeg_unref,
+ * the last one returning the buffer to the pool. */
+typedef struct {
+  const uint8_t *data;
+  size_t len;
+  /* pool bookkeeping (bsp.c) */
+  uint8_t *buf;
+  size_t cap;
+  uint32_t refs;
+  bool pooled;
+} bsp_jpeg_t;
+
+bsp_jpeg_t *bsp_jpeg_ref(bsp_jpeg_t *jpeg);
+void bsp_jpeg_unref(bsp_jpeg_t *jpeg); /* NULL is a no-op */
+
+/* JPEG of the 240x240 preview frame; *jpeg comes with one reference. */
+esp_err_t bsp_camera_capture_jpeg(bsp_jpeg_t **jpeg);
+/* JPEG of a camera-order RGB565 frame already in memory (sides multiple of
+ * 16, e.g. a live-view snapshot); *jpeg comes with one reference. */
+esp_err_t bsp_jpeg_encode_rgb565(const uint8_t *rgb565, uint16_t width,
+                                 uint16_t height, bsp_jpeg_t **jpeg);
+
+/* Vision capture: a full stream frame, center-square cropped and scaled to
+ * size_px (clamped to the frame, rounded down to 16), JPEG-encoded with the
+ * quality adjusted in up to two passes to land under budget_bytes. */
+typedef struct {
+  uint16_t size_px;    /* output side: 512, 768 or 1024 (max) */
+  size_t budget_bytes; /* target JPEG size */
+} bsp_vision_cfg_t;
+
+typedef struct {
+  uint32_t src_w; /* stream frame size */
+  uint32_t src_h;
+  uint32_t width; /* encoded size */
+  uint32_t height;
+  uint32_t quality; /* JPEG quality of the result */
+  uint32_t passes;  /* 1 or 2 encodes */
+  uint32_t jpeg_len;
+  size_t budget_bytes;
+  uint32_t capture_us; /* waiting for the frame */
+  uint32_t scale_us;
+  uint32_t encode_us; /* all passes */
+  uint32_t total_us;
+} bsp_vision_stats_t;
+
+/* *jpeg comes with one reference; stats (optional) is filled on failure
+ * too. */
+esp_err_t bsp_camera_capture_vision_jpeg(const bsp_vision_cfg_t *cfg,
+                                         bsp_jpeg_t **jpeg,
+                                         bsp_vision_stats_t *stats);
 
 esp_err_t bsp_audio_capture_blocking(const bsp_audio_capture_cfg_t *cfg,
                                      uint8_t *buffer, size_t buffer_len,
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/*
+ * Center-square crop + scale of a camera frame to RGB565.
+ *
+ * The source coordinates of every output column and row are computed once
+ * per resolution (bsp_scaler_configure) into lookup tables, so the per-frame
+ * pass is table lookups, no divisions. Output is written as 32-bit words
+ * (two pixels) with the optional byte swap for the display folded in.
+ */
+
+typedef enum {
+  BSP_SCALE_NEAREST = 0,
+  BSP_SCALE_BOX2X2, /* average of the 2x2 source block, less aliasing */
+} bsp_scale_mode_t;
+
+typedef struct {
+  uint32_t src_w;
+  uint32_t src_h;
+  uint32_t src_stride; /* bytes per source line */
+  uint32_t src_bpp;    /* 2 = RGB565 (little endian), 3 = RGB24 */
+  uint32_t dst_w;      /* even */
+  uint32_t dst_h;
+  bsp_scale_mode_t mode;
+  bool swap_bytes; /* write big-endian RGB565 (display order) */
+} bsp_scaler_cfg_t;
+
+typedef struct {
+  bsp_scaler_cfg_t cfg;
+  uint32_t *x0; /* source byte offset in the line, per output column */
+  uint32_t *x1; /* right neighbour (box filter) */
+  uint32_t *y0; /* source line byte offset, per output row */
+  uint32_t *y1; /* line below (box filter) */
+} bsp_scaler_t;
+
+/**
+ * @brief (Re)build the tables for @p cfg; no-op if it did not change.
+ * @return ESP_ERR_INVALID_ARG for an empty or odd-width output, a source
+ *         smaller than the output or an unsupported bpp.
+ */
+esp_err_t bsp_scaler_configure(bsp_scaler_t *scaler,
+                               const bsp_scaler_cfg_t *cfg);
+
+/** @brief Scale one frame into @p dst (dst_w * dst_h * 2 bytes, 4-aligned). */
+void bsp_scaler_run(const bsp_scaler_t *scaler, const uint8_t *src,
+                    uint8_t *dst);
+
+void bsp_scaler_deinit(bsp_scaler_t *scaler);
@@ -1,17 +1,11 @@
 #include "bsp.h"
+#include "bsp_camera.h"
+#include "bsp_scaler.h"
 
-#include <errno.h>
-#include <fcntl.h>
 #include <inttypes.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/ioctl.h>
-#include <sys/mman.h>
-#include <unistd.h>
-
-#ifndef MAP_FAILED
-#define MAP_FAILED ((void *)-1)
-#endif
 
 #include "driver/gpio.h"
 #include "driver/jpeg_encode.h"
@@ -20,14 +14,15 @@
 #include "esp_event.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_netif.h"
 #include "esp_netif_sntp.h"
-#include "esp_video_device.h"
 #include "esp_video_init.h"
 #include "esp_wifi.h"
 #include "esp_wifi_remote.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 #include "linux/videodev2.h"
 #include "lwip/dns.h"
 
@@ -41,11 +36,18 @@ static const char *TAG = "bsp";
 #define BSP_AUDIO_READ_TIMEOUT_MS 350
 #define BSP_WIFI_MAXIMUM_RETRY 8
 #define BSP_WIFI_WAIT_TIMEOUT_MS 20000
-#define BSP_CAMERA_MMAP_BUFFERS 2
 #define BSP_CAMERA_MAX_JPEG_BYTES (512 * 1024)
+#define BSP_CAMERA_JPEG_QUALITY 80
+#define BSP_VISION_QUALITY_MIN 20
+#define BSP_VISION_QUALITY_MAX 90
+#define BSP_VISION_MAX_SIZE_PX 1024
+#define BSP_VISION_SIZE_ALIGN 16      // JPEG MCU (YUV422: 16x8)
+#define BSP_VISION_SIZE_EXPONENT 0.6f // JPEG bytes ~ quant scale^-0.6
+#define BSP_VISION_TARGET_PCT 92      // aim a bit under the budget on pass 2
+#define BSP_VISION_UNDERSHOOT_PCT 70  // re-encode finer below this
+#define BSP_JPEG_IN_BYTES (BSP_VISION_MAX_SIZE_PX * BSP_VISION_MAX_SIZE_PX * 2)
+#define BSP_JPEG_POOL_SIZE 4 // locked photo + SD queue (2) + a pass-2 spare
 #define BSP_CAMERA_PREVIEW_SIZE 240
-#define BSP_CAMERA_PREVIEW_SKIP_FRAMES                                         \
-  8 // More frames for ISP stabilization (AWB, AGC, etc.)
 #define BSP_CAMERA_CAPTURE_SKIP_FRAMES 6
 #define BSP_CAMERA_JPEG_MAX_WIDTH                                              \
   320 // Reduced for AI (smaller file, faster processing)
@@ -64,12 +66,17 @@ static portMUX_TYPE s_knob_lock = portMUX_INITIALIZER_UNLOCKED;
 static bool s_video_ready;
 static jpeg_encoder_handle_t s_jpeg_encoder_handle = NULL;
 
+static bsp_scaler_t s_preview_scaler; // tables per resolution, frame held
+static bsp_scaler_t s_vision_scaler;  // same, for the vision capture
+static uint32_t s_vision_quality;      // last quality that met the budget
+static uint32_t s_vision_quality_size; // ...at this output size
+static SemaphoreHandle_t s_jpeg_lock;   // encoder input, pool acquire
+static uint8_t *s_jpeg_in_buf;
+static size_t s_jpeg_in_cap;
+static bsp_jpeg_t s_jpeg_pool[BSP_JPEG_POOL_SIZE];
+
 static esp_err_t bsp_button_init(void);
-static esp_err_t bsp_camera_ensure_ready(void);
-static int bsp_camera_open_capture_fd(const char **opened_dev_name);
-static bool bsp_camera_try_set_capture_format(int fd, uint32_t pixfmt,
-                                              uint32_t *out_w, uint32_t *out_h,
-                                              uint32_t *out_bytesperline);
+static esp_err_t bsp_jpeg_pool_init(void);
 static void bsp_knob_left_cb(void *arg, void *data);
 static void bsp_knob_right_cb(void *arg, void *data);
 
@@ -89,7 +96,7 @@ static void bsp_knob_right_cb(void *arg, void *data) {
   portEXIT_CRITICAL(&s_knob_lock);
 }
 
-static esp_err_t bsp_camera_ensure_ready(void) {
+esp_err_t bsp_camera_ensure_ready(void) {
   if (s_video_ready) {
     return ESP_OK;
   }
@@ -138,118 +145,6 @@ static esp_err_t bsp_camera_ensure_ready(void) {
   return ESP_OK;
 }
 
-static int bsp_camera_open_capture_fd(const char **opened_dev_name) {
-  // For MIPI CSI (OV2710), ISP processes RAW10->RGB565 through /dev/video0
-  // ISP DVP device (/dev/video1) only exists when ISP is configured for DVP
-  // input
-  const char *video_dev_candidates[] = {
-      ESP_VIDEO_MIPI_CSI_DEVICE_NAME, // /dev/video0 - MIPI CSI with ISP
-                                      // processing
-      ESP_VIDEO_ISP_DVP_DEVICE_NAME, // /dev/video1 - ISP DVP (may not exist for
-                                     // CSI)
-      ESP_VIDEO_DVP_DEVICE_NAME,     // /dev/video2 - DVP
-  };
-  const size_t candidates =
-      sizeof(video_dev_candidates) / sizeof(video_dev_candidates[0]);
-
-  for (size_t i = 0; i < candidates; i++) {
-    int test_fd = open(video_dev_candidates[i], O_RDONLY);
-    if (test_fd < 0) {
-      test_fd = open(video_dev_candidates[i], O_RDWR);
-    }
-    if (test_fd < 0) {
-      ESP_LOGW(TAG, "open %s failed (errno=%d)", video_dev_candidates[i],
-               errno);
-      continue;
-    }
-
-    struct v4l2_capability cap = {0};
-    if (ioctl(test_fd, VIDIOC_QUERYCAP, &cap) != 0) {
-      ESP_LOGW(TAG, "VIDIOC_QUERYCAP failed on %s", video_dev_candidates[i]);
-      close(test_fd);
-      continue;
-    }
-
-    const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS)
-                              ? cap.device_caps
-                              : cap.capabilities;
-    if ((caps & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE)) ==
-        0) {
-      ESP_LOGW(TAG, "skip non-capture %s caps=0x%08" PRIx32,
-               video_dev_candidates[i], caps);
-      close(test_fd);
-      continue;
-    }
-
-    if (opened_dev_name) {
-      *opened_dev_name = video_dev_candidates[i];
-    }
-    return test_fd;
-  }
-
-  return -1;
-}
-
-static bool bsp_camera_try_set_capture_format(int fd, uint32_t pixfmt,
-                                              uint32_t *out_w, uint32_t *out_h,
-                                              uint32_t *out_bytesperline) {
-  // ISP-supported resolutions (OV2710 outputs 1920x1080 RAW, ISP converts to
-  // RGB) Try current format first, then common ISP output resolutions
-  const uint32_t sizes[][2] = {
-      {640, 480},   // VGA - commonly supported by ISP
-      {1280, 720},  // HD - commonly supported by ISP
-      {1920, 1080}, // Full HD - matches sensor output
-      {800, 600},   // SVGA
-  };
-
-  // First, try to use current format (ISP may already have a good format set)
-  struct v4l2_format cur = {0};
-  cur.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (ioctl(fd, VIDIOC_G_FMT, &cur) == 0 && cur.fmt.pix.width > 0 &&
-      cur.fmt.pix.height > 0) {
-    // Only change pixel format, keep resolution
-    struct v4l2_format req = {
-        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
-        .fmt.pix.width = cur.fmt.pix.width,
-        .fmt.pix.height = cur.fmt.pix.height,
-        .fmt.pix.pixelformat = pixfmt,
-    };
-    if (ioctl(fd, VIDIOC_S_FMT, &req) == 0) {
-      if (out_w)
-        *out_w = req.fmt.pix.width;
-      if (out_h)
-        *out_h = req.fmt.pix.height;
-      if (out_bytesperline)
-        *out_bytesperline = req.fmt.pix.bytesperline;
-      ESP_LOGD(TAG, "Using current format: %" PRIu32 "x%" PRIu32, *out_w,
-               *out_h);
-      return true;
-    }
-  }
-
-  // If current format doesn't work, try ISP-supported resolutions
-  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
-    struct v4l2_format req = {
-        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
-        .fmt.pix.width = sizes[i][0],
-        .fmt.pix.height = sizes[i][1],
-        .fmt.pix.pixelformat = pixfmt,
-    };
-    if (ioctl(fd, VIDIOC_S_FMT, &req) == 0) {
-      if (out_w)
-        *out_w = req.fmt.pix.width;
-      if (out_h)
-        *out_h = req.fmt.pix.height;
-      if (out_bytesperline)
-        *out_bytesperline = req.fmt.pix.bytesperline;
-      ESP_LOGD(TAG, "Set format: %" PRIu32 "x%" PRIu32, *out_w, *out_h);
-      return true;
-    }
-  }
-
-  return false;
-}
-
 static void bsp_wifi_remote_event_handler(void *arg,
                                           esp_event_base_t event_base,
                                           int32_t event_id, void *event_data) {
@@ -434,10 +329,20 @@ esp_err_t bsp_init(void) {
 
   // 3. INICIE A CÂMERA APENAS UMA VEZ
   ESP_LOGI(TAG, "Starting Camera subsystem...");
+  s_jpeg_lock = xSemaphoreCreateMutex();
+  if (bsp_camera_session_init() != ESP_OK || !s_jpeg_lock) {
+    return ESP_ERR_NO_MEM;
+  }
   esp_err_t cam_err = bsp_camera_ensure_ready();
   if (cam_err != ESP_OK) {
     ESP_LOGE(TAG, "Camera hardware failed: %s", esp_err_to_name(cam_err));
   }
+  /* Photo buffers up front, before the heap fragments; retried per photo. */
+  esp_err_t pool_err = bsp_jpeg_pool_init();
+  if (pool_err != ESP_OK) {
+    ESP_LOGW(TAG, "JPEG buffer pool init failed: %s",
+             esp_err_to_name(pool_err));
+  }
 
   ESP_RETURN_ON_ERROR(bsp_display_backlight_on(), TAG, "backlight init failed");
   ESP_RETURN_ON_ERROR(bsp_button_init(), TAG, "button init failed");
@@ -539,350 +444,503 @@ int bsp_knob_consume_delta(void) {
 
 bool bsp_wifi_is_ready(void) { return s_wifi_ready; }
 
-esp_err_t bsp_camera_capture_jpeg(uint8_t **jpeg_data, size_t *jpeg_len) {
-  if (!jpeg_data || !jpeg_len) {
-    return ESP_ERR_INVALID_ARG;
+static esp_err_t bsp_jpeg_encoder_ready(void) {
+  if (s_jpeg_encoder_handle) {
+    return ESP_OK;
+  }
+  jpeg_encode_engine_cfg_t encode_eng_cfg = {
+      .timeout_ms = 500, // Increased timeout for encoding, but with smaller
+                         // resolution should be fast
+  };
+  esp_err_t err =
+      jpeg_new_encoder_engine(&encode_eng_cfg, &s_jpeg_encoder_handle);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to create JPEG encoder: %s", esp_err_to_name(err));
   }
-  *jpeg_data = NULL;
-  *jpeg_len = 0;
+  return err;
+}
 
-  ESP_RETURN_ON_ERROR(bsp_camera_ensure_ready(), TAG, "camera init failed");
+/* Encoder-aligned buffers allocated once (bsp_init) and reused by every
+ * photo: one input frame, shared under s_jpeg_lock, and a pool of output
+ * bitstreams handed out by reference. */
+static uint8_t *bsp_jpeg_alloc_out(size_t *cap) {
+  jpeg_encode_memory_alloc_cfg_t mem_cfg = {
+      .buffer_direction = JPEG_ENC_ALLOC_OUTPUT_BUFFER,
+  };
+  return (uint8_t *)jpeg_alloc_encoder_mem(BSP_CAMERA_MAX_JPEG_BYTES, &mem_cfg,
+                                           cap);
+}
 
-  // Initialize JPEG encoder if not already done
-  if (s_jpeg_encoder_handle == NULL) {
-    jpeg_encode_engine_cfg_t encode_eng_cfg = {
-        .timeout_ms = 500, // Increased timeout for encoding, but with smaller
-                           // resolution should be fast
+static esp_err_t bsp_jpeg_pool_init(void) {
+  if (!s_jpeg_in_buf) {
+    jpeg_encode_memory_alloc_cfg_t mem_cfg = {
+        .buffer_direction = JPEG_ENC_ALLOC_INPUT_BUFFER,
     };
-    esp_err_t err =
-        jpeg_new_encoder_engine(&encode_eng_cfg, &s_jpeg_encoder_handle);
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "Failed to create JPEG encoder: %s", esp_err_to_name(err));
-      return err;
+    s_jpeg_in_buf = (uint8_t *)jpeg_alloc_encoder_mem(
+        BSP_JPEG_IN_BYTES, &mem_cfg, &s_jpeg_in_cap);
+    if (!s_jpeg_in_buf) {
+      return ESP_ERR_NO_MEM;
     }
   }
-  esp_err_t ret = ESP_FAIL;
-  uint8_t *preview_rgb565 = NULL;
-  uint8_t *rgb565_buf = NULL;
-  uint8_t *jpeg_out_buf = NULL;
-  size_t jpeg_out_size = 0;
-  size_t jpeg_alloced_size = 0;
-  uint16_t preview_w = 0;
-  uint16_t preview_h = 0;
-
-  /* Use the same frame source as the on-screen preview to avoid mismatch
-   * between what user sees and what is sent to AI.
-   */
-  ret = bsp_camera_capture_preview_rgb565(&preview_rgb565, &preview_w,
-                                          &preview_h);
-  if (ret != ESP_OK || !preview_rgb565 || preview_w == 0 || preview_h == 0) {
-    ESP_LOGE(TAG, "preview frame capture for JPEG failed");
-    goto cleanup;
+  for (int i = 0; i < BSP_JPEG_POOL_SIZE; i++) {
+    bsp_jpeg_t *jpeg = &s_jpeg_pool[i];
+    if (!jpeg->buf) {
+      jpeg->buf = bsp_jpeg_alloc_out(&jpeg->cap);
+      if (!jpeg->buf) {
+        return ESP_ERR_NO_MEM;
+      }
+      jpeg->pooled = true;
+    }
   }
+  return ESP_OK;
+}
 
-  const size_t rgb565_size = (size_t)preview_w * (size_t)preview_h * 2;
-  rgb565_buf =
-      heap_caps_malloc(rgb565_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!rgb565_buf) {
-    rgb565_buf =
-        heap_caps_malloc(rgb565_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+/* Free pool buffer with one reference, or a one-off buffer if every pooled
+ * one is still held (e.g. photos waiting in the SD queue). s_jpeg_lock. */
+static bsp_jpeg_t *bsp_jpeg_acquire(void) {
+  for (int i = 0; i < BSP_JPEG_POOL_SIZE; i++) {
+    bsp_jpeg_t *jpeg = &s_jpeg_pool[i];
+    uint32_t idle = 0;
+    if (jpeg->buf &&
+        __atomic_compare_exchange_n(&jpeg->refs, &idle, 1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      jpeg->data = jpeg->buf;
+      jpeg->len = 0;
+      return jpeg;
+    }
   }
-  if (!rgb565_buf) {
-    ret = ESP_ERR_NO_MEM;
-    goto cleanup;
+  bsp_jpeg_t *jpeg = calloc(1, sizeof(*jpeg));
+  if (!jpeg) {
+    return NULL;
   }
-  memcpy(rgb565_buf, preview_rgb565, rgb565_size);
-
-  /* Send preview pixels to JPEG encoder without extra byte swapping.
-   * Display path may apply its own swap, but AI payload must keep camera order.
-   */
-
-  /* For some scenes, compressed JPEG can be larger than expected.
-   * Allocate with generous headroom to avoid encoder overflow.
-   */
-  jpeg_out_size = rgb565_size;
-  if (jpeg_out_size < 4096) {
-    jpeg_out_size = 4096;
+  jpeg->buf = bsp_jpeg_alloc_out(&jpeg->cap);
+  if (!jpeg->buf) {
+    free(jpeg);
+    return NULL;
   }
-  if (jpeg_out_size > BSP_CAMERA_MAX_JPEG_BYTES) {
-    jpeg_out_size = BSP_CAMERA_MAX_JPEG_BYTES;
+  jpeg->data = jpeg->buf;
+  jpeg->refs = 1;
+  ESP_LOGW(TAG, "JPEG pool exhausted, using a one-off buffer");
+  return jpeg;
+}
+
+bsp_jpeg_t *bsp_jpeg_ref(bsp_jpeg_t *jpeg) {
+  if (jpeg) {
+    __atomic_add_fetch(&jpeg->refs, 1, __ATOMIC_RELAXED);
   }
+  return jpeg;
+}
 
-  jpeg_encode_memory_alloc_cfg_t jpeg_mem_cfg = {
-      .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
-  };
-  jpeg_out_buf = (uint8_t *)jpeg_alloc_encoder_mem(jpeg_out_size, &jpeg_mem_cfg,
-                                                   &jpeg_alloced_size);
-  if (!jpeg_out_buf) {
-    ret = ESP_ERR_NO_MEM;
-    goto cleanup;
+void bsp_jpeg_unref(bsp_jpeg_t *jpeg) {
+  if (!jpeg || __atomic_sub_fetch(&jpeg->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+    return;
   }
-  jpeg_out_size = jpeg_alloced_size;
+  if (!jpeg->pooled) {
+    free(jpeg->buf);
+    free(jpeg);
+  } // pooled: refs == 0 puts it back in the pool
+}
 
+/* One hardware encode of camera-order RGB565 into @p out; checks the result
+ * is a JPEG. */
+static esp_err_t bsp_jpeg_encode_pass(const uint8_t *src, size_t src_len,
+                                      uint32_t width, uint32_t height,
+                                      uint32_t quality, bsp_jpeg_t *out) {
   jpeg_encode_cfg_t enc_config = {
       .src_type = JPEG_ENCODE_IN_FORMAT_RGB565,
       .sub_sample = JPEG_DOWN_SAMPLING_YUV422,
-      .image_quality = 80,
-      .width = preview_w,
-      .height = preview_h,
+      .image_quality = quality,
+      .width = width,
+      .height = height,
   };
-
-  uint32_t actual_jpeg_size = 0;
-  ret = jpeg_encoder_process(s_jpeg_encoder_handle, &enc_config, rgb565_buf,
-                             rgb565_size, jpeg_out_buf, jpeg_out_size,
-                             &actual_jpeg_size);
+  uint32_t len = 0;
+  out->len = 0;
+  esp_err_t ret = jpeg_encoder_process(s_jpeg_encoder_handle, &enc_config,
+                                       src, src_len, out->buf, out->cap, &len);
   if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "JPEG encoding failed from preview: %s",
-             esp_err_to_name(ret));
-    goto cleanup;
+    return ret;
   }
-  if (actual_jpeg_size < 4 || actual_jpeg_size > BSP_CAMERA_MAX_JPEG_BYTES) {
-    ret = ESP_FAIL;
-    goto cleanup;
+  if (len < 4 || len > out->cap || out->buf[0] != 0xFF ||
+      out->buf[1] != 0xD8) {
+    return ESP_FAIL;
   }
-  if (jpeg_out_buf[0] != 0xFF || jpeg_out_buf[1] != 0xD8) {
-    ret = ESP_FAIL;
-    goto cleanup;
+  out->len = len;
+  return ESP_OK;
+}
+
+/* Encodes the width x height frame already in s_jpeg_in_buf into a pool
+ * buffer. s_jpeg_lock. */
+static esp_err_t bsp_jpeg_encode_input_locked(uint32_t width, uint32_t height,
+                                              bsp_jpeg_t **jpeg) {
+  bsp_jpeg_t *out = bsp_jpeg_acquire();
+  if (!out) {
+    return ESP_ERR_NO_MEM;
+  }
+  const esp_err_t ret =
+      bsp_jpeg_encode_pass(s_jpeg_in_buf, (size_t)width * height * 2, width,
+                           height, BSP_CAMERA_JPEG_QUALITY, out);
+  if (ret != ESP_OK) {
+    bsp_jpeg_unref(out);
+    return ret;
   }
+  *jpeg = out;
+  return ESP_OK;
+}
 
-  *jpeg_data =
-      heap_caps_malloc(actual_jpeg_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!*jpeg_data) {
-    *jpeg_data = heap_caps_malloc(actual_jpeg_size,
-                                  MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+esp_err_t bsp_camera_capture_jpeg(bsp_jpeg_t **jpeg) {
+  if (!jpeg) {
+    return ESP_ERR_INVALID_ARG;
   }
-  if (!*jpeg_data) {
-    ret = ESP_ERR_NO_MEM;
-    goto cleanup;
+  *jpeg = NULL;
+  if (!s_jpeg_lock) {
+    return ESP_ERR_INVALID_STATE;
   }
-  memcpy(*jpeg_data, jpeg_out_buf, actual_jpeg_size);
-  *jpeg_len = actual_jpeg_size;
-  ESP_LOGI(TAG, "captured JPEG from preview: %u bytes (%ux%u)",
-           (unsigned)actual_jpeg_size, (unsigned)preview_w,
-           (unsigned)preview_h);
-  ret = ESP_OK;
 
-cleanup:
-  free(preview_rgb565);
-  free(rgb565_buf);
-  if (jpeg_out_buf) {
-    free(jpeg_out_buf);
+  /* Use the same frame source as the on-screen preview to avoid mismatch
+   * between what user sees and what is sent to AI. Scaled straight into
+   * the encoder input, in camera byte order.
+   */
+  bsp_jpeg_t *out = NULL;
+  xSemaphoreTake(s_jpeg_lock, portMAX_DELAY);
+  esp_err_t ret = bsp_jpeg_pool_init();
+  if (ret == ESP_OK) {
+    ret = bsp_jpeg_encoder_ready();
+  }
+  if (ret == ESP_OK) {
+    ret = bsp_camera_capture_preview_into(
+        s_jpeg_in_buf, BSP_CAMERA_PREVIEW_SIZE, BSP_CAMERA_PREVIEW_SIZE,
+        BSP_PREVIEW_BOX_FILTER, NULL);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "preview frame capture for JPEG failed");
+    }
+  }
+  if (ret == ESP_OK) {
+    ret = bsp_jpeg_encode_input_locked(BSP_CAMERA_PREVIEW_SIZE,
+                                       BSP_CAMERA_PREVIEW_SIZE, &out);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "JPEG encoding failed from preview: %s",
+               esp_err_to_name(ret));
+    }
   }
+  xSemaphoreGive(s_jpeg_lock);
+
   if (ret != ESP_OK) {
-    free(*jpeg_data);
-    *jpeg_data = NULL;
-    *jpeg_len = 0;
+    return ret;
   }
-  return ret;
+  ESP_LOGI(TAG, "encoded JPEG: %u bytes (%ux%u)", (unsigned)out->len,
+           (unsigned)BSP_CAMERA_PREVIEW_SIZE,
+           (unsigned)BSP_CAMERA_PREVIEW_SIZE);
+  *jpeg = out;
+  return ESP_OK;
 }
 
-esp_err_t bsp_camera_capture_preview_rgb565(uint8_t **rgb565_data,
-                                            uint16_t *width, uint16_t *height) {
-  if (!rgb565_data || !width || !height) {
+esp_err_t bsp_jpeg_encode_rgb565(const uint8_t *rgb565, uint16_t width,
+                                 uint16_t height, bsp_jpeg_t **jpeg) {
+  if (!jpeg) {
     return ESP_ERR_INVALID_ARG;
   }
-  *rgb565_data = NULL;
-  *width = 0;
-  *height = 0;
-
-  ESP_RETURN_ON_ERROR(bsp_camera_ensure_ready(), TAG, "camera init failed");
+  *jpeg = NULL;
+  if (!rgb565 || width == 0 || height == 0 || (width % 16) || (height % 16)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!s_jpeg_lock) {
+    return ESP_ERR_INVALID_STATE;
+  }
 
-  int fd = -1;
-  const char *opened_dev = NULL;
-  fd = bsp_camera_open_capture_fd(&opened_dev);
-  if (fd < 0) {
-    ESP_LOGE(TAG, "preview camera open failed");
-    return ESP_FAIL;
+  const size_t rgb_len = (size_t)width * height * 2;
+  bsp_jpeg_t *out = NULL;
+  xSemaphoreTake(s_jpeg_lock, portMAX_DELAY);
+  esp_err_t ret = bsp_jpeg_pool_init();
+  if (ret == ESP_OK) {
+    ret = bsp_jpeg_encoder_ready();
   }
-  ESP_LOGD(TAG, "preview camera device opened: %s", opened_dev);
-
-  esp_err_t ret = ESP_FAIL;
-  struct v4l2_requestbuffers req = {0};
-  struct v4l2_buffer buf = {0};
-  const int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  void *mmap_ptrs[BSP_CAMERA_MMAP_BUFFERS] = {0};
-  size_t mmap_sizes[BSP_CAMERA_MMAP_BUFFERS] = {0};
-  bool stream_on = false;
-
-  uint32_t frame_w = 0;
-  uint32_t frame_h = 0;
-  uint32_t bytesperline = 0;
-  uint32_t pixel_format = 0;
-
-  // OV2710 outputs RAW10 at 1920x1080, ISP converts to RGB565
-  // Don't try to set unsupported resolutions directly - let ISP handle it
-  // Try RGB565 first (ISP output), then RGB24
-  if (bsp_camera_try_set_capture_format(fd, V4L2_PIX_FMT_RGB565, &frame_w,
-                                        &frame_h, &bytesperline)) {
-    pixel_format = V4L2_PIX_FMT_RGB565;
-    ESP_LOGD(TAG,
-             "preview format RGB565: %" PRIu32 "x%" PRIu32 " (ISP processed)",
-             frame_w, frame_h);
-  } else if (bsp_camera_try_set_capture_format(fd, V4L2_PIX_FMT_RGB24, &frame_w,
-                                               &frame_h, &bytesperline)) {
-    pixel_format = V4L2_PIX_FMT_RGB24;
-    ESP_LOGD(TAG,
-             "preview format RGB24: %" PRIu32 "x%" PRIu32 " (ISP processed)",
-             frame_w, frame_h);
-  } else {
-    ESP_LOGE(TAG, "Failed to set any supported capture format for preview");
-    goto cleanup;
-  }
-
-  req.count = BSP_CAMERA_MMAP_BUFFERS;
-  req.type = type;
-  req.memory = V4L2_MEMORY_MMAP;
-  if (ioctl(fd, VIDIOC_REQBUFS, &req) != 0 || req.count < 1) {
-    ESP_LOGE(TAG, "VIDIOC_REQBUFS failed");
-    goto cleanup;
-  }
-
-  for (uint32_t i = 0; i < req.count && i < BSP_CAMERA_MMAP_BUFFERS; i++) {
-    memset(&buf, 0, sizeof(buf));
-    buf.type = type;
-    buf.memory = V4L2_MEMORY_MMAP;
-    buf.index = i;
-    if (ioctl(fd, VIDIOC_QUERYBUF, &buf) != 0) {
-      ESP_LOGE(TAG, "VIDIOC_QUERYBUF failed idx=%" PRIu32, i);
-      goto cleanup;
-    }
-    mmap_ptrs[i] = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
-                        fd, buf.m.offset);
-    if (mmap_ptrs[i] == MAP_FAILED) {
-      mmap_ptrs[i] = NULL;
-      ESP_LOGE(TAG, "mmap failed idx=%" PRIu32, i);
-      goto cleanup;
-    }
-    mmap_sizes[i] = buf.length;
-    if (ioctl(fd, VIDIOC_QBUF, &buf) != 0) {
-      ESP_LOGE(TAG, "VIDIOC_QBUF failed idx=%" PRIu32, i);
-      goto cleanup;
+  if (ret == ESP_OK && rgb_len > s_jpeg_in_cap) {
+    ret = ESP_ERR_INVALID_SIZE;
+  }
+  if (ret == ESP_OK) {
+    memcpy(s_jpeg_in_buf, rgb565, rgb_len);
+    ret = bsp_jpeg_encode_input_locked(width, height, &out);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "JPEG encoding failed from frame: %s",
+               esp_err_to_name(ret));
     }
   }
+  xSemaphoreGive(s_jpeg_lock);
 
-  if (ioctl(fd, VIDIOC_STREAMON, (void *)&type) != 0) {
-    ESP_LOGE(TAG, "VIDIOC_STREAMON failed");
-    goto cleanup;
+  if (ret != ESP_OK) {
+    return ret;
   }
-  stream_on = true;
+  ESP_LOGI(TAG, "encoded JPEG: %u bytes (%ux%u)", (unsigned)out->len,
+           (unsigned)width, (unsigned)height);
+  *jpeg = out;
+  return ESP_OK;
+}
 
-  for (int i = 0; i < BSP_CAMERA_PREVIEW_SKIP_FRAMES; i++) {
-    memset(&buf, 0, sizeof(buf));
-    buf.type = type;
-    buf.memory = V4L2_MEMORY_MMAP;
-    if (ioctl(fd, VIDIOC_DQBUF, &buf) != 0) {
-      ESP_LOGE(TAG, "VIDIOC_DQBUF warmup failed");
-      goto cleanup;
-    }
-    if (ioctl(fd, VIDIOC_QBUF, &buf) != 0) {
-      ESP_LOGE(TAG, "VIDIOC_QBUF warmup failed");
-      goto cleanup;
-    }
+esp_err_t bsp_camera_capture_preview_into(uint8_t *dst, uint16_t width,
+                                          uint16_t height, uint32_t flags,
+                                          int64_t *timestamp_us) {
+  if (!dst || width == 0 || height == 0) {
+    return ESP_ERR_INVALID_ARG;
   }
 
-  memset(&buf, 0, sizeof(buf));
-  buf.type = type;
-  buf.memory = V4L2_MEMORY_MMAP;
-  if (ioctl(fd, VIDIOC_DQBUF, &buf) != 0) {
-    ESP_LOGE(TAG, "VIDIOC_DQBUF failed");
-    goto cleanup;
+  bsp_camera_frame_t frame;
+  esp_err_t ret = bsp_camera_frame_acquire(&frame, -1);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  // Center-square crop from source, then sample to width x height (lookup
+  // tables rebuilt only when the session resolution changes).
+  const bsp_scaler_cfg_t scale_cfg = {
+      .src_w = frame.width,
+      .src_h = frame.height,
+      .src_stride = frame.bytesperline,
+      .src_bpp = (frame.pixel_format == V4L2_PIX_FMT_RGB565) ? 2 : 3,
+      .dst_w = width,
+      .dst_h = height,
+      .mode = (flags & BSP_PREVIEW_BOX_FILTER) ? BSP_SCALE_BOX2X2
+                                               : BSP_SCALE_NEAREST,
+      .swap_bytes = (flags & BSP_PREVIEW_SWAP_BYTES) != 0,
+  };
+  ret = bsp_scaler_configure(&s_preview_scaler, &scale_cfg);
+  if (ret == ESP_OK) {
+    bsp_scaler_run(&s_preview_scaler, frame.data, dst);
+    if (timestamp_us) {
+      *timestamp_us = frame.timestamp_us;
+    }
+  } else {
+    ESP_LOGE(TAG, "preview scaler rejected %" PRIu32 "x%" PRIu32 ": %s",
+             frame.width, frame.height, esp_err_to_name(ret));
   }
 
-  if (buf.index >= BSP_CAMERA_MMAP_BUFFERS || !mmap_ptrs[buf.index] ||
-      buf.bytesused == 0) {
-    ESP_LOGE(TAG, "invalid preview frame");
-    goto cleanup;
+  bsp_camera_frame_release(&frame);
+  return ret;
+}
+
+esp_err_t bsp_camera_capture_preview_rgb565(uint8_t **rgb565_data,
+                                            uint16_t *width, uint16_t *height,
+                                            uint32_t flags) {
+  if (!rgb565_data || !width || !height) {
+    return ESP_ERR_INVALID_ARG;
   }
+  *rgb565_data = NULL;
+  *width = 0;
+  *height = 0;
 
-  if (frame_w < BSP_CAMERA_PREVIEW_SIZE || frame_h < BSP_CAMERA_PREVIEW_SIZE) {
-    ESP_LOGE(TAG, "preview frame too small: %" PRIu32 "x%" PRIu32, frame_w,
-             frame_h);
-    goto cleanup;
+  const size_t size = BSP_CAMERA_PREVIEW_SIZE * BSP_CAMERA_PREVIEW_SIZE * 2;
+  uint8_t *buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) {
+    buf = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
   }
-  if (bytesperline == 0) {
-    bytesperline =
-        frame_w * (pixel_format == V4L2_PIX_FMT_RGB565
-                       ? 2
-                       : (pixel_format == V4L2_PIX_FMT_RGB24 ? 3 : 1));
+  if (!buf) {
+    return ESP_ERR_NO_MEM;
   }
 
-  *rgb565_data =
-      heap_caps_malloc(BSP_CAMERA_PREVIEW_SIZE * BSP_CAMERA_PREVIEW_SIZE * 2,
-                       MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!*rgb565_data) {
-    *rgb565_data =
-        heap_caps_malloc(BSP_CAMERA_PREVIEW_SIZE * BSP_CAMERA_PREVIEW_SIZE * 2,
-                         MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-  }
-  if (!*rgb565_data) {
-    ret = ESP_ERR_NO_MEM;
-    goto cleanup;
+  esp_err_t ret = bsp_camera_capture_preview_into(
+      buf, BSP_CAMERA_PREVIEW_SIZE, BSP_CAMERA_PREVIEW_SIZE, flags, NULL);
+  if (ret != ESP_OK) {
+    free(buf);
+    return ret;
   }
+  *rgb565_data = buf;
+  *width = BSP_CAMERA_PREVIEW_SIZE;
+  *height = BSP_CAMERA_PREVIEW_SIZE;
+  return ESP_OK;
+}
 
-  const uint8_t *src = (const uint8_t *)mmap_ptrs[buf.index];
+/* JPEG quantizer scale as libjpeg derives it from quality (the tables
+ * are the standard ones scaled by it). */
+static float bsp_vision_quant_scale(uint32_t quality) {
+  return quality < 50 ? 5000.0f / (float)quality
+                      : 200.0f - 2.0f * (float)quality;
+}
 
-  // Return buffer to camera immediately after reading to avoid frame
-  // accumulation
-  if (ioctl(fd, VIDIOC_QBUF, &buf) != 0) {
-    ESP_LOGW(TAG, "VIDIOC_QBUF failed after capture");
+/* Quality expected to produce target_len bytes, given that @p quality
+ * produced @p got_len: size follows scale^-BSP_VISION_SIZE_EXPONENT closely
+ * enough over 20..90 that one correction lands within a few percent. */
+static uint32_t bsp_vision_next_quality(uint32_t quality, size_t got_len,
+                                        size_t target_len) {
+  const float scale =
+      bsp_vision_quant_scale(quality) *
+      powf((float)got_len / (float)target_len,
+           1.0f / BSP_VISION_SIZE_EXPONENT);
+  int next = (scale <= 100.0f) ? (int)((200.0f - scale) / 2.0f)
+                               : (int)(5000.0f / scale);
+  if (next < BSP_VISION_QUALITY_MIN) {
+    next = BSP_VISION_QUALITY_MIN;
+  }
+  if (next > BSP_VISION_QUALITY_MAX) {
+    next = BSP_VISION_QUALITY_MAX;
+  }
+  return (uint32_t)next;
+}
+
+esp_err_t bsp_camera_capture_vision_jpeg(const bsp_vision_cfg_t *cfg,
+                                         bsp_jpeg_t **jpeg,
+                                         bsp_vision_stats_t *stats) {
+  if (!cfg || !jpeg || cfg->size_px < BSP_VISION_SIZE_ALIGN ||
+      cfg->budget_bytes == 0) {
+    return ESP_ERR_INVALID_ARG;
   }
+  *jpeg = NULL;
+  if (!s_jpeg_lock) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  bsp_vision_stats_t st = {.budget_bytes = cfg->budget_bytes};
+  const int64_t t_start = esp_timer_get_time();
+  bsp_jpeg_t *best = NULL;
 
-  // Center-square crop from source, then sample to 240x240.
-  // This keeps coordinates in-bounds and avoids quadrant/noise artifacts.
-  const uint32_t src_side = (frame_w < frame_h) ? frame_w : frame_h;
-  const uint32_t crop_x = (frame_w - src_side) / 2;
-  const uint32_t crop_y = (frame_h - src_side) / 2;
+  /* One photo at a time owns the encoder input; the session lock is only
+   * held for the scale pass. */
+  xSemaphoreTake(s_jpeg_lock, portMAX_DELAY);
+  esp_err_t ret = bsp_jpeg_pool_init();
+  if (ret == ESP_OK) {
+    ret = bsp_jpeg_encoder_ready();
+  }
+  if (ret != ESP_OK) {
+    goto done;
+  }
 
-  for (uint32_t y = 0; y < BSP_CAMERA_PREVIEW_SIZE; y++) {
-    uint8_t *dst_line = *rgb565_data + y * BSP_CAMERA_PREVIEW_SIZE * 2;
-    const uint32_t src_y =
-        crop_y + (((uint64_t)y * src_side) / BSP_CAMERA_PREVIEW_SIZE);
-    const uint8_t *src_line = src + src_y * bytesperline;
+  bsp_camera_frame_t frame;
+  ret = bsp_camera_frame_acquire(&frame, -1);
+  if (ret != ESP_OK) {
+    goto done;
+  }
+  const int64_t t_frame = esp_timer_get_time();
+  st.src_w = frame.width;
+  st.src_h = frame.height;
+
+  /* The output can't be larger than the center square the stream offers
+   * (nor than the encoder input buffer). */
+  uint32_t size = cfg->size_px;
+  if (size > BSP_VISION_MAX_SIZE_PX) {
+    size = BSP_VISION_MAX_SIZE_PX;
+  }
+  const uint32_t side = frame.width < frame.height ? frame.width : frame.height;
+  if (size > side) {
+    size = side;
+  }
+  size -= size % BSP_VISION_SIZE_ALIGN;
+  st.width = size;
+  st.height = size;
+
+  /* Averaging only pays off when decimating; for ratios under 2 it just
+   * blurs the fine detail (text) this capture is for. */
+  const bsp_scaler_cfg_t scale_cfg = {
+      .src_w = frame.width,
+      .src_h = frame.height,
+      .src_stride = frame.bytesperline,
+      .src_bpp = (frame.pixel_format == V4L2_PIX_FMT_RGB565) ? 2 : 3,
+      .dst_w = size,
+      .dst_h = size,
+      .mode = (side >= 2 * size) ? BSP_SCALE_BOX2X2 : BSP_SCALE_NEAREST,
+      .swap_bytes = false,
+  };
+  ret = size > 0 ? bsp_scaler_configure(&s_vision_scaler, &scale_cfg)
+                 : ESP_ERR_INVALID_SIZE;
+  if (ret == ESP_OK) {
+    bsp_scaler_run(&s_vision_scaler, frame.data, s_jpeg_in_buf);
+  }
+  bsp_camera_frame_release(&frame);
+  const int64_t t_scaled = esp_timer_get_time();
+  st.capture_us = (uint32_t)(t_frame - t_start);
+  st.scale_us = (uint32_t)(t_scaled - t_frame);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "vision scaler rejected %" PRIu32 "x%" PRIu32 " -> %" PRIu32
+                  ": %s",
+             st.src_w, st.src_h, size, esp_err_to_name(ret));
+    goto done;
+  }
 
-    if (pixel_format == V4L2_PIX_FMT_RGB565) {
-      for (uint32_t x = 0; x < BSP_CAMERA_PREVIEW_SIZE; x++) {
-        const uint32_t src_x =
-            crop_x + (((uint64_t)x * src_side) / BSP_CAMERA_PREVIEW_SIZE);
-        const uint8_t *src_pixel = src_line + src_x * 2;
-        // Keep byte order as delivered by the camera/ISP path.
-        dst_line[x * 2] = src_pixel[0];
-        dst_line[x * 2 + 1] = src_pixel[1];
+  best = bsp_jpeg_acquire();
+  if (!best) {
+    ret = ESP_ERR_NO_MEM;
+    goto done;
+  }
+
+  /* Rate control: start from the quality that fit last time at this size,
+   * re-encode once if the result is over the budget or well under it. */
+  const size_t rgb_len = (size_t)size * size * 2;
+  uint32_t quality = (s_vision_quality_size == size && s_vision_quality)
+                         ? s_vision_quality
+                         : BSP_CAMERA_JPEG_QUALITY;
+  ret = bsp_jpeg_encode_pass(s_jpeg_in_buf, rgb_len, size, size, quality,
+                             best);
+  st.passes = 1;
+  const bool over = (ret != ESP_OK) || best->len > cfg->budget_bytes;
+  const bool under =
+      (ret == ESP_OK) &&
+      best->len < cfg->budget_bytes * BSP_VISION_UNDERSHOOT_PCT / 100 &&
+      quality < BSP_VISION_QUALITY_MAX;
+  if (over || under) {
+    /* An encode that overflowed the output buffer has no size to correct
+     * from; treat it as the buffer size. */
+    const size_t got = (ret == ESP_OK) ? best->len : best->cap;
+    const uint32_t next = bsp_vision_next_quality(
+        quality, got, cfg->budget_bytes * BSP_VISION_TARGET_PCT / 100);
+    if (next != quality) {
+      /* Pass 2 always goes to a second buffer, so a valid pass 1 survives
+       * a failed pass 2; the loser goes back to the pool: no copy. Only a
+       * pass 1 with nothing to keep lends its buffer if the pool is dry. */
+      bsp_jpeg_t *second = bsp_jpeg_acquire();
+      if (!second && ret != ESP_OK) {
+        second = best;
       }
-    } else if (pixel_format == V4L2_PIX_FMT_RGB24) {
-      // Convert RGB24 to RGB565 with center-square sampling
-      for (uint32_t x = 0; x < BSP_CAMERA_PREVIEW_SIZE; x++) {
-        const uint32_t src_x =
-            crop_x + (((uint64_t)x * src_side) / BSP_CAMERA_PREVIEW_SIZE);
-        const uint8_t *src_pixel = src_line + src_x * 3;
-        uint8_t r = src_pixel[0];
-        uint8_t g = src_pixel[1];
-        uint8_t b = src_pixel[2];
-        uint16_t rgb565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-        dst_line[x * 2] = (uint8_t)(rgb565 & 0xFF);
-        dst_line[x * 2 + 1] = (uint8_t)(rgb565 >> 8);
+      if (second) {
+        const esp_err_t ret2 = bsp_jpeg_encode_pass(
+            s_jpeg_in_buf, rgb_len, size, size, next, second);
+        st.passes = 2;
+        if (second == best) {
+          ret = ret2;
+          quality = next;
+        } else if (ret2 == ESP_OK &&
+                   (ret != ESP_OK || second->len <= cfg->budget_bytes ||
+                    second->len < best->len)) {
+          bsp_jpeg_unref(best);
+          best = second;
+          ret = ESP_OK;
+          quality = next;
+        } else {
+          bsp_jpeg_unref(second);
+        }
       }
     }
   }
-  *width = BSP_CAMERA_PREVIEW_SIZE;
-  *height = BSP_CAMERA_PREVIEW_SIZE;
-  ret = ESP_OK;
-
-cleanup:
-  if (stream_on) {
-    (void)ioctl(fd, VIDIOC_STREAMOFF, (void *)&type);
-  }
-  for (int i = 0; i < BSP_CAMERA_MMAP_BUFFERS; i++) {
-    if (mmap_ptrs[i]) {
-      (void)munmap(mmap_ptrs[i], mmap_sizes[i]);
-    }
-  }
-  close(fd);
-
+  st.encode_us = (uint32_t)(esp_timer_get_time() - t_scaled);
   if (ret != ESP_OK) {
-    free(*rgb565_data);
-    *rgb565_data = NULL;
-    *width = 0;
-    *height = 0;
+    ESP_LOGE(TAG, "vision JPEG encode failed at q%" PRIu32 ": %s", quality,
+             esp_err_to_name(ret));
+    goto done;
+  }
+  st.quality = quality;
+  st.jpeg_len = best->len;
+  st.total_us = (uint32_t)(esp_timer_get_time() - t_start);
+  s_vision_quality = quality;
+  s_vision_quality_size = size;
+
+  if (best->len > cfg->budget_bytes) {
+    ESP_LOGW(TAG, "vision JPEG over budget at q%" PRIu32 "%s: %" PRIu32
+                  " > %u bytes",
+             quality, quality == BSP_VISION_QUALITY_MIN ? " (minimum)" : "",
+             st.jpeg_len, (unsigned)cfg->budget_bytes);
+  }
+  ESP_LOGI(TAG,
+           "vision JPEG %" PRIu32 "x%" PRIu32 " (from %" PRIu32 "x%" PRIu32
+           "): %" PRIu32 " B / budget %u B, q%" PRIu32 ", %" PRIu32
+           " pass(es); wait %" PRIu32 " ms, scale %" PRIu32
+           " ms, encode %" PRIu32 " ms, total %" PRIu32 " ms",
+           st.width, st.height, st.src_w, st.src_h, st.jpeg_len,
+           (unsigned)st.budget_bytes, st.quality, st.passes,
+           st.capture_us / 1000, st.scale_us / 1000, st.encode_us / 1000,
+           st.total_us / 1000);
+  *jpeg = best;
+  best = NULL;
+
+done:
+  xSemaphoreGive(s_jpeg_lock);
+  bsp_jpeg_unref(best);
+  if (stats) {
+    *stats = st;
   }
   return ret;
 }
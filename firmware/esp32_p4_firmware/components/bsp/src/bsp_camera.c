@@ -0,0 +1,427 @@
+#include "bsp.h"
+#include "bsp_camera.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *)-1)
+#endif
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_video_device.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "linux/videodev2.h"
+
+static const char *TAG = "bsp";
+
+#define BSP_CAMERA_MMAP_BUFFERS 3 // Ring kept queued while streaming
+#define BSP_CAMERA_FRAME_TIMEOUT_MS 1000
+#define BSP_CAMERA_DQBUF_POLL_MS 5
+#define BSP_CAMERA_PREVIEW_SKIP_FRAMES                                         \
+  8 // More frames for ISP stabilization (AWB, AGC, etc.)
+
+/* Long-lived capture session: the device is opened, negotiated and
+ * streaming once, and stays on until bsp_camera_session_stop(). */
+typedef struct {
+  int fd;
+  bool streaming;
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytesperline;
+  uint32_t pixel_format;
+  uint32_t buf_count;
+  void *ptrs[BSP_CAMERA_MMAP_BUFFERS];
+  size_t sizes[BSP_CAMERA_MMAP_BUFFERS];
+  uint32_t sequence;
+  uint32_t dropped;
+} bsp_camera_session_t;
+
+static bsp_camera_session_t s_cam = {.fd = -1};
+static SemaphoreHandle_t s_cam_lock;
+
+esp_err_t bsp_camera_session_init(void) {
+  if (!s_cam_lock) {
+    s_cam_lock = xSemaphoreCreateMutex();
+  }
+  return s_cam_lock ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static int bsp_camera_open_capture_fd(int flags, const char **opened_dev_name) {
+  // For MIPI CSI (OV2710), ISP processes RAW10->RGB565 through /dev/video0
+  // ISP DVP device (/dev/video1) only exists when ISP is configured for DVP
+  // input
+  const char *video_dev_candidates[] = {
+      ESP_VIDEO_MIPI_CSI_DEVICE_NAME, // /dev/video0 - MIPI CSI with ISP
+                                      // processing
+      ESP_VIDEO_ISP_DVP_DEVICE_NAME, // /dev/video1 - ISP DVP (may not exist for
+                                     // CSI)
+      ESP_VIDEO_DVP_DEVICE_NAME,     // /dev/video2 - DVP
+  };
+  const size_t candidates =
+      sizeof(video_dev_candidates) / sizeof(video_dev_candidates[0]);
+
+  for (size_t i = 0; i < candidates; i++) {
+    int test_fd = open(video_dev_candidates[i], O_RDONLY | flags);
+    if (test_fd < 0) {
+      test_fd = open(video_dev_candidates[i], O_RDWR | flags);
+    }
+    if (test_fd < 0) {
+      ESP_LOGW(TAG, "open %s failed (errno=%d)", video_dev_candidates[i],
+               errno);
+      continue;
+    }
+
+    struct v4l2_capability cap = {0};
+    if (ioctl(test_fd, VIDIOC_QUERYCAP, &cap) != 0) {
+      ESP_LOGW(TAG, "VIDIOC_QUERYCAP failed on %s", video_dev_candidates[i]);
+      close(test_fd);
+      continue;
+    }
+
+    const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS)
+                              ? cap.device_caps
+                              : cap.capabilities;
+    if ((caps & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE)) ==
+        0) {
+      ESP_LOGW(TAG, "skip non-capture %s caps=0x%08" PRIx32,
+               video_dev_candidates[i], caps);
+      close(test_fd);
+      continue;
+    }
+
+    if (opened_dev_name) {
+      *opened_dev_name = video_dev_candidates[i];
+    }
+    return test_fd;
+  }
+
+  return -1;
+}
+
+static bool bsp_camera_try_set_capture_format(int fd, uint32_t pixfmt,
+                                              uint32_t *out_w, uint32_t *out_h,
+                                              uint32_t *out_bytesperline) {
+  // ISP-supported resolutions (OV2710 outputs 1920x1080 RAW, ISP converts to
+  // RGB) Try current format first, then common ISP output resolutions
+  const uint32_t sizes[][2] = {
+      {640, 480},   // VGA - commonly supported by ISP
+      {1280, 720},  // HD - commonly supported by ISP
+      {1920, 1080}, // Full HD - matches sensor output
+      {800, 600},   // SVGA
+  };
+
+  // First, try to use current format (ISP may already have a good format set)
+  struct v4l2_format cur = {0};
+  cur.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (ioctl(fd, VIDIOC_G_FMT, &cur) == 0 && cur.fmt.pix.width > 0 &&
+      cur.fmt.pix.height > 0) {
+    // Only change pixel format, keep resolution
+    struct v4l2_format req = {
+        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+        .fmt.pix.width = cur.fmt.pix.width,
+        .fmt.pix.height = cur.fmt.pix.height,
+        .fmt.pix.pixelformat = pixfmt,
+    };
+    if (ioctl(fd, VIDIOC_S_FMT, &req) == 0) {
+      if (out_w)
+        *out_w = req.fmt.pix.width;
+      if (out_h)
+        *out_h = req.fmt.pix.height;
+      if (out_bytesperline)
+        *out_bytesperline = req.fmt.pix.bytesperline;
+      ESP_LOGD(TAG, "Using current format: %" PRIu32 "x%" PRIu32, *out_w,
+               *out_h);
+      return true;
+    }
+  }
+
+  // If current format doesn't work, try ISP-supported resolutions
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    struct v4l2_format req = {
+        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+        .fmt.pix.width = sizes[i][0],
+        .fmt.pix.height = sizes[i][1],
+        .fmt.pix.pixelformat = pixfmt,
+    };
+    if (ioctl(fd, VIDIOC_S_FMT, &req) == 0) {
+      if (out_w)
+        *out_w = req.fmt.pix.width;
+      if (out_h)
+        *out_h = req.fmt.pix.height;
+      if (out_bytesperline)
+        *out_bytesperline = req.fmt.pix.bytesperline;
+      ESP_LOGD(TAG, "Set format: %" PRIu32 "x%" PRIu32, *out_w, *out_h);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void bsp_camera_session_close_locked(void) {
+  const int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (s_cam.streaming) {
+    (void)ioctl(s_cam.fd, VIDIOC_STREAMOFF, (void *)&type);
+  }
+  for (uint32_t i = 0; i < BSP_CAMERA_MMAP_BUFFERS; i++) {
+    if (s_cam.ptrs[i]) {
+      (void)munmap(s_cam.ptrs[i], s_cam.sizes[i]);
+    }
+  }
+  if (s_cam.fd >= 0) {
+    /* Give the driver's DMA buffers back before closing. */
+    struct v4l2_requestbuffers req = {
+        .count = 0,
+        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+        .memory = V4L2_MEMORY_MMAP,
+    };
+    (void)ioctl(s_cam.fd, VIDIOC_REQBUFS, &req);
+    close(s_cam.fd);
+  }
+  if (s_cam.sequence > 0) {
+    ESP_LOGI(TAG, "camera session closed: %" PRIu32 " frames, %" PRIu32
+                  " stale frames skipped",
+             s_cam.sequence, s_cam.dropped);
+  }
+  memset(&s_cam, 0, sizeof(s_cam));
+  s_cam.fd = -1;
+}
+
+/* DQBUF on the non-blocking fd, polling until a frame is ready. Drivers that
+ * ignore O_NONBLOCK simply block here. */
+static esp_err_t bsp_camera_dqbuf_wait(struct v4l2_buffer *buf,
+                                       int timeout_ms) {
+  const TickType_t start = xTaskGetTickCount();
+  for (;;) {
+    memset(buf, 0, sizeof(*buf));
+    buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf->memory = V4L2_MEMORY_MMAP;
+    if (ioctl(s_cam.fd, VIDIOC_DQBUF, buf) == 0) {
+      return ESP_OK;
+    }
+    if (errno != EAGAIN) {
+      return ESP_FAIL;
+    }
+    if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(timeout_ms)) {
+      return ESP_ERR_TIMEOUT;
+    }
+    const TickType_t poll_ticks = pdMS_TO_TICKS(BSP_CAMERA_DQBUF_POLL_MS);
+    vTaskDelay(poll_ticks > 0 ? poll_ticks : 1);
+  }
+}
+
+static esp_err_t bsp_camera_session_open_locked(void) {
+  if (s_cam.streaming) {
+    return ESP_OK;
+  }
+  ESP_RETURN_ON_ERROR(bsp_camera_ensure_ready(), TAG, "camera init failed");
+
+  const char *opened_dev = NULL;
+  s_cam.fd = bsp_camera_open_capture_fd(O_NONBLOCK, &opened_dev);
+  if (s_cam.fd < 0) {
+    ESP_LOGE(TAG, "camera open failed");
+    return ESP_FAIL;
+  }
+
+  // OV2710 outputs RAW10 at 1920x1080, ISP converts to RGB565
+  // Don't try to set unsupported resolutions directly - let ISP handle it
+  // Try RGB565 first (ISP output), then RGB24
+  if (bsp_camera_try_set_capture_format(s_cam.fd, V4L2_PIX_FMT_RGB565,
+                                        &s_cam.width, &s_cam.height,
+                                        &s_cam.bytesperline)) {
+    s_cam.pixel_format = V4L2_PIX_FMT_RGB565;
+  } else if (bsp_camera_try_set_capture_format(
+                 s_cam.fd, V4L2_PIX_FMT_RGB24, &s_cam.width, &s_cam.height,
+                 &s_cam.bytesperline)) {
+    s_cam.pixel_format = V4L2_PIX_FMT_RGB24;
+  } else {
+    ESP_LOGE(TAG, "Failed to set any supported capture format");
+    bsp_camera_session_close_locked();
+    return ESP_FAIL;
+  }
+  if (s_cam.bytesperline == 0) {
+    s_cam.bytesperline =
+        s_cam.width * (s_cam.pixel_format == V4L2_PIX_FMT_RGB565 ? 2 : 3);
+  }
+
+  const int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  struct v4l2_requestbuffers req = {
+      .count = BSP_CAMERA_MMAP_BUFFERS,
+      .type = type,
+      .memory = V4L2_MEMORY_MMAP,
+  };
+  if (ioctl(s_cam.fd, VIDIOC_REQBUFS, &req) != 0 || req.count < 1) {
+    ESP_LOGE(TAG, "VIDIOC_REQBUFS failed");
+    bsp_camera_session_close_locked();
+    return ESP_FAIL;
+  }
+  s_cam.buf_count = req.count < BSP_CAMERA_MMAP_BUFFERS
+                        ? req.count
+                        : BSP_CAMERA_MMAP_BUFFERS;
+
+  for (uint32_t i = 0; i < s_cam.buf_count; i++) {
+    struct v4l2_buffer buf = {
+        .type = type,
+        .memory = V4L2_MEMORY_MMAP,
+        .index = i,
+    };
+    if (ioctl(s_cam.fd, VIDIOC_QUERYBUF, &buf) != 0) {
+      ESP_LOGE(TAG, "VIDIOC_QUERYBUF failed idx=%" PRIu32, i);
+      bsp_camera_session_close_locked();
+      return ESP_FAIL;
+    }
+    void *ptr = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     s_cam.fd, buf.m.offset);
+    if (ptr == MAP_FAILED) {
+      ESP_LOGE(TAG, "mmap failed idx=%" PRIu32, i);
+      bsp_camera_session_close_locked();
+      return ESP_FAIL;
+    }
+    s_cam.ptrs[i] = ptr;
+    s_cam.sizes[i] = buf.length;
+    if (ioctl(s_cam.fd, VIDIOC_QBUF, &buf) != 0) {
+      ESP_LOGE(TAG, "VIDIOC_QBUF failed idx=%" PRIu32, i);
+      bsp_camera_session_close_locked();
+      return ESP_FAIL;
+    }
+  }
+
+  if (ioctl(s_cam.fd, VIDIOC_STREAMON, (void *)&type) != 0) {
+    ESP_LOGE(TAG, "VIDIOC_STREAMON failed");
+    bsp_camera_session_close_locked();
+    return ESP_FAIL;
+  }
+  s_cam.streaming = true;
+
+  /* ISP stabilization (AWB, AGC, ...) once per session, not per frame. */
+  for (int i = 0; i < BSP_CAMERA_PREVIEW_SKIP_FRAMES; i++) {
+    struct v4l2_buffer buf;
+    if (bsp_camera_dqbuf_wait(&buf, BSP_CAMERA_FRAME_TIMEOUT_MS) != ESP_OK ||
+        ioctl(s_cam.fd, VIDIOC_QBUF, &buf) != 0) {
+      ESP_LOGE(TAG, "camera warmup failed");
+      bsp_camera_session_close_locked();
+      return ESP_FAIL;
+    }
+  }
+
+  ESP_LOGI(TAG,
+           "camera session streaming: %s %" PRIu32 "x%" PRIu32 " %s, %" PRIu32
+           " buffers",
+           opened_dev, s_cam.width, s_cam.height,
+           s_cam.pixel_format == V4L2_PIX_FMT_RGB565 ? "RGB565" : "RGB24",
+           s_cam.buf_count);
+  return ESP_OK;
+}
+
+esp_err_t bsp_camera_session_start(void) {
+  if (!s_cam_lock) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  xSemaphoreTake(s_cam_lock, portMAX_DELAY);
+  esp_err_t ret = bsp_camera_session_open_locked();
+  xSemaphoreGive(s_cam_lock);
+  return ret;
+}
+
+void bsp_camera_session_stop(void) {
+  if (!s_cam_lock) {
+    return;
+  }
+  xSemaphoreTake(s_cam_lock, portMAX_DELAY);
+  if (s_cam.fd >= 0) {
+    bsp_camera_session_close_locked();
+  }
+  xSemaphoreGive(s_cam_lock);
+}
+
+bool bsp_camera_session_is_active(void) { return s_cam.streaming; }
+
+esp_err_t bsp_camera_frame_acquire(bsp_camera_frame_t *frame,
+                                   int timeout_ms) {
+  if (!frame) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(frame, 0, sizeof(*frame));
+  if (!s_cam_lock) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (timeout_ms < 0) {
+    timeout_ms = BSP_CAMERA_FRAME_TIMEOUT_MS;
+  }
+
+  xSemaphoreTake(s_cam_lock, portMAX_DELAY);
+  esp_err_t ret = bsp_camera_session_open_locked();
+  if (ret != ESP_OK) {
+    xSemaphoreGive(s_cam_lock);
+    return ret;
+  }
+
+  struct v4l2_buffer buf;
+  ret = bsp_camera_dqbuf_wait(&buf, timeout_ms);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "VIDIOC_DQBUF failed: %s", esp_err_to_name(ret));
+    if (ret != ESP_ERR_TIMEOUT) {
+      bsp_camera_session_close_locked(); // reopened on the next call
+    }
+    xSemaphoreGive(s_cam_lock);
+    return ret;
+  }
+
+  /* Frames that completed while nobody was reading are stale: hand out the
+   * newest one and requeue the rest. */
+  for (uint32_t i = 1; i < s_cam.buf_count; i++) {
+    struct v4l2_buffer newer = {
+        .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+        .memory = V4L2_MEMORY_MMAP,
+    };
+    if (ioctl(s_cam.fd, VIDIOC_DQBUF, &newer) != 0) {
+      break;
+    }
+    (void)ioctl(s_cam.fd, VIDIOC_QBUF, &buf);
+    buf = newer;
+    s_cam.dropped++;
+  }
+
+  if (buf.index >= s_cam.buf_count || buf.bytesused == 0) {
+    ESP_LOGE(TAG, "invalid camera frame");
+    (void)ioctl(s_cam.fd, VIDIOC_QBUF, &buf);
+    xSemaphoreGive(s_cam_lock);
+    return ESP_FAIL;
+  }
+
+  frame->data = (const uint8_t *)s_cam.ptrs[buf.index];
+  frame->width = s_cam.width;
+  frame->height = s_cam.height;
+  frame->bytesperline = s_cam.bytesperline;
+  frame->pixel_format = s_cam.pixel_format;
+  frame->sequence = ++s_cam.sequence;
+  frame->index = buf.index;
+  frame->timestamp_us = esp_timer_get_time();
+  return ESP_OK; // s_cam_lock held until bsp_camera_frame_release()
+}
+
+void bsp_camera_frame_release(bsp_camera_frame_t *frame) {
+  if (!frame || !frame->data) {
+    return;
+  }
+  struct v4l2_buffer buf = {
+      .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+      .memory = V4L2_MEMORY_MMAP,
+      .index = frame->index,
+  };
+  if (s_cam.fd >= 0 && ioctl(s_cam.fd, VIDIOC_QBUF, &buf) != 0) {
+    ESP_LOGW(TAG, "VIDIOC_QBUF failed after capture");
+  }
+  frame->data = NULL;
+  xSemaphoreGive(s_cam_lock);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "esp_err.h"
+
+/* Internal to the bsp component. The capture session (V4L2 device, mmapped
+ * ring, frame hand-out) lives in bsp_camera.c; the esp_video bring-up on the
+ * board's I2C bus stays in bsp.c. */
+
+/* Creates the session lock; called once from bsp_init(). */
+esp_err_t bsp_camera_session_init(void);
+
+/* One-time esp_video init (bsp.c), run before the device is first opened. */
+esp_err_t bsp_camera_ensure_ready(void);
@@ -0,0 +1,156 @@
+#include "bsp_scaler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* RGB565 fields split so that four pixels can be summed in one word:
+ * red+blue never carry into each other (the green gap absorbs it). */
+#define RGB565_RB_MASK 0xF81Fu
+#define RGB565_G_MASK 0x07E0u
+#define RGB565_RB_ROUND ((2u << 11) | 2u)
+#define RGB565_G_ROUND (2u << 5)
+
+static inline uint32_t bsp_scaler_rgb24_to_565(const uint8_t *p) {
+  return ((uint32_t)(p[0] & 0xF8) << 8) | ((uint32_t)(p[1] & 0xFC) << 3) |
+         (uint32_t)(p[2] >> 3);
+}
+
+static inline uint32_t bsp_scaler_avg4_565(uint32_t a, uint32_t b, uint32_t c,
+                                           uint32_t d) {
+  const uint32_t rb = (a & RGB565_RB_MASK) + (b & RGB565_RB_MASK) +
+                      (c & RGB565_RB_MASK) + (d & RGB565_RB_MASK) +
+                      RGB565_RB_ROUND;
+  const uint32_t g = (a & RGB565_G_MASK) + (b & RGB565_G_MASK) +
+                     (c & RGB565_G_MASK) + (d & RGB565_G_MASK) +
+                     RGB565_G_ROUND;
+  return ((rb >> 2) & RGB565_RB_MASK) | ((g >> 2) & RGB565_G_MASK);
+}
+
+static inline uint32_t bsp_scaler_avg4_rgb24(const uint8_t *a,
+                                             const uint8_t *b,
+                                             const uint8_t *c,
+                                             const uint8_t *d) {
+  uint8_t px[3];
+  for (int i = 0; i < 3; i++) {
+    px[i] = (uint8_t)((a[i] + b[i] + c[i] + d[i] + 2) >> 2);
+  }
+  return bsp_scaler_rgb24_to_565(px);
+}
+
+/* Two pixels per word; swap each half when the display wants big endian. */
+static inline uint32_t bsp_scaler_pack2(uint32_t p0, uint32_t p1, bool swap) {
+  const uint32_t w = p0 | (p1 << 16);
+  return swap ? (((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu)) : w;
+}
+
+static void bsp_scaler_build_axis(uint32_t *t0, uint32_t *t1, uint32_t n,
+                                  uint32_t crop, uint32_t side,
+                                  uint32_t unit) {
+  const uint32_t last = crop + side - 1;
+  for (uint32_t i = 0; i < n; i++) {
+    const uint32_t s = crop + (i * side) / n;
+    t0[i] = s * unit;
+    t1[i] = (s < last ? s + 1 : last) * unit;
+  }
+}
+
+/* Field by field: the struct has padding after swap_bytes, and callers
+ * build it on the stack, so memcmp would see stale bytes and rebuild. */
+static bool bsp_scaler_cfg_equal(const bsp_scaler_cfg_t *a,
+                                 const bsp_scaler_cfg_t *b) {
+  return a->src_w == b->src_w && a->src_h == b->src_h &&
+         a->src_stride == b->src_stride && a->src_bpp == b->src_bpp &&
+         a->dst_w == b->dst_w && a->dst_h == b->dst_h && a->mode == b->mode &&
+         a->swap_bytes == b->swap_bytes;
+}
+
+esp_err_t bsp_scaler_configure(bsp_scaler_t *scaler,
+                               const bsp_scaler_cfg_t *cfg) {
+  if (!scaler || !cfg || cfg->dst_w == 0 || (cfg->dst_w & 1) ||
+      cfg->dst_h == 0 || (cfg->src_bpp != 2 && cfg->src_bpp != 3)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint32_t side = (cfg->src_w < cfg->src_h) ? cfg->src_w : cfg->src_h;
+  if (side < cfg->dst_w || side < cfg->dst_h ||
+      cfg->src_stride < cfg->src_w * cfg->src_bpp) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (scaler->x0 && bsp_scaler_cfg_equal(&scaler->cfg, cfg)) {
+    return ESP_OK;
+  }
+
+  bsp_scaler_deinit(scaler);
+  uint32_t *tables =
+      malloc(sizeof(uint32_t) * 2 * ((size_t)cfg->dst_w + cfg->dst_h));
+  if (!tables) {
+    return ESP_ERR_NO_MEM;
+  }
+  scaler->x0 = tables;
+  scaler->x1 = scaler->x0 + cfg->dst_w;
+  scaler->y0 = scaler->x1 + cfg->dst_w;
+  scaler->y1 = scaler->y0 + cfg->dst_h;
+  scaler->cfg = *cfg;
+
+  /* Center-square crop, then sample the square down to dst_w x dst_h. */
+  bsp_scaler_build_axis(scaler->x0, scaler->x1, cfg->dst_w,
+                        (cfg->src_w - side) / 2, side, cfg->src_bpp);
+  bsp_scaler_build_axis(scaler->y0, scaler->y1, cfg->dst_h,
+                        (cfg->src_h - side) / 2, side, cfg->src_stride);
+  return ESP_OK;
+}
+
+void bsp_scaler_run(const bsp_scaler_t *scaler, const uint8_t *src,
+                    uint8_t *dst) {
+  const bsp_scaler_cfg_t *cfg = &scaler->cfg;
+  const uint32_t *x0 = scaler->x0;
+  const uint32_t *x1 = scaler->x1;
+  const bool swap = cfg->swap_bytes;
+  const bool box = (cfg->mode == BSP_SCALE_BOX2X2);
+  uint32_t *out = (uint32_t *)dst;
+
+  for (uint32_t y = 0; y < cfg->dst_h; y++) {
+    const uint8_t *l0 = src + scaler->y0[y];
+    const uint8_t *l1 = src + scaler->y1[y];
+
+    if (cfg->src_bpp == 2 && !box) {
+      for (uint32_t x = 0; x < cfg->dst_w; x += 2) {
+        *out++ = bsp_scaler_pack2(*(const uint16_t *)(l0 + x0[x]),
+                                  *(const uint16_t *)(l0 + x0[x + 1]), swap);
+      }
+    } else if (cfg->src_bpp == 2) {
+      for (uint32_t x = 0; x < cfg->dst_w; x += 2) {
+        uint32_t p[2];
+        for (int k = 0; k < 2; k++) {
+          p[k] = bsp_scaler_avg4_565(*(const uint16_t *)(l0 + x0[x + k]),
+                                     *(const uint16_t *)(l0 + x1[x + k]),
+                                     *(const uint16_t *)(l1 + x0[x + k]),
+                                     *(const uint16_t *)(l1 + x1[x + k]));
+        }
+        *out++ = bsp_scaler_pack2(p[0], p[1], swap);
+      }
+    } else if (!box) {
+      for (uint32_t x = 0; x < cfg->dst_w; x += 2) {
+        *out++ = bsp_scaler_pack2(bsp_scaler_rgb24_to_565(l0 + x0[x]),
+                                  bsp_scaler_rgb24_to_565(l0 + x0[x + 1]),
+                                  swap);
+      }
+    } else {
+      for (uint32_t x = 0; x < cfg->dst_w; x += 2) {
+        uint32_t p[2];
+        for (int k = 0; k < 2; k++) {
+          p[k] = bsp_scaler_avg4_rgb24(l0 + x0[x + k], l0 + x1[x + k],
+                                       l1 + x0[x + k], l1 + x1[x + k]);
+        }
+        *out++ = bsp_scaler_pack2(p[0], p[1], swap);
+      }
+    }
+  }
+}
+
+void bsp_scaler_deinit(bsp_scaler_t *scaler) {
+  if (!scaler) {
+    return;
+  }
+  free(scaler->x0);
+  memset(scaler, 0, sizeof(*scaler));
+}
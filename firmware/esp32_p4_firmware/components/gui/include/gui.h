@@ -2,6 +2,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 esp_err_t gui_init(void);
@@ -9,11 +10,16 @@ esp_err_t gui_set_state(const char *state_text);
 esp_err_t gui_set_status_icons(bool wifi_ok, int batt_percent);
 esp_err_t gui_set_transcript(const char *text);
 esp_err_t gui_set_response(const char *text);
+esp_err_t gui_append_response(const char *frag, size_t len);
 esp_err_t gui_set_response_compact(bool compact);
 esp_err_t gui_set_response_panel_visible(bool visible);
 esp_err_t gui_set_footer(const char *text);
 esp_err_t gui_scroll_response(int16_t delta_pixels);
 esp_err_t gui_set_recording_progress(uint8_t percent);
 esp_err_t gui_hide_camera_preview(void);
-esp_err_t gui_show_camera_preview_rgb565(const uint8_t *rgb565_data,
-                                         uint16_t width, uint16_t height);
+/* Live view source, polled from the LVGL task at display rate: returns a
+ * new 240x240 RGB565 frame in LCD byte order (BSP_PREVIEW_SWAP_BYTES), or
+ * NULL if there is none. The canvas shows the frame in place, so it must
+ * stay untouched until the next non-NULL return. */
+typedef const uint8_t *(*gui_preview_source_t)(void);
+esp_err_t gui_camera_preview_set_source(gui_preview_source_t source);
@@ -19,8 +19,12 @@ static lv_obj_t *s_label_progress; /* "REC 65%" on the bar        */
 static lv_obj_t *s_panel_footer;   /* Bottom strip background panel */
 static lv_obj_t *s_label_footer;   /* Bottom contextual hints     */
 static lv_obj_t *s_canvas_preview; /* Camera live-view canvas     */
-static lv_color_t *s_preview_buf;
+/* Live view: the canvas points straight at the newest frame of the camera
+ * mailbox; the timer only swaps that pointer, at display rate. */
+static gui_preview_source_t s_preview_source;
+static lv_timer_t *s_preview_timer;
 static lv_coord_t s_response_scroll_y;
+static lv_timer_t *s_stream_timer; /* Repaint of streamed response  */
 
 /* ==================================================================
  *  Layout constants  (240x240 ST7789 display)
@@ -36,6 +40,14 @@ static lv_coord_t s_response_scroll_y;
 #define CONTENT_W (SCR_W - 2 * MARGIN)
 #define CONTENT_H (SCR_H - CONTENT_Y - FOOTER_H - 2)
 
+/* Streamed response: the label points at s_response_buf (static text) and is
+ * repainted by an LVGL timer instead of on every fragment. */
+#define GUI_RESPONSE_BUF_LEN 2048
+#define GUI_STREAM_REFRESH_MS 40
+
+/* Live view: how often the canvas picks up the newest camera frame. */
+#define GUI_PREVIEW_REFRESH_MS 33
+
 /* ==================================================================
  *  Colour palette
  *  Display uses inversion-ON: displayed colour is approx. bitwise NOT.
@@ -90,17 +102,74 @@ static lv_coord_t s_response_scroll_y;
 #endif
 
 /* ==================================================================
- *  Helpers
+ *  Streamed response text
  * ================================================================== */
-static void gui_swap_rgb565_bytes(uint16_t *buffer, size_t pixel_count) {
-  if (!buffer)
-    return;
-  for (size_t i = 0; i < pixel_count; i++) {
-    uint16_t v = buffer[i];
-    buffer[i] = (uint16_t)((v >> 8) | (v << 8));
+/* UTF-8 -> ASCII state carried across fragments (a character may be split
+ * between two SSE events). */
+typedef struct {
+  uint8_t lead; /* Lead byte of the pending sequence */
+  uint8_t need; /* Continuation bytes still expected */
+} gui_translit_t;
+
+static char s_response_buf[GUI_RESPONSE_BUF_LEN];
+static size_t s_response_len;
+static bool s_response_dirty;
+static gui_translit_t s_translit;
+
+/* U+00C0..U+00FF (lead byte 0xC3) -> ASCII; '\0' drops the character. */
+static const char k_latin1_ascii[] =
+    "AAAAAA\0CEEEEIIII\0NOOOOO\0\0UUUU\0\0\0"
+    "aaaaaa\0ceeeeiiii\0nooooo\0\0uuuu\0\0\0";
+
+/* Transliterates @p len bytes into s_response_buf. Accented Latin-1 letters
+ * become their base letter; other multibyte sequences are dropped to avoid
+ * square glyphs in the fonts. */
+static void gui_translit_append(const char *frag, size_t len) {
+  gui_translit_t *st = &s_translit;
+  for (size_t i = 0; i < len; i++) {
+    const uint8_t c = (uint8_t)frag[i];
+    if (st->need > 0) {
+      if ((c & 0xC0) == 0x80) {
+        st->need--;
+        if (st->need == 0 && st->lead == 0xC3) {
+          const char a = k_latin1_ascii[c & 0x3F];
+          if (a && s_response_len + 1 < sizeof(s_response_buf)) {
+            s_response_buf[s_response_len++] = a;
+          }
+        }
+        continue;
+      }
+      st->need = 0; /* Truncated sequence: restart on this byte */
+    }
+    if (c < 0x80) {
+      if (s_response_len + 1 < sizeof(s_response_buf)) {
+        s_response_buf[s_response_len++] = (char)c;
+      }
+    } else if ((c & 0xE0) == 0xC0) {
+      st->lead = c;
+      st->need = 1;
+    } else if ((c & 0xF0) == 0xE0) {
+      st->lead = c;
+      st->need = 2;
+    } else if ((c & 0xF8) == 0xF0) {
+      st->lead = c;
+      st->need = 3;
+    }
   }
+  s_response_buf[s_response_len] = '\0';
+}
+
+static void gui_response_reset(void) {
+  s_response_len = 0;
+  s_response_buf[0] = '\0';
+  s_translit.lead = 0;
+  s_translit.need = 0;
+  s_response_dirty = false;
 }
 
+/* ==================================================================
+ *  Helpers
+ * ================================================================== */
 static lv_coord_t gui_response_max_scroll_y(void) {
   if (!s_panel_response || !s_label_response) {
     return 0;
@@ -129,6 +198,38 @@ static void gui_apply_response_scroll(void) {
   lv_obj_set_y(s_label_response, -s_response_scroll_y);
 }
 
+/* Runs in the LVGL task (lock held): coalesces the fragments received since
+ * the last frame into a single relayout, then parks itself. */
+static void gui_stream_timer_cb(lv_timer_t *t) {
+  if (s_response_dirty && s_label_response) {
+    s_response_dirty = false;
+    lv_label_set_text_static(s_label_response, s_response_buf);
+    gui_apply_response_scroll();
+  }
+  lv_timer_pause(t);
+}
+
+static void gui_raise_hud(void);
+
+static void gui_preview_timer_cb(lv_timer_t *t) {
+  (void)t;
+  const uint8_t *frame = s_preview_source ? s_preview_source() : NULL;
+  if (!frame || !s_canvas_preview) {
+    return;
+  }
+  lv_canvas_set_buffer(s_canvas_preview, (void *)frame, SCR_W, SCR_H,
+                       LV_IMG_CF_TRUE_COLOR);
+  lv_obj_clear_flag(s_canvas_preview, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_move_foreground(s_canvas_preview);
+  gui_raise_hud();
+  /* NOTE: lv_refr_now() removido intencionalmente.
+   * Chamar lv_refr_now() dentro do lock LVGL força um flush SPI síncrono
+   * que pode bloquear a taskLVGL por tempo indefinido quando a fila SPI
+   * está cheia, impedindo o IDLE0 de rodar e disparando o WDT.
+   * O refresh ocorre naturalmente no próximo tick da taskLVGL. */
+  lv_obj_invalidate(s_canvas_preview);
+}
+
 /** Bring all HUD widgets to foreground (over camera canvas). */
 static void gui_raise_hud(void) {
   if (s_panel_status)
@@ -197,16 +298,8 @@ esp_err_t gui_init(void) {
   lv_obj_align(s_canvas_preview, LV_ALIGN_CENTER, 0, 0);
   lv_obj_add_flag(s_canvas_preview, LV_OBJ_FLAG_HIDDEN);
 
-  s_preview_buf = heap_caps_malloc(SCR_W * SCR_H * sizeof(lv_color_t),
-                                   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!s_preview_buf) {
-    s_preview_buf = heap_caps_malloc(SCR_W * SCR_H * sizeof(lv_color_t),
-                                     MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-  }
-  if (s_preview_buf) {
-    lv_canvas_set_buffer(s_canvas_preview, s_preview_buf, SCR_W, SCR_H,
-                         LV_IMG_CF_TRUE_COLOR);
-  }
+  s_preview_timer =
+      lv_timer_create(gui_preview_timer_cb, GUI_PREVIEW_REFRESH_MS, NULL);
 
   /* -- Status bar (top, edge-to-edge) -- */
   s_panel_status =
@@ -255,6 +348,10 @@ esp_err_t gui_init(void) {
   s_response_scroll_y = 0;
   gui_apply_response_scroll();
 
+  s_stream_timer = lv_timer_create(gui_stream_timer_cb, GUI_STREAM_REFRESH_MS,
+                                   NULL);
+  lv_timer_pause(s_stream_timer);
+
   /* -- Recording progress bar (hidden until recording) -- */
   s_bar_progress = lv_bar_create(scr);
   lv_obj_set_size(s_bar_progress, CONTENT_W, PROGRESS_H);
@@ -380,7 +477,10 @@ esp_err_t gui_set_response(const char *text) {
 
   /* Keep deterministic width even if parent layout is deferred. */
   lv_obj_set_width(s_label_response, CONTENT_W - 2 * (PAD + 1));
-  lv_label_set_text(s_label_response, text ? text : "");
+  gui_response_reset();
+  strlcpy(s_response_buf, text ? text : "", sizeof(s_response_buf));
+  s_response_len = strlen(s_response_buf);
+  lv_label_set_text_static(s_label_response, s_response_buf);
   s_response_scroll_y = 0;
   gui_apply_response_scroll();
   gui_raise_hud();
@@ -388,6 +488,21 @@ esp_err_t gui_set_response(const char *text) {
   return ESP_OK;
 }
 
+esp_err_t gui_append_response(const char *frag, size_t len) {
+  if (!s_label_response || !s_stream_timer)
+    return ESP_ERR_INVALID_STATE;
+  if (!frag || len == 0)
+    return ESP_OK;
+  if (!bsp_lvgl_lock(200))
+    return ESP_ERR_TIMEOUT;
+  gui_translit_append(frag, len);
+  s_response_dirty = true;
+  lv_timer_resume(s_stream_timer);
+  bsp_lvgl_unlock();
+  return ESP_OK;
+}
+
+
 esp_err_t gui_set_response_compact(bool compact) {
   if (!s_panel_response || !s_label_response)
     return ESP_ERR_INVALID_STATE;
@@ -513,38 +628,10 @@ esp_err_t gui_hide_camera_preview(void) {
   return ESP_OK;
 }
 
-esp_err_t gui_show_camera_preview_rgb565(const uint8_t *rgb565_data,
-                                         uint16_t width, uint16_t height) {
-  if (!rgb565_data || width == 0 || height == 0 || !s_canvas_preview ||
-      !s_preview_buf) {
-    if (s_canvas_preview) {
-      if (!bsp_lvgl_lock(200))
-        return ESP_ERR_TIMEOUT;
-      lv_obj_add_flag(s_canvas_preview, LV_OBJ_FLAG_HIDDEN);
-      bsp_lvgl_unlock();
-    }
-    return ESP_ERR_INVALID_ARG;
-  }
-  if (width != 240 || height != 240) {
-    return ESP_ERR_INVALID_SIZE;
-  }
-
+esp_err_t gui_camera_preview_set_source(gui_preview_source_t source) {
   if (!bsp_lvgl_lock(200))
     return ESP_ERR_TIMEOUT;
-
-  memcpy(s_preview_buf, rgb565_data, SCR_W * SCR_H * sizeof(lv_color_t));
-  gui_swap_rgb565_bytes((uint16_t *)s_preview_buf, SCR_W * SCR_H);
-
-  lv_obj_clear_flag(s_canvas_preview, LV_OBJ_FLAG_HIDDEN);
-  lv_obj_move_foreground(s_canvas_preview);
-  gui_raise_hud();
-  /* NOTE: lv_refr_now() removido intencionalmente.
-   * Chamar lv_refr_now() dentro do lock LVGL força um flush SPI síncrono
-   * que pode bloquear a taskLVGL por tempo indefinido quando a fila SPI
-   * está cheia, impedindo o IDLE0 de rodar e disparando o WDT.
-   * O refresh ocorre naturalmente no próximo tick da taskLVGL. */
-  lv_obj_invalidate(s_canvas_preview);
-
+  s_preview_source = source;
   bsp_lvgl_unlock();
   return ESP_OK;
 }
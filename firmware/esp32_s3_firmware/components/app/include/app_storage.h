@@ -1,9 +1,13 @@
 #pragma once
 
+#include "audio_pool.h"
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stdint.h>
 
+/** @brief Releases a buffer handed over to the storage queue. */
+typedef void (*app_storage_free_fn_t)(void *ptr);
+
 /**
  * @brief Initialize storage subsystem
  *
@@ -45,9 +49,9 @@ void app_storage_mount_after_camera_init(void);
 /**
  * @brief Queue JPEG image for saving (buffered in PSRAM)
  *
- * This function copies the JPEG data to PSRAM buffer and queues it for
- * saving after the AI interaction completes. This avoids SDMMC/DMA conflicts
- * during network communication.
+ * Copies the JPEG data to a PSRAM buffer and queues it with
+ * app_storage_queue_image_owned(). Prefer the owned variant when the caller
+ * can hand its buffer over.
  *
  * @param jpeg_data Pointer to JPEG data (will be copied to PSRAM)
  * @param jpeg_len Length of JPEG data in bytes
@@ -55,6 +59,24 @@ void app_storage_mount_after_camera_init(void);
  */
 esp_err_t app_storage_queue_image(const uint8_t *jpeg_data, size_t jpeg_len);
 
+/**
+ * @brief Queue a JPEG image, taking ownership of its buffer (no copy)
+ *
+ * The buffer is saved after the AI interaction completes, avoiding
+ * SDMMC/DMA conflicts during network communication, and then released with
+ * @p free_fn. Queued items are limited by the PSRAM they hold, not by
+ * count; an item over the budget is written to SD immediately (in the
+ * caller's task), and only if that fails are the oldest items dropped.
+ *
+ * @param jpeg_data Buffer to hand over; released with @p free_fn on every
+ *                  path, including errors
+ * @param jpeg_len Length of JPEG data in bytes
+ * @param free_fn Releases @p jpeg_data (e.g. free, heap_caps_free)
+ * @return ESP_OK if queued or saved, error code otherwise
+ */
+esp_err_t app_storage_queue_image_owned(uint8_t *jpeg_data, size_t jpeg_len,
+                                        app_storage_free_fn_t free_fn);
+
 /**
  * @brief Process queued images and audio and save to SD card
  *
@@ -75,7 +97,7 @@ void app_storage_notify_interaction(void);
 /**
  * @brief Get number of queued images waiting to be saved
  *
- * @return Number of images in queue (0-5)
+ * @return Number of images and recordings in queue
  */
 int app_storage_get_queue_count(void);
 
@@ -103,8 +125,8 @@ esp_err_t app_storage_save_audio(const uint8_t *pcm_data, size_t pcm_bytes,
 /**
  * @brief Queue recording audio for saving (buffered in PSRAM)
  *
- * This function copies the audio data to PSRAM buffer and queues it for
- * saving later. This avoids SDMMC/DMA conflicts during AI voice recording.
+ * Copies the audio data to a PSRAM buffer and queues it with
+ * app_storage_queue_audio_owned().
  *
  * @param pcm_data Pointer to PCM data (will be copied to PSRAM)
  * @param pcm_bytes Length of PCM data in bytes
@@ -114,6 +136,28 @@ esp_err_t app_storage_save_audio(const uint8_t *pcm_data, size_t pcm_bytes,
 esp_err_t app_storage_queue_audio(const uint8_t *pcm_data, size_t pcm_bytes,
                                   uint32_t sample_rate_hz);
 
+/**
+ * @brief Queue recording audio, taking ownership of its buffer (no copy)
+ *
+ * Same admission and ownership rules as app_storage_queue_image_owned().
+ * The whole recording is archived (no size cap).
+ */
+esp_err_t app_storage_queue_audio_owned(uint8_t *pcm_data, size_t pcm_bytes,
+                                        uint32_t sample_rate_hz,
+                                        app_storage_free_fn_t free_fn);
+
+/**
+ * @brief Queue [offset, offset + pcm_bytes) of a segmented recording,
+ *        taking its segments (no copy)
+ *
+ * The segments move to the queue and go back to the audio pool once saved;
+ * @p chain is left empty on every path. Queued recordings hold at most half
+ * of the pool, so the next recording always has room.
+ */
+esp_err_t app_storage_queue_audio_chain(audio_chain_t *chain, size_t offset,
+                                        size_t pcm_bytes,
+                                        uint32_t sample_rate_hz);
+
 /**
  * @brief Append an interaction entry to the daily chat log on SD card
  *
@@ -127,6 +171,20 @@ esp_err_t app_storage_queue_audio(const uint8_t *pcm_data, size_t pcm_bytes,
 esp_err_t app_storage_save_chat_log(const char *mode_label,
                                     const char *ai_response);
 
+/**
+ * @brief Calibrate the SD SPI clock and report write throughput
+ *
+ * Tries each step of BSP_SD_FREQ_STEPS_KHZ: remounts at that clock, writes a
+ * scratch file with a known pattern, times the sequential write (KB/s), reads
+ * it back and compares CRC32. The fastest step that passes is stored in NVS
+ * and used from then on. Remounts the card, so call it at boot before any
+ * other SD traffic.
+ *
+ * @param force Run even if a calibrated clock is already stored (bench mode)
+ * @return ESP_OK if a clock passed, ESP_ERR_NOT_FOUND if none did
+ */
+esp_err_t app_storage_sd_calibrate(bool force);
+
 /**
  * @brief Force mount SD card if not already mounted
  *
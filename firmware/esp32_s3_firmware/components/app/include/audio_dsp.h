@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Block DSP kernels for audio buffers.
+ *
+ * The capture front-end (audio_frontend_decode) does not use them: its
+ * high-pass has to feed the clamped output back to stay bit-exact, which
+ * keeps the filter scalar, and a block pipeline around that recursion ran
+ * at about half the throughput of the fused loop (bench_audio_frontend).
+ *
+ * The filter and energy kernels have a portable C reference
+ * (audio_dsp_ref_*) and dispatching entry points (audio_dsp_*) bound at
+ * compile time: on the ESP32-S3 they use esp-dsp (PIE-optimised biquad and
+ * dot product), elsewhere, or with AUDIO_DSP_FORCE_REFERENCE defined, the
+ * reference code. They are measured by audio_dsp_self_test() on request
+ * ("audio": {"dsp_bench": true}) and by the host tests. The module has no
+ * ESP-IDF dependency in the reference build, so it also compiles on a
+ * Linux host.
+ */
+
+/** @brief Block length used by the benchmarks (bench_audio_frontend). */
+#define AUDIO_DSP_BLOCK 256
+
+/** @brief Name of the compiled-in backend ("esp-dsp" or "reference"). */
+const char *audio_dsp_backend(void);
+
+/**
+ * @brief Biquad coefficients {b0, b1, b2, a1, a2} equivalent to the
+ *        1st-order high-pass y[n] = alpha * (y[n-1] + x[n] - x[n-1]).
+ */
+void audio_dsp_highpass_coefs(float alpha, float coef[5]);
+
+/**
+ * @brief Decode interleaved 32-bit stereo I2S frames to mono float.
+ *
+ * Keeps the louder of L/R after >>15, clamped to the int16 range, so the
+ * result holds exactly the 16-bit sample the BSP would produce.
+ */
+void audio_dsp_i2s_to_f32(const int32_t *raw, size_t frames, float *out);
+
+/**
+ * @brief Direct form II biquad, in-place allowed (in == out).
+ *
+ * @param coef {b0, b1, b2, a1, a2}.
+ * @param w    Two delay elements, carried across calls (zero to start).
+ */
+void audio_dsp_biquad_f32(const float *in, float *out, size_t count,
+                          const float coef[5], float w[2]);
+
+/**
+ * @brief Sum of squares of a float block (dot product with itself).
+ *
+ * Single-precision accumulation: rounded, not the exact integer sum of
+ * audio_window_stats_t.
+ */
+float audio_dsp_energy_f32(const float *samples, size_t count);
+
+/**
+ * @brief Saturating pack of float samples to int16 (truncated toward zero,
+ *        as a (int16_t) cast after clamping).
+ */
+void audio_dsp_pack_s16(const float *in, int16_t *out, size_t count);
+
+/* Portable reference kernels --------------------------------------------- */
+
+void audio_dsp_ref_biquad_f32(const float *in, float *out, size_t count,
+                              const float coef[5], float w[2]);
+float audio_dsp_ref_energy_f32(const float *samples, size_t count);
+
+/* Self-test ---------------------------------------------------------------- */
+
+/**
+ * @brief Result of audio_dsp_self_test().
+ *
+ * Ticks are CPU cycles on the device and nanoseconds on a host build.
+ */
+typedef struct {
+  const char *backend;
+  float biquad_max_err;  /* largest |fast - reference| (int16 LSBs)     */
+  float energy_rel_err;  /* |fast - reference| / reference              */
+  uint32_t samples;      /* block length used for the timings           */
+  uint32_t ref_ticks[2]; /* reference biquad, energy                    */
+  uint32_t dsp_ticks[2]; /* dispatched biquad, energy                   */
+  bool ok;               /* errors within tolerance                     */
+} audio_dsp_report_t;
+
+/**
+ * @brief Run the dispatched kernels against the reference on a synthetic
+ *        speech-like signal and time both.
+ *
+ * Allocates ~12 KB of scratch for the duration of the call.
+ *
+ * @return false if the scratch could not be allocated or the kernels
+ *         disagree beyond tolerance (report->ok is set accordingly).
+ */
+bool audio_dsp_self_test(audio_dsp_report_t *report);
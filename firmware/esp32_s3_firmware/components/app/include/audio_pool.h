@@ -0,0 +1,95 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Segmented audio buffer pool.
+ *
+ * Fixed-size PSRAM segments are allocated once (audio_pool_init) and lent
+ * to recordings as chains. A recording is limited by the free segments in
+ * the pool, not by the largest free block of the heap, and capturing,
+ * uploading and archiving allocate nothing in steady state. Segments go
+ * back to the pool with audio_chain_release().
+ */
+
+typedef struct audio_seg {
+  uint8_t *data; /* audio_pool_seg_bytes() bytes */
+  struct audio_seg *next;
+} audio_seg_t;
+
+/**
+ * @brief A recording stored as a chain of pool segments.
+ *
+ * Written by one task (audio_chain_reserve/commit). Another task may read
+ * the bytes below a length published to it with release semantics: the
+ * links to new segments are written before their data.
+ */
+typedef struct {
+  audio_seg_t *head;
+  audio_seg_t *tail;
+  size_t len;       /* bytes committed */
+  size_t tail_used; /* bytes committed in the tail segment */
+  size_t count;     /* segments held */
+} audio_chain_t;
+
+/** @brief Cursor over a byte range of a chain (see audio_chain_iter_init). */
+typedef struct {
+  const audio_seg_t *seg;
+  size_t seg_off;
+  size_t remaining;
+} audio_chain_iter_t;
+
+/**
+ * @brief Allocate @p seg_count segments of @p seg_bytes in PSRAM.
+ *
+ * Keeps what could be allocated if PSRAM runs out part way (logged);
+ * fails only if no segment at all could be allocated. Call once.
+ */
+esp_err_t audio_pool_init(size_t seg_bytes, size_t seg_count);
+
+/** @brief Size of one segment (0 before audio_pool_init). */
+size_t audio_pool_seg_bytes(void);
+
+/** @brief Segments allocated by audio_pool_init(). */
+size_t audio_pool_total_segments(void);
+
+/** @brief Segments currently free. */
+size_t audio_pool_free_segments(void);
+
+void audio_chain_init(audio_chain_t *chain);
+
+/**
+ * @brief Writable space at the end of the chain, taking a new segment from
+ *        the pool when the tail is full.
+ *
+ * @param[out] room Contiguous bytes available at the returned pointer.
+ * @return NULL if the pool is exhausted.
+ */
+uint8_t *audio_chain_reserve(audio_chain_t *chain, size_t *room);
+
+/** @brief Mark @p bytes of the last reservation as written. */
+void audio_chain_commit(audio_chain_t *chain, size_t bytes);
+
+/** @brief Return every segment to the pool and reset the chain. */
+void audio_chain_release(audio_chain_t *chain);
+
+/**
+ * @brief Start iterating [offset, offset + len) of the chain; the range is
+ *        clamped to the committed length.
+ */
+void audio_chain_iter_init(audio_chain_iter_t *it, const audio_chain_t *chain,
+                           size_t offset, size_t len);
+
+/**
+ * @brief Next contiguous piece of the range.
+ * @return false when the range is exhausted.
+ */
+bool audio_chain_iter_next(audio_chain_iter_t *it, const uint8_t **data,
+                           size_t *len);
+
+/** @brief Copy [offset, offset + len) into @p dst; returns bytes copied. */
+size_t audio_chain_read(const audio_chain_t *chain, size_t offset, void *dst,
+                        size_t len);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -25,3 +26,163 @@ float audio_calculate_rms(const int16_t *samples, size_t count);
  */
 void audio_apply_highpass(int16_t *samples, size_t count, float fc_hz,
                           float fs_hz);
+
+/**
+ * @brief State of the streaming high-pass filter (see audio_highpass_init).
+ */
+typedef struct {
+  float alpha;
+  float prev_x;
+  float prev_y;
+  bool primed; /* false until the first sample has been seen */
+} audio_highpass_state_t;
+
+/**
+ * @brief Initialise a streaming high-pass filter.
+ *
+ * Same filter as audio_apply_highpass(), but the state is carried across
+ * calls so the signal can be filtered chunk by chunk while it is captured.
+ * Filtering a buffer in consecutive chunks gives the same output as one
+ * audio_apply_highpass() call over the whole buffer.
+ */
+void audio_highpass_init(audio_highpass_state_t *state, float fc_hz,
+                         float fs_hz);
+
+/**
+ * @brief Filter the next chunk of a stream in-place.
+ *
+ * @param state    Filter state created with audio_highpass_init().
+ * @param samples  Pointer to 16-bit PCM samples (modified in-place).
+ * @param count    Number of samples (not bytes).
+ */
+void audio_highpass_process(audio_highpass_state_t *state, int16_t *samples,
+                            size_t count);
+
+/* Capture front-end ------------------------------------------------------- */
+
+/**
+ * @brief Level statistics of the current analysis window, accumulated in
+ *        integers while samples are decoded.
+ */
+typedef struct {
+  int64_t sum_sq;     /* sum of squared samples (exact)            */
+  uint32_t count;     /* samples in the window                     */
+  uint32_t crossings; /* sign changes, including across chunks     */
+  int32_t peak;       /* largest absolute sample                   */
+} audio_window_stats_t;
+
+/**
+ * @brief State of the fused capture kernel (see audio_frontend_decode).
+ */
+typedef struct {
+  audio_highpass_state_t hpf; /* same filter as audio_highpass_process() */
+  audio_window_stats_t window;
+  int16_t last; /* previous output sample, for zero crossings */
+} audio_frontend_t;
+
+/**
+ * @brief Initialise the capture front-end with the given high-pass cut-off.
+ */
+void audio_frontend_init(audio_frontend_t *fe, float fc_hz, float fs_hz);
+
+/** @brief Start a new analysis window (statistics only; filter state is kept). */
+void audio_frontend_window_reset(audio_frontend_t *fe);
+
+/**
+ * @brief Fused I2S kernel, one pass per DMA chunk (bsp_audio_decode_fn_t).
+ *
+ * For each stereo 32-bit frame: >>15 to 16-bit, keep the louder of L/R,
+ * clamp, run the streaming high-pass filter and update the window
+ * statistics. The filter output is bit-identical to decoding the whole
+ * capture and calling audio_highpass_process() on it afterwards, for any
+ * split of the stream into calls.
+ *
+ * @param raw     Interleaved L/R 32-bit I2S frames.
+ * @param frames  Number of frames (= output samples).
+ * @param out     Destination PCM16 mono samples.
+ * @param ctx     audio_frontend_t created with audio_frontend_init().
+ */
+void audio_frontend_decode(const int32_t *raw, size_t frames, int16_t *out,
+                           void *ctx);
+
+/** @brief RMS of the window statistics (0 for an empty window). */
+float audio_window_rms(const audio_window_stats_t *stats);
+
+/* Voice activity detection ------------------------------------------------ */
+
+/**
+ * @brief Endpointing parameters (see audio_vad_init).
+ */
+typedef struct {
+  uint32_t sample_rate_hz;
+  uint32_t silence_ms;     /* trailing silence that ends the utterance   */
+  uint32_t pre_margin_ms;  /* audio kept before the first voiced window  */
+  uint32_t post_margin_ms; /* audio kept after the last voiced window    */
+} audio_vad_cfg_t;
+
+/**
+ * @brief State of the window-based voice activity detector.
+ *
+ * Positions are sample offsets from the start of the stream.
+ */
+typedef struct {
+  audio_vad_cfg_t cfg;
+  float noise_floor;   /* adaptive RMS of the background noise         */
+  size_t pos;          /* samples processed so far                     */
+  size_t speech_start; /* start of the first voiced window             */
+  size_t speech_end;   /* end of the last voiced window                */
+  size_t run_start;    /* start of the current run of voiced windows   */
+  uint8_t voiced_run;  /* consecutive voiced windows                   */
+  bool speech;         /* onset confirmed (speech_start/end are valid) */
+  bool primed;         /* false until the first window has been seen   */
+} audio_vad_t;
+
+/**
+ * @brief Initialise the voice activity detector.
+ *
+ * Each audio_vad_process() call classifies one analysis window (the app
+ * feeds its 100 ms capture chunks) using short-term energy plus the
+ * zero-crossing rate, against a noise floor that adapts while no one is
+ * speaking. Speech onset needs two consecutive voiced windows, so a single
+ * click (e.g. the button) does not count as speech.
+ */
+void audio_vad_init(audio_vad_t *vad, const audio_vad_cfg_t *cfg);
+
+/**
+ * @brief Classify the next window (high-pass filtered PCM).
+ *
+ * @param vad      Detector created with audio_vad_init().
+ * @param samples  Pointer to 16-bit PCM samples of one window.
+ * @param count    Number of samples (not bytes).
+ * @return true if the window was classified as voiced.
+ */
+bool audio_vad_process(audio_vad_t *vad, const int16_t *samples, size_t count);
+
+/**
+ * @brief Classify the next window from statistics gathered by the capture
+ *        front-end (no extra pass over the samples).
+ *
+ * @param vad    Detector created with audio_vad_init().
+ * @param stats  Window statistics (high-pass filtered signal).
+ * @param count  Samples the window advanced the stream by.
+ * @return true if the window was classified as voiced.
+ */
+bool audio_vad_process_stats(audio_vad_t *vad,
+                             const audio_window_stats_t *stats, size_t count);
+
+/**
+ * @brief true once speech was detected and followed by cfg.silence_ms of
+ *        silence: capture can stop.
+ */
+bool audio_vad_endpoint(const audio_vad_t *vad);
+
+/**
+ * @brief Speech segment with the configured margins, in samples.
+ *
+ * The end never exceeds the samples processed so far and only grows as the
+ * stream advances, so it can be used to publish audio incrementally.
+ *
+ * @return false if no speech has been detected yet.
+ */
+bool audio_vad_get_segment(const audio_vad_t *vad, size_t *start_sample,
+                           size_t *end_sample);
@@ -18,6 +18,7 @@ extern "C" {
 #define CONFIG_AI_PERSONALITY_MAX 256
 #define CONFIG_AI_BASE_URL_MAX    128
 #define CONFIG_AI_MODEL_MAX       64
+#define CONFIG_AI_AUDIO_FORMAT_MAX 8
 #define CONFIG_PROFILE_PROMPT_MAX 512
 #define CONFIG_PROFILE_TERMS_MAX  256
 #define CONFIG_PROFILE_NAME_MAX   32
@@ -46,11 +47,22 @@ typedef struct {
   char ai_base_url[CONFIG_AI_BASE_URL_MAX];
   char ai_model[CONFIG_AI_MODEL_MAX];
   app_expert_profile_t expert_profile; /* índice 0..num_profiles-1 */
+  bool ai_pipelined_upload; /* envia o áudio enquanto o usuário fala */
+  char ai_audio_format[CONFIG_AI_AUDIO_FORMAT_MAX]; /* wav | adpcm | flac */
 
   /* Perfis Especialistas — dinâmicos */
   uint8_t       num_profiles;                   /* 1..CONFIG_MAX_PROFILES */
   app_profile_t profiles[CONFIG_MAX_PROFILES];  /* array de perfis */
 
+  /* Áudio */
+  bool audio_vad;                /* fim automático e corte de silêncio */
+  uint16_t audio_vad_silence_ms; /* silêncio final que encerra; 0 = só corta */
+  uint16_t audio_preroll_ms;     /* áudio antes do botão; 0 = desligado      */
+  bool audio_dsp_bench;          /* mede os kernels de DSP no boot (log)     */
+
+  /* Armazenamento */
+  bool storage_bench; /* recalibra o clock do SD e mede KB/s a cada boot */
+
   /* Hardware */
   uint8_t volume;     /* 0–100 */
   uint8_t brightness; /* 0–100 */
@@ -4,24 +4,26 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "ai_client.h"
 #include "app_state.h"
 #include "app_storage.h"
+#include "audio_codec.h"
+#include "audio_dsp.h"
+#include "audio_pool.h"
 #include "audio_utils.h"
 #include "bsp.h"
 #include "cJSON.h"
 #include "captive_portal.h"
 #include "config_manager.h"
 #include "driver/gpio.h"
-#include "esp_crt_bundle.h"
 #include "esp_heap_caps.h"
-#include "esp_http_client.h"
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "gui.h"
 #include "lwip/ip4_addr.h"
-#include "mbedtls/base64.h"
 
 
 #define APP_TASK_STACK_SIZE (10 * 1024)
@@ -29,10 +31,19 @@
 #define APP_QUEUE_LENGTH 8
 #define APP_BUTTON_POLL_MS 40
 #define APP_BUTTON_DEBOUNCE_MS 140
-#define APP_AUDIO_BUFFER_LEN (660 * 1024)
+/* Pool de audio: 8 kHz/16 bits sao 16 KB/s, entao 20 s de gravacao mais
+ * 750 ms de pre-roll (~332 KB) ocupam 11 segmentos de 32 KB. Os 24
+ * segmentos (768 KB) cabem a gravacao e a copia comprimida (FLAC no pior
+ * caso ~11 segmentos, ADPCM ~3), ou a gravacao e a anterior ainda na fila
+ * do SD; sem segmentos para o codec o envio cai para WAV PCM. */
+#define APP_AUDIO_SEG_BYTES (32 * 1024)
+#define APP_AUDIO_POOL_SEGMENTS 24
 #define APP_CAPTURE_CHUNK_MS 100
+#define APP_CAPTURE_TIMEOUT_MS 1000 /* alem da janela, sem dados do I2S */
 #define APP_MAX_CAPTURE_MS 20000
 #define APP_MIN_CAPTURE_BYTES 24000
+#define APP_VAD_PRE_MARGIN_MS 300
+#define APP_VAD_POST_MARGIN_MS 300
 #define APP_MODE_SELECT_TIMEOUT_MS 4000
 #define APP_PREVIEW_REFRESH_MS 220
 #define APP_RESPONSE_TEXT_MAX 1024
@@ -64,10 +75,6 @@ static uint32_t s_last_interaction_end_ms = 0;
 static uint32_t s_config_longpress_start;
 static bool s_config_longpress_active;
 
-/* Persistent HTTP client — reused across interactions to avoid TLS handshake */
-static esp_http_client_handle_t s_http_client = NULL;
-static char s_http_client_url[512] = {0};
-
 static app_expert_profile_t s_expert_profile =
     0; /* índice 0 = primeiro perfil */
 static char s_last_response[APP_RESPONSE_TEXT_MAX] =
@@ -83,6 +90,18 @@ static void deep_sleep_timer_cb(TimerHandle_t xTimer) {
   }
 }
 
+/* Pre-roll: com o aparelho acordado e ocioso o BSP mantem os ultimos
+ * audio_preroll_ms do microfone, entao a gravacao comeca antes do botao ser
+ * detectado (polling + debounce) e a primeira silaba nao se perde.
+ * Desligado na preparacao do deep sleep. */
+static void app_preroll_enable(bool enable) {
+  const uint32_t ms = enable ? config_manager_get()->audio_preroll_ms : 0;
+  esp_err_t err = bsp_audio_preroll_set(ms);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "pre-roll %u ms: %s", (unsigned)ms, esp_err_to_name(err));
+  }
+}
+
 static void sleep_warning_timer_cb(TimerHandle_t xTimer) {
   app_event_t evt = {.type = APP_EVT_DEEP_SLEEP_WARNING};
   if (s_app_queue) {
@@ -137,65 +156,78 @@ static void app_gui_event_cb(gui_event_type_t event) {
 /* Long-press config portal: btn2 + btn3 simultaneos por 10 s */
 #define APP_CONFIG_PORTAL_LONGPRESS_MS 10000
 
-static uint8_t *app_pcm16_to_wav(const uint8_t *pcm, size_t pcm_len,
-                                 uint32_t sample_rate_hz, uint16_t channels,
-                                 uint16_t bits_per_sample, size_t *wav_len) {
-  if (!pcm || !wav_len || sample_rate_hz == 0 || channels == 0 ||
-      bits_per_sample == 0) {
-    return NULL;
-  }
+static audio_codec_format_t app_audio_format(void) {
+  return audio_codec_from_name(config_manager_get()->ai_audio_format);
+}
 
-  const uint32_t byte_rate = sample_rate_hz * channels * (bits_per_sample / 8);
-  const uint16_t block_align = channels * (bits_per_sample / 8);
-  const size_t total_len = 44 + pcm_len;
-  uint8_t *wav = malloc(total_len);
-  if (!wav) {
-    return NULL;
+/* Pedacos contiguos de [offset, offset + len) da gravacao, na ordem. */
+static size_t app_chain_to_iov(const audio_chain_t *chain, size_t offset,
+                               size_t len, ai_iov_t *iov, size_t max_iov) {
+  audio_chain_iter_t it;
+  audio_chain_iter_init(&it, chain, offset, len);
+  size_t n = 0;
+  while (n < max_iov && audio_chain_iter_next(&it, &iov[n].data, &iov[n].len)) {
+    n++;
   }
-
-  memcpy(wav + 0, "RIFF", 4);
-  uint32_t chunk_size = (uint32_t)(36 + pcm_len);
-  memcpy(wav + 4, &chunk_size, sizeof(uint32_t));
-  memcpy(wav + 8, "WAVE", 4);
-  memcpy(wav + 12, "fmt ", 4);
-  uint32_t subchunk1_size = 16;
-  memcpy(wav + 16, &subchunk1_size, sizeof(uint32_t));
-  uint16_t audio_format = 1;
-  memcpy(wav + 20, &audio_format, sizeof(uint16_t));
-  memcpy(wav + 22, &channels, sizeof(uint16_t));
-  memcpy(wav + 24, &sample_rate_hz, sizeof(uint32_t));
-  memcpy(wav + 28, &byte_rate, sizeof(uint32_t));
-  memcpy(wav + 32, &block_align, sizeof(uint16_t));
-  memcpy(wav + 34, &bits_per_sample, sizeof(uint16_t));
-  memcpy(wav + 36, "data", 4);
-  uint32_t subchunk2_size = (uint32_t)pcm_len;
-  memcpy(wav + 40, &subchunk2_size, sizeof(uint32_t));
-  memcpy(wav + 44, pcm, pcm_len);
-
-  *wav_len = total_len;
-  return wav;
+  return n;
 }
 
-static char *app_base64_encode(const uint8_t *data, size_t data_len) {
-  size_t out_len = 0;
-  int ret = mbedtls_base64_encode(NULL, 0, &out_len, data, data_len);
-  if (ret != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL && ret != 0) {
-    return NULL;
+/* Estado do codificador em stream (~17 KB em PSRAM), alocado na primeira
+ * gravacao com codec e mantido entre interacoes. */
+static audio_codec_stream_t *s_encoder;
+
+/* Sink do codificador: acrescenta os bytes a uma chain do pool. */
+static bool app_encode_sink(void *ctx, const uint8_t *data, size_t len) {
+  audio_chain_t *out = (audio_chain_t *)ctx;
+  while (len > 0) {
+    size_t room = 0;
+    uint8_t *dst = audio_chain_reserve(out, &room);
+    if (!dst) {
+      return false;
+    }
+    const size_t n = (len < room) ? len : room;
+    memcpy(dst, data, n);
+    audio_chain_commit(out, n);
+    data += n;
+    len -= n;
   }
+  return true;
+}
 
-  char *out = malloc(out_len + 1);
-  if (!out) {
-    return NULL;
+/* Codifica o trecho da gravacao em IMA-ADPCM ou FLAC lendo direto dos
+ * segmentos da chain e escrevendo em segmentos do pool (@p out), sem copia
+ * contigua do PCM. Se faltarem segmentos (ex.: gravacao anterior ainda na
+ * fila do SD) @p out fica vazia e o chamador envia WAV PCM. */
+static esp_err_t app_encode_audio(audio_codec_format_t fmt,
+                                  const audio_chain_t *chain,
+                                  size_t pcm_offset, size_t pcm_len,
+                                  uint32_t sample_rate_hz, audio_chain_t *out) {
+  if (!s_encoder) {
+    s_encoder = heap_caps_malloc(sizeof(*s_encoder),
+                                 MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s_encoder) {
+      return ESP_ERR_NO_MEM;
+    }
   }
-
-  ret = mbedtls_base64_encode((unsigned char *)out, out_len, &out_len, data,
-                              data_len);
-  if (ret != 0) {
-    free(out);
-    return NULL;
+  esp_err_t err =
+      audio_codec_stream_begin(s_encoder, fmt, pcm_len / sizeof(int16_t),
+                               sample_rate_hz, app_encode_sink, out);
+  audio_chain_iter_t it;
+  audio_chain_iter_init(&it, chain, pcm_offset, pcm_len);
+  const uint8_t *piece = NULL;
+  size_t piece_len = 0;
+  while (err == ESP_OK && audio_chain_iter_next(&it, &piece, &piece_len)) {
+    /* offset e segmentos de tamanho par: so amostras inteiras e alinhadas */
+    err = audio_codec_stream_write(s_encoder, (const int16_t *)piece,
+                                   piece_len / sizeof(int16_t));
   }
-  out[out_len] = '\0';
-  return out;
+  if (err == ESP_OK) {
+    err = audio_codec_stream_end(s_encoder, NULL);
+  }
+  if (err != ESP_OK) {
+    audio_chain_release(out);
+  }
+  return err;
 }
 
 static void app_utf8_to_ascii(char *text) {
@@ -335,13 +367,20 @@ app_profile_transcription_terms(app_expert_profile_t profile) {
   return cfg->profiles[0].terms; /* fallback seguro */
 }
 
+/* -----------------------------------------------------------------------
+ * Requisicao para a API
+ *
+ * O JSON e montado pelo cJSON com um marcador no lugar do base64 do audio;
+ * o ai_client codifica o audio em blocos direto no socket durante o envio.
+ * ----------------------------------------------------------------------- */
+
 static esp_err_t app_build_ai_request_json(
-    const char *model, const char *audio_b64, const char *system_profile_text,
-    const char *audio_context_text, bool inject_history, char **out_json) {
-  if (!model || !out_json || !audio_b64) {
+    const char *model, const ai_blob_t *audio, audio_codec_format_t audio_fmt,
+    const char *system_profile_text, const char *audio_context_text,
+    bool inject_history, ai_request_t *out_req) {
+  if (!model || !audio || !out_req) {
     return ESP_ERR_INVALID_ARG;
   }
-
   cJSON *root = cJSON_CreateObject();
   cJSON *messages = cJSON_CreateArray();
   if (!root || !messages) {
@@ -422,8 +461,9 @@ static esp_err_t app_build_ai_request_json(
     return ESP_ERR_NO_MEM;
   }
   cJSON_AddStringToObject(audio_part, "type", "input_audio");
-  cJSON_AddStringToObject(audio_obj, "format", "wav");
-  cJSON_AddStringToObject(audio_obj, "data", audio_b64);
+  cJSON_AddStringToObject(audio_obj, "format",
+                          audio_codec_api_format(audio_fmt));
+  cJSON_AddStringToObject(audio_obj, "data", AI_REQUEST_BLOB0_MARKER);
   cJSON_AddItemToObject(audio_part, "input_audio", audio_obj);
   cJSON_AddItemToArray(user_content, audio_part);
 
@@ -435,333 +475,342 @@ static esp_err_t app_build_ai_request_json(
     return ESP_ERR_NO_MEM;
   }
 
-  *out_json = json;
-  return ESP_OK;
+  return ai_request_init(out_req, json, audio, 1);
 }
 
-/* -----------------------------------------------------------------------
- * Persistent HTTP client management
- * ----------------------------------------------------------------------- */
+static void app_ai_client_cfg(ai_client_cfg_t *cfg) {
+  cfg->url = config_manager_get()->ai_base_url;
+  /* Use token from config (set via Captive Portal or SD card) */
+  cfg->token = config_manager_get()->ai_token;
+  cfg->timeout_ms = APP_HTTP_TIMEOUT_MS;
+}
 
-static void app_http_client_invalidate(void) {
-  if (s_http_client) {
-    esp_http_client_cleanup(s_http_client);
-    s_http_client = NULL;
-  }
-  s_http_client_url[0] = '\0';
+/* Repassa cada fragmento do stream SSE para a tela; a GUI agrupa os
+ * fragmentos e redesenha no timer do LVGL. */
+static void app_ai_on_delta(const char *frag, size_t frag_len,
+                            const char *text, size_t text_len,
+                            void *user_ctx) {
+  bool *started = (bool *)user_ctx;
+  if (!*started) {
+    gui_set_response("");
+    *started = true;
+  }
+  gui_append_response(frag, frag_len);
 }
 
-static esp_err_t app_http_client_ensure(void) {
-  const char *url = config_manager_get()->ai_base_url;
-  if (s_http_client && strcmp(s_http_client_url, url) == 0) {
-    return ESP_OK; /* already valid and URL unchanged */
-  }
-  app_http_client_invalidate();
-  esp_http_client_config_t cfg = {
-      .url = url,
-      .timeout_ms = APP_HTTP_TIMEOUT_MS,
-      .crt_bundle_attach = esp_crt_bundle_attach,
-      .keep_alive_enable = true,
-      .keep_alive_idle = 5,
-      .keep_alive_interval = 5,
-      .keep_alive_count = 3,
-  };
-  s_http_client = esp_http_client_init(&cfg);
-  if (!s_http_client) {
-    return ESP_FAIL;
-  }
-  strlcpy(s_http_client_url, url, sizeof(s_http_client_url));
-  ESP_LOGI(TAG, "HTTP client initialized: %s", url);
-  return ESP_OK;
+static esp_err_t app_http_post_json(const ai_request_t *req, char *out_text,
+                                    size_t out_text_len, int *http_code) {
+  ai_client_cfg_t cfg;
+  app_ai_client_cfg(&cfg);
+  bool stream_started = false;
+  return ai_client_post(&cfg, req, out_text, out_text_len, http_code,
+                        app_ai_on_delta, &stream_started);
 }
 
 /* -----------------------------------------------------------------------
- * SSE streaming parser
+ * Requisicao de audio (prompt do perfil + historico)
  * ----------------------------------------------------------------------- */
 
-#define APP_SSE_LINE_BUF 4096
-
-typedef struct {
-  char text[APP_RESPONSE_TEXT_MAX]; /* accumulated response text */
-  size_t text_len;
-  char line_buf[APP_SSE_LINE_BUF]; /* current SSE line assembly buffer */
-  size_t line_buf_pos;
-  bool done;                /* [DONE] received */
-  TickType_t last_gui_tick; /* rate-limit GUI updates */
-} app_sse_ctx_t;
-
-static void app_sse_on_data(app_sse_ctx_t *ctx, const char *data) {
-  if (strcmp(data, "[DONE]") == 0) {
-    ctx->done = true;
-    return;
-  }
-
-  cJSON *chunk = cJSON_Parse(data);
-  if (!chunk) {
-    return;
-  }
-
-  const char *frag = NULL;
-  cJSON *choices = cJSON_GetObjectItemCaseSensitive(chunk, "choices");
-  if (cJSON_IsArray(choices)) {
-    cJSON *c0 = cJSON_GetArrayItem(choices, 0);
-    cJSON *delta = cJSON_GetObjectItemCaseSensitive(c0, "delta");
-    if (delta) {
-      /* Standard text models: delta.content */
-      cJSON *content = cJSON_GetObjectItemCaseSensitive(delta, "content");
-      if (cJSON_IsString(content) && content->valuestring &&
-          content->valuestring[0]) {
-        frag = content->valuestring;
-      } else {
-        /* gpt-4o-audio-preview: delta.audio.transcript */
-        cJSON *audio = cJSON_GetObjectItemCaseSensitive(delta, "audio");
-        if (audio) {
-          cJSON *tr = cJSON_GetObjectItemCaseSensitive(audio, "transcript");
-          if (cJSON_IsString(tr) && tr->valuestring && tr->valuestring[0]) {
-            frag = tr->valuestring;
-          }
-        }
-      }
-    }
-  }
-
-  if (frag) {
-    size_t fl = strlen(frag);
-    if (ctx->text_len + fl < APP_RESPONSE_TEXT_MAX - 1) {
-      memcpy(ctx->text + ctx->text_len, frag, fl);
-      ctx->text_len += fl;
-      ctx->text[ctx->text_len] = '\0';
-    }
-    /* Update display at most every 250 ms to avoid GUI overload */
-    TickType_t now = xTaskGetTickCount();
-    if ((now - ctx->last_gui_tick) >= pdMS_TO_TICKS(250)) {
-      /* Alocado no heap para não pressionar a stack da app_task (10 KB).
-       * Com APP_RESPONSE_TEXT_MAX=1024 + ai_response[1024] no caller,
-       * colocar na stack causaria ~4 KB de uso simultâneo — risco de overflow.
-       */
-      char *disp = malloc(APP_RESPONSE_TEXT_MAX);
-      if (disp) {
-        strlcpy(disp, ctx->text, APP_RESPONSE_TEXT_MAX);
-        app_utf8_to_ascii(disp);
-        gui_set_response(disp);
-        free(disp);
-      }
-      ctx->last_gui_tick = now;
-    }
+static esp_err_t app_check_ai_credentials(char *out_text,
+                                          size_t out_text_len) {
+  /* Warn if no token configured and URL points to OpenAI (public cloud requires
+   * auth) */
+  const char *cfg_token = config_manager_get()->ai_token;
+  const char *cfg_url = config_manager_get()->ai_base_url;
+  /* Detecta servidores locais (Ollama, etc.) que não requerem token.
+   * Usa prefixos após "://" para evitar falsos positivos como "110.x.x.x"
+   * que conteria "10." em posição incorreta. */
+  const char *url_host = strstr(cfg_url, "://");
+  url_host = url_host ? url_host + 3 : cfg_url;
+  bool is_local =
+      (strncmp(url_host, "localhost", 9) == 0 ||
+       strncmp(url_host, "127.0.0.1", 9) == 0 ||
+       strncmp(url_host, "192.168.", 8) == 0 ||
+       strncmp(url_host, "10.", 3) == 0 || strncmp(url_host, "172.", 4) == 0);
+  if ((!cfg_token || cfg_token[0] == '\0') && !is_local) {
+    strlcpy(out_text,
+            "Token nao configurado.\nAcesse o Portal para\nconfigurar a chave "
+            "de API.",
+            out_text_len);
+    return ESP_ERR_INVALID_STATE;
   }
-
-  cJSON_Delete(chunk);
+  return ESP_OK;
 }
 
-static void app_sse_feed(app_sse_ctx_t *ctx, const char *buf, int len) {
-  for (int i = 0; i < len && !ctx->done; i++) {
-    char c = buf[i];
-    if (c == '\n') {
-      /* strip trailing \r */
-      if (ctx->line_buf_pos > 0 &&
-          ctx->line_buf[ctx->line_buf_pos - 1] == '\r') {
-        ctx->line_buf_pos--;
-      }
-      ctx->line_buf[ctx->line_buf_pos] = '\0';
-      if (strncmp(ctx->line_buf, "data: ", 6) == 0) {
-        app_sse_on_data(ctx, ctx->line_buf + 6);
-      }
-      ctx->line_buf_pos = 0;
-    } else if (ctx->line_buf_pos < APP_SSE_LINE_BUF - 1) {
-      ctx->line_buf[ctx->line_buf_pos++] = c;
-    }
+/* audio pode ser um blob vazio quando o audio e enviado depois, em
+ * pipeline, entre o prefixo e o sufixo da requisicao. fmt e o formato do
+ * blob de fato enviado (pode cair para WAV se o codec falhar). */
+static esp_err_t app_build_audio_request(const ai_blob_t *audio,
+                                         audio_codec_format_t fmt,
+                                         ai_request_t *out_req) {
+  char *audio_only_prompt = malloc(APP_RESPONSE_TEXT_MAX);
+  if (!audio_only_prompt) {
+    return ESP_ERR_NO_MEM;
   }
-}
+  snprintf(audio_only_prompt, APP_RESPONSE_TEXT_MAX,
+           "Ouca o audio e responda exatamente o que o usuario perguntou. "
+           "Se a pergunta estiver cortada ou ruidosa, use o contexto para "
+           "inferir a intencao. "
+           "Nunca diga 'nao entendi' sem tentar responder. "
+           "Vocabulario tecnico relevante: %s.",
+           app_profile_transcription_terms(s_expert_profile));
 
-/* -----------------------------------------------------------------------
- * HTTP POST (streaming, persistent client)
- * ----------------------------------------------------------------------- */
+  esp_err_t err = app_build_ai_request_json(
+      config_manager_get()->ai_model, audio, fmt,
+      app_profile_system_prompt(s_expert_profile), audio_only_prompt, true,
+      out_req);
+  free(audio_only_prompt);
+  return err;
+}
 
-static esp_err_t app_http_post_json(const char *request_json, char *out_text,
-                                    size_t out_text_len, int *http_code) {
-  if (!request_json || !out_text || !http_code) {
+static esp_err_t app_call_ai_with_audio(const ai_blob_t *audio,
+                                        audio_codec_format_t fmt,
+                                        char *out_text, size_t out_text_len) {
+  if (!audio || audio->len == 0 || !out_text || out_text_len == 0) {
     return ESP_ERR_INVALID_ARG;
   }
-  *http_code = 0;
 
-  esp_err_t err = app_http_client_ensure();
+  esp_err_t err = app_check_ai_credentials(out_text, out_text_len);
   if (err != ESP_OK) {
     return err;
   }
 
-  const size_t json_len = strlen(request_json);
-
-  esp_http_client_set_method(s_http_client, HTTP_METHOD_POST);
-  /* Use token from config (set via Captive Portal or SD card).
-   * Skip Authorization header for local servers (Ollama, etc.) that
-   * don't require authentication. */
-  const char *token = config_manager_get()->ai_token;
-  if (token && token[0] != '\0') {
-    char auth_header[256];
-    snprintf(auth_header, sizeof(auth_header), "Bearer %s", token);
-    esp_http_client_set_header(s_http_client, "Authorization", auth_header);
-  }
-  esp_http_client_set_header(s_http_client, "Content-Type", "application/json");
-  esp_http_client_set_post_field(s_http_client, request_json, (int)json_len);
+  /* No S3 Wifi we assume network is up if bsp_wifi_is_ready is true */
 
-  err = esp_http_client_open(s_http_client, (int)json_len);
+  ESP_LOGI(TAG, "Audio-only path initiated");
+  ai_request_t request;
+  err = app_build_audio_request(audio, fmt, &request);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "HTTP open failed: %s", esp_err_to_name(err));
-    app_http_client_invalidate();
     return err;
   }
 
-  int written =
-      esp_http_client_write(s_http_client, request_json, (int)json_len);
-  if (written < 0) {
-    ESP_LOGE(TAG, "HTTP write failed");
-    esp_http_client_close(s_http_client);
-    app_http_client_invalidate();
-    return ESP_FAIL;
-  }
+  int http_code = 0;
+  err = app_http_post_json(&request, out_text, out_text_len, &http_code);
+  ai_request_free(&request);
 
-  if (esp_http_client_fetch_headers(s_http_client) < 0) {
-    ESP_LOGE(TAG, "HTTP fetch headers failed");
-    esp_http_client_close(s_http_client);
-    app_http_client_invalidate();
-    return ESP_FAIL;
+  if (err == ESP_OK) {
+    app_history_add(NULL, out_text);
+  } else {
+    ESP_LOGE(TAG, "AI request failed (http=%d): %s", http_code,
+             esp_err_to_name(err));
   }
+  return err;
+}
 
-  *http_code = esp_http_client_get_status_code(s_http_client);
-  if (*http_code < 200 || *http_code >= 300) {
-    char err_buf[256] = {0};
-    esp_http_client_read(s_http_client, err_buf, sizeof(err_buf) - 1);
-    ESP_LOGE(TAG, "AI HTTP status=%d body=%.200s", *http_code, err_buf);
-    esp_http_client_close(s_http_client);
-    return ESP_FAIL;
-  }
+/* -----------------------------------------------------------------------
+ * Pipelined upload
+ *
+ * Com ai.pipelined_upload ativo, a conexao e aberta (DNS + TLS) numa task
+ * auxiliar assim que a gravacao comeca, e cada bloco capturado e enviado
+ * como corpo HTTP chunked enquanto o usuario ainda fala. Ao soltar o botao
+ * so falta fechar o corpo: a latencia ate o primeiro token passa a refletir
+ * basicamente o tempo do servidor.
+ *
+ * O WAV e enviado com tamanho indefinido (0xFFFFFFFF no cabecalho), pois o
+ * tamanho final so e conhecido no fim; o gateway precisa aceitar isso. Se o
+ * upload falhar, o audio continua no buffer e o caminho sequencial e usado.
+ * ----------------------------------------------------------------------- */
 
-  /* Stream SSE response.
-   * app_sse_ctx_t contém line_buf[4096] + text[1024] = ~5125 bytes.
-   * Alocado no heap para não pressionar a stack da app_task (10 KB). */
-  app_sse_ctx_t *sse = calloc(1, sizeof(app_sse_ctx_t));
-  if (!sse) {
-    esp_http_client_close(s_http_client);
-    return ESP_ERR_NO_MEM;
+#define APP_UPLOAD_TASK_STACK_SIZE (8 * 1024)
+#define APP_UPLOAD_TASK_PRIORITY 4
+#define APP_UPLOAD_WAIT_MS 200
+
+typedef struct {
+  ai_request_t req;
+  ai_client_cfg_t cfg;
+  const audio_chain_t *pcm; /* cabecalho WAV + PCM, escrito pela app_task */
+  size_t pcm_start;    /* inicio da fala no PCM (fixo apos publicar) */
+  size_t pcm_ready;    /* fim do trecho pronto para envio (atomico) */
+  bool capture_done;   /* gravacao encerrada (atomico) */
+  bool abort;          /* gravacao descartada (atomico) */
+  uint32_t sample_rate_hz;
+  esp_err_t err;       /* resultado do envio do corpo */
+  TaskHandle_t task;
+  SemaphoreHandle_t done_sem;
+  TickType_t start_tick;
+  ai_b64_stream_t b64;
+} app_upload_pipe_t;
+
+static void app_upload_task(void *arg) {
+  app_upload_pipe_t *pipe = (app_upload_pipe_t *)arg;
+
+  esp_err_t err = ai_client_begin(&pipe->cfg, -1);
+  const bool opened = (err == ESP_OK);
+  if (opened) {
+    ESP_LOGI(TAG, "Pipelined upload: connection ready in %u ms",
+             (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - pipe->start_tick));
+    err = ai_client_write_chunk(pipe->req.text[0], pipe->req.text_len[0]);
+  }
+  if (err == ESP_OK) {
+    /* Cabecalho de tamanho indefinido, ja escrito no inicio da gravacao */
+    const uint8_t *wav_hdr;
+    size_t wav_hdr_len;
+    audio_chain_iter_t it;
+    audio_chain_iter_init(&it, pipe->pcm, 0, AUDIO_WAV_HEADER_LEN);
+    if (audio_chain_iter_next(&it, &wav_hdr, &wav_hdr_len)) {
+      err = ai_b64_stream_push(&pipe->b64, wav_hdr, wav_hdr_len);
+    }
   }
-  sse->last_gui_tick = xTaskGetTickCount();
 
-  char read_buf[512];
-  while (!sse->done) {
-    int rd = esp_http_client_read(s_http_client, read_buf, sizeof(read_buf));
-    if (rd < 0) {
-      err = ESP_FAIL;
-      break;
+  size_t sent = 0;
+  while (err == ESP_OK && !__atomic_load_n(&pipe->abort, __ATOMIC_ACQUIRE)) {
+    /* Le capture_done antes de pcm_ready: se a gravacao terminou, o valor de
+     * pcm_ready lido em seguida ja e o final. */
+    const bool done = __atomic_load_n(&pipe->capture_done, __ATOMIC_ACQUIRE);
+    const size_t ready = __atomic_load_n(&pipe->pcm_ready, __ATOMIC_ACQUIRE);
+    const size_t start = __atomic_load_n(&pipe->pcm_start, __ATOMIC_RELAXED);
+    if (sent < start) {
+      sent = start; /* silencio inicial cortado pelo VAD */
+    }
+    if (ready > sent) {
+      /* Os segmentos ate ready ja estao encadeados (publicado com
+       * release depois do commit). */
+      audio_chain_iter_t it;
+      audio_chain_iter_init(&it, pipe->pcm, AUDIO_WAV_HEADER_LEN + sent,
+                            ready - sent);
+      const uint8_t *piece;
+      size_t piece_len;
+      while (err == ESP_OK && audio_chain_iter_next(&it, &piece, &piece_len)) {
+        err = ai_b64_stream_push(&pipe->b64, piece, piece_len);
+      }
+      sent = ready;
+      continue;
     }
-    if (rd == 0) {
-      break; /* end of stream */
+    if (done) {
+      break;
     }
-    app_sse_feed(sse, read_buf, rd);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(APP_UPLOAD_WAIT_MS));
   }
 
-  /* Close HTTP session — TCP socket kept alive for next interaction */
-  esp_http_client_close(s_http_client);
-
-  bool has_text = (sse->text_len > 0);
-  if (has_text) {
-    strlcpy(out_text, sse->text, out_text_len);
+  const bool aborted = __atomic_load_n(&pipe->abort, __ATOMIC_ACQUIRE);
+  if (err == ESP_OK && !aborted) {
+    err = ai_b64_stream_flush(&pipe->b64);
+    if (err == ESP_OK) {
+      err = ai_client_write_chunk(pipe->req.text[1], pipe->req.text_len[1]);
+    }
+    if (err == ESP_OK) {
+      err = ai_client_end_chunked();
+    }
   }
-  free(sse);
-
-  if (has_text)
-    return ESP_OK;
-  return (err == ESP_OK) ? ESP_ERR_NOT_FOUND : err;
-}
 
-static esp_err_t app_call_ai_once(const char *model, const char *audio_b64,
-                                  const char *system_profile_text,
-                                  const char *audio_context_text,
-                                  bool inject_history, char *out_text,
-                                  size_t out_text_len) {
-  if (!model || !out_text || out_text_len == 0) {
-    return ESP_ERR_INVALID_ARG;
+  if (aborted && err == ESP_OK) {
+    err = ESP_ERR_INVALID_STATE;
   }
-
-  char *request_json = NULL;
-  esp_err_t err = app_build_ai_request_json(
-      model, audio_b64, system_profile_text, audio_context_text, inject_history,
-      &request_json);
-  if (err != ESP_OK) {
-    return err;
+  if (err != ESP_OK && opened) {
+    /* Corpo incompleto: a conexao nao pode ser reaproveitada */
+    ai_client_abort();
   }
 
-  int http_code = 0;
-  err = app_http_post_json(request_json, out_text, out_text_len, &http_code);
-  free(request_json);
+  pipe->err = err;
+  xSemaphoreGive(pipe->done_sem);
+  vTaskDelete(NULL);
+}
 
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "AI request failed (http=%d): %s", http_code,
-             esp_err_to_name(err));
+static void app_upload_pipe_free(app_upload_pipe_t *pipe) {
+  if (!pipe) {
+    return;
   }
-  return err;
+  ai_request_free(&pipe->req);
+  if (pipe->done_sem) {
+    vSemaphoreDelete(pipe->done_sem);
+  }
+  free(pipe);
 }
 
-static esp_err_t app_call_ai_with_audio(const uint8_t *wav_data, size_t wav_len,
-                                        char *out_text, size_t out_text_len) {
-  if (!wav_data || wav_len == 0 || !out_text || out_text_len == 0) {
-    return ESP_ERR_INVALID_ARG;
+/* Retorna NULL se o modo pipeline nao puder ser usado; o chamador segue no
+ * caminho sequencial. */
+static app_upload_pipe_t *app_upload_pipe_start(const audio_chain_t *pcm,
+                                                uint32_t sample_rate_hz) {
+  char msg[APP_RESPONSE_TEXT_MAX];
+  if (app_check_ai_credentials(msg, sizeof(msg)) != ESP_OK) {
+    return NULL;
   }
-
-  /* Warn if no token configured and URL points to OpenAI (public cloud requires
-   * auth) */
-  const char *cfg_token = config_manager_get()->ai_token;
-  const char *cfg_url = config_manager_get()->ai_base_url;
-  /* Detecta servidores locais (Ollama, etc.) que não requerem token.
-   * Usa prefixos após "://" para evitar falsos positivos como "110.x.x.x"
-   * que conteria "10." em posição incorreta. */
-  const char *url_host = strstr(cfg_url, "://");
-  url_host = url_host ? url_host + 3 : cfg_url;
-  bool is_local =
-      (strncmp(url_host, "localhost", 9) == 0 ||
-       strncmp(url_host, "127.0.0.1", 9) == 0 ||
-       strncmp(url_host, "192.168.", 8) == 0 ||
-       strncmp(url_host, "10.", 3) == 0 || strncmp(url_host, "172.", 4) == 0);
-  if ((!cfg_token || cfg_token[0] == '\0') && !is_local) {
-    strlcpy(out_text,
-            "Token nao configurado.\nAcesse o Portal para\nconfigurar a chave "
-            "de API.",
-            out_text_len);
-    return ESP_ERR_INVALID_STATE;
+  /* O pipeline envia PCM bruto a medida que e capturado; formatos
+   * comprimidos precisam do audio completo (caminho sequencial). */
+  if (app_audio_format() != AUDIO_CODEC_WAV_PCM16) {
+    ESP_LOGI(TAG, "Pipelined upload skipped: audio_format=%s",
+             audio_codec_name(app_audio_format()));
+    return NULL;
   }
 
-  /* No S3 Wifi we assume network is up if bsp_wifi_is_ready is true */
-
-  char *audio_b64 = app_base64_encode(wav_data, wav_len);
-  if (!audio_b64) {
-    return ESP_ERR_NO_MEM;
+  app_upload_pipe_t *pipe = calloc(1, sizeof(app_upload_pipe_t));
+  if (!pipe) {
+    return NULL;
+  }
+  pipe->pcm = pcm;
+  app_ai_client_cfg(&pipe->cfg);
+  pipe->sample_rate_hz = sample_rate_hz;
+  pipe->start_tick = xTaskGetTickCount();
+  pipe->done_sem = xSemaphoreCreateBinary();
+  const ai_blob_t later = {0};
+  if (!pipe->done_sem ||
+      app_build_audio_request(&later, AUDIO_CODEC_WAV_PCM16, &pipe->req) !=
+          ESP_OK) {
+    app_upload_pipe_free(pipe);
+    return NULL;
   }
 
-  ESP_LOGI(TAG, "Audio-only path initiated");
-  char *audio_only_prompt = malloc(APP_RESPONSE_TEXT_MAX);
-  if (!audio_only_prompt) {
-    free(audio_b64);
-    return ESP_ERR_NO_MEM;
+  if (xTaskCreatePinnedToCore(app_upload_task, "app_upload",
+                              APP_UPLOAD_TASK_STACK_SIZE, pipe,
+                              APP_UPLOAD_TASK_PRIORITY, &pipe->task,
+                              1) != pdPASS) {
+    app_upload_pipe_free(pipe);
+    return NULL;
   }
-  snprintf(audio_only_prompt, APP_RESPONSE_TEXT_MAX,
-           "Ouca o audio e responda exatamente o que o usuario perguntou. "
-           "Se a pergunta estiver cortada ou ruidosa, use o contexto para "
-           "inferir a intencao. "
-           "Nunca diga 'nao entendi' sem tentar responder. "
-           "Vocabulario tecnico relevante: %s.",
-           app_profile_transcription_terms(s_expert_profile));
+  ESP_LOGI(TAG, "Pipelined upload started");
+  return pipe;
+}
 
-  const char *audio_model = config_manager_get()->ai_model;
+/* Publica o trecho [pcm_start, pcm_end) da gravacao. pcm_start nao muda
+ * depois da primeira publicacao e pcm_end so cresce. */
+static void app_upload_pipe_publish(app_upload_pipe_t *pipe, size_t pcm_start,
+                                    size_t pcm_end) {
+  __atomic_store_n(&pipe->pcm_start, pcm_start, __ATOMIC_RELAXED);
+  __atomic_store_n(&pipe->pcm_ready, pcm_end, __ATOMIC_RELEASE);
+  xTaskNotifyGive(pipe->task);
+}
 
-  esp_err_t err = app_call_ai_once(
-      audio_model, audio_b64, app_profile_system_prompt(s_expert_profile),
-      audio_only_prompt, true, out_text, out_text_len);
-  free(audio_only_prompt);
+/* Descarta a gravacao: fecha a conexao e libera o pipe. */
+static void app_upload_pipe_abort(app_upload_pipe_t *pipe) {
+  __atomic_store_n(&pipe->abort, true, __ATOMIC_RELEASE);
+  xTaskNotifyGive(pipe->task);
+  xSemaphoreTake(pipe->done_sem, portMAX_DELAY);
+  app_upload_pipe_free(pipe);
+}
+
+/* Fecha o corpo, le a resposta SSE e libera o pipe. *body_sent = false
+ * indica falha no envio do corpo: nada foi consumido do servidor e o
+ * chamador pode refazer a requisicao pelo caminho sequencial. */
+static esp_err_t app_upload_pipe_finish(app_upload_pipe_t *pipe,
+                                        char *out_text, size_t out_text_len,
+                                        bool *body_sent) {
+  const TickType_t release_tick = xTaskGetTickCount();
+  __atomic_store_n(&pipe->capture_done, true, __ATOMIC_RELEASE);
+  xTaskNotifyGive(pipe->task);
+  xSemaphoreTake(pipe->done_sem, portMAX_DELAY);
+
+  esp_err_t err = pipe->err;
+  app_upload_pipe_free(pipe);
+  *body_sent = (err == ESP_OK);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Pipelined upload failed: %s", esp_err_to_name(err));
+    return err;
+  }
+  ESP_LOGI(TAG, "Pipelined upload: body closed %u ms after release",
+           (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - release_tick));
 
+  int http_code = 0;
+  bool stream_started = false;
+  err = ai_client_finish(out_text, out_text_len, &http_code, app_ai_on_delta,
+                         &stream_started);
+  ESP_LOGI(TAG, "Pipelined upload: release -> response in %u ms",
+           (unsigned)pdTICKS_TO_MS(xTaskGetTickCount() - release_tick));
   if (err == ESP_OK) {
     app_history_add(NULL, out_text);
+  } else {
+    ESP_LOGE(TAG, "AI request failed (http=%d): %s", http_code,
+             esp_err_to_name(err));
   }
-
-  free(audio_b64);
   return err;
 }
 
@@ -814,19 +863,75 @@ static void app_set_state(app_state_t next_state) {
 static esp_err_t app_do_interaction(void) {
   ESP_LOGI(TAG, "starting interaction in audio mode");
 
-  const size_t audio_buffer_len = APP_AUDIO_BUFFER_LEN;
-  uint8_t *audio_buffer =
-      heap_caps_malloc(audio_buffer_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!audio_buffer) {
-    audio_buffer = heap_caps_malloc(audio_buffer_len,
-                                    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-  }
-  if (!audio_buffer) {
+  /* Gravacao em segmentos do pool (alocado no boot): nada e alocado por
+   * interacao e o limite e o pool livre, nao o maior bloco do heap. */
+  if (audio_pool_seg_bytes() == 0) {
     ESP_LOGE(TAG, "no memory for audio buffer");
     return ESP_ERR_NO_MEM;
   }
+  /* Os primeiros bytes da gravacao sao o cabecalho WAV: o enquadramento e
+   * so uma escrita no lugar, sem copiar o PCM. */
+  audio_chain_t audio;
+  audio_chain_init(&audio);
+  size_t hdr_room = 0;
+  uint8_t *wav_hdr = audio_chain_reserve(&audio, &hdr_room);
+  if (!wav_hdr) {
+    ESP_LOGE(TAG, "audio pool exhausted");
+    return ESP_ERR_NO_MEM;
+  }
+  audio_wav_pcm16_header(wav_hdr, UINT32_MAX, 8000, 1);
+  audio_chain_commit(&audio, AUDIO_WAV_HEADER_LEN);
   app_set_state(APP_STATE_LISTENING);
   size_t captured_bytes = 0;
+
+  /* Decodificacao I2S, high-pass (estado mantido entre blocos) e medicao de
+   * nivel numa unica passada, aplicada ao ler cada janela do ring de
+   * captura: o audio sai filtrado e pronto para o upload em pipeline. */
+  audio_frontend_t frontend;
+  audio_frontend_init(&frontend, 100.0f, 8000.0f);
+
+  /* VAD sobre as mesmas janelas de 100 ms: encerra a gravacao apos o
+   * silencio final e corta o silencio antes do upload. */
+  const bool vad_on = config_manager_get()->audio_vad;
+  const audio_vad_cfg_t vad_cfg = {
+      .sample_rate_hz = 8000,
+      .silence_ms = config_manager_get()->audio_vad_silence_ms,
+      .pre_margin_ms = APP_VAD_PRE_MARGIN_MS,
+      .post_margin_ms = APP_VAD_POST_MARGIN_MS,
+  };
+  audio_vad_t vad;
+  audio_vad_init(&vad, &vad_cfg);
+
+  /* Captura continua: a task de audio do BSP esvazia o DMA num ring e este
+   * loop consome as janelas no proprio ritmo (botao, progresso, upload). */
+  const bsp_audio_capture_cfg_t capture_cfg = {
+      .sample_rate_hz = 8000,
+      .bits_per_sample = 16,
+      .channels = 1,
+      .capture_ms = APP_CAPTURE_CHUNK_MS,
+      .decode = audio_frontend_decode,
+      .decode_ctx = &frontend,
+  };
+  esp_err_t stream_err = bsp_audio_stream_start(&capture_cfg);
+  if (stream_err != ESP_OK) {
+    ESP_LOGE(TAG, "audio stream start failed: %s",
+             esp_err_to_name(stream_err));
+    audio_chain_release(&audio);
+    return stream_err;
+  }
+
+  app_upload_pipe_t *pipe = NULL;
+  if (bsp_wifi_is_ready()) {
+    if (config_manager_get()->ai_pipelined_upload) {
+      pipe = app_upload_pipe_start(&audio, 8000);
+    }
+    if (!pipe) {
+      ai_client_cfg_t ai_cfg;
+      app_ai_client_cfg(&ai_cfg);
+      ai_client_prewarm_start(&ai_cfg);
+    }
+  }
+
   const TickType_t capture_start = xTaskGetTickCount();
   uint32_t local_last_edge_ms = pdTICKS_TO_MS(xTaskGetTickCount());
 
@@ -855,76 +960,209 @@ static esp_err_t app_do_interaction(void) {
       local_last_edge_ms = pdTICKS_TO_MS(xTaskGetTickCount());
     }
 
-    const size_t remaining = audio_buffer_len - captured_bytes;
-    if (remaining < 1024) {
-      break;
+    /* Uma janela pode cruzar o fim de um segmento: le em partes, com a
+     * medicao de nivel acumulada na janela inteira. */
+    const size_t window_samples = (8000U * APP_CAPTURE_CHUNK_MS) / 1000U;
+    audio_frontend_window_reset(&frontend);
+    size_t read_samples = 0;
+    esp_err_t capture_err = ESP_OK;
+    bool pool_full = false;
+    while (read_samples < window_samples) {
+      size_t room = 0;
+      int16_t *dst = (int16_t *)audio_chain_reserve(&audio, &room);
+      if (!dst) {
+        pool_full = true;
+        break;
+      }
+      size_t want = window_samples - read_samples;
+      if (want > room / sizeof(int16_t)) {
+        want = room / sizeof(int16_t);
+      }
+      size_t got = 0;
+      capture_err = bsp_audio_stream_read(
+          dst, want, &got, APP_CAPTURE_CHUNK_MS + APP_CAPTURE_TIMEOUT_MS);
+      if (capture_err != ESP_OK) {
+        break;
+      }
+      audio_chain_commit(&audio, got * sizeof(int16_t));
+      read_samples += got;
+      if (got < want) {
+        break; /* leitura curta (timeout): fecha a janela com o que veio */
+      }
+    }
+    if (capture_err == ESP_ERR_TIMEOUT && read_samples > 0) {
+      capture_err = ESP_OK;
     }
-
-    bsp_audio_capture_cfg_t capture_cfg = {
-        .sample_rate_hz = 8000,
-        .bits_per_sample = 16,
-        .channels = 1,
-        .capture_ms = APP_CAPTURE_CHUNK_MS,
-    };
-
-    size_t chunk_bytes = 0;
-    esp_err_t capture_err = bsp_audio_capture_blocking(
-        &capture_cfg, audio_buffer + captured_bytes, remaining, &chunk_bytes);
     if (capture_err != ESP_OK) {
       ESP_LOGE(TAG, "audio capture failed: %s", esp_err_to_name(capture_err));
-      free(audio_buffer);
+      bsp_audio_stream_stop(NULL);
+      if (pipe) {
+        app_upload_pipe_abort(pipe);
+      }
+      ai_client_prewarm_cancel();
+      audio_chain_release(&audio);
       return capture_err;
     }
+    const size_t chunk_bytes = read_samples * sizeof(int16_t);
 
-    float rms =
-        audio_calculate_rms((const int16_t *)(audio_buffer + captured_bytes),
-                            chunk_bytes / sizeof(int16_t));
+    /* Nivel ja filtrado, medido durante a decodificacao */
+    const float rms = audio_window_rms(&frontend.window);
+    const bool voiced = audio_vad_process_stats(
+        &vad, &frontend.window, chunk_bytes / sizeof(int16_t));
     captured_bytes += chunk_bytes;
-    ESP_LOGI(TAG, "[RMS] Window: %.2f (Total: %u bytes)", rms,
+    if (pipe) {
+      /* Com VAD, so publica a partir do inicio da fala e ate o fim da
+       * ultima janela sonora (+ margem): silencio nao vai para o socket. */
+      size_t seg_start = 0;
+      size_t seg_end = captured_bytes / sizeof(int16_t);
+      if (!vad_on || audio_vad_get_segment(&vad, &seg_start, &seg_end)) {
+        app_upload_pipe_publish(pipe, seg_start * sizeof(int16_t),
+                                seg_end * sizeof(int16_t));
+      }
+    }
+    ESP_LOGI(TAG, "[RMS] Window: %.2f peak %d %s (Total: %u bytes)", rms,
+             (int)frontend.window.peak, voiced ? "voz" : "-",
              (unsigned)captured_bytes);
+
+    if (pool_full) {
+      ESP_LOGW(TAG, "audio pool exhausted (%u KB) -> stopping recording",
+               (unsigned)(captured_bytes / 1024));
+      break;
+    }
+
+    if (vad_on && audio_vad_endpoint(&vad)) {
+      ESP_LOGI(TAG, "VAD: %u ms of silence after speech -> stopping recording",
+               (unsigned)vad_cfg.silence_ms);
+      break;
+    }
+  }
+
+  bsp_audio_stream_stats_t stream_stats;
+  if (bsp_audio_stream_stop(&stream_stats) == ESP_OK &&
+      (stream_stats.overruns || stream_stats.dma_overflows)) {
+    ESP_LOGW(TAG, "audio lost during capture: %u frames (ring), %u DMA "
+                  "overflows",
+             (unsigned)stream_stats.dropped_frames,
+             (unsigned)stream_stats.dma_overflows);
   }
 
   /* If capture was extremely short (e.g. just a quick click to dismiss screen),
    * silently cancel. (Lower threshold to 100ms / 3200 bytes) */
   if (captured_bytes < 3200) {
+    if (pipe) {
+      app_upload_pipe_abort(pipe);
+    }
+    ai_client_prewarm_cancel();
     app_set_state(APP_STATE_IDLE);
     gui_set_response(s_last_response);
-    free(audio_buffer);
+    audio_chain_release(&audio);
     return ESP_OK;
   }
 
   if (captured_bytes < APP_MIN_CAPTURE_BYTES) {
+    if (pipe) {
+      app_upload_pipe_abort(pipe);
+    }
+    ai_client_prewarm_cancel();
     gui_set_response("Fale por mais tempo\n(minimo 2 segundos).");
     app_set_state(APP_STATE_IDLE);
-    free(audio_buffer);
+    audio_chain_release(&audio);
     return ESP_OK;
   }
 
-  /* High-pass filter: remove low-freq noise to improve speech clarity */
-  const size_t sample_count = captured_bytes / sizeof(int16_t);
-  audio_apply_highpass((int16_t *)audio_buffer, sample_count, 100.0f, 8000.0f);
   ESP_LOGI(TAG, "HPF applied: 100 Hz cutoff @ 8kHz, %u samples",
-           (unsigned)sample_count);
+           (unsigned)(captured_bytes / sizeof(int16_t)));
+
+  /* Trecho enviado/salvo: sem o silencio inicial e final quando o VAD esta
+   * ativo. */
+  size_t pcm_offset = 0;
+  size_t pcm_len = captured_bytes;
+  if (vad_on) {
+    size_t seg_start = 0;
+    size_t seg_end = 0;
+    if (!audio_vad_get_segment(&vad, &seg_start, &seg_end)) {
+      ESP_LOGI(TAG, "VAD: no speech in %u bytes, not sending",
+               (unsigned)captured_bytes);
+      if (pipe) {
+        app_upload_pipe_abort(pipe);
+      }
+      ai_client_prewarm_cancel();
+      gui_set_response("Nenhuma fala detectada.\nTente novamente.");
+      app_set_state(APP_STATE_IDLE);
+      audio_chain_release(&audio);
+      return ESP_OK;
+    }
+    pcm_offset = seg_start * sizeof(int16_t);
+    pcm_len = (seg_end - seg_start) * sizeof(int16_t);
+    ESP_LOGI(TAG, "VAD: keeping %u of %u ms (lead %u ms, tail %u ms trimmed)",
+             (unsigned)((pcm_len * 1000U) / (8000U * 2U)),
+             (unsigned)((captured_bytes * 1000U) / (8000U * 2U)),
+             (unsigned)((pcm_offset * 1000U) / (8000U * 2U)),
+             (unsigned)(((captured_bytes - pcm_offset - pcm_len) * 1000U) /
+                        (8000U * 2U)));
+  }
 
   app_set_state(APP_STATE_THINKING);
 
-  size_t wav_len = 0;
-  uint8_t *wav_data =
-      app_pcm16_to_wav(audio_buffer, captured_bytes, 8000, 1, 16, &wav_len);
-  if (!wav_data) {
-    free(audio_buffer);
-    return ESP_ERR_NO_MEM;
-  }
-
   char ai_response[APP_RESPONSE_TEXT_MAX] = {0};
-  esp_err_t ai_err = app_call_ai_with_audio(wav_data, wav_len, ai_response,
-                                            sizeof(ai_response));
-  free(wav_data);
+  esp_err_t ai_err = ESP_FAIL;
+  bool body_sent = false;
+  if (pipe) {
+    ai_err = app_upload_pipe_finish(pipe, ai_response, sizeof(ai_response),
+                                    &body_sent);
+  }
+
+  /* Sem pipeline, ou falha no envio do corpo: caminho sequencial. Erros
+   * depois do envio (HTTP status, resposta vazia) nao sao repetidos. */
+  if (!body_sent) {
+    audio_codec_format_t fmt = app_audio_format();
+    audio_chain_t encoded;
+    audio_chain_init(&encoded);
+    ai_iov_t iov[APP_AUDIO_POOL_SEGMENTS + 2];
+    ai_blob_t blob = {0};
+    if (fmt != AUDIO_CODEC_WAV_PCM16) {
+      const esp_err_t enc_err =
+          app_encode_audio(fmt, &audio, AUDIO_WAV_HEADER_LEN + pcm_offset,
+                           pcm_len, 8000, &encoded);
+      if (enc_err == ESP_OK) {
+        blob.iov = iov;
+        blob.iov_count = app_chain_to_iov(&encoded, 0, encoded.len, iov,
+                                          APP_AUDIO_POOL_SEGMENTS + 2);
+        blob.len = encoded.len;
+      } else {
+        ESP_LOGW(TAG, "%s encode failed (%s): sending WAV",
+                 audio_codec_name(fmt), esp_err_to_name(enc_err));
+        fmt = AUDIO_CODEC_WAV_PCM16;
+      }
+    }
+    if (fmt == AUDIO_CODEC_WAV_PCM16) {
+      /* WAV PCM: cabecalho + segmentos codificados em base64 direto no
+       * socket, sem copiar a gravacao. */
+      audio_wav_pcm16_header(wav_hdr, (uint32_t)pcm_len, 8000, 1);
+      iov[0].data = wav_hdr;
+      iov[0].len = AUDIO_WAV_HEADER_LEN;
+      blob.iov = iov;
+      blob.iov_count =
+          1 + app_chain_to_iov(&audio, AUDIO_WAV_HEADER_LEN + pcm_offset,
+                               pcm_len, iov + 1, APP_AUDIO_POOL_SEGMENTS + 1);
+      blob.len = AUDIO_WAV_HEADER_LEN + pcm_len;
+    }
+
+    ai_err = app_call_ai_with_audio(&blob, fmt, ai_response,
+                                    sizeof(ai_response));
+    audio_chain_release(&encoded);
+  }
+  /* Pre-warm nao consumido (ex.: token ausente): nao deixa a requisicao
+   * aberta para a proxima interacao. */
+  ai_client_prewarm_cancel();
 
   // --- Queue audio to be saved to SD card opportunistically ---
-  if (captured_bytes > 0) {
+  /* Os segmentos da gravacao passam para a fila (sem copia); a chain fica
+   * vazia e o audio_chain_release abaixo nao faz nada. */
+  if (pcm_len > 0) {
     esp_err_t audio_save_err =
-        app_storage_queue_audio(audio_buffer, captured_bytes, 8000);
+        app_storage_queue_audio_chain(&audio, AUDIO_WAV_HEADER_LEN + pcm_offset,
+                                      pcm_len, 8000);
     if (audio_save_err != ESP_OK) {
       ESP_LOGW(TAG, "Audio not queued: %s", esp_err_to_name(audio_save_err));
     }
@@ -952,7 +1190,7 @@ static esp_err_t app_do_interaction(void) {
            (unsigned)captured_bytes,
            (unsigned)((captured_bytes * 1000U) / (8000U * 2U)));
 
-  free(audio_buffer);
+  audio_chain_release(&audio);
   return ESP_OK;
 }
 
@@ -986,6 +1224,7 @@ static void app_task(void *arg) {
           xTimerReset(s_deep_sleep_timer, 0);
         if (s_sleep_warning_timer)
           xTimerReset(s_sleep_warning_timer, 0);
+        app_preroll_enable(true);
 
         if (evt.gui_event == GUI_EVENT_PROFILE) {
           const app_config_t *cfg = config_manager_get();
@@ -1016,6 +1255,7 @@ static void app_task(void *arg) {
           app_history_clear();
         }
 
+        app_preroll_enable(true);
         esp_err_t err = app_do_interaction();
         if (err != ESP_OK) {
           app_set_state(APP_STATE_ERROR);
@@ -1028,6 +1268,7 @@ static void app_task(void *arg) {
             s_state == APP_STATE_SHOWING_RESPONSE) {
           ESP_LOGI(TAG, "Deep sleep warning: 10s remaining");
           gui_set_state("Suspensao em 10s");
+          app_preroll_enable(false);
         }
       }
 
@@ -1038,6 +1279,9 @@ static void app_task(void *arg) {
           gui_set_state("Entrando na Suspensao...");
           vTaskDelay(pdMS_TO_TICKS(
               1500)); // Give time for the UI to render the goodbye message
+          /* Sessao TLS em NVS: o proximo wake retoma o handshake mesmo se
+           * a RTC se perder (bateria removida) */
+          ai_client_suspend();
           bsp_enter_deep_sleep();
         }
       }
@@ -1138,12 +1382,33 @@ static void app_task(void *arg) {
   }
 }
 
+/* Confere os kernels de DSP contra a referencia portavel e registra o custo
+ * de cada um (ciclos por bloco). So com "audio": {"dsp_bench": true}: o
+ * teste aloca ~12 KB e atrasa o boot, e a equivalencia ja e coberta pelos
+ * testes de host (test_audio_dsp). */
+static void app_dsp_self_test(void) {
+  audio_dsp_report_t rep;
+  const bool ok = audio_dsp_self_test(&rep);
+  ESP_LOGI(TAG,
+           "DSP %s: biquad %u/%u cyc, energy %u/%u cyc per %u samples "
+           "(ref/dispatch), err %.3f LSB / %.2e",
+           rep.backend, (unsigned)rep.ref_ticks[0], (unsigned)rep.dsp_ticks[0],
+           (unsigned)rep.ref_ticks[1], (unsigned)rep.dsp_ticks[1],
+           (unsigned)rep.samples, rep.biquad_max_err, rep.energy_rel_err);
+  if (!ok) {
+    ESP_LOGW(TAG, "DSP self-test failed: kernels disagree with reference");
+  }
+}
+
 esp_err_t app_init(void) {
   if (s_app_queue) {
     return ESP_OK;
   }
 
   bsp_battery_init();
+  if (audio_pool_init(APP_AUDIO_SEG_BYTES, APP_AUDIO_POOL_SEGMENTS) != ESP_OK) {
+    ESP_LOGE(TAG, "audio pool unavailable: recording disabled");
+  }
 
   s_app_queue = xQueueCreate(APP_QUEUE_LENGTH, sizeof(app_event_t));
   if (!s_app_queue) {
@@ -1206,6 +1471,18 @@ esp_err_t app_init(void) {
 
   // Now that config is loaded, configure and start the WiFi connection
   const app_config_t *cfg = config_manager_get();
+
+  // Calibra o clock SPI do SD na primeira vez (ou sempre, com
+  // "storage": {"bench": true}); remonta o cartao, entao roda antes do WiFi
+  if (cfg->storage_bench || !bsp_sdcard_freq_is_calibrated()) {
+    esp_err_t cal_err = app_storage_sd_calibrate(cfg->storage_bench);
+    if (cal_err != ESP_OK && cal_err != ESP_ERR_NOT_FOUND) {
+      ESP_LOGW(TAG, "SD calibration failed: %s", esp_err_to_name(cal_err));
+    }
+  }
+  if (cfg->audio_dsp_bench) {
+    app_dsp_self_test();
+  }
   esp_err_t wifi_err =
       bsp_wifi_config_and_start(cfg->wifi_ssid, cfg->wifi_pass);
   if (wifi_err != ESP_OK) {
@@ -1216,6 +1493,8 @@ esp_err_t app_init(void) {
   // Restore the active profile from NVS/settings
   s_expert_profile = config_manager_get()->expert_profile;
 
+  app_preroll_enable(true);
+
   gui_set_event_callback(app_gui_event_cb);
   gui_set_footer("Segure para falar  SD: OK");
   return ESP_OK;
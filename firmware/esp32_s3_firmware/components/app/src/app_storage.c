@@ -1,8 +1,11 @@
 #include "app_storage.h"
 
+#include "audio_codec.h"
 #include "bsp.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
@@ -13,46 +16,55 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 static const char *TAG = "app_storage";
 
 // Track SD card mount state
 static bool s_sd_mounted = false;
 
-// PSRAM buffer for queued JPEG images (to avoid SDMMC conflicts during network
-// I/O)
-#define MAX_QUEUED_IMAGES 2        // Reduced to 2 for easier testing
-#define MAX_JPEG_SIZE (256 * 1024) // 256KB max per image
+// PSRAM buffers queued for saving (to avoid SDMMC conflicts during network
+// I/O). The queue owns them; admission is by bytes held, not by count.
+#define MAX_QUEUED_ITEMS 8 // Slots per ring (images, audio)
+#define QUEUE_BUDGET_BYTES (1024 * 1024) // PSRAM held by queued items
+#define QUEUE_POOL_SHARE_DIV 2 // Queued audio holds at most 1/2 of the pool
 #define INACTIVITY_TIMEOUT_MS                                                  \
   (10 * 1000) // 10 seconds of inactivity before saving
 #define MIN_QUEUE_FOR_IMMEDIATE_SAVE                                           \
-  1 // Save immediately if queue is almost full (1 of 2)
+  1 // Save as soon as anything is queued
 
 typedef struct {
-  uint8_t *data; // Allocated in PSRAM
+  uint8_t *data; // Owned, released with free_fn
   size_t len;
+  app_storage_free_fn_t free_fn;
   bool valid;
   time_t timestamp; // When image was queued
 } queued_image_t;
 
 typedef struct {
-  uint8_t *data; // Allocated in PSRAM
+  uint8_t *data;       // Contiguous PCM (owned, released with free_fn), or
+  audio_chain_t chain; // pool segments (owned), PCM at chain_offset
+  size_t chain_offset;
   size_t len;
+  app_storage_free_fn_t free_fn;
   uint32_t sample_rate_hz;
   bool valid;
   time_t timestamp;
 } queued_audio_t;
 
-static queued_image_t s_image_queue[MAX_QUEUED_IMAGES];
+static queued_image_t s_image_queue[MAX_QUEUED_ITEMS];
 static int s_queue_head = 0;
 static int s_queue_tail = 0;
 static int s_queue_count = 0;
 
-static queued_audio_t s_audio_queue[MAX_QUEUED_IMAGES];
+static queued_audio_t s_audio_queue[MAX_QUEUED_ITEMS];
 static int s_audio_queue_head = 0;
 static int s_audio_queue_tail = 0;
 static int s_audio_queue_count = 0;
 
+static size_t s_queue_bytes = 0;      // PSRAM held by both rings
+static size_t s_queue_pool_segs = 0;  // Audio pool segments held
+
 // Task and synchronization for opportunistic saving
 static TaskHandle_t s_save_task_handle = NULL;
 static TimerHandle_t s_inactivity_timer = NULL;
@@ -63,6 +75,7 @@ static SemaphoreHandle_t s_queue_mutex =
     NULL; // Protect queued image ring buffer
 static volatile bool s_storage_busy = false;
 static bool s_mount_after_camera_attempted = false;
+static bool s_sd_io_error = false; // Bus error (EIO): step the SD clock down
 
 // Directory paths
 #define SD_BASE_PATH "/sdcard"
@@ -155,8 +168,12 @@ static bool validate_jpeg(const uint8_t *data, size_t len) {
   return true;
 }
 
-// Forward declaration
+// Forward declarations
 static void app_storage_process_queue_internal(void);
+static void storage_note_io_error(int err);
+static void storage_apply_clock_fallback_locked(void);
+static esp_err_t save_image_file(const uint8_t *jpeg_data, size_t jpeg_len);
+static esp_err_t save_queued_audio(const queued_audio_t *item);
 
 static int app_queue_count_locked(void) {
   return s_queue_count + s_audio_queue_count;
@@ -174,6 +191,71 @@ static int app_queue_get_count(void) {
   return count;
 }
 
+static size_t queued_audio_cost(const queued_audio_t *item) {
+  return item->data ? item->len : item->chain.count * audio_pool_seg_bytes();
+}
+
+static void queued_image_release(queued_image_t *item) {
+  if (item->data && item->free_fn) {
+    item->free_fn(item->data);
+  }
+  memset(item, 0, sizeof(*item));
+}
+
+static void queued_audio_release(queued_audio_t *item) {
+  if (item->data && item->free_fn) {
+    item->free_fn(item->data);
+  }
+  audio_chain_release(&item->chain);
+  memset(item, 0, sizeof(*item));
+}
+
+// Takes the oldest image out of the ring (queue mutex held)
+static void app_queue_take_image_locked(queued_image_t *out_item) {
+  queued_image_t *head = &s_image_queue[s_queue_head];
+  s_queue_bytes -= head->len;
+  *out_item = *head;
+  memset(head, 0, sizeof(*head));
+  s_queue_head = (s_queue_head + 1) % MAX_QUEUED_ITEMS;
+  s_queue_count--;
+}
+
+// Takes the oldest audio item out of the ring (queue mutex held)
+static void app_queue_take_audio_locked(queued_audio_t *out_item) {
+  queued_audio_t *head = &s_audio_queue[s_audio_queue_head];
+  s_queue_bytes -= queued_audio_cost(head);
+  s_queue_pool_segs -= head->chain.count;
+  *out_item = *head;
+  memset(head, 0, sizeof(*head));
+  s_audio_queue_head = (s_audio_queue_head + 1) % MAX_QUEUED_ITEMS;
+  s_audio_queue_count--;
+}
+
+// Frees the oldest queued item, image or audio (queue mutex held)
+static bool app_queue_drop_oldest_locked(void) {
+  const bool have_image = s_queue_count > 0;
+  const bool have_audio = s_audio_queue_count > 0;
+  if (!have_image && !have_audio) {
+    return false;
+  }
+  if (have_image &&
+      (!have_audio || s_image_queue[s_queue_head].timestamp <=
+                          s_audio_queue[s_audio_queue_head].timestamp)) {
+    queued_image_t item;
+    app_queue_take_image_locked(&item);
+    ESP_LOGW(TAG, "Dropping oldest queued image (%u bytes)",
+             (unsigned)item.len);
+    queued_image_release(&item);
+  } else {
+    queued_audio_t item;
+    app_queue_take_audio_locked(&item);
+    ESP_LOGW(TAG, "Dropping oldest queued audio (%u bytes)",
+             (unsigned)item.len);
+    queued_audio_release(&item);
+  }
+  return true;
+}
+
 static void app_queue_clear(void) {
   if (s_queue_mutex == NULL) {
     return;
@@ -181,35 +263,12 @@ static void app_queue_clear(void) {
   if (xSemaphoreTake(s_queue_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
     return;
   }
-  while (s_queue_count > 0) {
-    if (s_image_queue[s_queue_head].valid && s_image_queue[s_queue_head].data) {
-      free(s_image_queue[s_queue_head].data);
-      s_image_queue[s_queue_head].data = NULL;
-    }
-    s_image_queue[s_queue_head].len = 0;
-    s_image_queue[s_queue_head].timestamp = 0;
-    s_image_queue[s_queue_head].valid = false;
-    s_queue_head = (s_queue_head + 1) % MAX_QUEUED_IMAGES;
-    s_queue_count--;
+  while (app_queue_drop_oldest_locked()) {
   }
   s_queue_head = 0;
   s_queue_tail = 0;
-
-  while (s_audio_queue_count > 0) {
-    if (s_audio_queue[s_audio_queue_head].valid &&
-        s_audio_queue[s_audio_queue_head].data) {
-      free(s_audio_queue[s_audio_queue_head].data);
-      s_audio_queue[s_audio_queue_head].data = NULL;
-    }
-    s_audio_queue[s_audio_queue_head].len = 0;
-    s_audio_queue[s_audio_queue_head].timestamp = 0;
-    s_audio_queue[s_audio_queue_head].valid = false;
-    s_audio_queue_head = (s_audio_queue_head + 1) % MAX_QUEUED_IMAGES;
-    s_audio_queue_count--;
-  }
   s_audio_queue_head = 0;
   s_audio_queue_tail = 0;
-
   xSemaphoreGive(s_queue_mutex);
 }
 
@@ -225,13 +284,7 @@ static bool app_queue_pop(queued_image_t *out_item) {
     return false;
   }
 
-  *out_item = s_image_queue[s_queue_head];
-  s_image_queue[s_queue_head].data = NULL;
-  s_image_queue[s_queue_head].len = 0;
-  s_image_queue[s_queue_head].timestamp = 0;
-  s_image_queue[s_queue_head].valid = false;
-  s_queue_head = (s_queue_head + 1) % MAX_QUEUED_IMAGES;
-  s_queue_count--;
+  app_queue_take_image_locked(out_item);
 
   xSemaphoreGive(s_queue_mutex);
   return true;
@@ -249,13 +302,7 @@ static bool app_queue_pop_audio(queued_audio_t *out_item) {
     return false;
   }
 
-  *out_item = s_audio_queue[s_audio_queue_head];
-  s_audio_queue[s_audio_queue_head].data = NULL;
-  s_audio_queue[s_audio_queue_head].len = 0;
-  s_audio_queue[s_audio_queue_head].timestamp = 0;
-  s_audio_queue[s_audio_queue_head].valid = false;
-  s_audio_queue_head = (s_audio_queue_head + 1) % MAX_QUEUED_IMAGES;
-  s_audio_queue_count--;
+  app_queue_take_audio_locked(out_item);
 
   xSemaphoreGive(s_queue_mutex);
   return true;
@@ -303,8 +350,8 @@ static void opportunistic_save_task(void *pvParameters) {
     bool immediate_save = (queued_now >= MIN_QUEUE_FOR_IMMEDIATE_SAVE);
 
     if (immediate_save) {
-      ESP_LOGI(TAG, "Queue almost full (%d/%d), saving immediately", queued_now,
-               MAX_QUEUED_IMAGES);
+      ESP_LOGI(TAG, "%d item(s) queued (%u KB), saving immediately",
+               queued_now, (unsigned)(s_queue_bytes / 1024));
     } else {
       ESP_LOGI(TAG, "Inactivity detected, saving %d queued images", queued_now);
     }
@@ -415,15 +462,15 @@ static void app_storage_process_queue_internal(void) {
     }
 
     s_sd_mounted = true;
-    bsp_lvgl_lock(-1);
+    bsp_spi_bus_acquire(-1);
     ensure_directory_structure();
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     ESP_LOGI(TAG, "SD card mounted successfully (will remain mounted)");
   } else {
     ESP_LOGI(TAG, "SD card already mounted, proceeding to save");
-    bsp_lvgl_lock(-1);
+    bsp_spi_bus_acquire(-1);
     ensure_directory_structure();
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
   }
 
   // Processa fila: salva todas as imagens e audios
@@ -433,11 +480,11 @@ static void app_storage_process_queue_internal(void) {
   queued_image_t image_item = {0};
   while (app_queue_pop(&image_item)) {
     if (!image_item.valid || !image_item.data || image_item.len == 0) {
+      queued_image_release(&image_item);
       continue;
     }
 
-    esp_err_t save_ret =
-        app_storage_save_image(image_item.data, image_item.len);
+    esp_err_t save_ret = save_image_file(image_item.data, image_item.len);
     if (save_ret == ESP_OK) {
       saved_count++;
     } else {
@@ -447,20 +494,17 @@ static void app_storage_process_queue_internal(void) {
     }
 
     // Libera buffer PSRAM
-    free(image_item.data);
-    image_item.data = NULL;
-    image_item.valid = false;
-    image_item.len = 0;
+    queued_image_release(&image_item);
   }
 
   queued_audio_t audio_item = {0};
   while (app_queue_pop_audio(&audio_item)) {
-    if (!audio_item.valid || !audio_item.data || audio_item.len == 0) {
+    if (!audio_item.valid || audio_item.len == 0) {
+      queued_audio_release(&audio_item);
       continue;
     }
 
-    esp_err_t save_ret = app_storage_save_audio(audio_item.data, audio_item.len,
-                                                audio_item.sample_rate_hz);
+    esp_err_t save_ret = save_queued_audio(&audio_item);
     if (save_ret == ESP_OK) {
       saved_count++;
     } else {
@@ -469,15 +513,13 @@ static void app_storage_process_queue_internal(void) {
                esp_err_to_name(save_ret));
     }
 
-    // Libera buffer PSRAM
-    free(audio_item.data);
-    audio_item.data = NULL;
-    audio_item.valid = false;
-    audio_item.len = 0;
+    // Libera buffer PSRAM / segmentos do pool
+    queued_audio_release(&audio_item);
   }
 
   ESP_LOGI(TAG, "Batch save complete (SD kept mounted): %d saved, %d failed",
            saved_count, failed_count);
+  storage_apply_clock_fallback_locked();
 
   xSemaphoreGive(s_sd_mount_mutex);
 
@@ -586,7 +628,9 @@ void app_storage_mount_after_camera_init(void) {
   xSemaphoreGive(s_sd_mount_mutex);
 }
 
-esp_err_t app_storage_save_image(const uint8_t *jpeg_data, size_t jpeg_len) {
+/* Caller holds s_sd_mount_mutex (the save task, a spill, or
+ * app_storage_save_image), so the card cannot be remounted mid-write. */
+static esp_err_t save_image_file(const uint8_t *jpeg_data, size_t jpeg_len) {
   if (!jpeg_data || jpeg_len == 0) {
     ESP_LOGE(TAG, "Invalid parameters");
     return ESP_ERR_INVALID_ARG;
@@ -688,185 +732,317 @@ esp_err_t app_storage_save_image(const uint8_t *jpeg_data, size_t jpeg_len) {
   snprintf(filename, sizeof(filename), "%s/I%02d%02d%02d.JPG", SD_IMAGES_PATH,
            timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
 
-  /* Protect SPI bus shared with LCD */
-  bsp_lvgl_lock(-1);
+  /* SPI bus shared with LCD: taken per operation, the data in slices */
+  (void)bsp_ui_stall_take_max_us();
+  bsp_spi_bus_acquire(-1);
   FILE *f = fopen(filename, "wb");
+  bsp_spi_bus_release();
   if (!f) {
-    bsp_lvgl_unlock();
+    const int err = errno;
     ESP_LOGE(TAG, "Failed to open file for writing: %s (errno: %d, %s)",
-             filename, errno, strerror(errno));
+             filename, err, strerror(err));
+    storage_note_io_error(err);
     return ESP_FAIL;
   }
 
-  // Write JPEG data
-  size_t written = fwrite(jpeg_data, 1, jpeg_len, f);
+  // Write JPEG data (errno read before fclose, which may overwrite it)
+  errno = 0;
+  size_t written = bsp_sdcard_fwrite(jpeg_data, jpeg_len, f);
+  const int write_err = errno;
+  bsp_spi_bus_acquire(-1);
   fclose(f);
-  bsp_lvgl_unlock();
+  bsp_spi_bus_release();
+  const uint32_t ui_stall_us = bsp_ui_stall_take_max_us();
 
   if (written != jpeg_len) {
-    ESP_LOGE(TAG, "Failed to write complete file: %s (written: %u/%u bytes)",
-             filename, (unsigned)written, (unsigned)jpeg_len);
+    ESP_LOGE(TAG,
+             "Failed to write complete file: %s (written: %u/%u bytes, "
+             "errno %d)",
+             filename, (unsigned)written, (unsigned)jpeg_len, write_err);
+    storage_note_io_error(write_err);
     return ESP_FAIL;
   }
 
-  ESP_LOGI(TAG, "Image saved successfully: %s (%u bytes)", filename,
-           (unsigned)jpeg_len);
+  ESP_LOGI(TAG, "Image saved successfully: %s (%u bytes, UI stall max %u ms)",
+           filename, (unsigned)jpeg_len, (unsigned)(ui_stall_us / 1000));
   return ESP_OK;
 }
 
+esp_err_t app_storage_save_image(const uint8_t *jpeg_data, size_t jpeg_len) {
+  if (s_sd_mount_mutex == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (xSemaphoreTake(s_sd_mount_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
+    return ESP_ERR_TIMEOUT;
+  }
+  esp_err_t ret = save_image_file(jpeg_data, jpeg_len);
+  xSemaphoreGive(s_sd_mount_mutex);
+  return ret;
+}
+
 bool app_storage_is_ready(void) { return bsp_sdcard_is_present(); }
 
-esp_err_t app_storage_queue_image(const uint8_t *jpeg_data, size_t jpeg_len) {
-  if (!jpeg_data || jpeg_len == 0) {
-    ESP_LOGE(TAG, "Invalid parameters for queue");
-    return ESP_ERR_INVALID_ARG;
+/* -----------------------------------------------------------------------
+ * Queue admission
+ *
+ * The queue takes ownership of the caller's buffer (no copy, no size cap).
+ * An item is held while the queue stays within QUEUE_BUDGET_BYTES (and,
+ * for audio pool segments, within its share of the pool, so the next
+ * recording still has room). Otherwise it is spilled: written to SD right
+ * away by the caller. Only if the SD is unavailable too (or busy with a
+ * batch) are the oldest items dropped to make room.
+ * ----------------------------------------------------------------------- */
+
+static bool app_queue_fits_locked(int ring_count, size_t cost,
+                                  size_t pool_segs) {
+  const size_t pool_cap = audio_pool_total_segments() / QUEUE_POOL_SHARE_DIV;
+  return ring_count < MAX_QUEUED_ITEMS &&
+         s_queue_bytes + cost <= QUEUE_BUDGET_BYTES &&
+         s_queue_pool_segs + pool_segs <= pool_cap;
+}
+
+/* Over-budget items are written to SD by the producer itself. The write
+ * holds the mount mutex like the save task does, so
+ * storage_apply_clock_fallback_locked() cannot remount the card under it.
+ * The timeout is short: if a batch is running, the item takes the
+ * drop-oldest path instead of waiting for the whole batch. */
+static bool app_queue_spill_lock(void) {
+  if (s_sd_mount_mutex == NULL ||
+      xSemaphoreTake(s_sd_mount_mutex, pdMS_TO_TICKS(200)) != pdTRUE) {
+    ESP_LOGW(TAG, "SD busy, not spilling");
+    return false;
   }
+  return true;
+}
 
-  // Validate JPEG
-  if (!validate_jpeg(jpeg_data, jpeg_len)) {
-    ESP_LOGE(TAG, "Invalid JPEG data (missing FF D8 marker)");
-    return ESP_ERR_INVALID_ARG;
+static void app_queue_kick_save_task(void) {
+  if (s_save_task_handle != NULL) {
+    xTaskNotifyGive(s_save_task_handle);
   }
+}
+
+static void app_queue_insert_image_locked(const queued_image_t *item) {
+  s_image_queue[s_queue_tail] = *item;
+  s_queue_tail = (s_queue_tail + 1) % MAX_QUEUED_ITEMS;
+  s_queue_count++;
+  s_queue_bytes += item->len;
+}
+
+static void app_queue_insert_audio_locked(const queued_audio_t *item) {
+  s_audio_queue[s_audio_queue_tail] = *item;
+  s_audio_queue_tail = (s_audio_queue_tail + 1) % MAX_QUEUED_ITEMS;
+  s_audio_queue_count++;
+  s_queue_bytes += queued_audio_cost(item);
+  s_queue_pool_segs += item->chain.count;
+}
 
-  // Check queue capacity
+static esp_err_t app_queue_add_image(queued_image_t *item) {
   if (s_queue_mutex == NULL ||
       xSemaphoreTake(s_queue_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
     ESP_LOGW(TAG, "Queue mutex unavailable, dropping frame");
+    queued_image_release(item);
     return ESP_FAIL;
   }
-
-  if (s_queue_count >= MAX_QUEUED_IMAGES) {
-    ESP_LOGW(TAG, "Image queue full (%d images), dropping oldest",
-             s_queue_count);
-    // Free oldest image
-    if (s_image_queue[s_queue_head].valid && s_image_queue[s_queue_head].data) {
-      free(s_image_queue[s_queue_head].data);
-      s_image_queue[s_queue_head].data = NULL;
-      s_image_queue[s_queue_head].valid = false;
-      s_image_queue[s_queue_head].len = 0;
-      s_image_queue[s_queue_head].timestamp = 0;
-    }
-    s_queue_head = (s_queue_head + 1) % MAX_QUEUED_IMAGES;
-    s_queue_count--;
+  if (app_queue_fits_locked(s_queue_count, item->len, 0)) {
+    app_queue_insert_image_locked(item);
+    ESP_LOGI(TAG, "JPEG queued (%u bytes, queue: %d, %u KB held)",
+             (unsigned)item->len, s_queue_count,
+             (unsigned)(s_queue_bytes / 1024));
+    xSemaphoreGive(s_queue_mutex);
+    app_queue_kick_save_task();
+    return ESP_OK;
   }
+  xSemaphoreGive(s_queue_mutex);
 
-  // Check JPEG size limit
-  if (jpeg_len > MAX_JPEG_SIZE) {
-    ESP_LOGW(TAG, "JPEG too large (%u bytes, max %u), truncating",
-             (unsigned)jpeg_len, (unsigned)MAX_JPEG_SIZE);
-    jpeg_len = MAX_JPEG_SIZE;
+  ESP_LOGW(TAG, "Queue over budget, spilling JPEG (%u bytes) to SD",
+           (unsigned)item->len);
+  esp_err_t ret = ESP_ERR_TIMEOUT;
+  if (app_queue_spill_lock()) {
+    ret = save_image_file(item->data, item->len);
+    xSemaphoreGive(s_sd_mount_mutex);
+  }
+  if (ret == ESP_OK) {
+    queued_image_release(item);
+    return ESP_OK;
   }
 
-  // Allocate buffer in PSRAM for JPEG data
-  uint8_t *buffer =
-      heap_caps_malloc(jpeg_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!buffer) {
-    ESP_LOGE(TAG, "Failed to allocate PSRAM buffer for JPEG (%u bytes)",
-             (unsigned)jpeg_len);
+  if (xSemaphoreTake(s_queue_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+    queued_image_release(item);
+    return ESP_FAIL;
+  }
+  while (!app_queue_fits_locked(s_queue_count, item->len, 0) &&
+         app_queue_drop_oldest_locked()) {
+  }
+  if (!app_queue_fits_locked(s_queue_count, item->len, 0)) {
     xSemaphoreGive(s_queue_mutex);
+    ESP_LOGE(TAG, "JPEG (%u bytes) exceeds queue budget, dropped",
+             (unsigned)item->len);
+    queued_image_release(item);
     return ESP_ERR_NO_MEM;
   }
-
-  // Copy JPEG data to PSRAM buffer
-  memcpy(buffer, jpeg_data, jpeg_len);
-
-  // Add to queue with timestamp
-  s_image_queue[s_queue_tail].data = buffer;
-  s_image_queue[s_queue_tail].len = jpeg_len;
-  s_image_queue[s_queue_tail].valid = true;
-  s_image_queue[s_queue_tail].timestamp = time(NULL);
-  s_queue_tail = (s_queue_tail + 1) % MAX_QUEUED_IMAGES;
-  s_queue_count++;
-
-  ESP_LOGI(TAG, "JPEG queued in PSRAM (%u bytes, queue: %d/%d)",
-           (unsigned)jpeg_len, s_queue_count, MAX_QUEUED_IMAGES);
-
-  const bool trigger_immediate =
-      (s_queue_count >= MIN_QUEUE_FOR_IMMEDIATE_SAVE);
+  app_queue_insert_image_locked(item);
   xSemaphoreGive(s_queue_mutex);
-
-  // Check if queue is almost full - trigger immediate save
-  if (trigger_immediate && s_save_task_handle != NULL) {
-    ESP_LOGW(TAG, "Queue almost full, triggering immediate save");
-    xTaskNotifyGive(s_save_task_handle);
-  }
-
+  app_queue_kick_save_task();
   return ESP_OK;
 }
 
-esp_err_t app_storage_queue_audio(const uint8_t *pcm_data, size_t pcm_bytes,
-                                  uint32_t sample_rate_hz) {
-  if (!pcm_data || pcm_bytes == 0) {
-    ESP_LOGE(TAG, "Invalid parameters for audio queue");
-    return ESP_ERR_INVALID_ARG;
-  }
-
-  // Check queue capacity
+static esp_err_t app_queue_add_audio(queued_audio_t *item) {
+  const size_t cost = queued_audio_cost(item);
+  const size_t segs = item->chain.count;
   if (s_queue_mutex == NULL ||
       xSemaphoreTake(s_queue_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
     ESP_LOGW(TAG, "Queue mutex unavailable, dropping audio");
+    queued_audio_release(item);
     return ESP_FAIL;
   }
-
-  if (s_audio_queue_count >= MAX_QUEUED_IMAGES) {
-    ESP_LOGW(TAG, "Audio queue full (%d items), dropping oldest",
-             s_audio_queue_count);
-    // Free oldest audio
-    if (s_audio_queue[s_audio_queue_head].valid &&
-        s_audio_queue[s_audio_queue_head].data) {
-      free(s_audio_queue[s_audio_queue_head].data);
-      s_audio_queue[s_audio_queue_head].data = NULL;
-      s_audio_queue[s_audio_queue_head].valid = false;
-      s_audio_queue[s_audio_queue_head].len = 0;
-      s_audio_queue[s_audio_queue_head].timestamp = 0;
-    }
-    s_audio_queue_head = (s_audio_queue_head + 1) % MAX_QUEUED_IMAGES;
-    s_audio_queue_count--;
+  if (app_queue_fits_locked(s_audio_queue_count, cost, segs)) {
+    app_queue_insert_audio_locked(item);
+    ESP_LOGI(TAG, "Audio queued (%u bytes PCM, queue: %d, %u KB held)",
+             (unsigned)item->len, s_audio_queue_count,
+             (unsigned)(s_queue_bytes / 1024));
+    xSemaphoreGive(s_queue_mutex);
+    app_queue_kick_save_task();
+    return ESP_OK;
   }
+  xSemaphoreGive(s_queue_mutex);
 
-  // Check Audio size limit
-  if (pcm_bytes > MAX_JPEG_SIZE) {
-    ESP_LOGW(TAG, "Audio too large (%u bytes, max %u), truncating",
-             (unsigned)pcm_bytes, (unsigned)MAX_JPEG_SIZE);
-    pcm_bytes = MAX_JPEG_SIZE;
+  ESP_LOGW(TAG, "Queue over budget, spilling audio (%u bytes) to SD",
+           (unsigned)item->len);
+  esp_err_t ret = ESP_ERR_TIMEOUT;
+  if (app_queue_spill_lock()) {
+    ret = save_queued_audio(item);
+    xSemaphoreGive(s_sd_mount_mutex);
+  }
+  if (ret == ESP_OK) {
+    queued_audio_release(item);
+    return ESP_OK;
   }
 
-  // Allocate buffer in PSRAM for Audio data
-  uint8_t *buffer =
-      heap_caps_malloc(pcm_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  if (!buffer) {
-    ESP_LOGE(TAG, "Failed to allocate PSRAM buffer for audio (%u bytes)",
-             (unsigned)pcm_bytes);
+  if (xSemaphoreTake(s_queue_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+    queued_audio_release(item);
+    return ESP_FAIL;
+  }
+  while (!app_queue_fits_locked(s_audio_queue_count, cost, segs) &&
+         app_queue_drop_oldest_locked()) {
+  }
+  if (!app_queue_fits_locked(s_audio_queue_count, cost, segs)) {
     xSemaphoreGive(s_queue_mutex);
+    ESP_LOGE(TAG, "Audio (%u bytes) exceeds queue budget, dropped",
+             (unsigned)item->len);
+    queued_audio_release(item);
     return ESP_ERR_NO_MEM;
   }
+  app_queue_insert_audio_locked(item);
+  xSemaphoreGive(s_queue_mutex);
+  app_queue_kick_save_task();
+  return ESP_OK;
+}
 
-  // Copy audio data to PSRAM buffer
-  memcpy(buffer, pcm_data, pcm_bytes);
+static uint8_t *app_queue_copy_to_psram(const uint8_t *data, size_t len) {
+  uint8_t *buffer = heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buffer) {
+    ESP_LOGE(TAG, "Failed to allocate PSRAM buffer (%u bytes)", (unsigned)len);
+    return NULL;
+  }
+  memcpy(buffer, data, len);
+  return buffer;
+}
 
-  // Add to queue with timestamp
-  s_audio_queue[s_audio_queue_tail].data = buffer;
-  s_audio_queue[s_audio_queue_tail].len = pcm_bytes;
-  s_audio_queue[s_audio_queue_tail].sample_rate_hz = sample_rate_hz;
-  s_audio_queue[s_audio_queue_tail].valid = true;
-  s_audio_queue[s_audio_queue_tail].timestamp = time(NULL);
-  s_audio_queue_tail = (s_audio_queue_tail + 1) % MAX_QUEUED_IMAGES;
-  s_audio_queue_count++;
+esp_err_t app_storage_queue_image_owned(uint8_t *jpeg_data, size_t jpeg_len,
+                                        app_storage_free_fn_t free_fn) {
+  queued_image_t item = {
+      .data = jpeg_data,
+      .len = jpeg_len,
+      .free_fn = free_fn,
+      .valid = true,
+      .timestamp = time(NULL),
+  };
+  if (!jpeg_data || jpeg_len == 0 || !free_fn) {
+    ESP_LOGE(TAG, "Invalid parameters for queue");
+    queued_image_release(&item);
+    return ESP_ERR_INVALID_ARG;
+  }
 
-  ESP_LOGI(TAG, "Audio queued in PSRAM (%u bytes, queue: %d/%d)",
-           (unsigned)pcm_bytes, s_audio_queue_count, MAX_QUEUED_IMAGES);
+  // Validate JPEG
+  if (!validate_jpeg(jpeg_data, jpeg_len)) {
+    ESP_LOGE(TAG, "Invalid JPEG data (missing FF D8 marker)");
+    queued_image_release(&item);
+    return ESP_ERR_INVALID_ARG;
+  }
 
-  const bool trigger_immediate =
-      (s_audio_queue_count >= MIN_QUEUE_FOR_IMMEDIATE_SAVE);
-  xSemaphoreGive(s_queue_mutex);
+  return app_queue_add_image(&item);
+}
 
-  // Check if queue is almost full - trigger immediate save
-  if (trigger_immediate && s_save_task_handle != NULL) {
-    ESP_LOGW(TAG, "Audio queue almost full, triggering immediate save");
-    xTaskNotifyGive(s_save_task_handle);
+esp_err_t app_storage_queue_image(const uint8_t *jpeg_data, size_t jpeg_len) {
+  if (!jpeg_data || jpeg_len == 0) {
+    ESP_LOGE(TAG, "Invalid parameters for queue");
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!validate_jpeg(jpeg_data, jpeg_len)) {
+    ESP_LOGE(TAG, "Invalid JPEG data (missing FF D8 marker)");
+    return ESP_ERR_INVALID_ARG;
+  }
+  uint8_t *buffer = app_queue_copy_to_psram(jpeg_data, jpeg_len);
+  if (!buffer) {
+    return ESP_ERR_NO_MEM;
   }
+  return app_storage_queue_image_owned(buffer, jpeg_len, heap_caps_free);
+}
 
-  return ESP_OK;
+esp_err_t app_storage_queue_audio_owned(uint8_t *pcm_data, size_t pcm_bytes,
+                                        uint32_t sample_rate_hz,
+                                        app_storage_free_fn_t free_fn) {
+  queued_audio_t item = {
+      .data = pcm_data,
+      .len = pcm_bytes,
+      .free_fn = free_fn,
+      .sample_rate_hz = sample_rate_hz,
+      .valid = true,
+      .timestamp = time(NULL),
+  };
+  if (!pcm_data || pcm_bytes == 0 || !free_fn) {
+    ESP_LOGE(TAG, "Invalid parameters for audio queue");
+    queued_audio_release(&item);
+    return ESP_ERR_INVALID_ARG;
+  }
+  return app_queue_add_audio(&item);
+}
+
+esp_err_t app_storage_queue_audio(const uint8_t *pcm_data, size_t pcm_bytes,
+                                  uint32_t sample_rate_hz) {
+  if (!pcm_data || pcm_bytes == 0) {
+    ESP_LOGE(TAG, "Invalid parameters for audio queue");
+    return ESP_ERR_INVALID_ARG;
+  }
+  uint8_t *buffer = app_queue_copy_to_psram(pcm_data, pcm_bytes);
+  if (!buffer) {
+    return ESP_ERR_NO_MEM;
+  }
+  return app_storage_queue_audio_owned(buffer, pcm_bytes, sample_rate_hz,
+                                       heap_caps_free);
+}
+
+esp_err_t app_storage_queue_audio_chain(audio_chain_t *chain, size_t offset,
+                                        size_t pcm_bytes,
+                                        uint32_t sample_rate_hz) {
+  if (!chain) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  queued_audio_t item = {
+      .chain = *chain,
+      .chain_offset = offset,
+      .len = pcm_bytes,
+      .sample_rate_hz = sample_rate_hz,
+      .valid = true,
+      .timestamp = time(NULL),
+  };
+  audio_chain_init(chain);
+  if (pcm_bytes == 0 || offset + pcm_bytes > item.chain.len) {
+    ESP_LOGE(TAG, "Invalid parameters for audio queue");
+    queued_audio_release(&item);
+    return ESP_ERR_INVALID_ARG;
+  }
+  return app_queue_add_audio(&item);
 }
 
 // Legacy function - now just notifies interaction
@@ -893,64 +1069,29 @@ int app_storage_get_queue_count(void) { return app_queue_get_count(); }
 
 bool app_storage_is_busy(void) { return s_storage_busy; }
 
-/* -----------------------------------------------------------------------
- * WAV helper – build a minimal 44-byte RIFF/PCM header in-place.
- * 16-bit, mono, PCM (format tag 1).
- * ----------------------------------------------------------------------- */
-static void build_wav_header(uint8_t *hdr, uint32_t pcm_bytes,
-                             uint32_t sample_rate_hz) {
-  const uint16_t num_channels = 1;
-  const uint16_t bits_per_sample = 16;
-  const uint32_t byte_rate =
-      sample_rate_hz * num_channels * (bits_per_sample / 8);
-  const uint16_t block_align = num_channels * (bits_per_sample / 8);
-  const uint32_t data_chunk_size = pcm_bytes;
-  const uint32_t riff_size =
-      36 + pcm_bytes; /* 36 = rest of header after RIFF */
-
-  /* RIFF chunk */
-  memcpy(hdr, "RIFF", 4);
-  hdr[4] = (uint8_t)(riff_size);
-  hdr[5] = (uint8_t)(riff_size >> 8);
-  hdr[6] = (uint8_t)(riff_size >> 16);
-  hdr[7] = (uint8_t)(riff_size >> 24);
-  memcpy(hdr + 8, "WAVE", 4);
-
-  /* fmt sub-chunk */
-  memcpy(hdr + 12, "fmt ", 4);
-  hdr[16] = 16;
-  hdr[17] = 0;
-  hdr[18] = 0;
-  hdr[19] = 0; /* sub-chunk size = 16 */
-  hdr[20] = 1;
-  hdr[21] = 0; /* PCM = 1 */
-  hdr[22] = (uint8_t)(num_channels);
-  hdr[23] = (uint8_t)(num_channels >> 8);
-  hdr[24] = (uint8_t)(sample_rate_hz);
-  hdr[25] = (uint8_t)(sample_rate_hz >> 8);
-  hdr[26] = (uint8_t)(sample_rate_hz >> 16);
-  hdr[27] = (uint8_t)(sample_rate_hz >> 24);
-  hdr[28] = (uint8_t)(byte_rate);
-  hdr[29] = (uint8_t)(byte_rate >> 8);
-  hdr[30] = (uint8_t)(byte_rate >> 16);
-  hdr[31] = (uint8_t)(byte_rate >> 24);
-  hdr[32] = (uint8_t)(block_align);
-  hdr[33] = (uint8_t)(block_align >> 8);
-  hdr[34] = (uint8_t)(bits_per_sample);
-  hdr[35] = (uint8_t)(bits_per_sample >> 8);
-
-  /* data sub-chunk */
-  memcpy(hdr + 36, "data", 4);
-  hdr[40] = (uint8_t)(data_chunk_size);
-  hdr[41] = (uint8_t)(data_chunk_size >> 8);
-  hdr[42] = (uint8_t)(data_chunk_size >> 16);
-  hdr[43] = (uint8_t)(data_chunk_size >> 24);
-}
-
 /* -----------------------------------------------------------------------
  * Ensure SD is mounted (reuses the already-mounted state to avoid DMA
  * fragmentation).  Returns ESP_OK only when mount is confirmed.
  * ----------------------------------------------------------------------- */
+/* Caller holds s_sd_mount_mutex. */
+static esp_err_t storage_ensure_mounted_locked(void) {
+  if (s_sd_mounted) {
+    return ESP_OK;
+  }
+  if (!bsp_sdcard_is_present()) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  esp_err_t ret = bsp_sdcard_mount();
+  if (ret == ESP_OK) {
+    s_sd_mounted = true;
+    (void)ensure_directory_structure();
+    ESP_LOGI(TAG, "SD mounted on-demand");
+  } else {
+    ESP_LOGW(TAG, "SD mount failed: %s", esp_err_to_name(ret));
+  }
+  return ret;
+}
+
 static esp_err_t storage_ensure_mounted(void) {
   if (s_sd_mounted) {
     return ESP_OK;
@@ -964,31 +1105,283 @@ static esp_err_t storage_ensure_mounted(void) {
   if (xSemaphoreTake(s_sd_mount_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
     return ESP_ERR_TIMEOUT;
   }
-  esp_err_t ret = ESP_OK;
+  esp_err_t ret = storage_ensure_mounted_locked();
+  xSemaphoreGive(s_sd_mount_mutex);
+  return ret;
+}
+
+/* -----------------------------------------------------------------------
+ * SD clock calibration and runtime fallback
+ *
+ * The SPI clock the card sustains depends on the board revision (trace
+ * length) and on the card. Calibration writes a scratch file at each step of
+ * BSP_SD_FREQ_STEPS_KHZ, reads it back and keeps the fastest step whose CRC
+ * matches; bsp stores it in NVS.
+ *
+ * At runtime only bus errors step the clock down: SDSPI CRC and timeout
+ * errors reach the VFS as FR_DISK_ERR, i.e. errno EIO on the failed fopen or
+ * short write. A full card (ENOSPC), a missing directory (ENOENT) or too many
+ * open files say nothing about the clock and leave it alone. The step is
+ * taken once per batch, under the mount mutex, and only saved to NVS after
+ * the scratch-file CRC probe passes at the lower clock.
+ * ----------------------------------------------------------------------- */
+#define SD_CAL_FILE SD_BASE_PATH "/SDCAL.BIN"
+#define SD_CAL_BYTES (256 * 1024)
+#define SD_CAL_TIMEOUT_US (5 * 1000 * 1000)
+
+typedef struct {
+  uint32_t freq_khz;
+  uint32_t real_khz;
+  uint32_t write_kbps;
+  esp_err_t err;
+} sd_cal_result_t;
+
+static void storage_note_io_error(int err) {
+  if (err != EIO) {
+    ESP_LOGD(TAG, "SD error %d (%s) is not a bus error, clock kept", err,
+             strerror(err));
+    return;
+  }
+  if (bsp_sdcard_is_present()) {
+    __atomic_store_n(&s_sd_io_error, true, __ATOMIC_RELAXED);
+  }
+}
+
+/* Deterministic pattern (xorshift32), so every bit of the bus toggles. */
+static void sd_cal_fill(uint8_t *buf, size_t len) {
+  uint32_t x = 0x9E3779B9u;
+  for (size_t i = 0; i + sizeof(x) <= len; i += sizeof(x)) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    memcpy(buf + i, &x, sizeof(x));
+  }
+}
+
+/* Write, time and verify the scratch file at the current clock. */
+static esp_err_t sd_cal_run_step(const uint8_t *pattern, uint32_t pattern_crc,
+                                 uint8_t *chunk, uint32_t *write_kbps) {
+  bsp_spi_bus_acquire(-1);
+  FILE *f = fopen(SD_CAL_FILE, "wb");
+  bsp_spi_bus_release();
+  if (!f) {
+    return ESP_FAIL;
+  }
+  const int64_t t0 = esp_timer_get_time();
+  size_t written = bsp_sdcard_fwrite(pattern, SD_CAL_BYTES, f);
+  bsp_spi_bus_acquire(-1);
+  const int sync_ret = fsync(fileno(f));
+  fclose(f);
+  bsp_spi_bus_release();
+  const int64_t elapsed_us = esp_timer_get_time() - t0;
+  if (written != SD_CAL_BYTES || sync_ret != 0) {
+    return ESP_FAIL;
+  }
+  if (elapsed_us > SD_CAL_TIMEOUT_US) {
+    return ESP_ERR_TIMEOUT;
+  }
+  *write_kbps =
+      (uint32_t)(((int64_t)SD_CAL_BYTES * 1000000 / 1024) / (elapsed_us + 1));
+
+  bsp_spi_bus_acquire(-1);
+  f = fopen(SD_CAL_FILE, "rb");
+  bsp_spi_bus_release();
+  if (!f) {
+    return ESP_FAIL;
+  }
+  uint32_t crc = 0;
+  size_t total = 0;
+  for (;;) {
+    bsp_spi_bus_acquire(-1);
+    const size_t n = fread(chunk, 1, BSP_SD_WRITE_SLICE_BYTES, f);
+    bsp_spi_bus_release();
+    if (n == 0) {
+      break;
+    }
+    crc = esp_rom_crc32_le(crc, chunk, (uint32_t)n);
+    total += n;
+  }
+  bsp_spi_bus_acquire(-1);
+  fclose(f);
+  bsp_spi_bus_release();
+  return (total == SD_CAL_BYTES && crc == pattern_crc) ? ESP_OK
+                                                       : ESP_ERR_INVALID_CRC;
+}
+
+/* One calibration step at the current clock, with its own buffers. */
+static esp_err_t sd_cal_probe(uint32_t *write_kbps) {
+  uint8_t *pattern =
+      heap_caps_malloc(SD_CAL_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  uint8_t *chunk = heap_caps_malloc(BSP_SD_WRITE_SLICE_BYTES,
+                                    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  esp_err_t ret = ESP_ERR_NO_MEM;
+  if (pattern && chunk) {
+    sd_cal_fill(pattern, SD_CAL_BYTES);
+    ret = sd_cal_run_step(pattern, esp_rom_crc32_le(0, pattern, SD_CAL_BYTES),
+                          chunk, write_kbps);
+    bsp_spi_bus_acquire(-1);
+    unlink(SD_CAL_FILE);
+    bsp_spi_bus_release();
+  }
+  heap_caps_free(pattern);
+  heap_caps_free(chunk);
+  return ret;
+}
+
+/* Step down one clock, verify it with the CRC probe and only then save it;
+ * if the card fails the probe there too, go back to the previous clock
+ * without touching NVS (the errors were not the clock's fault). */
+static void storage_apply_clock_fallback_locked(void) {
+  if (!__atomic_exchange_n(&s_sd_io_error, false, __ATOMIC_RELAXED)) {
+    return;
+  }
+  const uint32_t prev_khz = bsp_sdcard_get_freq_khz();
+  bsp_spi_bus_acquire(-1);
+  esp_err_t ret = bsp_sdcard_freq_step_down(false);
+  bsp_spi_bus_release();
+  if (ret == ESP_ERR_NOT_FOUND) {
+    ESP_LOGW(TAG, "SD write failed at the slowest clock (%u kHz)",
+             (unsigned)prev_khz);
+    return;
+  }
+  const uint32_t new_khz = bsp_sdcard_get_freq_khz();
+  uint32_t write_kbps = 0;
+  if (ret == ESP_OK) {
+    ret = sd_cal_probe(&write_kbps);
+  }
+
+  bsp_spi_bus_acquire(-1);
+  if (ret == ESP_OK) {
+    ret = bsp_sdcard_set_freq_khz(new_khz, true);
+  } else {
+    ESP_LOGW(TAG, "SD probe at %u kHz failed (%s), keeping %u kHz",
+             (unsigned)new_khz, esp_err_to_name(ret), (unsigned)prev_khz);
+    (void)bsp_sdcard_set_freq_khz(prev_khz, false);
+  }
+  if (bsp_sdcard_get_real_freq_khz() == 0) {
+    (void)bsp_sdcard_mount();
+  }
+  bsp_spi_bus_release();
+  s_sd_mounted = bsp_sdcard_get_real_freq_khz() != 0;
+  if (ret == ESP_OK) {
+    ESP_LOGW(TAG, "SD clock lowered to %u kHz (probe %u KB/s), saved",
+             (unsigned)new_khz, (unsigned)write_kbps);
+  }
   if (!s_sd_mounted) {
-    ret = bsp_sdcard_mount();
-    if (ret == ESP_OK) {
-      s_sd_mounted = true;
-      (void)ensure_directory_structure();
-      ESP_LOGI(TAG, "SD mounted on-demand");
-    } else {
-      ESP_LOGW(TAG, "SD mount failed: %s", esp_err_to_name(ret));
+    ESP_LOGW(TAG, "SD remount at %u kHz failed",
+             (unsigned)bsp_sdcard_get_freq_khz());
+  }
+}
+
+esp_err_t app_storage_sd_calibrate(bool force) {
+  if (!force && bsp_sdcard_freq_is_calibrated()) {
+    return ESP_OK;
+  }
+  if (!bsp_sdcard_is_present()) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  if (s_sd_mount_mutex == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  uint8_t *pattern =
+      heap_caps_malloc(SD_CAL_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  uint8_t *chunk = heap_caps_malloc(BSP_SD_WRITE_SLICE_BYTES,
+                                    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!pattern || !chunk) {
+    heap_caps_free(pattern);
+    heap_caps_free(chunk);
+    return ESP_ERR_NO_MEM;
+  }
+  sd_cal_fill(pattern, SD_CAL_BYTES);
+  const uint32_t pattern_crc = esp_rom_crc32_le(0, pattern, SD_CAL_BYTES);
+
+  if (xSemaphoreTake(s_sd_mount_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
+    heap_caps_free(pattern);
+    heap_caps_free(chunk);
+    return ESP_ERR_TIMEOUT;
+  }
+  s_storage_busy = true;
+
+  static const uint32_t steps[BSP_SD_FREQ_STEP_COUNT] = BSP_SD_FREQ_STEPS_KHZ;
+  sd_cal_result_t results[BSP_SD_FREQ_STEP_COUNT] = {0};
+  int best = -1;
+  for (int i = 0; i < BSP_SD_FREQ_STEP_COUNT; i++) {
+    sd_cal_result_t *r = &results[i];
+    r->freq_khz = steps[i];
+    bsp_spi_bus_acquire(-1);
+    r->err = bsp_sdcard_set_freq_khz(steps[i], false);
+    if (r->err == ESP_OK) {
+      r->err = bsp_sdcard_mount(); // no-op if set_freq remounted
+    }
+    bsp_spi_bus_release();
+    r->real_khz = bsp_sdcard_get_real_freq_khz();
+    if (r->err == ESP_OK) {
+      r->err = sd_cal_run_step(pattern, pattern_crc, chunk, &r->write_kbps);
+    }
+    if (r->err == ESP_OK &&
+        (best < 0 || r->write_kbps > results[best].write_kbps)) {
+      best = i;
     }
   }
+
+  esp_err_t ret = ESP_ERR_NOT_FOUND;
+  const uint32_t chosen =
+      best >= 0 ? steps[best] : steps[BSP_SD_FREQ_STEP_COUNT - 1];
+  bsp_spi_bus_acquire(-1);
+  esp_err_t set_ret = bsp_sdcard_set_freq_khz(chosen, best >= 0);
+  if (bsp_sdcard_get_real_freq_khz() == 0) {
+    set_ret = bsp_sdcard_mount();
+  }
+  bsp_spi_bus_release();
+  if (best >= 0) {
+    ret = set_ret;
+  }
+  s_sd_mounted = bsp_sdcard_get_real_freq_khz() != 0;
+  if (s_sd_mounted) {
+    bsp_spi_bus_acquire(-1);
+    unlink(SD_CAL_FILE);
+    (void)ensure_directory_structure();
+    bsp_spi_bus_release();
+  }
+  __atomic_store_n(&s_sd_io_error, false, __ATOMIC_RELAXED);
+  s_storage_busy = false;
   xSemaphoreGive(s_sd_mount_mutex);
+
+  heap_caps_free(pattern);
+  heap_caps_free(chunk);
+
+  ESP_LOGI(TAG, "SD bench (%u KB sequential write, read-back CRC32):",
+           (unsigned)(SD_CAL_BYTES / 1024));
+  for (int i = 0; i < BSP_SD_FREQ_STEP_COUNT; i++) {
+    const sd_cal_result_t *r = &results[i];
+    ESP_LOGI(TAG, "  %5u kHz (real %5u): %-20s %5u KB/s%s",
+             (unsigned)r->freq_khz, (unsigned)r->real_khz,
+             esp_err_to_name(r->err), (unsigned)r->write_kbps,
+             i == best ? "  <- selected" : "");
+  }
+  if (best < 0) {
+    ESP_LOGW(TAG, "SD calibration: no clock passed, using %u kHz",
+             (unsigned)chosen);
+  }
   return ret;
 }
 
 /* -----------------------------------------------------------------------
  * app_storage_save_audio
  * ----------------------------------------------------------------------- */
-esp_err_t app_storage_save_audio(const uint8_t *pcm_data, size_t pcm_bytes,
+/* Writes pcm_data, or [chain_offset, +pcm_bytes) of chain, as a WAV file.
+ * Caller holds s_sd_mount_mutex (the save task, a spill, or
+ * app_storage_save_audio), so the card cannot be remounted mid-write. */
+static esp_err_t save_audio_file(const uint8_t *pcm_data,
+                                 const audio_chain_t *chain,
+                                 size_t chain_offset, size_t pcm_bytes,
                                  uint32_t sample_rate_hz) {
-  if (!pcm_data || pcm_bytes == 0) {
+  if ((!pcm_data && !chain) || pcm_bytes == 0) {
     return ESP_ERR_INVALID_ARG;
   }
 
-  esp_err_t ret = storage_ensure_mounted();
+  esp_err_t ret = storage_ensure_mounted_locked();
   if (ret != ESP_OK) {
     ESP_LOGW(TAG, "save_audio: SD not available (%s)", esp_err_to_name(ret));
     return ret;
@@ -1005,38 +1398,92 @@ esp_err_t app_storage_save_audio(const uint8_t *pcm_data, size_t pcm_bytes,
   snprintf(filename, sizeof(filename), "%s/R%02d%02d%02d.WAV",
            SD_MEDIA_PATH "/audio", ti.tm_hour, ti.tm_min, ti.tm_sec);
 
-  /* Protect SPI bus shared with LCD */
-  bsp_lvgl_lock(-1);
+  /* SPI bus shared with LCD: taken per operation, the data in slices */
+  (void)bsp_ui_stall_take_max_us();
+  bsp_spi_bus_acquire(-1);
   FILE *f = fopen(filename, "wb");
+  bsp_spi_bus_release();
   if (!f) {
-    bsp_lvgl_unlock();
+    const int err = errno;
     ESP_LOGE(TAG, "save_audio: fopen failed '%s' (errno %d: %s)", filename,
-             errno, strerror(errno));
+             err, strerror(err));
+    storage_note_io_error(err);
     return ESP_FAIL;
   }
 
   /* Write WAV header */
-  uint8_t wav_hdr[44];
-  build_wav_header(wav_hdr, (uint32_t)pcm_bytes, sample_rate_hz);
-  size_t hdr_written = fwrite(wav_hdr, 1, sizeof(wav_hdr), f);
-
-  /* Write PCM payload */
-  size_t pcm_written = fwrite(pcm_data, 1, pcm_bytes, f);
+  uint8_t wav_hdr[AUDIO_WAV_HEADER_LEN];
+  audio_wav_pcm16_header(wav_hdr, (uint32_t)pcm_bytes, sample_rate_hz, 1);
+  errno = 0;
+  size_t hdr_written = bsp_sdcard_fwrite(wav_hdr, sizeof(wav_hdr), f);
+
+  /* Write PCM payload (segment by segment for a chain) */
+  size_t pcm_written = 0;
+  if (chain) {
+    audio_chain_iter_t it;
+    audio_chain_iter_init(&it, chain, chain_offset, pcm_bytes);
+    const uint8_t *piece;
+    size_t piece_len;
+    while (audio_chain_iter_next(&it, &piece, &piece_len)) {
+      const size_t n = bsp_sdcard_fwrite(piece, piece_len, f);
+      pcm_written += n;
+      if (n != piece_len) {
+        break;
+      }
+    }
+  } else {
+    pcm_written = bsp_sdcard_fwrite(pcm_data, pcm_bytes, f);
+  }
+  const int write_err = errno;
+  bsp_spi_bus_acquire(-1);
   fclose(f);
-  bsp_lvgl_unlock();
+  bsp_spi_bus_release();
+  const uint32_t ui_stall_us = bsp_ui_stall_take_max_us();
 
   if (hdr_written != sizeof(wav_hdr) || pcm_written != pcm_bytes) {
-    ESP_LOGE(TAG, "save_audio: incomplete write to '%s' (hdr=%u/%u, pcm=%u/%u)",
+    ESP_LOGE(TAG,
+             "save_audio: incomplete write to '%s' (hdr=%u/%u, pcm=%u/%u, "
+             "errno %d)",
              filename, (unsigned)hdr_written, (unsigned)sizeof(wav_hdr),
-             (unsigned)pcm_written, (unsigned)pcm_bytes);
+             (unsigned)pcm_written, (unsigned)pcm_bytes, write_err);
+    storage_note_io_error(write_err);
     return ESP_FAIL;
   }
 
-  ESP_LOGI(TAG, "Audio saved: %s (%u bytes PCM -> %u bytes WAV)", filename,
-           (unsigned)pcm_bytes, (unsigned)(sizeof(wav_hdr) + pcm_bytes));
+  ESP_LOGI(TAG,
+           "Audio saved: %s (%u bytes PCM -> %u bytes WAV, UI stall max %u "
+           "ms)",
+           filename, (unsigned)pcm_bytes,
+           (unsigned)(sizeof(wav_hdr) + pcm_bytes),
+           (unsigned)(ui_stall_us / 1000));
   return ESP_OK;
 }
 
+esp_err_t app_storage_save_audio(const uint8_t *pcm_data, size_t pcm_bytes,
+                                 uint32_t sample_rate_hz) {
+  if (!pcm_data) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (s_sd_mount_mutex == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (xSemaphoreTake(s_sd_mount_mutex, pdMS_TO_TICKS(2000)) != pdTRUE) {
+    return ESP_ERR_TIMEOUT;
+  }
+  esp_err_t ret = save_audio_file(pcm_data, NULL, 0, pcm_bytes, sample_rate_hz);
+  xSemaphoreGive(s_sd_mount_mutex);
+  return ret;
+}
+
+static esp_err_t save_queued_audio(const queued_audio_t *item) {
+  if (item->data) {
+    return save_audio_file(item->data, NULL, 0, item->len,
+                           item->sample_rate_hz);
+  }
+  return save_audio_file(NULL, &item->chain, item->chain_offset, item->len,
+                         item->sample_rate_hz);
+}
+
 /* -----------------------------------------------------------------------
  * app_storage_save_chat_log
  * ----------------------------------------------------------------------- */
@@ -1063,12 +1510,12 @@ esp_err_t app_storage_save_chat_log(const char *mode_label,
   snprintf(filename, sizeof(filename), "%s/C%02d%02d.TXT",
            SD_BASE_PATH "/logs/chat", ti.tm_mon + 1, ti.tm_mday);
 
-  /* Protect SPI bus shared with LCD */
-  bsp_lvgl_lock(-1);
+  /* Protect SPI bus shared with LCD (one short append) */
+  bsp_spi_bus_acquire(-1);
   /* Append mode: cria o arquivo se não existir, senão acrescenta */
   FILE *f = fopen(filename, "a");
   if (!f) {
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     ESP_LOGE(TAG, "save_chat_log: fopen failed '%s' (errno %d: %s)", filename,
              errno, strerror(errno));
     return ESP_FAIL;
@@ -1082,7 +1529,7 @@ esp_err_t app_storage_save_chat_log(const char *mode_label,
   int written =
       fprintf(f, "[%s] [%s] AI: %s\n", timestamp, mode_label, ai_response);
   fclose(f);
-  bsp_lvgl_unlock();
+  bsp_spi_bus_release();
 
   if (written < 0) {
     ESP_LOGE(TAG, "save_chat_log: fprintf failed for '%s'", filename);
@@ -1096,9 +1543,9 @@ esp_err_t app_storage_save_chat_log(const char *mode_label,
 esp_err_t app_storage_ensure_mounted(void) {
   if (s_sd_mounted) {
     /* Mesmo se já montado, garante a estrutura de diretórios */
-    bsp_lvgl_lock(-1);
+    bsp_spi_bus_acquire(-1);
     ensure_directory_structure();
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     return ESP_OK;
   }
 
@@ -1133,9 +1580,9 @@ esp_err_t app_storage_ensure_mounted(void) {
   esp_err_t ret = bsp_sdcard_mount();
   if (ret == ESP_OK) {
     s_sd_mounted = true;
-    bsp_lvgl_lock(-1);
+    bsp_spi_bus_acquire(-1);
     ensure_directory_structure();
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     ESP_LOGI(TAG, "ensure_mounted: SD card mounted successfully");
   } else {
     ESP_LOGE(TAG, "ensure_mounted: mount failed: %s", esp_err_to_name(ret));
@@ -0,0 +1,215 @@
+#include "audio_dsp.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+#else
+#include <time.h>
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(AUDIO_DSP_FORCE_REFERENCE)
+#define AUDIO_DSP_USE_ESP_DSP 1
+#include "dsps_biquad.h"
+#include "dsps_dotprod.h"
+#else
+#define AUDIO_DSP_USE_ESP_DSP 0
+#endif
+
+const char *audio_dsp_backend(void) {
+  return AUDIO_DSP_USE_ESP_DSP ? "esp-dsp" : "reference";
+}
+
+void audio_dsp_highpass_coefs(float alpha, float coef[5]) {
+  /*
+   * H(z) = alpha * (1 - z^-1) / (1 - alpha * z^-1)
+   * In direct form II the delay line holds w[n] = x[n] + alpha * w[n-1],
+   * which starts at zero after the first (pass-through) sample.
+   */
+  coef[0] = alpha;
+  coef[1] = -alpha;
+  coef[2] = 0.0f;
+  coef[3] = -alpha;
+  coef[4] = 0.0f;
+}
+
+void audio_dsp_i2s_to_f32(const int32_t *raw, size_t frames, float *out) {
+  for (size_t i = 0; i < frames; i++) {
+    /* INMP441: 24-bit samples in 32-bit slots; >>15 as in the BSP. */
+    const int32_t l = raw[2 * i] >> 15;
+    const int32_t r = raw[2 * i + 1] >> 15;
+    int32_t s = (abs(l) >= abs(r)) ? l : r;
+    if (s > INT16_MAX) {
+      s = INT16_MAX;
+    } else if (s < INT16_MIN) {
+      s = INT16_MIN;
+    }
+    out[i] = (float)s;
+  }
+}
+
+void audio_dsp_pack_s16(const float *in, int16_t *out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    float y = in[i];
+    if (y > 32767.0f) {
+      y = 32767.0f;
+    } else if (y < -32768.0f) {
+      y = -32768.0f;
+    }
+    out[i] = (int16_t)y;
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Reference kernels
+ *
+ * Same arithmetic and operation order as the esp-dsp ANSI versions, so a
+ * reference build and an unoptimised esp-dsp build agree bit for bit; the
+ * PIE versions differ only by fused multiply-add rounding.
+ * ----------------------------------------------------------------------- */
+
+void audio_dsp_ref_biquad_f32(const float *in, float *out, size_t count,
+                              const float coef[5], float w[2]) {
+  float w0 = w[0];
+  float w1 = w[1];
+  for (size_t i = 0; i < count; i++) {
+    const float d0 = in[i] - coef[3] * w0 - coef[4] * w1;
+    out[i] = coef[0] * d0 + coef[1] * w0 + coef[2] * w1;
+    w1 = w0;
+    w0 = d0;
+  }
+  w[0] = w0;
+  w[1] = w1;
+}
+
+float audio_dsp_ref_energy_f32(const float *samples, size_t count) {
+  float acc = 0.0f;
+  for (size_t i = 0; i < count; i++) {
+    acc += samples[i] * samples[i];
+  }
+  return acc;
+}
+
+/* -----------------------------------------------------------------------
+ * Dispatch
+ * ----------------------------------------------------------------------- */
+
+void audio_dsp_biquad_f32(const float *in, float *out, size_t count,
+                          const float coef[5], float w[2]) {
+  if (count == 0) {
+    return;
+  }
+#if AUDIO_DSP_USE_ESP_DSP
+  dsps_biquad_f32((float *)in, out, (int)count, (float *)coef, w);
+#else
+  audio_dsp_ref_biquad_f32(in, out, count, coef, w);
+#endif
+}
+
+float audio_dsp_energy_f32(const float *samples, size_t count) {
+  if (count == 0) {
+    return 0.0f;
+  }
+#if AUDIO_DSP_USE_ESP_DSP
+  float acc = 0.0f;
+  dsps_dotprod_f32(samples, samples, &acc, (int)count);
+  return acc;
+#else
+  return audio_dsp_ref_energy_f32(samples, count);
+#endif
+}
+
+/* -----------------------------------------------------------------------
+ * Self-test
+ * ----------------------------------------------------------------------- */
+
+#define AUDIO_DSP_TEST_LEN 1024
+#define AUDIO_DSP_TEST_MAX_ERR 0.5f /* below one output LSB */
+#define AUDIO_DSP_TEST_MAX_REL 1e-4f
+
+static uint32_t audio_dsp_ticks(void) {
+#ifdef ESP_PLATFORM
+  return (uint32_t)esp_cpu_get_cycle_count();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+static void audio_dsp_test_signal(float *x, size_t count) {
+  /* Voiced-like harmonics + noise + DC offset, full int16 range. */
+  uint32_t seed = 0x1234567u;
+  for (size_t i = 0; i < count; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    const float noise = (float)((int32_t)(seed >> 16) - 32768) / 16.0f;
+    const float t = (float)i / 8000.0f;
+    float v = 12000.0f * sinf(2.0f * (float)M_PI * 180.0f * t) +
+              6000.0f * sinf(2.0f * (float)M_PI * 1260.0f * t) + noise +
+              1500.0f;
+    if (v > 32767.0f) {
+      v = 32767.0f;
+    } else if (v < -32768.0f) {
+      v = -32768.0f;
+    }
+    x[i] = (float)(int16_t)v;
+  }
+}
+
+bool audio_dsp_self_test(audio_dsp_report_t *report) {
+  audio_dsp_report_t r = {
+      .backend = audio_dsp_backend(),
+      .samples = AUDIO_DSP_TEST_LEN,
+  };
+
+  float *x = malloc(3 * AUDIO_DSP_TEST_LEN * sizeof(float));
+  if (!x) {
+    if (report) {
+      *report = r;
+    }
+    return false;
+  }
+  float *y_ref = x + AUDIO_DSP_TEST_LEN;
+  float *y_dsp = y_ref + AUDIO_DSP_TEST_LEN;
+  audio_dsp_test_signal(x, AUDIO_DSP_TEST_LEN);
+
+  float coef[5];
+  audio_dsp_highpass_coefs(0.927f, coef); /* 100 Hz @ 8 kHz */
+
+  float w_ref[2] = {0.0f, 0.0f};
+  float w_dsp[2] = {0.0f, 0.0f};
+  uint32_t t0 = audio_dsp_ticks();
+  audio_dsp_ref_biquad_f32(x, y_ref, AUDIO_DSP_TEST_LEN, coef, w_ref);
+  uint32_t t1 = audio_dsp_ticks();
+  audio_dsp_biquad_f32(x, y_dsp, AUDIO_DSP_TEST_LEN, coef, w_dsp);
+  uint32_t t2 = audio_dsp_ticks();
+  r.ref_ticks[0] = t1 - t0;
+  r.dsp_ticks[0] = t2 - t1;
+
+  for (size_t i = 0; i < AUDIO_DSP_TEST_LEN; i++) {
+    const float err = fabsf(y_dsp[i] - y_ref[i]);
+    if (err > r.biquad_max_err) {
+      r.biquad_max_err = err;
+    }
+  }
+
+  t0 = audio_dsp_ticks();
+  const float e_ref = audio_dsp_ref_energy_f32(y_ref, AUDIO_DSP_TEST_LEN);
+  t1 = audio_dsp_ticks();
+  const float e_dsp = audio_dsp_energy_f32(y_ref, AUDIO_DSP_TEST_LEN);
+  t2 = audio_dsp_ticks();
+  r.ref_ticks[1] = t1 - t0;
+  r.dsp_ticks[1] = t2 - t1;
+  r.energy_rel_err = (e_ref > 0.0f) ? fabsf(e_dsp - e_ref) / e_ref : 0.0f;
+
+  free(x);
+
+  r.ok = r.biquad_max_err <= AUDIO_DSP_TEST_MAX_ERR &&
+         r.energy_rel_err <= AUDIO_DSP_TEST_MAX_REL;
+  if (report) {
+    *report = r;
+  }
+  return r.ok;
+}
@@ -0,0 +1,196 @@
+#include "audio_pool.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "audio_pool";
+
+static audio_seg_t *s_segs;      /* descriptors, internal RAM */
+static audio_seg_t *s_free;      /* free list, linked through next */
+static size_t s_seg_bytes;
+static size_t s_seg_total;
+static size_t s_free_count;
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t audio_pool_init(size_t seg_bytes, size_t seg_count) {
+  if (s_segs) {
+    return ESP_OK;
+  }
+  if (seg_bytes == 0 || seg_count == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  s_segs = heap_caps_calloc(seg_count, sizeof(audio_seg_t),
+                            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!s_segs) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  size_t allocated = 0;
+  for (size_t i = 0; i < seg_count; i++) {
+    uint8_t *data =
+        heap_caps_malloc(seg_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!data) {
+      break;
+    }
+    s_segs[i].data = data;
+    s_segs[i].next = s_free;
+    s_free = &s_segs[i];
+    allocated++;
+  }
+
+  if (allocated == 0) {
+    heap_caps_free(s_segs);
+    s_segs = NULL;
+    ESP_LOGE(TAG, "no PSRAM for audio segments");
+    return ESP_ERR_NO_MEM;
+  }
+  if (allocated < seg_count) {
+    ESP_LOGW(TAG, "only %u of %u segments allocated", (unsigned)allocated,
+             (unsigned)seg_count);
+  }
+
+  s_seg_bytes = seg_bytes;
+  s_seg_total = allocated;
+  s_free_count = allocated;
+  ESP_LOGI(TAG, "%u x %u KB segments (%u KB, %.1f s @ 8 kHz)",
+           (unsigned)allocated, (unsigned)(seg_bytes / 1024),
+           (unsigned)((allocated * seg_bytes) / 1024),
+           (double)(allocated * seg_bytes) / (8000.0 * 2.0));
+  return ESP_OK;
+}
+
+size_t audio_pool_seg_bytes(void) { return s_seg_bytes; }
+
+size_t audio_pool_total_segments(void) { return s_seg_total; }
+
+size_t audio_pool_free_segments(void) {
+  taskENTER_CRITICAL(&s_pool_lock);
+  const size_t n = s_free_count;
+  taskEXIT_CRITICAL(&s_pool_lock);
+  return n;
+}
+
+void audio_chain_init(audio_chain_t *chain) {
+  if (chain) {
+    memset(chain, 0, sizeof(*chain));
+  }
+}
+
+uint8_t *audio_chain_reserve(audio_chain_t *chain, size_t *room) {
+  if (!chain || !room) {
+    return NULL;
+  }
+  if (chain->tail && chain->tail_used < s_seg_bytes) {
+    *room = s_seg_bytes - chain->tail_used;
+    return chain->tail->data + chain->tail_used;
+  }
+
+  taskENTER_CRITICAL(&s_pool_lock);
+  audio_seg_t *seg = s_free;
+  if (seg) {
+    s_free = seg->next;
+    s_free_count--;
+  }
+  taskEXIT_CRITICAL(&s_pool_lock);
+  if (!seg) {
+    *room = 0;
+    return NULL;
+  }
+
+  seg->next = NULL;
+  if (chain->tail) {
+    chain->tail->next = seg;
+  } else {
+    chain->head = seg;
+  }
+  chain->tail = seg;
+  chain->tail_used = 0;
+  chain->count++;
+  *room = s_seg_bytes;
+  return seg->data;
+}
+
+void audio_chain_commit(audio_chain_t *chain, size_t bytes) {
+  if (!chain || !chain->tail) {
+    return;
+  }
+  if (bytes > s_seg_bytes - chain->tail_used) {
+    bytes = s_seg_bytes - chain->tail_used;
+  }
+  chain->tail_used += bytes;
+  chain->len += bytes;
+}
+
+void audio_chain_release(audio_chain_t *chain) {
+  if (!chain || !chain->head) {
+    audio_chain_init(chain);
+    return;
+  }
+  taskENTER_CRITICAL(&s_pool_lock);
+  chain->tail->next = s_free;
+  s_free = chain->head;
+  s_free_count += chain->count;
+  taskEXIT_CRITICAL(&s_pool_lock);
+  audio_chain_init(chain);
+}
+
+void audio_chain_iter_init(audio_chain_iter_t *it, const audio_chain_t *chain,
+                           size_t offset, size_t len) {
+  memset(it, 0, sizeof(*it));
+  if (!chain || offset >= chain->len) {
+    return;
+  }
+  if (len > chain->len - offset) {
+    len = chain->len - offset;
+  }
+  const audio_seg_t *seg = chain->head;
+  while (offset >= s_seg_bytes) {
+    seg = seg->next;
+    offset -= s_seg_bytes;
+  }
+  it->seg = seg;
+  it->seg_off = offset;
+  it->remaining = len;
+}
+
+bool audio_chain_iter_next(audio_chain_iter_t *it, const uint8_t **data,
+                           size_t *len) {
+  if (!it->seg || it->remaining == 0) {
+    return false;
+  }
+  if (it->seg_off == s_seg_bytes) {
+    it->seg = it->seg->next;
+    it->seg_off = 0;
+    if (!it->seg) {
+      return false;
+    }
+  }
+  size_t n = s_seg_bytes - it->seg_off;
+  if (n > it->remaining) {
+    n = it->remaining;
+  }
+  *data = it->seg->data + it->seg_off;
+  *len = n;
+  it->seg_off += n;
+  it->remaining -= n;
+  return true;
+}
+
+size_t audio_chain_read(const audio_chain_t *chain, size_t offset, void *dst,
+                        size_t len) {
+  audio_chain_iter_t it;
+  audio_chain_iter_init(&it, chain, offset, len);
+  uint8_t *out = (uint8_t *)dst;
+  size_t copied = 0;
+  const uint8_t *piece;
+  size_t piece_len;
+  while (audio_chain_iter_next(&it, &piece, &piece_len)) {
+    memcpy(out + copied, piece, piece_len);
+    copied += piece_len;
+  }
+  return copied;
+}
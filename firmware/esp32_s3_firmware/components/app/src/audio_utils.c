@@ -1,30 +1,34 @@
 #include "audio_utils.h"
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 float audio_calculate_rms(const int16_t *samples, size_t count) {
   if (count == 0)
     return 0.0f;
 
-  // First pass: calculate mean for DC offset removal
-  double sum = 0;
+  // Single pass in exact integer sums; the DC offset is removed as
+  // variance = E[x^2] - E[x]^2.
+  int64_t sum = 0;
+  uint64_t sum_sq = 0;
   for (size_t i = 0; i < count; i++) {
-    sum += (double)samples[i];
+    const int32_t s = samples[i];
+    sum += s;
+    sum_sq += (uint64_t)(s * s);
   }
-  double mean = sum / (double)count;
-
-  // Second pass: sum squares relative to mean (variance)
-  double sum_sq = 0;
-  for (size_t i = 0; i < count; i++) {
-    double s = (double)samples[i] - mean;
-    sum_sq += s * s;
+  const double n = (double)count;
+  const double mean = (double)sum / n;
+  double var = (double)sum_sq / n - mean * mean;
+  if (var < 0.0) {
+    var = 0.0;
   }
 
-  return (float)sqrt(sum_sq / (double)count);
+  return (float)sqrt(var);
 }
 
-void audio_apply_highpass(int16_t *samples, size_t count, float fc_hz,
-                          float fs_hz) {
-  if (!samples || count == 0 || fc_hz <= 0.0f || fs_hz <= 0.0f) {
+void audio_highpass_init(audio_highpass_state_t *state, float fc_hz,
+                         float fs_hz) {
+  if (!state) {
     return;
   }
 
@@ -38,24 +42,296 @@ void audio_apply_highpass(int16_t *samples, size_t count, float fc_hz,
    */
   const float dt = 1.0f / fs_hz;
   const float rc = 1.0f / (2.0f * (float)M_PI * fc_hz);
-  const float alpha = rc / (rc + dt);
+  state->alpha = rc / (rc + dt);
+  state->prev_x = 0.0f;
+  state->prev_y = 0.0f;
+  state->primed = false;
+}
+
+/* One step of the recursion, shared with the capture front-end so both
+ * paths round identically. The clamped output is fed back. */
+static inline float audio_highpass_step(float alpha, float x, float *prev_x,
+                                        float *prev_y) {
+  float y = alpha * (*prev_y + x - *prev_x);
+
+  /* Clamp to int16 range */
+  if (y > 32767.0f) {
+    y = 32767.0f;
+  } else if (y < -32768.0f) {
+    y = -32768.0f;
+  }
+
+  *prev_x = x;
+  *prev_y = y;
+  return y;
+}
+
+void audio_highpass_process(audio_highpass_state_t *state, int16_t *samples,
+                            size_t count) {
+  if (!state || !samples || count == 0) {
+    return;
+  }
+
+  size_t i = 0;
+  if (!state->primed) {
+    /* First sample passes through and seeds the filter history */
+    state->prev_x = (float)samples[0];
+    state->prev_y = (float)samples[0];
+    state->primed = true;
+    i = 1;
+  }
+
+  const float alpha = state->alpha;
+  float prev_x = state->prev_x;
+  float prev_y = state->prev_y;
+
+  for (; i < count; i++) {
+    samples[i] = (int16_t)audio_highpass_step(alpha, (float)samples[i],
+                                              &prev_x, &prev_y);
+  }
+
+  state->prev_x = prev_x;
+  state->prev_y = prev_y;
+}
+
+void audio_apply_highpass(int16_t *samples, size_t count, float fc_hz,
+                          float fs_hz) {
+  if (!samples || count == 0 || fc_hz <= 0.0f || fs_hz <= 0.0f) {
+    return;
+  }
+
+  audio_highpass_state_t state;
+  audio_highpass_init(&state, fc_hz, fs_hz);
+  audio_highpass_process(&state, samples, count);
+}
+
+/* -----------------------------------------------------------------------
+ * Capture front-end
+ *
+ * Decode, high-pass and level metering fused in one pass over each DMA
+ * chunk. The filter runs the exact recursion of audio_highpass_process()
+ * (clamped output fed back), so the samples match the unfused path bit for
+ * bit, and the window statistics are integer sums over the output (why
+ * this is not built on the audio_dsp block kernels: see audio_dsp.h).
+ * ----------------------------------------------------------------------- */
+
+void audio_frontend_init(audio_frontend_t *fe, float fc_hz, float fs_hz) {
+  if (!fe) {
+    return;
+  }
+  memset(fe, 0, sizeof(*fe));
+  audio_highpass_init(&fe->hpf, fc_hz, fs_hz);
+}
+
+void audio_frontend_window_reset(audio_frontend_t *fe) {
+  if (fe) {
+    memset(&fe->window, 0, sizeof(fe->window));
+  }
+}
+
+/* INMP441: 24-bit samples in 32-bit slots; >>15 and louder of L/R, as in
+ * the BSP. */
+static inline int16_t audio_i2s_decode(const int32_t *frame) {
+  const int32_t l = frame[0] >> 15;
+  const int32_t r = frame[1] >> 15;
+  int32_t s = (abs(l) >= abs(r)) ? l : r;
+  if (s > INT16_MAX) {
+    s = INT16_MAX;
+  } else if (s < INT16_MIN) {
+    s = INT16_MIN;
+  }
+  return (int16_t)s;
+}
+
+static void audio_window_add(audio_window_stats_t *w, int16_t *last,
+                             int16_t y) {
+  const int32_t v = y;
+  w->sum_sq += v * v;
+  const int32_t mag = (v < 0) ? -v : v;
+  if (mag > w->peak) {
+    w->peak = mag;
+  }
+  /* branchless: the sign of background noise flips almost every sample */
+  w->crossings += ((*last < 0) != (y < 0));
+  *last = y;
+}
+
+void audio_frontend_decode(const int32_t *raw, size_t frames, int16_t *out,
+                           void *ctx) {
+  audio_frontend_t *fe = (audio_frontend_t *)ctx;
+  if (!fe || !raw || !out || frames == 0) {
+    return;
+  }
+
+  audio_highpass_state_t *hpf = &fe->hpf;
+  const float alpha = hpf->alpha;
+  float prev_x = hpf->prev_x;
+  float prev_y = hpf->prev_y;
+  audio_window_stats_t w = fe->window;
+  int16_t last = fe->last;
+  size_t i = 0;
+
+  if (!hpf->primed) {
+    /* First sample passes through and seeds the filter history */
+    const int16_t s = audio_i2s_decode(raw);
+    prev_x = (float)s;
+    prev_y = (float)s;
+    hpf->primed = true;
+    out[0] = s;
+    audio_window_add(&w, &last, s);
+    i = 1;
+  }
+  for (; i < frames; i++) {
+    const float x = (float)audio_i2s_decode(raw + 2 * i);
+    const int16_t y = (int16_t)audio_highpass_step(alpha, x, &prev_x, &prev_y);
+    out[i] = y;
+    audio_window_add(&w, &last, y);
+  }
+  w.count += (uint32_t)frames;
+  fe->window = w;
+
+  hpf->prev_x = prev_x;
+  hpf->prev_y = prev_y;
+  fe->last = last;
+}
+
+float audio_window_rms(const audio_window_stats_t *stats) {
+  if (!stats || stats->count == 0) {
+    return 0.0f;
+  }
+  return sqrtf((float)stats->sum_sq / (float)stats->count);
+}
+
+/* -----------------------------------------------------------------------
+ * Voice activity detection
+ *
+ * A window is voiced when its energy is well above the noise floor, or
+ * above it by a smaller margin with a high zero-crossing rate (low-energy
+ * fricatives such as "s" and "f"). The floor falls fast and rises slowly on
+ * silent windows; on voiced windows it rises very slowly, so a constant
+ * noise that starts mid-recording cannot keep the detector in "speech".
+ * ----------------------------------------------------------------------- */
 
-  float prev_x = (float)samples[0];
-  float prev_y = (float)samples[0];
+#define AUDIO_VAD_MIN_FLOOR 40.0f       /* lowest floor (RMS)              */
+#define AUDIO_VAD_MAX_INIT_FLOOR 160.0f /* user already talking at start   */
+#define AUDIO_VAD_SPEECH_RATIO 3.0f     /* energy / floor for voiced       */
+#define AUDIO_VAD_FRIC_RATIO 1.8f       /* same, with a high ZCR           */
+#define AUDIO_VAD_FRIC_ZCR 0.25f        /* zero crossings per sample       */
+#define AUDIO_VAD_ONSET_WINDOWS 2
 
-  for (size_t i = 1; i < count; i++) {
-    float x = (float)samples[i];
-    float y = alpha * (prev_y + x - prev_x);
+void audio_vad_init(audio_vad_t *vad, const audio_vad_cfg_t *cfg) {
+  if (!vad || !cfg) {
+    return;
+  }
+  memset(vad, 0, sizeof(*vad));
+  vad->cfg = *cfg;
+  vad->noise_floor = AUDIO_VAD_MIN_FLOOR;
+}
+
+static size_t audio_vad_ms_to_samples(const audio_vad_t *vad, uint32_t ms) {
+  return (size_t)(((uint64_t)ms * vad->cfg.sample_rate_hz) / 1000U);
+}
+
+bool audio_vad_process(audio_vad_t *vad, const int16_t *samples, size_t count) {
+  if (!vad || !samples || count == 0) {
+    return false;
+  }
+
+  audio_window_stats_t stats = {0};
+  int16_t last = samples[0];
+  for (size_t i = 0; i < count; i++) {
+    audio_window_add(&stats, &last, samples[i]);
+  }
+  stats.count = (uint32_t)count;
+  return audio_vad_process_stats(vad, &stats, count);
+}
 
-    /* Clamp to int16 range */
-    if (y > 32767.0f) {
-      y = 32767.0f;
-    } else if (y < -32768.0f) {
-      y = -32768.0f;
+bool audio_vad_process_stats(audio_vad_t *vad,
+                             const audio_window_stats_t *stats, size_t count) {
+  if (!vad || !stats || count == 0) {
+    return false;
+  }
+
+  /* Input is already high-passed: no DC offset to remove. */
+  const float rms = audio_window_rms(stats);
+  const float zcr =
+      stats->count ? (float)stats->crossings / (float)stats->count : 0.0f;
+
+  if (!vad->primed) {
+    float floor = rms;
+    if (floor > AUDIO_VAD_MAX_INIT_FLOOR) {
+      floor = AUDIO_VAD_MAX_INIT_FLOOR;
+    }
+    vad->noise_floor =
+        (floor < AUDIO_VAD_MIN_FLOOR) ? AUDIO_VAD_MIN_FLOOR : floor;
+    vad->primed = true;
+  }
+
+  const float floor = vad->noise_floor;
+  const bool voiced =
+      (rms > floor * AUDIO_VAD_SPEECH_RATIO) ||
+      (rms > floor * AUDIO_VAD_FRIC_RATIO && zcr > AUDIO_VAD_FRIC_ZCR);
+
+  /* Adaptive noise floor */
+  float next;
+  if (rms < floor) {
+    next = floor + (rms - floor) * 0.5f;
+  } else if (!voiced) {
+    next = floor + (rms - floor) * 0.1f;
+  } else {
+    next = floor * 1.01f; /* ~x2.7 per 10 s of continuous voicing */
+  }
+  vad->noise_floor = (next < AUDIO_VAD_MIN_FLOOR) ? AUDIO_VAD_MIN_FLOOR : next;
+
+  const size_t win_start = vad->pos;
+  vad->pos += count;
+
+  if (!voiced) {
+    vad->voiced_run = 0;
+    return false;
+  }
+
+  if (vad->voiced_run == 0) {
+    vad->run_start = win_start;
+  }
+  if (vad->voiced_run < UINT8_MAX) {
+    vad->voiced_run++;
+  }
+  if (vad->voiced_run >= AUDIO_VAD_ONSET_WINDOWS) {
+    if (!vad->speech) {
+      vad->speech = true;
+      vad->speech_start = vad->run_start;
     }
+    vad->speech_end = vad->pos;
+  }
+  return true;
+}
 
-    samples[i] = (int16_t)y;
-    prev_x = x;
-    prev_y = y;
+bool audio_vad_endpoint(const audio_vad_t *vad) {
+  if (!vad || !vad->speech || vad->cfg.silence_ms == 0) {
+    return false;
+  }
+  return (vad->pos - vad->speech_end) >=
+         audio_vad_ms_to_samples(vad, vad->cfg.silence_ms);
+}
+
+bool audio_vad_get_segment(const audio_vad_t *vad, size_t *start_sample,
+                           size_t *end_sample) {
+  if (!vad || !vad->speech) {
+    return false;
+  }
+  const size_t pre = audio_vad_ms_to_samples(vad, vad->cfg.pre_margin_ms);
+  const size_t post = audio_vad_ms_to_samples(vad, vad->cfg.post_margin_ms);
+  size_t start = (vad->speech_start > pre) ? vad->speech_start - pre : 0;
+  size_t end = vad->speech_end + post;
+  if (end > vad->pos) {
+    end = vad->pos;
+  }
+  if (start_sample) {
+    *start_sample = start;
+  }
+  if (end_sample) {
+    *end_sample = end;
   }
+  return true;
 }
@@ -29,6 +29,8 @@ static app_config_t s_config = {
     .ai_base_url    = "https://api.openai.com/v1/chat/completions",
     .ai_model       = "gpt-4o",
     .expert_profile = 0,
+    .ai_pipelined_upload = false,
+    .ai_audio_format = "wav",
 
     .num_profiles = 3,
     .profiles = {
@@ -59,6 +61,13 @@ static app_config_t s_config = {
         },
     },
 
+    .audio_vad            = true,
+    .audio_vad_silence_ms = 1200,
+    .audio_preroll_ms     = 400,
+    .audio_dsp_bench      = false,
+
+    .storage_bench = false,
+
     .volume     = 70,
     .brightness = 85,
     .loaded     = false,
@@ -93,11 +102,11 @@ esp_err_t config_manager_load(void) {
   app_storage_ensure_mounted();
 
   /* Protege barramento SPI */
-  bsp_lvgl_lock(-1);
+  bsp_spi_bus_acquire(-1);
 
   struct stat st = {0};
   if (stat(SETTINGS_PATH, &st) != 0) {
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     ESP_LOGW(TAG, "config.txt not found (%s) — using fallback values", SETTINGS_PATH);
     if (s_config.ai_personality[0] == '\0') {
       strlcpy(s_config.ai_personality, s_default_personality,
@@ -107,7 +116,7 @@ esp_err_t config_manager_load(void) {
   }
 
   if (st.st_size == 0 || st.st_size > JSON_READ_BUF_CAP) {
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     ESP_LOGW(TAG, "config.txt has unexpected size %ld — skipping", (long)st.st_size);
     return ESP_ERR_INVALID_SIZE;
   }
@@ -117,14 +126,14 @@ esp_err_t config_manager_load(void) {
                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
   if (!buf) buf = (char *)malloc(JSON_READ_BUF_CAP);
   if (!buf) {
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     ESP_LOGE(TAG, "Failed to allocate JSON read buffer");
     return ESP_ERR_NO_MEM;
   }
 
   FILE *f = fopen(SETTINGS_PATH, "r");
   if (!f) {
-    bsp_lvgl_unlock();
+    bsp_spi_bus_release();
     free(buf);
     ESP_LOGE(TAG, "fopen failed: %s (errno %d)", SETTINGS_PATH, errno);
     return ESP_FAIL;
@@ -132,7 +141,7 @@ esp_err_t config_manager_load(void) {
 
   size_t read_len = fread(buf, 1, JSON_READ_BUF_CAP - 1, f);
   fclose(f);
-  bsp_lvgl_unlock();
+  bsp_spi_bus_release();
   buf[read_len] = '\0';
 
   if (read_len == 0) {
@@ -187,6 +196,24 @@ esp_err_t config_manager_load(void) {
       strlcpy(s_config.ai_model, model->valuestring, sizeof(s_config.ai_model));
     }
 
+    /* pipelined_upload: exige gateway que aceite WAV de tamanho indefinido
+     * e corpo HTTP chunked (padrão: desligado) */
+    const cJSON *pipelined =
+        cJSON_GetObjectItemCaseSensitive(ai, "pipelined_upload");
+    if (cJSON_IsBool(pipelined)) {
+      s_config.ai_pipelined_upload = cJSON_IsTrue(pipelined);
+    }
+
+    /* audio_format: "wav" (PCM), "adpcm" (IMA-ADPCM em WAV) ou "flac";
+     * depende do que o endpoint aceita */
+    const cJSON *audio_fmt =
+        cJSON_GetObjectItemCaseSensitive(ai, "audio_format");
+    if (cJSON_IsString(audio_fmt) && audio_fmt->valuestring &&
+        audio_fmt->valuestring[0]) {
+      strlcpy(s_config.ai_audio_format, audio_fmt->valuestring,
+              sizeof(s_config.ai_audio_format));
+    }
+
     /* -------------------------------------------------------------------
      * Perfis: suporta novo formato (array) E formato legado (objeto nomeado)
      * ------------------------------------------------------------------- */
@@ -248,6 +275,43 @@ esp_err_t config_manager_load(void) {
     }
   }
 
+  /* audio: deteccao de voz (fim automatico da gravacao e corte de
+   * silencio antes do upload), pre-roll do microfone e "dsp_bench", que
+   * confere e mede os kernels de DSP no boot */
+  const cJSON *audio = cJSON_GetObjectItemCaseSensitive(root, "audio");
+  if (audio) {
+    const cJSON *vad = cJSON_GetObjectItemCaseSensitive(audio, "vad");
+    if (cJSON_IsBool(vad)) {
+      s_config.audio_vad = cJSON_IsTrue(vad);
+    }
+    const cJSON *silence =
+        cJSON_GetObjectItemCaseSensitive(audio, "vad_silence_ms");
+    if (cJSON_IsNumber(silence) && silence->valueint >= 0 &&
+        silence->valueint <= 10000) {
+      s_config.audio_vad_silence_ms = (uint16_t)silence->valueint;
+    }
+    const cJSON *preroll =
+        cJSON_GetObjectItemCaseSensitive(audio, "preroll_ms");
+    if (cJSON_IsNumber(preroll) && preroll->valueint >= 0 &&
+        preroll->valueint <= BSP_AUDIO_PREROLL_MAX_MS) {
+      s_config.audio_preroll_ms = (uint16_t)preroll->valueint;
+    }
+    const cJSON *dsp_bench =
+        cJSON_GetObjectItemCaseSensitive(audio, "dsp_bench");
+    if (cJSON_IsBool(dsp_bench)) {
+      s_config.audio_dsp_bench = cJSON_IsTrue(dsp_bench);
+    }
+  }
+
+  /* storage: "bench" recalibra o clock SPI do SD e reporta KB/s no boot */
+  const cJSON *storage = cJSON_GetObjectItemCaseSensitive(root, "storage");
+  if (storage) {
+    const cJSON *bench = cJSON_GetObjectItemCaseSensitive(storage, "bench");
+    if (cJSON_IsBool(bench)) {
+      s_config.storage_bench = cJSON_IsTrue(bench);
+    }
+  }
+
   /* hardware */
   const cJSON *hw = cJSON_GetObjectItemCaseSensitive(root, "hardware");
   if (hw) {
@@ -293,6 +357,8 @@ esp_err_t config_manager_save(void) {
   cJSON_AddStringToObject(ai, "base_url",     s_config.ai_base_url);
   cJSON_AddStringToObject(ai, "model",        s_config.ai_model);
   cJSON_AddNumberToObject(ai, "expert_profile", (int)s_config.expert_profile);
+  cJSON_AddBoolToObject(ai, "pipelined_upload", s_config.ai_pipelined_upload);
+  cJSON_AddStringToObject(ai, "audio_format", s_config.ai_audio_format);
 
   /* profiles — novo formato: array */
   cJSON *profiles = cJSON_CreateArray();
@@ -306,6 +372,20 @@ esp_err_t config_manager_save(void) {
   cJSON_AddItemToObject(ai, "profiles", profiles);
   cJSON_AddItemToObject(root, "ai", ai);
 
+  /* audio */
+  cJSON *audio = cJSON_CreateObject();
+  cJSON_AddBoolToObject(audio, "vad", s_config.audio_vad);
+  cJSON_AddNumberToObject(audio, "vad_silence_ms",
+                          s_config.audio_vad_silence_ms);
+  cJSON_AddNumberToObject(audio, "preroll_ms", s_config.audio_preroll_ms);
+  cJSON_AddBoolToObject(audio, "dsp_bench", s_config.audio_dsp_bench);
+  cJSON_AddItemToObject(root, "audio", audio);
+
+  /* storage */
+  cJSON *storage = cJSON_CreateObject();
+  cJSON_AddBoolToObject(storage, "bench", s_config.storage_bench);
+  cJSON_AddItemToObject(root, "storage", storage);
+
   /* hardware */
   cJSON *hw = cJSON_CreateObject();
   cJSON_AddNumberToObject(hw, "volume",     s_config.volume);
@@ -320,13 +400,15 @@ esp_err_t config_manager_save(void) {
     return ESP_ERR_NO_MEM;
   }
 
-  /* Protect SPI bus shared with LCD */
-  bsp_lvgl_lock(-1);
+  /* Barramento SPI compartilhado com o LCD: tomado por operacao, os dados
+   * em fatias */
+  (void)bsp_ui_stall_take_max_us();
+  bsp_spi_bus_acquire(-1);
   ESP_LOGI(TAG, "Opening config file for writing: %s", SETTINGS_PATH);
   FILE *f = fopen(SETTINGS_PATH, "w");
+  bsp_spi_bus_release();
   if (!f) {
     int err = errno;
-    bsp_lvgl_unlock();
     cJSON_free(json_str);
     ESP_LOGE(TAG, "fopen(%s, w) failed (errno %d: %s)", SETTINGS_PATH, err,
              strerror(err));
@@ -334,13 +416,15 @@ esp_err_t config_manager_save(void) {
   }
 
   size_t json_len = strlen(json_str);
-  size_t written  = fwrite(json_str, 1, json_len, f);
+  size_t written  = bsp_sdcard_fwrite(json_str, json_len, f);
 
+  bsp_spi_bus_acquire(-1);
   fflush(f);
   int fd = fileno(f);
   if (fd >= 0) fsync(fd);
   fclose(f);
-  bsp_lvgl_unlock();
+  bsp_spi_bus_release();
+  const uint32_t ui_stall_us = bsp_ui_stall_take_max_us();
   cJSON_free(json_str);
 
   if (written != json_len) {
@@ -349,8 +433,9 @@ esp_err_t config_manager_save(void) {
     return ESP_FAIL;
   }
 
-  ESP_LOGI(TAG, "Config saved to %s (%u bytes, %d perfis)",
-           SETTINGS_PATH, (unsigned)json_len, s_config.num_profiles);
+  ESP_LOGI(TAG, "Config saved to %s (%u bytes, %d perfis, UI stall max %u ms)",
+           SETTINGS_PATH, (unsigned)json_len, s_config.num_profiles,
+           (unsigned)(ui_stall_us / 1000));
   return ESP_OK;
 }
 
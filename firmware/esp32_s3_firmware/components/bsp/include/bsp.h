@@ -3,14 +3,27 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "esp_err.h"
 
+/**
+ * @brief Raw-frame decoder: converts @p frames stereo 32-bit I2S frames
+ *        (L, R interleaved) into @p frames mono PCM16 samples at @p out.
+ *        Called once per contiguous block of raw frames (DMA chunk or ring
+ *        span), so filtering and level metering can be fused into the same
+ *        pass.
+ */
+typedef void (*bsp_audio_decode_fn_t)(const int32_t *raw, size_t frames,
+                                      int16_t *out, void *ctx);
+
 typedef struct {
   uint32_t sample_rate_hz;
   uint8_t bits_per_sample;
   uint8_t channels;
   uint16_t capture_ms;
+  bsp_audio_decode_fn_t decode; /* NULL: built-in >>15, louder of L/R */
+  void *decode_ctx;
 } bsp_audio_capture_cfg_t;
 
 esp_err_t bsp_init(void);
@@ -28,6 +41,95 @@ esp_err_t bsp_audio_capture_blocking(const bsp_audio_capture_cfg_t *cfg,
                                      uint8_t *buffer, size_t buffer_len,
                                      size_t *captured_bytes);
 
+/* Audio stream ------------------------------------------------------------ */
+
+/** @brief Counters of one audio stream (bsp_audio_stream_start..stop). */
+typedef struct {
+  uint32_t frames;         /* frames written to the ring                  */
+  uint32_t preroll_frames; /* buffered frames delivered from before start */
+  uint32_t overruns;       /* DMA reads dropped because the ring was full */
+  uint32_t dropped_frames; /* frames lost in those reads                  */
+  uint32_t dma_overflows;  /* I2S DMA queue overflows (task too slow)     */
+  uint32_t i2s_timeouts;   /* reads that returned no data                 */
+  uint32_t high_water;     /* highest ring fill, frames                   */
+  uint32_t capacity;       /* ring size, frames                           */
+} bsp_audio_stream_stats_t;
+
+/** @brief Upper bound for bsp_audio_preroll_set(). */
+#define BSP_AUDIO_PREROLL_MAX_MS 750
+
+/**
+ * @brief Keep the last @p preroll_ms of microphone audio buffered while no
+ *        stream is open, so the next stream starts that far in the past.
+ *
+ * Non-zero keeps the capture task running between streams (rolling buffer
+ * in the stream ring); 0 stops it, e.g. while preparing deep sleep. Call
+ * from the same task as the stream functions.
+ */
+esp_err_t bsp_audio_preroll_set(uint32_t preroll_ms);
+
+/**
+ * @brief Start continuous capture: a high-priority task drains the I2S DMA
+ *        into a ~1 s lock-free ring until bsp_audio_stream_stop().
+ *
+ * The first samples read are the buffered pre-roll, if any (see
+ * bsp_audio_preroll_set). Only cfg->decode / cfg->decode_ctx are used (NULL
+ * cfg or decode: built-in >>15, louder of L/R). The hook runs in
+ * bsp_audio_stream_read(), in the reader's context. The ring is allocated
+ * on the first call and kept.
+ */
+esp_err_t bsp_audio_stream_start(const bsp_audio_capture_cfg_t *cfg);
+
+/**
+ * @brief Decode up to @p max_samples mono PCM16 samples from the ring,
+ *        waiting at most @p timeout_ms for them. Single reader only.
+ *
+ * @param[out] samples Samples written to @p out (may be short on timeout).
+ * @return ESP_OK if any sample was read, ESP_ERR_TIMEOUT if none.
+ */
+esp_err_t bsp_audio_stream_read(int16_t *out, size_t max_samples,
+                                size_t *samples, uint32_t timeout_ms);
+
+/** @brief Snapshot of the counters of the running (or last) stream. */
+void bsp_audio_stream_get_stats(bsp_audio_stream_stats_t *stats);
+
+/**
+ * @brief Close the stream and log its counters. The capture task keeps
+ *        running only if a pre-roll is configured.
+ * @param[out] stats Final counters (optional).
+ */
+esp_err_t bsp_audio_stream_stop(bsp_audio_stream_stats_t *stats);
+
+/* Shared SPI bus (LCD + SD card) ----------------------------------------- */
+
+/** @brief Bytes written per bus hold by bsp_sdcard_fwrite(). */
+#define BSP_SD_WRITE_SLICE_BYTES (16 * 1024)
+
+/**
+ * @brief Take the SPI bus shared by the LCD and the SD card for one bounded
+ *        SD operation (fopen, fclose, one write slice).
+ *
+ * Display flushes go first: if the LVGL task is waiting for the bus, the
+ * caller yields to it before taking the bus. Uses the LVGL lock, so it nests
+ * with bsp_lvgl_lock().
+ */
+bool bsp_spi_bus_acquire(int timeout_ms);
+void bsp_spi_bus_release(void);
+
+/**
+ * @brief fwrite() in BSP_SD_WRITE_SLICE_BYTES slices, taking and releasing
+ *        the bus for each one so the display keeps refreshing during long
+ *        writes. Call without holding the bus.
+ * @return Bytes written.
+ */
+size_t bsp_sdcard_fwrite(const void *data, size_t len, FILE *f);
+
+/**
+ * @brief Longest time the LVGL task waited for the bus since the previous
+ *        call, in microseconds. Reading resets it.
+ */
+uint32_t bsp_ui_stall_take_max_us(void);
+
 /* SD Card ----------------------------------------------------------------- */
 /* SD SPI pins on the Waveshare ESP32-S3-Touch-LCD-2 */
 #define BSP_SD_MISO_GPIO 40
@@ -59,6 +161,38 @@ esp_err_t bsp_sdcard_mount(void);
 /** @brief Unmount the SD card and free the SPI slot. */
 esp_err_t bsp_sdcard_unmount(void);
 
+/* SD SPI clock ------------------------------------------------------------ */
+
+/** @brief Clocks tried by calibration, fastest first (kHz). */
+#define BSP_SD_FREQ_STEPS_KHZ {40000, 26000, 20000, 10000}
+#define BSP_SD_FREQ_STEP_COUNT 4
+/** @brief Clock used until a calibrated value is stored (kHz). */
+#define BSP_SD_FREQ_DEFAULT_KHZ 10000
+
+/** @brief SPI clock requested for the SD card (kHz). */
+uint32_t bsp_sdcard_get_freq_khz(void);
+
+/** @brief Clock the card actually runs at while mounted (kHz, 0 if not). */
+uint32_t bsp_sdcard_get_real_freq_khz(void);
+
+/** @brief True if a calibrated clock is stored in NVS. */
+bool bsp_sdcard_freq_is_calibrated(void);
+
+/**
+ * @brief Change the SD SPI clock, remounting the card if it is mounted.
+ * @param persist Store the value in NVS as the calibrated clock.
+ */
+esp_err_t bsp_sdcard_set_freq_khz(uint32_t freq_khz, bool persist);
+
+/**
+ * @brief Runtime fallback after an SD bus error (CRC, timeout): move to the
+ *        next slower clock step and remount.
+ * @param persist Store the new clock in NVS. Pass false to verify the card
+ *        at the new clock first, then persist with bsp_sdcard_set_freq_khz().
+ * @return ESP_ERR_NOT_FOUND if already at the slowest step.
+ */
+esp_err_t bsp_sdcard_freq_step_down(bool persist);
+
 /**
  * @brief Initialize the ADC for the Battery (ADC_UNIT_1, ADC_CHANNEL_4).
  */
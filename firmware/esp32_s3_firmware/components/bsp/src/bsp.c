@@ -29,6 +29,7 @@
 #include "freertos/task.h"
 #include "lvgl.h"
 #include "lwip/ip4_addr.h"
+#include "nvs.h"
 #include "sdmmc_cmd.h"
 
 static const char *TAG = "bsp";
@@ -72,6 +73,7 @@ static const char *TAG = "bsp";
 #define BSP_LVGL_TASK_MAX_DELAY_MS 500
 #define BSP_LVGL_TASK_STACK (6 * 1024)
 #define BSP_LVGL_TASK_PRIORITY 4
+#define BSP_SPI_YIELD_MAX_TICKS 2 /* bounded wait for a pending LVGL flush */
 
 static SemaphoreHandle_t s_lvgl_mutex;
 static lv_disp_drv_t s_disp_drv;
@@ -83,6 +85,8 @@ static int s_wifi_retry_num;
 static bool s_wifi_shutting_down = false;
 static esp_timer_handle_t s_lvgl_tick_timer = NULL;
 static TaskHandle_t s_lvgl_task_handle = NULL;
+static bool s_lvgl_waiting;       /* LVGL task blocked on the lock (atomic) */
+static uint32_t s_ui_stall_max_us; /* longest such wait (atomic) */
 
 #define BSP_WIFI_CONNECTED_BIT BIT0
 #define BSP_WIFI_FAIL_BIT BIT1
@@ -131,7 +135,20 @@ static void bsp_lvgl_task(void *arg) {
   while (1) {
     uint32_t task_delay_ms = BSP_LVGL_TASK_MAX_DELAY_MS;
 
-    if (bsp_lvgl_lock(-1)) {
+    /* Time spent waiting here is time the screen and touch are frozen. */
+    const int64_t wait_start = esp_timer_get_time();
+    __atomic_store_n(&s_lvgl_waiting, true, __ATOMIC_RELEASE);
+    const bool locked = bsp_lvgl_lock(-1);
+    __atomic_store_n(&s_lvgl_waiting, false, __ATOMIC_RELEASE);
+    if (locked) {
+      const uint32_t waited_us =
+          (uint32_t)(esp_timer_get_time() - wait_start);
+      uint32_t prev = __atomic_load_n(&s_ui_stall_max_us, __ATOMIC_RELAXED);
+      while (waited_us > prev &&
+             !__atomic_compare_exchange_n(&s_ui_stall_max_us, &prev,
+                                          waited_us, false, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED)) {
+      }
       task_delay_ms = lv_timer_handler();
       bsp_lvgl_unlock();
     }
@@ -343,6 +360,20 @@ static esp_err_t bsp_button_init(void) {
   return gpio_config(&io_conf);
 }
 
+/* I2S DMA queue overflows (nobody read in time); always counted, the audio
+ * stream reports the delta over its lifetime. */
+static uint32_t s_i2s_dma_ovf;
+
+static bool IRAM_ATTR bsp_i2s_recv_ovf_cb(i2s_chan_handle_t handle,
+                                          i2s_event_data_t *event,
+                                          void *user_ctx) {
+  (void)handle;
+  (void)event;
+  (void)user_ctx;
+  __atomic_fetch_add(&s_i2s_dma_ovf, 1, __ATOMIC_RELAXED);
+  return false;
+}
+
 static esp_err_t bsp_audio_init(void) {
   i2s_chan_config_t chan_cfg =
       I2S_CHANNEL_DEFAULT_CONFIG(BSP_I2S_PORT, I2S_ROLE_MASTER);
@@ -379,6 +410,13 @@ static esp_err_t bsp_audio_init(void) {
    * inactive channel slot */
   gpio_set_pull_mode(BSP_MIC_SD_GPIO, GPIO_PULLDOWN_ONLY);
 
+  const i2s_event_callbacks_t i2s_cbs = {
+      .on_recv_q_ovf = bsp_i2s_recv_ovf_cb,
+  };
+  ESP_RETURN_ON_ERROR(
+      i2s_channel_register_event_callback(s_i2s_rx_handle, &i2s_cbs, NULL),
+      TAG, "i2s callbacks");
+
   ESP_RETURN_ON_ERROR(i2s_channel_enable(s_i2s_rx_handle), TAG, "i2s enable");
   ESP_LOGI(TAG, "I2S mic init ok (BCLK=%d WS=%d SD=%d)", BSP_MIC_BCLK_GPIO,
            BSP_MIC_WS_GPIO, BSP_MIC_SD_GPIO);
@@ -526,6 +564,53 @@ void bsp_lvgl_unlock(void) {
   }
 }
 
+/* ===========================================================================
+ * Shared SPI bus arbitration
+ *
+ * The LCD and the SD card share SPI2_HOST and both go through the LVGL lock.
+ * SD users take it per bounded operation instead of across a whole file, so
+ * a long write delays a frame by at most one slice. A task at or above the
+ * LVGL task priority would retake the lock before LVGL runs; it yields first
+ * while LVGL is waiting.
+ * ===========================================================================
+ */
+bool bsp_spi_bus_acquire(int timeout_ms) {
+  for (int i = 0; i < BSP_SPI_YIELD_MAX_TICKS &&
+                  __atomic_load_n(&s_lvgl_waiting, __ATOMIC_ACQUIRE);
+       i++) {
+    vTaskDelay(1);
+  }
+  return bsp_lvgl_lock(timeout_ms);
+}
+
+void bsp_spi_bus_release(void) { bsp_lvgl_unlock(); }
+
+size_t bsp_sdcard_fwrite(const void *data, size_t len, FILE *f) {
+  const uint8_t *src = (const uint8_t *)data;
+  size_t done = 0;
+  while (done < len) {
+    size_t n = len - done;
+    if (n > BSP_SD_WRITE_SLICE_BYTES) {
+      n = BSP_SD_WRITE_SLICE_BYTES;
+    }
+    if (!bsp_spi_bus_acquire(-1)) {
+      break;
+    }
+    const size_t written = fwrite(src + done, 1, n, f);
+    fflush(f); /* push the slice to FATFS while the bus is held */
+    bsp_spi_bus_release();
+    done += written;
+    if (written != n) {
+      break;
+    }
+  }
+  return done;
+}
+
+uint32_t bsp_ui_stall_take_max_us(void) {
+  return __atomic_exchange_n(&s_ui_stall_max_us, 0, __ATOMIC_RELAXED);
+}
+
 esp_err_t bsp_display_show_status(const char *status_text) {
   ESP_LOGI(TAG, "[DISPLAY][STATUS] %s", status_text ? status_text : "(null)");
   return ESP_OK;
@@ -549,6 +634,26 @@ bool bsp_button_is_pressed(void) {
   return (raw_level == BSP_BUTTON_ACTIVE_LEVEL);
 }
 
+static void bsp_audio_decode_default(const int32_t *raw, size_t frames,
+                                     int16_t *out, void *ctx) {
+  (void)ctx;
+  for (size_t i = 0; i < frames; i++) {
+    /* INMP441 uses 24-bit samples in 32-bit slots.
+     * Shifting by 15 or 16 is typically used to get 16-bit PCM.
+     * 15-bit shift reduces clipping distortion compared to 14, keeping good
+     * volume. */
+    int32_t sample_l = raw[2 * i] >> 15;
+    int32_t sample_r = raw[2 * i + 1] >> 15;
+    int32_t sample = (abs(sample_l) >= abs(sample_r)) ? sample_l : sample_r;
+    if (sample > INT16_MAX) {
+      sample = INT16_MAX;
+    } else if (sample < INT16_MIN) {
+      sample = INT16_MIN;
+    }
+    out[i] = (int16_t)sample;
+  }
+}
+
 esp_err_t bsp_audio_capture_blocking(const bsp_audio_capture_cfg_t *cfg,
                                      uint8_t *buffer, size_t buffer_len,
                                      size_t *captured_bytes) {
@@ -621,24 +726,18 @@ esp_err_t bsp_audio_capture_blocking(const bsp_audio_capture_cfg_t *cfg,
       break;
     }
 
-    size_t raw_samples = bytes_read / sizeof(int32_t);
-    for (size_t i = 0;
-         (i + 1) < raw_samples && out_samples_written < total_out_samples;
-         i += 2) {
-      /* INMP441 uses 24-bit samples in 32-bit slots.
-       * Shifting by 15 or 16 is typically used to get 16-bit PCM.
-       * 15-bit shift reduces clipping distortion compared to 14, keeping good
-       * volume. */
-      int32_t sample_l = raw_chunk[i] >> 15;
-      int32_t sample_r = raw_chunk[i + 1] >> 15;
-      int32_t sample = (abs(sample_l) >= abs(sample_r)) ? sample_l : sample_r;
-      if (sample > INT16_MAX) {
-        sample = INT16_MAX;
-      } else if (sample < INT16_MIN) {
-        sample = INT16_MIN;
-      }
-      out[out_samples_written++] = (int16_t)sample;
+    size_t frames = bytes_read / (2 * sizeof(int32_t));
+    if (frames > total_out_samples - out_samples_written) {
+      frames = total_out_samples - out_samples_written;
     }
+    if (cfg->decode) {
+      cfg->decode(raw_chunk, frames, out + out_samples_written,
+                  cfg->decode_ctx);
+    } else {
+      bsp_audio_decode_default(raw_chunk, frames, out + out_samples_written,
+                               NULL);
+    }
+    out_samples_written += frames;
   }
 
   free(raw_chunk);
@@ -652,6 +751,326 @@ esp_err_t bsp_audio_capture_blocking(const bsp_audio_capture_cfg_t *cfg,
   return final_ret;
 }
 
+/* ===========================================================================
+ * Audio stream: capture task + SPSC ring
+ *
+ * A dedicated task drains the I2S DMA queue straight into a ring of raw
+ * 32-bit L/R frames in PSRAM (i2s_channel_read copies into the ring, no
+ * intermediate buffer), so the DMA never waits on the app task. The reader
+ * decodes while copying out of the ring with the caller's decode hook.
+ * head and tail are free-running frame counters; head is written only by
+ * the capture task. tail belongs to the reader while one is attached and
+ * to the capture task otherwise: with a pre-roll configured the task keeps
+ * running between streams and drops the oldest frames, so the ring always
+ * holds the last moments before the next bsp_audio_stream_start().
+ * ===========================================================================
+ */
+#define BSP_AUDIO_STREAM_RING_FRAMES 8192 /* power of two; ~1 s @ 8 kHz */
+#define BSP_AUDIO_STREAM_READ_FRAMES 512  /* one DMA buffer (dma_frame_num) */
+#define BSP_AUDIO_STREAM_READ_TIMEOUT_MS 200
+#define BSP_AUDIO_STREAM_TASK_STACK (3 * 1024)
+#define BSP_AUDIO_STREAM_TASK_PRIORITY 10
+#define BSP_AUDIO_STREAM_TASK_CORE 1
+#define BSP_AUDIO_STREAM_RATE_HZ 8000
+
+typedef struct {
+  int32_t *ring;    /* BSP_AUDIO_STREAM_RING_FRAMES L/R frames          */
+  int32_t *scratch; /* drain target while the ring is full               */
+  uint32_t head;    /* frames written (capture task)                     */
+  uint32_t tail;    /* frames consumed (owner: see above)                */
+  uint32_t attach;  /* reader request: pre-roll frames + 1, 0 = none     */
+  bool reading;     /* a reader is attached and owns tail                */
+  bool stop;
+  bool task_running;
+  uint32_t preroll_frames; /* kept while idle; 0 = task stops with reader */
+  uint32_t dma_ovf_start;
+  SemaphoreHandle_t data_sem;   /* given after every write              */
+  SemaphoreHandle_t attach_sem; /* given when the reader owns the ring  */
+  SemaphoreHandle_t done_sem;   /* given when the capture task exits    */
+  bsp_audio_decode_fn_t decode;
+  void *decode_ctx;
+  bsp_audio_stream_stats_t stats;
+} bsp_audio_stream_t;
+
+static bsp_audio_stream_t s_stream;
+
+/* Runs in the capture task: hand the ring to the reader, starting at most
+ * the requested pre-roll before the newest frame. */
+static void bsp_audio_stream_do_attach(uint32_t preroll) {
+  const uint32_t head = s_stream.head;
+  uint32_t tail = s_stream.tail;
+  if (head - tail > preroll) {
+    tail = head - preroll;
+  }
+
+  memset(&s_stream.stats, 0, sizeof(s_stream.stats));
+  s_stream.stats.capacity = BSP_AUDIO_STREAM_RING_FRAMES;
+  s_stream.stats.preroll_frames = head - tail;
+  s_stream.dma_ovf_start = __atomic_load_n(&s_i2s_dma_ovf, __ATOMIC_RELAXED);
+
+  __atomic_store_n(&s_stream.tail, tail, __ATOMIC_RELEASE);
+  __atomic_store_n(&s_stream.reading, true, __ATOMIC_RELEASE);
+  __atomic_store_n(&s_stream.attach, 0, __ATOMIC_RELEASE);
+  xSemaphoreGive(s_stream.attach_sem);
+}
+
+static void bsp_audio_stream_task(void *arg) {
+  (void)arg;
+  bsp_audio_stream_stats_t *st = &s_stream.stats;
+
+  while (!__atomic_load_n(&s_stream.stop, __ATOMIC_ACQUIRE)) {
+    const uint32_t attach = __atomic_load_n(&s_stream.attach, __ATOMIC_ACQUIRE);
+    if (attach) {
+      bsp_audio_stream_do_attach(attach - 1);
+    }
+    const bool reading = __atomic_load_n(&s_stream.reading, __ATOMIC_ACQUIRE);
+
+    const uint32_t head = s_stream.head;
+    uint32_t tail = __atomic_load_n(&s_stream.tail, __ATOMIC_ACQUIRE);
+    if (!reading &&
+        BSP_AUDIO_STREAM_RING_FRAMES - (head - tail) <
+            BSP_AUDIO_STREAM_READ_FRAMES) {
+      /* Idle: drop the oldest frames to make room (rolling pre-roll). */
+      tail = head - (BSP_AUDIO_STREAM_RING_FRAMES -
+                     BSP_AUDIO_STREAM_READ_FRAMES);
+      __atomic_store_n(&s_stream.tail, tail, __ATOMIC_RELEASE);
+    }
+    const uint32_t used = head - tail;
+    const uint32_t pos = head & (BSP_AUDIO_STREAM_RING_FRAMES - 1);
+
+    uint32_t span = BSP_AUDIO_STREAM_RING_FRAMES - pos; /* contiguous */
+    if (span > BSP_AUDIO_STREAM_RING_FRAMES - used) {
+      span = BSP_AUDIO_STREAM_RING_FRAMES - used;
+    }
+    if (span > BSP_AUDIO_STREAM_READ_FRAMES) {
+      span = BSP_AUDIO_STREAM_READ_FRAMES;
+    }
+
+    /* Ring full: keep draining the DMA into scratch and drop the data, so
+     * the loss is counted here instead of as a silent DMA overflow. */
+    int32_t *dst = span ? &s_stream.ring[2 * pos] : s_stream.scratch;
+    const uint32_t want = span ? span : BSP_AUDIO_STREAM_READ_FRAMES;
+
+    size_t bytes_read = 0;
+    esp_err_t err = i2s_channel_read(
+        s_i2s_rx_handle, dst, want * 2 * sizeof(int32_t), &bytes_read,
+        pdMS_TO_TICKS(BSP_AUDIO_STREAM_READ_TIMEOUT_MS));
+    if (err == ESP_ERR_TIMEOUT) {
+      if (reading && st->i2s_timeouts++ == 0) {
+        ESP_LOGW(TAG, "I2S stream timeout. Check SD/BCLK/WS wiring.");
+      }
+      continue;
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "I2S stream read failed: %s", esp_err_to_name(err));
+      vTaskDelay(pdMS_TO_TICKS(10));
+      continue;
+    }
+
+    const uint32_t frames = (uint32_t)(bytes_read / (2 * sizeof(int32_t)));
+    if (!span) {
+      st->overruns++;
+      st->dropped_frames += frames;
+      continue;
+    }
+    __atomic_store_n(&s_stream.head, head + frames, __ATOMIC_RELEASE);
+    if (reading) {
+      st->frames += frames;
+      if (used + frames > st->high_water) {
+        st->high_water = used + frames;
+      }
+      xSemaphoreGive(s_stream.data_sem);
+    }
+  }
+
+  xSemaphoreGive(s_stream.done_sem);
+  vTaskDelete(NULL);
+}
+
+static esp_err_t bsp_audio_stream_task_start(void) {
+  if (s_stream.task_running) {
+    return ESP_OK;
+  }
+  if (!s_i2s_rx_handle) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  /* Allocated on first use and kept: no allocation per stream or chunk. */
+  if (!s_stream.ring) {
+    const size_t ring_bytes =
+        BSP_AUDIO_STREAM_RING_FRAMES * 2 * sizeof(int32_t);
+    s_stream.ring =
+        heap_caps_malloc(ring_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s_stream.ring) {
+      s_stream.ring =
+          heap_caps_malloc(ring_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    s_stream.scratch =
+        heap_caps_malloc(BSP_AUDIO_STREAM_READ_FRAMES * 2 * sizeof(int32_t),
+                         MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    s_stream.data_sem = xSemaphoreCreateBinary();
+    s_stream.attach_sem = xSemaphoreCreateBinary();
+    s_stream.done_sem = xSemaphoreCreateBinary();
+    if (!s_stream.ring || !s_stream.scratch || !s_stream.data_sem ||
+        !s_stream.attach_sem || !s_stream.done_sem) {
+      ESP_LOGE(TAG, "no memory for audio stream ring");
+      return ESP_ERR_NO_MEM;
+    }
+  }
+
+  s_stream.head = 0;
+  s_stream.tail = 0;
+  s_stream.attach = 0;
+  s_stream.reading = false;
+  s_stream.stop = false;
+  xSemaphoreTake(s_stream.done_sem, 0);
+
+  if (xTaskCreatePinnedToCore(bsp_audio_stream_task, "audio_stream",
+                              BSP_AUDIO_STREAM_TASK_STACK, NULL,
+                              BSP_AUDIO_STREAM_TASK_PRIORITY, NULL,
+                              BSP_AUDIO_STREAM_TASK_CORE) != pdPASS) {
+    return ESP_ERR_NO_MEM;
+  }
+  s_stream.task_running = true;
+  return ESP_OK;
+}
+
+static esp_err_t bsp_audio_stream_task_stop(void) {
+  if (!s_stream.task_running) {
+    return ESP_OK;
+  }
+  __atomic_store_n(&s_stream.stop, true, __ATOMIC_RELEASE);
+  if (xSemaphoreTake(s_stream.done_sem,
+                     pdMS_TO_TICKS(2 * BSP_AUDIO_STREAM_READ_TIMEOUT_MS)) !=
+      pdTRUE) {
+    ESP_LOGE(TAG, "audio stream task did not stop");
+    return ESP_ERR_TIMEOUT;
+  }
+  s_stream.task_running = false;
+  s_stream.reading = false;
+  return ESP_OK;
+}
+
+esp_err_t bsp_audio_preroll_set(uint32_t preroll_ms) {
+  if (preroll_ms > BSP_AUDIO_PREROLL_MAX_MS) {
+    preroll_ms = BSP_AUDIO_PREROLL_MAX_MS;
+  }
+  s_stream.preroll_frames = (BSP_AUDIO_STREAM_RATE_HZ * preroll_ms) / 1000U;
+
+  if (s_stream.reading) {
+    return ESP_OK; /* applied when the current stream stops */
+  }
+  if (s_stream.preroll_frames == 0) {
+    return bsp_audio_stream_task_stop();
+  }
+  return bsp_audio_stream_task_start();
+}
+
+esp_err_t bsp_audio_stream_start(const bsp_audio_capture_cfg_t *cfg) {
+  if (s_stream.reading) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  ESP_RETURN_ON_ERROR(bsp_audio_stream_task_start(), TAG, "audio stream task");
+
+  s_stream.decode =
+      (cfg && cfg->decode) ? cfg->decode : bsp_audio_decode_default;
+  s_stream.decode_ctx = cfg ? cfg->decode_ctx : NULL;
+  xSemaphoreTake(s_stream.data_sem, 0);
+  xSemaphoreTake(s_stream.attach_sem, 0);
+
+  __atomic_store_n(&s_stream.attach, s_stream.preroll_frames + 1,
+                   __ATOMIC_RELEASE);
+  if (xSemaphoreTake(s_stream.attach_sem,
+                     pdMS_TO_TICKS(2 * BSP_AUDIO_STREAM_READ_TIMEOUT_MS)) !=
+      pdTRUE) {
+    ESP_LOGE(TAG, "audio stream attach timed out");
+    __atomic_store_n(&s_stream.attach, 0, __ATOMIC_RELEASE);
+    return ESP_ERR_TIMEOUT;
+  }
+  return ESP_OK;
+}
+
+esp_err_t bsp_audio_stream_read(int16_t *out, size_t max_samples,
+                                size_t *samples, uint32_t timeout_ms) {
+  if (!out || !samples) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *samples = 0;
+  if (!s_stream.reading) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  const TickType_t start = xTaskGetTickCount();
+  const TickType_t wait = pdMS_TO_TICKS(timeout_ms);
+  size_t done = 0;
+
+  while (done < max_samples) {
+    const uint32_t tail = s_stream.tail;
+    const uint32_t avail =
+        __atomic_load_n(&s_stream.head, __ATOMIC_ACQUIRE) - tail;
+    if (avail == 0) {
+      const TickType_t elapsed = xTaskGetTickCount() - start;
+      if (elapsed >= wait ||
+          xSemaphoreTake(s_stream.data_sem, wait - elapsed) != pdTRUE) {
+        break;
+      }
+      continue;
+    }
+
+    const uint32_t pos = tail & (BSP_AUDIO_STREAM_RING_FRAMES - 1);
+    size_t n = BSP_AUDIO_STREAM_RING_FRAMES - pos;
+    if (n > avail) {
+      n = avail;
+    }
+    if (n > max_samples - done) {
+      n = max_samples - done;
+    }
+    s_stream.decode(&s_stream.ring[2 * pos], n, out + done,
+                    s_stream.decode_ctx);
+    done += n;
+    __atomic_store_n(&s_stream.tail, tail + (uint32_t)n, __ATOMIC_RELEASE);
+  }
+
+  *samples = done;
+  return done ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void bsp_audio_stream_get_stats(bsp_audio_stream_stats_t *stats) {
+  if (!stats) {
+    return;
+  }
+  *stats = s_stream.stats;
+  stats->dma_overflows =
+      __atomic_load_n(&s_i2s_dma_ovf, __ATOMIC_RELAXED) - s_stream.dma_ovf_start;
+}
+
+esp_err_t bsp_audio_stream_stop(bsp_audio_stream_stats_t *stats) {
+  if (!s_stream.reading) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  /* Give tail back to the capture task (it resumes the rolling pre-roll) */
+  __atomic_store_n(&s_stream.reading, false, __ATOMIC_RELEASE);
+
+  bsp_audio_stream_stats_t st;
+  bsp_audio_stream_get_stats(&st);
+  ESP_LOGI(TAG,
+           "Audio stream stopped: %u frames (%u pre-roll), peak fill %u/%u, "
+           "%u overruns (%u frames dropped), %u DMA overflows, %u timeouts",
+           (unsigned)st.frames, (unsigned)st.preroll_frames,
+           (unsigned)st.high_water, (unsigned)st.capacity,
+           (unsigned)st.overruns, (unsigned)st.dropped_frames,
+           (unsigned)st.dma_overflows, (unsigned)st.i2s_timeouts);
+  if (stats) {
+    *stats = st;
+  }
+
+  if (s_stream.preroll_frames == 0) {
+    return bsp_audio_stream_task_stop();
+  }
+  return ESP_OK;
+}
+
 /* ===========================================================================
  * Wi-Fi status helper
  * ===========================================================================
@@ -671,9 +1090,50 @@ bool bsp_wifi_is_ready(void) {
  * ===========================================================================
  */
 #define SD_MOUNT_POINT "/sdcard"
+#define SD_NVS_NAMESPACE "bsp_sd"
+#define SD_NVS_FREQ_KEY "freq_khz"
 
 static sdmmc_card_t *s_sd_card = NULL;
 static bool s_sd_spi_bus_initialized = false;
+static uint32_t s_sd_freq_khz = 0; /* 0: not loaded from NVS yet */
+static bool s_sd_freq_calibrated = false;
+static const uint32_t s_sd_freq_steps[BSP_SD_FREQ_STEP_COUNT] =
+    BSP_SD_FREQ_STEPS_KHZ;
+
+static void bsp_sdcard_load_freq(void) {
+  if (s_sd_freq_khz != 0) {
+    return;
+  }
+  s_sd_freq_khz = BSP_SD_FREQ_DEFAULT_KHZ;
+  nvs_handle_t nvs;
+  if (nvs_open(SD_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+    return;
+  }
+  uint32_t khz = 0;
+  if (nvs_get_u32(nvs, SD_NVS_FREQ_KEY, &khz) == ESP_OK && khz >= 400 &&
+      khz <= s_sd_freq_steps[0]) {
+    s_sd_freq_khz = khz;
+    s_sd_freq_calibrated = true;
+  }
+  nvs_close(nvs);
+}
+
+static esp_err_t bsp_sdcard_store_freq(uint32_t khz) {
+  nvs_handle_t nvs;
+  esp_err_t ret = nvs_open(SD_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  ret = nvs_set_u32(nvs, SD_NVS_FREQ_KEY, khz);
+  if (ret == ESP_OK) {
+    ret = nvs_commit(nvs);
+  }
+  nvs_close(nvs);
+  if (ret == ESP_OK) {
+    s_sd_freq_calibrated = true;
+  }
+  return ret;
+}
 
 bool bsp_sdcard_is_present(void) {
   /* Waveshare board has no CD pin — assume present after detect_init succeeds
@@ -728,9 +1188,12 @@ esp_err_t bsp_sdcard_mount(void) {
       .allocation_unit_size = 16 * 1024,
   };
 
+  /* Calibrated per board/card (see bsp_sdcard_set_freq_khz); 10 MHz,
+   * conservative for long traces, until then. */
+  bsp_sdcard_load_freq();
   sdmmc_host_t host = SDSPI_HOST_DEFAULT();
   host.slot = SPI2_HOST;
-  host.max_freq_khz = 10000; /* 10 MHz — conservative for long traces */
+  host.max_freq_khz = (int)s_sd_freq_khz;
 
   sdspi_device_config_t slot_cfg = SDSPI_DEVICE_CONFIG_DEFAULT();
   slot_cfg.gpio_cs = BSP_SD_CS_GPIO;
@@ -744,7 +1207,9 @@ esp_err_t bsp_sdcard_mount(void) {
     return ret;
   }
 
-  ESP_LOGI("bsp_sd", "SD card mounted at %s", SD_MOUNT_POINT);
+  ESP_LOGI("bsp_sd", "SD card mounted at %s (%u kHz requested, %u kHz real)",
+           SD_MOUNT_POINT, (unsigned)s_sd_freq_khz,
+           (unsigned)s_sd_card->real_freq_khz);
   sdmmc_card_print_info(stdout, s_sd_card);
   return ESP_OK;
 }
@@ -760,6 +1225,58 @@ esp_err_t bsp_sdcard_unmount(void) {
   return ret;
 }
 
+uint32_t bsp_sdcard_get_freq_khz(void) {
+  bsp_sdcard_load_freq();
+  return s_sd_freq_khz;
+}
+
+uint32_t bsp_sdcard_get_real_freq_khz(void) {
+  return s_sd_card ? (uint32_t)s_sd_card->real_freq_khz : 0;
+}
+
+bool bsp_sdcard_freq_is_calibrated(void) {
+  bsp_sdcard_load_freq();
+  return s_sd_freq_calibrated;
+}
+
+esp_err_t bsp_sdcard_set_freq_khz(uint32_t freq_khz, bool persist) {
+  if (freq_khz < 400 || freq_khz > s_sd_freq_steps[0]) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  bsp_sdcard_load_freq();
+  esp_err_t ret = ESP_OK;
+  if (freq_khz != s_sd_freq_khz) {
+    /* The clock is fixed at mount time: remount to apply it. */
+    const bool was_mounted = (s_sd_card != NULL);
+    if (was_mounted) {
+      ret = bsp_sdcard_unmount();
+      if (ret != ESP_OK) {
+        return ret;
+      }
+    }
+    s_sd_freq_khz = freq_khz;
+    if (was_mounted) {
+      ret = bsp_sdcard_mount();
+    }
+  }
+  if (ret == ESP_OK && persist) {
+    ret = bsp_sdcard_store_freq(freq_khz);
+  }
+  return ret;
+}
+
+esp_err_t bsp_sdcard_freq_step_down(bool persist) {
+  bsp_sdcard_load_freq();
+  for (size_t i = 0; i < BSP_SD_FREQ_STEP_COUNT; i++) {
+    if (s_sd_freq_steps[i] < s_sd_freq_khz) {
+      ESP_LOGW("bsp_sd", "SD I/O error at %u kHz, falling back to %u kHz",
+               (unsigned)s_sd_freq_khz, (unsigned)s_sd_freq_steps[i]);
+      return bsp_sdcard_set_freq_khz(s_sd_freq_steps[i], persist);
+    }
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
 /* ===========================================================================
  * Deep Sleep Management
  * ===========================================================================
@@ -801,6 +1318,8 @@ void bsp_enter_deep_sleep(void) {
   }
 
   /* --- 4. Parar I2S / microfone INMP441 --- */
+  s_stream.preroll_frames = 0;
+  bsp_audio_stream_task_stop();
   if (s_i2s_rx_handle) {
     i2s_channel_disable(s_i2s_rx_handle);
     i2s_del_channel(s_i2s_rx_handle);
@@ -2,6 +2,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -26,6 +27,14 @@ esp_err_t gui_set_transcript(const char *text);
 /** @brief Set the main AI response text. */
 esp_err_t gui_set_response(const char *text);
 
+/**
+ * @brief Append a streamed fragment to the response text.
+ *        UTF-8 is transliterated to ASCII (state kept across fragments) and
+ *        the label is repainted by an LVGL timer, coalescing fragments.
+ *        Call gui_set_response() first to start a new response.
+ */
+esp_err_t gui_append_response(const char *frag, size_t len);
+
 /** @brief Switch response panel between full-screen and compact mode. */
 esp_err_t gui_set_response_compact(bool compact);
 
@@ -20,6 +20,7 @@ static lv_obj_t *s_panel_footer;   /* Bottom strip background panel */
 static lv_obj_t *s_label_footer;   /* Bottom contextual hints     */
 static gui_event_callback_t s_event_cb = NULL;
 static lv_coord_t s_response_scroll_y;
+static lv_timer_t *s_stream_timer;    /* Repaint of streamed response  */
 static bool s_profile_btn_held = false;
 
 /* ==================================================================
@@ -38,6 +39,11 @@ static bool s_profile_btn_held = false;
   (SCR_H - CONTENT_Y - FOOTER_H - 52) /* Stop the text area ABOVE the buttons  \
                                        */
 
+/* Streamed response: the label points at s_response_buf (static text) and is
+ * repainted by an LVGL timer instead of on every fragment. */
+#define GUI_RESPONSE_BUF_LEN 2048
+#define GUI_STREAM_REFRESH_MS 40
+
 /* ==================================================================
  *  Colour palette (Inversion-ON display)
  * ================================================================== */
@@ -71,6 +77,72 @@ static bool s_profile_btn_held = false;
 #define FONT_STRIP (&lv_font_unscii_8)
 #endif
 
+/* ==================================================================
+ *  Streamed response text
+ * ================================================================== */
+/* UTF-8 -> ASCII state carried across fragments (a character may be split
+ * between two SSE events). */
+typedef struct {
+  uint8_t lead; /* Lead byte of the pending sequence */
+  uint8_t need; /* Continuation bytes still expected */
+} gui_translit_t;
+
+static char s_response_buf[GUI_RESPONSE_BUF_LEN];
+static size_t s_response_len;
+static bool s_response_dirty;
+static gui_translit_t s_translit;
+
+/* U+00C0..U+00FF (lead byte 0xC3) -> ASCII; '\0' drops the character. */
+static const char k_latin1_ascii[] =
+    "AAAAAA\0CEEEEIIII\0NOOOOO\0\0UUUU\0\0\0"
+    "aaaaaa\0ceeeeiiii\0nooooo\0\0uuuu\0\0\0";
+
+/* Transliterates @p len bytes into s_response_buf. Accented Latin-1 letters
+ * become their base letter; other multibyte sequences are dropped to avoid
+ * square glyphs in the fonts. */
+static void gui_translit_append(const char *frag, size_t len) {
+  gui_translit_t *st = &s_translit;
+  for (size_t i = 0; i < len; i++) {
+    const uint8_t c = (uint8_t)frag[i];
+    if (st->need > 0) {
+      if ((c & 0xC0) == 0x80) {
+        st->need--;
+        if (st->need == 0 && st->lead == 0xC3) {
+          const char a = k_latin1_ascii[c & 0x3F];
+          if (a && s_response_len + 1 < sizeof(s_response_buf)) {
+            s_response_buf[s_response_len++] = a;
+          }
+        }
+        continue;
+      }
+      st->need = 0; /* Truncated sequence: restart on this byte */
+    }
+    if (c < 0x80) {
+      if (s_response_len + 1 < sizeof(s_response_buf)) {
+        s_response_buf[s_response_len++] = (char)c;
+      }
+    } else if ((c & 0xE0) == 0xC0) {
+      st->lead = c;
+      st->need = 1;
+    } else if ((c & 0xF0) == 0xE0) {
+      st->lead = c;
+      st->need = 2;
+    } else if ((c & 0xF8) == 0xF0) {
+      st->lead = c;
+      st->need = 3;
+    }
+  }
+  s_response_buf[s_response_len] = '\0';
+}
+
+static void gui_response_reset(void) {
+  s_response_len = 0;
+  s_response_buf[0] = '\0';
+  s_translit.lead = 0;
+  s_translit.need = 0;
+  s_response_dirty = false;
+}
+
 /* ==================================================================
  *  Helpers
  * ================================================================== */
@@ -102,6 +174,17 @@ static void gui_apply_response_scroll(void) {
   lv_obj_set_y(s_label_response, -s_response_scroll_y);
 }
 
+/* Runs in the LVGL task (lock held): coalesces the fragments received since
+ * the last frame into a single relayout, then parks itself. */
+static void gui_stream_timer_cb(lv_timer_t *t) {
+  if (s_response_dirty && s_label_response) {
+    s_response_dirty = false;
+    lv_label_set_text_static(s_label_response, s_response_buf);
+    gui_apply_response_scroll();
+  }
+  lv_timer_pause(t);
+}
+
 static lv_obj_t *gui_create_strip(lv_obj_t *parent, lv_obj_t **out_label,
                                   lv_align_t align, lv_coord_t y_ofs,
                                   const char *text) {
@@ -235,6 +318,10 @@ esp_err_t gui_init(void) {
   s_response_scroll_y = 0;
   gui_apply_response_scroll();
 
+  s_stream_timer = lv_timer_create(gui_stream_timer_cb, GUI_STREAM_REFRESH_MS,
+                                   NULL);
+  lv_timer_pause(s_stream_timer);
+
   /* -- Progress bar -- */
   s_bar_progress = lv_bar_create(scr);
   lv_obj_set_size(s_bar_progress, CONTENT_W, PROGRESS_H);
@@ -319,13 +406,30 @@ esp_err_t gui_set_response(const char *text) {
     return ESP_ERR_INVALID_STATE;
   if (!bsp_lvgl_lock(200))
     return ESP_ERR_TIMEOUT;
-  lv_label_set_text(s_label_response, text ? text : "");
+  gui_response_reset();
+  strlcpy(s_response_buf, text ? text : "", sizeof(s_response_buf));
+  s_response_len = strlen(s_response_buf);
+  lv_label_set_text_static(s_label_response, s_response_buf);
   s_response_scroll_y = 0;
   gui_apply_response_scroll();
   bsp_lvgl_unlock();
   return ESP_OK;
 }
 
+esp_err_t gui_append_response(const char *frag, size_t len) {
+  if (!s_label_response || !s_stream_timer)
+    return ESP_ERR_INVALID_STATE;
+  if (!frag || len == 0)
+    return ESP_OK;
+  if (!bsp_lvgl_lock(200))
+    return ESP_ERR_TIMEOUT;
+  gui_translit_append(frag, len);
+  s_response_dirty = true;
+  lv_timer_resume(s_stream_timer);
+  bsp_lvgl_unlock();
+  return ESP_OK;
+}
+
 esp_err_t gui_set_response_compact(bool compact) {
   if (!s_panel_response)
     return ESP_ERR_INVALID_STATE;
@@ -0,0 +1,100 @@
+/* Micro-benchmark do parser SSE nos streams de OpenAI, Groq e Ollama:
+ * scanner (ai_sse_feed completo: framing + scan + copia do texto) contra o
+ * caminho cJSON (Parse + ai_sse_cjson_delta + Delete por evento). O cJSON
+ * so roda com a libcjson real; o duble nao parseia. Numeros de host servem
+ * para comparar os caminhos, nao como tempo no ESP32. */
+#include "ai_client.c"
+
+#include "host_test.h"
+#include "sse_fixtures.h"
+
+#define BENCH_REPS 200  /* ~6600 eventos por stream */
+#define BENCH_ROUNDS 20
+
+#ifdef HOST_TEST_HAVE_CJSON
+static size_t s_mallocs;
+
+static void *count_malloc(size_t n) {
+  s_mallocs++;
+  return malloc(n);
+}
+#endif
+
+static double bench_scanner(const char *stream, size_t len, char *text,
+                            size_t cap) {
+  ai_sse_ctx_t *ctx = calloc(1, sizeof(*ctx));
+  const double t0 = host_test_now_ms();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->text = text;
+    ctx->text_cap = cap;
+    ai_sse_feed(ctx, stream, (int)len);
+  }
+  const double ms = host_test_now_ms() - t0;
+  CHECK(ctx->done);
+  CHECK_EQ_INT(ctx->events_cjson, 0);
+  free(ctx);
+  return ms;
+}
+
+#ifdef HOST_TEST_HAVE_CJSON
+/* Mesmo framing, mas cada evento pelo cJSON. */
+static double bench_cjson(const char *stream, size_t len, size_t *mallocs) {
+  char *copy = malloc(len + 1);
+  cJSON_Hooks hooks = {.malloc_fn = count_malloc, .free_fn = free};
+  cJSON_InitHooks(&hooks);
+  s_mallocs = 0;
+  const double t0 = host_test_now_ms();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    memcpy(copy, stream, len + 1);
+    for (char *line = strtok(copy, "\n"); line; line = strtok(NULL, "\n")) {
+      if (strncmp(line, "data: {", 7) != 0) {
+        continue;
+      }
+      cJSON *chunk = cJSON_Parse(line + 6);
+      CHECK(chunk != NULL);
+      (void)ai_sse_cjson_delta(chunk);
+      cJSON_Delete(chunk);
+    }
+  }
+  const double ms = host_test_now_ms() - t0;
+  *mallocs = s_mallocs / BENCH_ROUNDS;
+  cJSON_InitHooks(NULL);
+  free(copy);
+  return ms;
+}
+#endif
+
+int main(void) {
+  char *expected = sse_fixture_text(BENCH_REPS);
+  const size_t cap = strlen(expected) + 1;
+  char *text = malloc(cap);
+  printf("%-8s %8s %9s %12s %10s %12s %10s\n", "stream", "events", "KB",
+         "scan ns/ev", "scan MB/s", "cjson ns/ev", "allocs/ev");
+  for (int f = 0; f < SSE_FIXTURE_COUNT; f++) {
+    size_t len = 0;
+    size_t events = 0;
+    char *stream =
+        sse_fixture_build((sse_fixture_t)f, BENCH_REPS, &len, &events);
+    const double scan_ms = bench_scanner(stream, len, text, cap);
+    CHECK_STR_EQ(text, expected);
+    const double n = (double)events * BENCH_ROUNDS;
+    printf("%-8s %8zu %9.1f %12.0f %10.1f", sse_fixture_name(f), events,
+           len / 1024.0, scan_ms * 1e6 / n,
+           (double)len * BENCH_ROUNDS / (scan_ms * 1e3));
+#ifdef HOST_TEST_HAVE_CJSON
+    size_t mallocs = 0;
+    const double cjson_ms = bench_cjson(stream, len, &mallocs);
+    printf(" %12.0f %10.1f\n", cjson_ms * 1e6 / n, (double)mallocs / events);
+#else
+    printf(" %12s %10s\n", "n/a", "n/a");
+#endif
+    free(stream);
+  }
+#ifndef HOST_TEST_HAVE_CJSON
+  printf("cJSON path not measured: libcjson not found\n");
+#endif
+  free(text);
+  free(expected);
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,78 @@
+/* Taxa de compressao e tempo de codificacao do audio_codec em 20 s de
+ * sinal sintetico, por formato e taxa. A razao e relativa ao WAV PCM16
+ * (o que iria no corpo sem codec); o tempo e por segundo de audio, como no
+ * log "audio_codec" do dispositivo. Numeros de host: comparam formatos e
+ * mudancas no codificador, nao preveem o tempo no ESP32. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_codec.h"
+#include "audio_decoders.h"
+#include "audio_signals.h"
+#include "host_test.h"
+
+#define BENCH_SECONDS 20
+#define BENCH_ROUNDS 3
+
+typedef size_t (*encode_fn_t)(const int16_t *, size_t, uint32_t, uint8_t *,
+                              size_t);
+
+static void bench_one(const char *name, encode_fn_t encode, size_t cap,
+                      const int16_t *pcm, size_t n, uint32_t rate,
+                      audio_sig_t sig) {
+  uint8_t *out = malloc(cap);
+  size_t len = 0;
+  double best_ms = 1e30;
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    const double t0 = host_test_now_ms();
+    len = encode(pcm, n, rate, out, cap);
+    const double ms = host_test_now_ms() - t0;
+    if (ms < best_ms) {
+      best_ms = ms;
+    }
+  }
+  CHECK(len > 0);
+
+  /* confere a saida medida */
+  int16_t *dec = malloc(n * sizeof(int16_t));
+  long got;
+  if (encode == audio_flac_encode) {
+    flac_dec_info_t info;
+    got = flac_dec_decode(out, len, dec, n, &info);
+    CHECK(got == (long)n && memcmp(dec, pcm, n * 2) == 0);
+  } else {
+    uint32_t dec_rate = 0;
+    got = ima_dec_wav_decode(out, len, dec, n, &dec_rate);
+    CHECK_EQ_INT(got, n);
+  }
+
+  const size_t wav_len = AUDIO_WAV_HEADER_LEN + n * sizeof(int16_t);
+  printf("%-6s %-8s %6u %10zu %10zu %7.2f:1 %9.2f %9.1f\n", name,
+         audio_sig_name(sig), (unsigned)rate, wav_len, len,
+         (double)wav_len / (double)len, best_ms / BENCH_SECONDS,
+         (double)n / (best_ms * 1e3));
+  free(dec);
+  free(out);
+}
+
+int main(void) {
+  static const uint32_t rates[] = {8000, 16000};
+  static const audio_sig_t sigs[] = {AUDIO_SIG_SPEECH, AUDIO_SIG_SINE,
+                                     AUDIO_SIG_NOISE};
+  printf("%-6s %-8s %6s %10s %10s %9s %9s %9s\n", "codec", "signal", "rate",
+         "wav B", "out B", "ratio", "ms/s", "Msmp/s");
+  for (size_t r = 0; r < 2; r++) {
+    const size_t n = (size_t)rates[r] * BENCH_SECONDS;
+    int16_t *pcm = malloc(n * sizeof(int16_t));
+    for (size_t s = 0; s < sizeof(sigs) / sizeof(sigs[0]); s++) {
+      audio_sig_fill(sigs[s], pcm, n, rates[r], 42);
+      bench_one("flac", audio_flac_encode, audio_flac_max_len(n), pcm, n,
+                rates[r], sigs[s]);
+      bench_one("adpcm", audio_ima_adpcm_wav_encode,
+                audio_ima_adpcm_wav_len(n, rates[r]), pcm, n, rates[r],
+                sigs[s]);
+    }
+    free(pcm);
+  }
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,273 @@
+/* Vazao do front-end de captura do S3, em Msamples/s, sobre 60 s de voz
+ * sintetica em pedacos de DMA de 256 frames:
+ *   - bsp+hpf: decodificacao do BSP, audio_highpass_process() e uma
+ *     passada separada de estatisticas (o caminho sem fusao);
+ *   - fused: audio_frontend_decode() atual, uma passada por amostra;
+ *   - block: unpack, recursao e pack em blocos de AUDIO_DSP_BLOCK com os
+ *     kernels de audio_dsp (a versao que a camada de DSP introduziu);
+ *   - biquad: o caminho de blocos com biquad + energia em float, que nao e
+ *     bit-exato quando o filtro satura (so para comparacao).
+ * Depois, os kernels de audio_dsp: referencia contra despacho (no host sao
+ * o mesmo codigo; no S3 o despacho e o esp-dsp, medido pelo "dsp_bench").
+ * Numeros de host: comparam as variantes, nao preveem o tempo no ESP32. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_dsp.h"
+#include "audio_signals.h"
+#include "audio_utils.h"
+#include "host_test.h"
+
+#define RATE 8000
+#define SECONDS 60
+#define CHUNK 256
+#define WINDOW 800
+#define ROUNDS 5
+
+typedef void (*frontend_fn_t)(const int32_t *raw, size_t frames,
+                              int16_t *out, void *ctx);
+
+static int16_t clamp16(int32_t s) {
+  if (s > INT16_MAX) {
+    return INT16_MAX;
+  }
+  if (s < INT16_MIN) {
+    return INT16_MIN;
+  }
+  return (int16_t)s;
+}
+
+static int16_t decode_one(const int32_t *raw) {
+  const int32_t l = raw[0] >> 15;
+  const int32_t r = raw[1] >> 15;
+  return clamp16((abs(l) >= abs(r)) ? l : r);
+}
+
+static void stats_add(audio_window_stats_t *w, int16_t *last, int16_t y) {
+  const int32_t v = y;
+  w->sum_sq += v * v;
+  const int32_t mag = (v < 0) ? -v : v;
+  if (mag > w->peak) {
+    w->peak = mag;
+  }
+  w->crossings += ((*last < 0) != (y < 0));
+  *last = y;
+}
+
+/* bsp_audio_decode_default + audio_highpass_process + estatisticas */
+static void fe_unfused(const int32_t *raw, size_t frames, int16_t *out,
+                       void *ctx) {
+  audio_frontend_t *fe = ctx;
+  for (size_t i = 0; i < frames; i++) {
+    out[i] = decode_one(raw + 2 * i);
+  }
+  audio_highpass_process(&fe->hpf, out, frames);
+  for (size_t i = 0; i < frames; i++) {
+    stats_add(&fe->window, &fe->last, out[i]);
+  }
+  fe->window.count += (uint32_t)frames;
+}
+
+/* Blocos sobre os kernels de audio_dsp, recursao escalar entre eles. */
+static void fe_block(const int32_t *raw, size_t frames, int16_t *out,
+                     void *ctx) {
+  audio_frontend_t *fe = ctx;
+  audio_highpass_state_t *hpf = &fe->hpf;
+  static float block[AUDIO_DSP_BLOCK];
+  while (frames > 0) {
+    const size_t n = frames < AUDIO_DSP_BLOCK ? frames : AUDIO_DSP_BLOCK;
+    audio_dsp_i2s_to_f32(raw, n, block);
+    size_t k = 0;
+    if (!hpf->primed) {
+      hpf->prev_x = block[0];
+      hpf->prev_y = block[0];
+      hpf->primed = true;
+      k = 1;
+    }
+    const float alpha = hpf->alpha;
+    float prev_x = hpf->prev_x;
+    float prev_y = hpf->prev_y;
+    for (size_t i = k; i < n; i++) {
+      float y = alpha * (prev_y + block[i] - prev_x);
+      if (y > 32767.0f) {
+        y = 32767.0f;
+      } else if (y < -32768.0f) {
+        y = -32768.0f;
+      }
+      prev_x = block[i];
+      prev_y = y;
+      block[i] = y;
+    }
+    hpf->prev_x = prev_x;
+    hpf->prev_y = prev_y;
+    audio_dsp_pack_s16(block, out, n);
+    for (size_t i = 0; i < n; i++) {
+      stats_add(&fe->window, &fe->last, out[i]);
+    }
+    fe->window.count += (uint32_t)n;
+    raw += 2 * n;
+    out += n;
+    frames -= n;
+  }
+}
+
+/* Blocos com biquad e energia em float (estado do biquad em prev_x/y). */
+static void fe_biquad(const int32_t *raw, size_t frames, int16_t *out,
+                      void *ctx) {
+  audio_frontend_t *fe = ctx;
+  static float block[AUDIO_DSP_BLOCK];
+  float coef[5];
+  audio_dsp_highpass_coefs(fe->hpf.alpha, coef);
+  float w[2] = {fe->hpf.prev_x, fe->hpf.prev_y};
+  float energy = 0.0f;
+  while (frames > 0) {
+    const size_t n = frames < AUDIO_DSP_BLOCK ? frames : AUDIO_DSP_BLOCK;
+    audio_dsp_i2s_to_f32(raw, n, block);
+    audio_dsp_biquad_f32(block, block, n, coef, w);
+    energy += audio_dsp_energy_f32(block, n);
+    audio_dsp_pack_s16(block, out, n);
+    for (size_t i = 0; i < n; i++) {
+      const int32_t mag = out[i] < 0 ? -out[i] : out[i];
+      if (mag > fe->window.peak) {
+        fe->window.peak = mag;
+      }
+      fe->window.crossings += ((fe->last < 0) != (out[i] < 0));
+      fe->last = out[i];
+    }
+    fe->window.count += (uint32_t)n;
+    raw += 2 * n;
+    out += n;
+    frames -= n;
+  }
+  fe->hpf.prev_x = w[0];
+  fe->hpf.prev_y = w[1];
+  fe->window.sum_sq += (int64_t)energy;
+}
+
+static double bench_frontend(frontend_fn_t fn, const int32_t *raw, size_t n,
+                             int16_t *out) {
+  audio_frontend_t *fe = malloc(sizeof(*fe));
+  double best_ms = 1e30;
+  for (int r = 0; r < ROUNDS; r++) {
+    audio_frontend_init(fe, 100.0f, (float)RATE);
+    const double t0 = host_test_now_ms();
+    for (size_t pos = 0; pos < n; pos += CHUNK) {
+      if (pos % WINDOW < CHUNK) {
+        audio_frontend_window_reset(fe);
+      }
+      const size_t c = (n - pos < CHUNK) ? n - pos : CHUNK;
+      fn(raw + 2 * pos, c, out + pos, fe);
+    }
+    const double ms = host_test_now_ms() - t0;
+    if (ms < best_ms) {
+      best_ms = ms;
+    }
+  }
+  free(fe);
+  return (double)n / (best_ms * 1e3);
+}
+
+typedef float (*kernel_fn_t)(float *x, float *y, size_t n);
+
+static float k_biquad_ref(float *x, float *y, size_t n) {
+  float coef[5];
+  float w[2] = {0.0f, 0.0f};
+  audio_dsp_highpass_coefs(0.927f, coef);
+  audio_dsp_ref_biquad_f32(x, y, n, coef, w);
+  return y[n - 1];
+}
+
+static float k_biquad_dsp(float *x, float *y, size_t n) {
+  float coef[5];
+  float w[2] = {0.0f, 0.0f};
+  audio_dsp_highpass_coefs(0.927f, coef);
+  audio_dsp_biquad_f32(x, y, n, coef, w);
+  return y[n - 1];
+}
+
+static float k_energy_ref(float *x, float *y, size_t n) {
+  (void)y;
+  return audio_dsp_ref_energy_f32(x, n);
+}
+
+static float k_energy_dsp(float *x, float *y, size_t n) {
+  (void)y;
+  return audio_dsp_energy_f32(x, n);
+}
+
+static void bench_kernel(const char *name, kernel_fn_t fn, float *x,
+                         float *y, size_t n) {
+  double best_ms = 1e30;
+  volatile float sink = 0.0f;
+  for (int r = 0; r < ROUNDS; r++) {
+    const double t0 = host_test_now_ms();
+    for (size_t pos = 0; pos + AUDIO_DSP_BLOCK <= n; pos += AUDIO_DSP_BLOCK) {
+      sink += fn(x + pos, y + pos, AUDIO_DSP_BLOCK);
+    }
+    const double ms = host_test_now_ms() - t0;
+    if (ms < best_ms) {
+      best_ms = ms;
+    }
+  }
+  (void)sink;
+  printf("%-22s %9.1f Msmp/s\n", name, (double)n / (best_ms * 1e3));
+}
+
+int main(void) {
+  const size_t n = (size_t)RATE * SECONDS;
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  int32_t *raw = malloc(2 * n * sizeof(int32_t));
+  int16_t *out = malloc(n * sizeof(int16_t));
+  int16_t *ref = malloc(n * sizeof(int16_t));
+  audio_sig_fill(AUDIO_SIG_SPEECH, pcm, n, RATE, 42);
+  uint32_t seed = 42;
+  for (size_t i = 0; i < n; i++) {
+    raw[2 * i] = (int32_t)pcm[i] * 32768 + (int32_t)(host_test_rand(&seed) &
+                                                     0x7F00);
+    raw[2 * i + 1] = raw[2 * i] / 4;
+  }
+
+  static const struct {
+    const char *name;
+    frontend_fn_t fn;
+  } variants[] = {
+      {"bsp+hpf", fe_unfused},
+      {"fused", audio_frontend_decode},
+      {"block", fe_block},
+      {"biquad", fe_biquad},
+  };
+  printf("front-end, %d s @ %d Hz, %d-frame chunks\n", SECONDS, RATE, CHUNK);
+  printf("%-22s %9s %s\n", "variant", "Msmp/s", "vs bsp+hpf");
+  double base = 0.0;
+  for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+    const double msps = bench_frontend(variants[v].fn, raw, n, out);
+    if (v == 0) {
+      base = msps;
+      memcpy(ref, out, n * sizeof(int16_t));
+    } else if (variants[v].fn != fe_biquad) {
+      /* as variantes exatas tem de produzir a mesma saida */
+      CHECK(memcmp(out, ref, n * sizeof(int16_t)) == 0);
+    }
+    printf("%-22s %9.1f %9.2fx\n", variants[v].name, msps, msps / base);
+  }
+
+  float *x = malloc(n * sizeof(float));
+  float *y = malloc(n * sizeof(float));
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (float)pcm[i];
+  }
+  printf("\nkernels (%s), %d-sample blocks\n", audio_dsp_backend(),
+         AUDIO_DSP_BLOCK);
+  bench_kernel("biquad reference", k_biquad_ref, x, y, n);
+  bench_kernel("biquad dispatch", k_biquad_dsp, x, y, n);
+  bench_kernel("energy reference", k_energy_ref, x, y, n);
+  bench_kernel("energy dispatch", k_energy_dsp, x, y, n);
+
+  free(y);
+  free(x);
+  free(ref);
+  free(out);
+  free(raw);
+  free(pcm);
+  return HOST_TEST_EXIT();
+}
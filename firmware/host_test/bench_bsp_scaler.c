@@ -0,0 +1,124 @@
+/* Vazao do crop/scale da preview do P4, em Mpix/s de saida (240x240):
+ *   - old loop + swap: o laco de bsp.c antes do bsp_scaler (divisao de 64
+ *     bits e copia byte a byte por pixel) seguido da troca de bytes que o
+ *     gui.c fazia no quadro inteiro (o caminho da tela);
+ *   - old loop: so o laco (o caminho do JPEG, na ordem da camera);
+ *   - scaler nearest (+swap): bsp_scaler_run() com as tabelas;
+ *   - scaler box (+swap): o filtro 2x2 usado no JPEG para a IA.
+ * A saida do vizinho mais proximo e conferida contra o laco antigo.
+ * Numeros de host: comparam as variantes, nao preveem o tempo no P4 (onde
+ * a divisao de 64 bits e uma chamada de biblioteca). */
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_scaler.h"
+#include "host_test.h"
+#include "scaler_ref.h"
+
+#define SIZE 240
+#define FRAMES 200
+#define ROUNDS 5
+
+typedef struct {
+  const uint8_t *src;
+  uint32_t w;
+  uint32_t h;
+  uint32_t stride;
+  uint32_t bpp;
+  bsp_scaler_t scaler;
+} bench_ctx_t;
+
+typedef void (*variant_fn_t)(bench_ctx_t *ctx, uint8_t *dst);
+
+static void v_old(bench_ctx_t *ctx, uint8_t *dst) {
+  scaler_ref_old_loop(ctx->src, ctx->w, ctx->h, ctx->stride, ctx->bpp, dst,
+                      SIZE);
+}
+
+static void v_old_swap(bench_ctx_t *ctx, uint8_t *dst) {
+  v_old(ctx, dst);
+  scaler_ref_swap((uint16_t *)dst, SIZE * SIZE);
+}
+
+static void v_scaler(bench_ctx_t *ctx, uint8_t *dst) {
+  bsp_scaler_run(&ctx->scaler, ctx->src, dst);
+}
+
+static double bench_variant(variant_fn_t fn, bench_ctx_t *ctx, uint8_t *dst) {
+  double best_ms = 1e30;
+  for (int r = 0; r < ROUNDS; r++) {
+    const double t0 = host_test_now_ms();
+    for (int f = 0; f < FRAMES; f++) {
+      fn(ctx, dst);
+    }
+    const double ms = host_test_now_ms() - t0;
+    if (ms < best_ms) {
+      best_ms = ms;
+    }
+  }
+  return (double)SIZE * SIZE * FRAMES / (best_ms * 1e3);
+}
+
+static void bench_resolution(uint32_t w, uint32_t h, uint32_t bpp) {
+  const uint32_t stride = w * bpp;
+  uint8_t *frame = malloc((size_t)stride * h);
+  scaler_ref_fill_frame(frame, w, h, stride, bpp, w + h);
+  uint32_t *ref = malloc(SIZE * SIZE * 2);
+  uint32_t *out = malloc(SIZE * SIZE * 2);
+  bench_ctx_t ctx = {
+      .src = frame, .w = w, .h = h, .stride = stride, .bpp = bpp};
+
+  static const struct {
+    const char *name;
+    bsp_scale_mode_t mode;
+    bool swap;
+  } scaled[] = {
+      {"scaler nearest", BSP_SCALE_NEAREST, false},
+      {"scaler nearest+swap", BSP_SCALE_NEAREST, true},
+      {"scaler box", BSP_SCALE_BOX2X2, false},
+      {"scaler box+swap", BSP_SCALE_BOX2X2, true},
+  };
+
+  printf("\n%ux%u %s -> %dx%d\n", (unsigned)w, (unsigned)h,
+         bpp == 2 ? "RGB565" : "RGB24", SIZE, SIZE);
+  printf("%-22s %9s %s\n", "variant", "Mpix/s", "vs old loop(+swap)");
+  const double old = bench_variant(v_old, &ctx, (uint8_t *)ref);
+  const double old_swap = bench_variant(v_old_swap, &ctx, (uint8_t *)out);
+  printf("%-22s %9.1f\n", "old loop", old);
+  printf("%-22s %9.1f\n", "old loop+swap", old_swap);
+
+  for (size_t v = 0; v < sizeof(scaled) / sizeof(scaled[0]); v++) {
+    const bsp_scaler_cfg_t cfg = {
+        .src_w = w,
+        .src_h = h,
+        .src_stride = stride,
+        .src_bpp = bpp,
+        .dst_w = SIZE,
+        .dst_h = SIZE,
+        .mode = scaled[v].mode,
+        .swap_bytes = scaled[v].swap,
+    };
+    CHECK_EQ_INT(bsp_scaler_configure(&ctx.scaler, &cfg), ESP_OK);
+    const double mpps = bench_variant(v_scaler, &ctx, (uint8_t *)out);
+    if (scaled[v].mode == BSP_SCALE_NEAREST) {
+      if (scaled[v].swap) {
+        scaler_ref_swap((uint16_t *)out, SIZE * SIZE);
+      }
+      CHECK(memcmp(out, ref, SIZE * SIZE * 2) == 0);
+    }
+    printf("%-22s %9.1f %9.2fx\n", scaled[v].name, mpps,
+           mpps / (scaled[v].swap ? old_swap : old));
+  }
+
+  bsp_scaler_deinit(&ctx.scaler);
+  free(out);
+  free(ref);
+  free(frame);
+}
+
+int main(void) {
+  bench_resolution(640, 480, 2);
+  bench_resolution(1280, 720, 2);
+  bench_resolution(1920, 1080, 3);
+  return HOST_TEST_EXIT();
+}
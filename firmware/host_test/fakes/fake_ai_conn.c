@@ -0,0 +1,76 @@
+#include "fake_ai_conn.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool s_open;
+static uint8_t *s_tx;
+static size_t s_tx_len;
+static size_t s_tx_cap;
+static const char *s_rx;
+static size_t s_rx_pos;
+static int s_opens;
+
+void fake_ai_conn_reset(const char *response) {
+  s_open = false;
+  s_tx_len = 0;
+  s_rx = response ? response : "";
+  s_rx_pos = 0;
+  s_opens = 0;
+}
+
+const uint8_t *fake_ai_conn_tx(size_t *len) {
+  *len = s_tx_len;
+  return s_tx;
+}
+
+int fake_ai_conn_opens(void) { return s_opens; }
+
+esp_err_t ai_conn_open(const ai_conn_cfg_t *cfg, ai_conn_info_t *info) {
+  (void)cfg;
+  memset(info, 0, sizeof(*info));
+  s_open = true;
+  s_opens++;
+  return ESP_OK;
+}
+
+bool ai_conn_is_open(void) { return s_open; }
+
+bool ai_conn_is_alive(void) { return s_open; }
+
+esp_err_t ai_conn_write(const void *data, size_t len) {
+  if (!s_open) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (s_tx_len + len > s_tx_cap) {
+    size_t cap = s_tx_cap ? s_tx_cap : 4096;
+    while (cap < s_tx_len + len) {
+      cap *= 2;
+    }
+    uint8_t *p = realloc(s_tx, cap);
+    if (!p) {
+      return ESP_ERR_NO_MEM;
+    }
+    s_tx = p;
+    s_tx_cap = cap;
+  }
+  memcpy(s_tx + s_tx_len, data, len);
+  s_tx_len += len;
+  return ESP_OK;
+}
+
+esp_err_t ai_conn_read(void *buf, size_t len, size_t *got) {
+  const size_t left = strlen(s_rx + s_rx_pos);
+  *got = (left < len) ? left : len;
+  memcpy(buf, s_rx + s_rx_pos, *got);
+  s_rx_pos += *got;
+  return ESP_OK;
+}
+
+void ai_conn_close(void) { s_open = false; }
+
+void ai_conn_session_persist(void) {}
+
+void ai_conn_get_tls_stats(ai_conn_tls_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+}
@@ -0,0 +1,13 @@
+#pragma once
+/* Duble de ai_conn (src/ai_conn.h): grava o que o ai_client escreve e
+ * devolve uma resposta pronta, sem socket. */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ai_conn.h"
+
+void fake_ai_conn_reset(const char *response);
+/* Bytes escritos desde o reset (cabecalhos + corpo). */
+const uint8_t *fake_ai_conn_tx(size_t *len);
+/* Numero de ai_conn_open() desde o reset. */
+int fake_ai_conn_opens(void);
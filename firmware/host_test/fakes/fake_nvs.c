@@ -0,0 +1,146 @@
+#include "fake_nvs.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_NVS_ENTRIES 8
+#define FAKE_NVS_NAME_MAX 16 /* 15 caracteres + NUL, como no NVS */
+
+typedef struct {
+  char name[FAKE_NVS_NAME_MAX];
+  char key[FAKE_NVS_NAME_MAX];
+  uint8_t *data;
+  size_t len;
+} fake_nvs_entry_t;
+
+static fake_nvs_entry_t s_entries[FAKE_NVS_ENTRIES];
+static char s_open[FAKE_NVS_ENTRIES][FAKE_NVS_NAME_MAX]; /* handle - 1 */
+static bool s_writable[FAKE_NVS_ENTRIES];
+static int s_commits;
+
+void fake_nvs_reset(void) {
+  for (int i = 0; i < FAKE_NVS_ENTRIES; i++) {
+    free(s_entries[i].data);
+  }
+  memset(s_entries, 0, sizeof(s_entries));
+  memset(s_open, 0, sizeof(s_open));
+  s_commits = 0;
+}
+
+static fake_nvs_entry_t *fake_nvs_find(const char *name, const char *key) {
+  for (int i = 0; i < FAKE_NVS_ENTRIES; i++) {
+    fake_nvs_entry_t *e = &s_entries[i];
+    if (e->data && strcmp(e->name, name) == 0 &&
+        (!key || strcmp(e->key, key) == 0)) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static const char *fake_nvs_handle_name(nvs_handle_t handle) {
+  if (handle == 0 || handle > FAKE_NVS_ENTRIES || !s_open[handle - 1][0]) {
+    return NULL;
+  }
+  return s_open[handle - 1];
+}
+
+uint8_t *fake_nvs_blob(const char *name, const char *key, size_t *len) {
+  fake_nvs_entry_t *e = fake_nvs_find(name, key);
+  if (len) {
+    *len = e ? e->len : 0;
+  }
+  return e ? e->data : NULL;
+}
+
+int fake_nvs_commits(void) { return s_commits; }
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode,
+                   nvs_handle_t *out_handle) {
+  if (!name || !out_handle || strlen(name) >= FAKE_NVS_NAME_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  /* como no ESP-IDF: so leitura num namespace que nao existe falha */
+  if (mode == NVS_READONLY && !fake_nvs_find(name, NULL)) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  for (int i = 0; i < FAKE_NVS_ENTRIES; i++) {
+    if (!s_open[i][0]) {
+      strcpy(s_open[i], name);
+      s_writable[i] = (mode == NVS_READWRITE);
+      *out_handle = (nvs_handle_t)(i + 1);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value,
+                       size_t *length) {
+  const char *name = fake_nvs_handle_name(handle);
+  if (!name) {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  const fake_nvs_entry_t *e = fake_nvs_find(name, key);
+  if (!e) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  if (!out_value) {
+    *length = e->len;
+    return ESP_OK;
+  }
+  if (*length < e->len) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out_value, e->data, e->len);
+  *length = e->len;
+  return ESP_OK;
+}
+
+/* Grava direto (o commit so conta): os testes simulam o corte de energia
+ * reiniciando a RAM, nao a flash. */
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+                       size_t length) {
+  const char *name = fake_nvs_handle_name(handle);
+  if (!name || !s_writable[handle - 1]) {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  if (!key || strlen(key) >= FAKE_NVS_NAME_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  fake_nvs_entry_t *e = fake_nvs_find(name, key);
+  for (int i = 0; !e && i < FAKE_NVS_ENTRIES; i++) {
+    if (!s_entries[i].data) {
+      e = &s_entries[i];
+    }
+  }
+  if (!e) {
+    return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+  }
+  uint8_t *data = malloc(length ? length : 1);
+  if (!data) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(data, value, length);
+  free(e->data);
+  strcpy(e->name, name);
+  strcpy(e->key, key);
+  e->data = data;
+  e->len = length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  if (!fake_nvs_handle_name(handle)) {
+    return ESP_ERR_NVS_INVALID_HANDLE;
+  }
+  s_commits++;
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  if (fake_nvs_handle_name(handle)) {
+    s_open[handle - 1][0] = '\0';
+  }
+}
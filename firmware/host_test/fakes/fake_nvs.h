@@ -0,0 +1,14 @@
+#pragma once
+/* NVS em memoria (stubs/nvs.h): namespaces e blobs numa tabela fixa, para
+ * os testes reiniciarem, inspecionarem e corromperem o que foi gravado. */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nvs.h"
+
+/* Apaga tudo (flash apagada). */
+void fake_nvs_reset(void);
+/* Blob gravado e commitado, ou NULL. Pode ser alterado pelo teste. */
+uint8_t *fake_nvs_blob(const char *name, const char *key, size_t *len);
+/* Numero de nvs_commit() desde o reset. */
+int fake_nvs_commits(void);
@@ -0,0 +1,365 @@
+#include "fake_v4l2.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <linux/videodev2.h>
+
+#define FAKE_FD_BASE 100
+#define FAKE_OFFSET_STEP 0x100000u
+
+typedef enum { BUF_IDLE, BUF_QUEUED, BUF_DONE } buf_state_t;
+
+typedef struct {
+  uint8_t *mem;
+  uint32_t length;
+  buf_state_t state;
+  uint32_t frame; /* numero do quadro quando DONE */
+  bool mapped;
+} fake_buf_t;
+
+static fake_v4l2_cfg_t s_cfg;
+static fake_v4l2_stats_t s_st;
+static int s_open_node = -1;
+static bool s_streaming;
+static uint32_t s_w;
+static uint32_t s_h;
+static uint32_t s_pixfmt;
+static uint32_t s_bpl;
+static uint32_t s_count;
+static fake_buf_t s_bufs[FAKE_V4L2_MAX_BUFS];
+/* filas do driver, em ordem de chegada */
+static uint32_t s_in[FAKE_V4L2_MAX_BUFS];
+static uint32_t s_out[FAKE_V4L2_MAX_BUFS];
+static int s_mmap_calls;
+static int s_dqbuf_err;
+static bool s_auto_armed; /* auto: o proximo DQBUF vazio completa um */
+
+static const char *const k_nodes[FAKE_V4L2_NODES] = {
+    "/dev/video0", "/dev/video1", "/dev/video2"};
+
+fake_v4l2_cfg_t fake_v4l2_defaults(void) {
+  const fake_v4l2_cfg_t cfg = {
+      .present = {true, false, false},
+      .capture = {true, false, false},
+      .rgb565 = true,
+      .rgb24 = true,
+      .cur_w = 1920,
+      .cur_h = 1080,
+      .grant = FAKE_V4L2_MAX_BUFS,
+      .fail_querybuf = -1,
+      .fail_mmap = -1,
+      .auto_frames = true,
+  };
+  return cfg;
+}
+
+static void fake_free_bufs(void) {
+  for (uint32_t i = 0; i < FAKE_V4L2_MAX_BUFS; i++) {
+    free(s_bufs[i].mem);
+  }
+  memset(s_bufs, 0, sizeof(s_bufs));
+  s_count = 0;
+  s_st.queued = 0;
+  s_st.done = 0;
+}
+
+void fake_v4l2_reset(const fake_v4l2_cfg_t *cfg) {
+  fake_free_bufs();
+  s_cfg = cfg ? *cfg : fake_v4l2_defaults();
+  memset(&s_st, 0, sizeof(s_st));
+  s_open_node = -1;
+  s_streaming = false;
+  s_w = s_cfg.cur_w;
+  s_h = s_cfg.cur_h;
+  s_pixfmt = 0;
+  s_bpl = 0;
+  s_mmap_calls = 0;
+  s_dqbuf_err = 0;
+  s_auto_armed = false;
+}
+
+void fake_v4l2_set_auto(bool on) { s_cfg.auto_frames = on; }
+
+void fake_v4l2_fail_next_dqbuf(int err) { s_dqbuf_err = err; }
+
+const fake_v4l2_stats_t *fake_v4l2_stats(void) { return &s_st; }
+
+uint32_t fake_v4l2_frame_id(const uint8_t *data) {
+  uint32_t id;
+  memcpy(&id, data, sizeof(id));
+  return id;
+}
+
+static uint32_t fifo_pop(uint32_t *fifo, int *len) {
+  const uint32_t head = fifo[0];
+  memmove(fifo, fifo + 1, (size_t)(*len - 1) * sizeof(*fifo));
+  (*len)--;
+  return head;
+}
+
+int fake_v4l2_produce(int n) {
+  int made = 0;
+  while (made < n && s_streaming && s_st.queued > 0) {
+    const uint32_t idx = fifo_pop(s_in, &s_st.queued);
+    fake_buf_t *b = &s_bufs[idx];
+    b->state = BUF_DONE;
+    b->frame = ++s_st.frames;
+    memcpy(b->mem, &b->frame, sizeof(b->frame));
+    s_out[s_st.done++] = idx;
+    made++;
+  }
+  return made;
+}
+
+int fake_v4l2_open(const char *path, int flags, ...) {
+  for (int i = 0; i < FAKE_V4L2_NODES; i++) {
+    if (strcmp(path, k_nodes[i]) != 0) {
+      continue;
+    }
+    if (!s_cfg.present[i]) {
+      break;
+    }
+    if (s_open_node >= 0) {
+      errno = EBUSY;
+      return -1;
+    }
+    s_open_node = i;
+    s_st.opens++;
+    s_st.open_fds++;
+    s_st.last_dev = k_nodes[i];
+    if (flags & O_NONBLOCK) {
+      s_st.nonblock_opens++;
+    }
+    return FAKE_FD_BASE + i;
+  }
+  errno = ENOENT;
+  return -1;
+}
+
+static bool fake_fd_ok(int fd) {
+  return s_open_node >= 0 && fd == FAKE_FD_BASE + s_open_node;
+}
+
+int fake_v4l2_close(int fd) {
+  if (!fake_fd_ok(fd)) {
+    errno = EBADF;
+    return -1;
+  }
+  /* como o driver: fechar para o stream e solta os buffers */
+  s_streaming = false;
+  fake_free_bufs();
+  s_open_node = -1;
+  s_st.closes++;
+  s_st.open_fds--;
+  return 0;
+}
+
+static int fake_err(int err) {
+  errno = err;
+  return -1;
+}
+
+static int fake_s_fmt(struct v4l2_format *f) {
+  const uint32_t pix = f->fmt.pix.pixelformat;
+  const bool ok = (pix == V4L2_PIX_FMT_RGB565 && s_cfg.rgb565) ||
+                  (pix == V4L2_PIX_FMT_RGB24 && s_cfg.rgb24);
+  if (!ok || f->fmt.pix.width == 0 || f->fmt.pix.height == 0 ||
+      (s_cfg.only_w && (f->fmt.pix.width != s_cfg.only_w ||
+                        f->fmt.pix.height != s_cfg.only_h))) {
+    return fake_err(EINVAL);
+  }
+  if (s_count > 0) {
+    return fake_err(EBUSY);
+  }
+  s_w = f->fmt.pix.width;
+  s_h = f->fmt.pix.height;
+  s_pixfmt = pix;
+  s_bpl = s_w * (pix == V4L2_PIX_FMT_RGB565 ? 2 : 3);
+  f->fmt.pix.bytesperline = s_cfg.zero_bytesperline ? 0 : s_bpl;
+  f->fmt.pix.sizeimage = s_bpl * s_h;
+  return 0;
+}
+
+static int fake_reqbufs(struct v4l2_requestbuffers *req) {
+  if (req->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+      req->memory != V4L2_MEMORY_MMAP) {
+    return fake_err(EINVAL);
+  }
+  if (s_streaming || s_st.live_maps > 0) {
+    return fake_err(EBUSY); /* V4L2: buffers mapeados nao sao liberados */
+  }
+  fake_free_bufs();
+  if (req->count == 0) {
+    s_st.reqbufs_free++;
+    return 0;
+  }
+  uint32_t n = req->count < s_cfg.grant ? req->count : s_cfg.grant;
+  if (n > FAKE_V4L2_MAX_BUFS) {
+    n = FAKE_V4L2_MAX_BUFS;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    s_bufs[i].length = s_bpl * s_h;
+    s_bufs[i].mem = calloc(1, s_bufs[i].length);
+  }
+  s_count = n;
+  req->count = n;
+  return 0;
+}
+
+static fake_buf_t *fake_buf_arg(const struct v4l2_buffer *b) {
+  if (b->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+      b->memory != V4L2_MEMORY_MMAP || b->index >= s_count) {
+    return NULL;
+  }
+  return &s_bufs[b->index];
+}
+
+static int fake_dqbuf(struct v4l2_buffer *b) {
+  if (b->type != V4L2_BUF_TYPE_VIDEO_CAPTURE ||
+      b->memory != V4L2_MEMORY_MMAP || !s_streaming) {
+    return fake_err(EINVAL);
+  }
+  if (s_dqbuf_err) {
+    const int err = s_dqbuf_err;
+    s_dqbuf_err = 0;
+    return fake_err(err);
+  }
+  if (s_st.done == 0 && s_cfg.auto_frames && s_auto_armed) {
+    fake_v4l2_produce(1);
+  }
+  if (s_st.done == 0) {
+    s_auto_armed = true;
+    return fake_err(EAGAIN);
+  }
+  s_auto_armed = false;
+  const uint32_t idx = fifo_pop(s_out, &s_st.done);
+  fake_buf_t *buf = &s_bufs[idx];
+  buf->state = BUF_IDLE;
+  b->index = idx;
+  b->bytesused = buf->length;
+  b->length = buf->length;
+  b->sequence = buf->frame;
+  b->m.offset = idx * FAKE_OFFSET_STEP;
+  s_st.dqbufs++;
+  return 0;
+}
+
+int fake_v4l2_ioctl(int fd, unsigned long request, ...) {
+  va_list ap;
+  va_start(ap, request);
+  void *arg = va_arg(ap, void *);
+  va_end(ap);
+  if (!fake_fd_ok(fd)) {
+    return fake_err(EBADF);
+  }
+
+  switch (request) {
+  case VIDIOC_QUERYCAP: {
+    struct v4l2_capability *cap = arg;
+    memset(cap, 0, sizeof(*cap));
+    cap->device_caps = V4L2_CAP_STREAMING |
+                       (s_cfg.capture[s_open_node] ? V4L2_CAP_VIDEO_CAPTURE
+                                                   : V4L2_CAP_VIDEO_OUTPUT);
+    cap->capabilities = cap->device_caps | V4L2_CAP_DEVICE_CAPS;
+    return 0;
+  }
+  case VIDIOC_G_FMT: {
+    struct v4l2_format *f = arg;
+    if (s_cfg.cur_w == 0 || f->type != V4L2_BUF_TYPE_VIDEO_CAPTURE) {
+      return fake_err(EINVAL);
+    }
+    f->fmt.pix.width = s_w;
+    f->fmt.pix.height = s_h;
+    f->fmt.pix.pixelformat = s_pixfmt;
+    f->fmt.pix.bytesperline = s_bpl;
+    return 0;
+  }
+  case VIDIOC_S_FMT:
+    return fake_s_fmt(arg);
+  case VIDIOC_REQBUFS:
+    return fake_reqbufs(arg);
+  case VIDIOC_QUERYBUF: {
+    struct v4l2_buffer *b = arg;
+    if (!fake_buf_arg(b) || (int)b->index == s_cfg.fail_querybuf) {
+      return fake_err(EINVAL);
+    }
+    b->length = s_bufs[b->index].length;
+    b->m.offset = b->index * FAKE_OFFSET_STEP;
+    return 0;
+  }
+  case VIDIOC_QBUF: {
+    struct v4l2_buffer *b = arg;
+    fake_buf_t *buf = fake_buf_arg(b);
+    if (!buf || buf->state != BUF_IDLE) {
+      return fake_err(EINVAL);
+    }
+    buf->state = BUF_QUEUED;
+    s_in[s_st.queued++] = b->index;
+    s_st.qbufs++;
+    return 0;
+  }
+  case VIDIOC_DQBUF:
+    return fake_dqbuf(arg);
+  case VIDIOC_STREAMON:
+    if (*(const int *)arg != V4L2_BUF_TYPE_VIDEO_CAPTURE || s_count == 0) {
+      return fake_err(EINVAL);
+    }
+    s_streaming = true;
+    s_st.streamon++;
+    return 0;
+  case VIDIOC_STREAMOFF:
+    if (*(const int *)arg != V4L2_BUF_TYPE_VIDEO_CAPTURE) {
+      return fake_err(EINVAL);
+    }
+    /* V4L2: todos os buffers voltam para o usuario */
+    for (uint32_t i = 0; i < s_count; i++) {
+      s_bufs[i].state = BUF_IDLE;
+    }
+    s_st.queued = 0;
+    s_st.done = 0;
+    s_streaming = false;
+    s_st.streamoff++;
+    return 0;
+  default:
+    return fake_err(ENOTTY);
+  }
+}
+
+void *fake_v4l2_mmap(void *addr, size_t len, int prot, int flags, int fd,
+                     off_t offset) {
+  (void)addr;
+  (void)prot;
+  (void)flags;
+  const int call = s_mmap_calls++;
+  const uint32_t idx = (uint32_t)(offset / FAKE_OFFSET_STEP);
+  if (!fake_fd_ok(fd) || call == s_cfg.fail_mmap || idx >= s_count ||
+      offset % FAKE_OFFSET_STEP != 0 || len != s_bufs[idx].length ||
+      s_bufs[idx].mapped) {
+    errno = EINVAL;
+    return MAP_FAILED;
+  }
+  s_bufs[idx].mapped = true;
+  s_st.mmaps++;
+  s_st.live_maps++;
+  return s_bufs[idx].mem;
+}
+
+int fake_v4l2_munmap(void *addr, size_t len) {
+  for (uint32_t i = 0; i < s_count; i++) {
+    if (s_bufs[i].mapped && s_bufs[i].mem == addr) {
+      if (len != s_bufs[i].length) {
+        return fake_err(EINVAL);
+      }
+      s_bufs[i].mapped = false;
+      s_st.munmaps++;
+      s_st.live_maps--;
+      return 0;
+    }
+  }
+  return fake_err(EINVAL);
+}
@@ -0,0 +1,71 @@
+#pragma once
+/* Dispositivo V4L2 em memoria para a sessao de camera do P4 (bsp_camera.c):
+ * os tres nos do esp_video, negociacao de formato, anel de buffers mmap e
+ * quadros completados sob comando do teste. O fonte testado chama
+ * fake_v4l2_open/close/ioctl/mmap/munmap no lugar das chamadas do sistema
+ * (ver test_bsp_camera.c). Um dispositivo aberto por vez. */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define FAKE_V4L2_NODES 3    /* /dev/video0..2 */
+#define FAKE_V4L2_MAX_BUFS 8
+
+typedef struct {
+  bool present[FAKE_V4L2_NODES]; /* o no existe */
+  bool capture[FAKE_V4L2_NODES]; /* ...e anuncia V4L2_CAP_VIDEO_CAPTURE */
+  bool rgb565;                   /* S_FMT aceita o formato */
+  bool rgb24;
+  uint32_t cur_w; /* resolucao do G_FMT (0: G_FMT falha) */
+  uint32_t cur_h;
+  uint32_t only_w; /* S_FMT so aceita este tamanho (0: qualquer) */
+  uint32_t only_h;
+  bool zero_bytesperline; /* S_FMT devolve bytesperline 0 */
+  uint32_t grant;         /* teto de buffers do REQBUFS */
+  int fail_querybuf;      /* indice cujo QUERYBUF falha (-1: nenhum) */
+  int fail_mmap;          /* n-esimo mmap que falha, a partir de 0 (-1) */
+  /* DQBUF sem quadro pronto: EAGAIN, e o seguinte completa um buffer da
+   * fila (a camera entrega enquanto o cliente espera) */
+  bool auto_frames;
+} fake_v4l2_cfg_t;
+
+typedef struct {
+  int opens; /* open() bem-sucedidos */
+  int closes;
+  int open_fds;
+  int streamon;
+  int streamoff;
+  int reqbufs_free; /* REQBUFS(0) aceitos */
+  int mmaps;
+  int munmaps;
+  int live_maps;
+  int dqbufs; /* DQBUF que entregaram um quadro */
+  int qbufs;
+  int queued; /* buffers na fila do driver agora */
+  int done;   /* quadros prontos ainda nao retirados */
+  int nonblock_opens;
+  const char *last_dev;
+  uint32_t frames; /* quadros completados desde o reset */
+} fake_v4l2_stats_t;
+
+/* Camera tipica: so /dev/video0, RGB565 e RGB24, 1920x1080 corrente,
+ * qualquer numero de buffers, quadros automaticos. */
+fake_v4l2_cfg_t fake_v4l2_defaults(void);
+/* Fecha tudo, libera a memoria e aplica cfg (NULL: padrao). */
+void fake_v4l2_reset(const fake_v4l2_cfg_t *cfg);
+void fake_v4l2_set_auto(bool on);
+/* Completa ate n buffers da fila, na ordem; retorna quantos. */
+int fake_v4l2_produce(int n);
+/* Proximo DQBUF falha com este errno (uma vez). */
+void fake_v4l2_fail_next_dqbuf(int err);
+/* Numero do quadro (1, 2, ...) gravado no inicio do buffer. */
+uint32_t fake_v4l2_frame_id(const uint8_t *data);
+const fake_v4l2_stats_t *fake_v4l2_stats(void);
+
+int fake_v4l2_open(const char *path, int flags, ...);
+int fake_v4l2_close(int fd);
+int fake_v4l2_ioctl(int fd, unsigned long request, ...);
+void *fake_v4l2_mmap(void *addr, size_t len, int prot, int flags, int fd,
+                     off_t offset);
+int fake_v4l2_munmap(void *addr, size_t len);
@@ -0,0 +1,278 @@
+#include "stub_http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define STUB_HEAD_MAX 4096
+
+static int s_listen = -1;
+static pthread_t s_thread;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char *s_response;
+static size_t s_response_len;
+static bool s_close_after;
+static bool s_drop_next;
+
+static int s_connections;
+static int s_requests;
+static char s_head[STUB_HEAD_MAX];
+static uint8_t *s_body;
+static size_t s_body_len;
+static bool s_chunked;
+
+/* Leitura com buffer sobre o socket aceito. */
+typedef struct {
+  int fd;
+  char buf[4096];
+  size_t pos;
+  size_t len;
+} stub_reader_t;
+
+static int stub_getc(stub_reader_t *r) {
+  if (r->pos == r->len) {
+    const ssize_t n = recv(r->fd, r->buf, sizeof(r->buf), 0);
+    if (n <= 0) {
+      return -1;
+    }
+    r->pos = 0;
+    r->len = (size_t)n;
+  }
+  return (unsigned char)r->buf[r->pos++];
+}
+
+static bool stub_read_line(stub_reader_t *r, char *line, size_t cap) {
+  size_t n = 0;
+  for (;;) {
+    const int c = stub_getc(r);
+    if (c < 0) {
+      return false;
+    }
+    if (c == '\n') {
+      break;
+    }
+    if (n < cap - 1) {
+      line[n++] = (char)c;
+    }
+  }
+  if (n > 0 && line[n - 1] == '\r') {
+    n--;
+  }
+  line[n] = '\0';
+  return true;
+}
+
+static bool stub_read_exact(stub_reader_t *r, uint8_t *dst, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    const int c = stub_getc(r);
+    if (c < 0) {
+      return false;
+    }
+    dst[i] = (uint8_t)c;
+  }
+  return true;
+}
+
+static void stub_body_append(uint8_t **body, size_t *len, size_t *cap,
+                             size_t extra) {
+  if (*len + extra + 1 > *cap) {
+    *cap = (*len + extra + 1) * 2;
+    *body = realloc(*body, *cap);
+  }
+}
+
+/* Uma requisicao; false se a conexao acabou. */
+static bool stub_handle_request(stub_reader_t *r) {
+  char head[STUB_HEAD_MAX] = {0};
+  char line[1024];
+  size_t head_len = 0;
+  long content_len = -1;
+  bool chunked = false;
+  do {
+    if (!stub_read_line(r, line, sizeof(line))) {
+      return false;
+    }
+    head_len += (size_t)snprintf(head + head_len, sizeof(head) - head_len,
+                                 "%s\r\n", line);
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      content_len = strtol(line + 15, NULL, 10);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 &&
+               strstr(line, "chunked")) {
+      chunked = true;
+    }
+  } while (line[0] != '\0');
+
+  uint8_t *body = NULL;
+  size_t len = 0;
+  size_t cap = 0;
+  stub_body_append(&body, &len, &cap, 0);
+  if (chunked) {
+    for (;;) {
+      if (!stub_read_line(r, line, sizeof(line))) {
+        free(body);
+        return false;
+      }
+      const size_t n = strtoul(line, NULL, 16);
+      if (n == 0) {
+        stub_read_line(r, line, sizeof(line)); /* CRLF final */
+        break;
+      }
+      stub_body_append(&body, &len, &cap, n);
+      if (!stub_read_exact(r, body + len, n) ||
+          !stub_read_line(r, line, sizeof(line))) {
+        free(body);
+        return false;
+      }
+      len += n;
+    }
+  } else if (content_len > 0) {
+    stub_body_append(&body, &len, &cap, (size_t)content_len);
+    if (!stub_read_exact(r, body, (size_t)content_len)) {
+      free(body);
+      return false;
+    }
+    len = (size_t)content_len;
+  }
+  body[len] = '\0';
+
+  pthread_mutex_lock(&s_lock);
+  memcpy(s_head, head, sizeof(s_head));
+  free(s_body);
+  s_body = body;
+  s_body_len = len;
+  s_chunked = chunked;
+  s_requests++;
+  /* copia: o teste pode trocar a resposta enquanto ela e enviada */
+  const size_t resp_len = s_response_len;
+  char *resp = resp_len ? malloc(resp_len) : NULL;
+  if (resp) {
+    memcpy(resp, s_response, resp_len);
+  }
+  const bool close_after = s_close_after;
+  const bool drop = s_drop_next;
+  s_drop_next = false;
+  pthread_mutex_unlock(&s_lock);
+
+  bool ok = !drop;
+  if (ok && resp) {
+    ok = send(r->fd, resp, resp_len, MSG_NOSIGNAL) == (ssize_t)resp_len;
+  }
+  free(resp);
+  return ok && !close_after;
+}
+
+static void *stub_server_main(void *arg) {
+  (void)arg;
+  for (;;) {
+    const int fd = accept(s_listen, NULL, NULL);
+    if (fd < 0) {
+      return NULL; /* listen fechado em stub_server_stop */
+    }
+    pthread_mutex_lock(&s_lock);
+    s_connections++;
+    pthread_mutex_unlock(&s_lock);
+    stub_reader_t r = {.fd = fd};
+    while (stub_handle_request(&r)) {
+    }
+    close(fd);
+  }
+}
+
+uint16_t stub_server_start(void) {
+  s_listen = socket(AF_INET, SOCK_STREAM, 0);
+  const int one = 1;
+  setsockopt(s_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {
+      .sin_family = AF_INET,
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+  };
+  socklen_t addr_len = sizeof(addr);
+  if (bind(s_listen, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(s_listen, 4) < 0 ||
+      getsockname(s_listen, (struct sockaddr *)&addr, &addr_len) < 0 ||
+      pthread_create(&s_thread, NULL, stub_server_main, NULL) != 0) {
+    close(s_listen);
+    s_listen = -1;
+    return 0;
+  }
+  return ntohs(addr.sin_port);
+}
+
+void stub_server_stop(void) {
+  if (s_listen >= 0) {
+    shutdown(s_listen, SHUT_RDWR);
+    close(s_listen);
+    pthread_join(s_thread, NULL);
+    s_listen = -1;
+  }
+  free(s_response);
+  free(s_body);
+  s_response = NULL;
+  s_body = NULL;
+}
+
+void stub_server_set_response(const char *raw, size_t len, bool close_after) {
+  char *copy = malloc(len + 1);
+  memcpy(copy, raw, len);
+  pthread_mutex_lock(&s_lock);
+  free(s_response);
+  s_response = copy;
+  s_response_len = len;
+  s_close_after = close_after;
+  pthread_mutex_unlock(&s_lock);
+}
+
+char *stub_sse_response(const char *const *events, size_t n, size_t *len) {
+  static const char head[] = "HTTP/1.1 200 OK\r\n"
+                             "Content-Type: text/event-stream\r\n"
+                             "Transfer-Encoding: chunked\r\n\r\n";
+  size_t cap = sizeof(head) + 16;
+  for (size_t i = 0; i < n; i++) {
+    cap += strlen(events[i]) + 16;
+  }
+  char *out = malloc(cap);
+  size_t o = (size_t)snprintf(out, cap, "%s", head);
+  for (size_t i = 0; i < n; i++) {
+    const size_t el = strlen(events[i]);
+    o += (size_t)snprintf(out + o, cap - o, "%zx\r\n%s\r\n", el, events[i]);
+  }
+  o += (size_t)snprintf(out + o, cap - o, "0\r\n\r\n");
+  *len = o;
+  return out;
+}
+
+void stub_server_drop_next(void) {
+  pthread_mutex_lock(&s_lock);
+  s_drop_next = true;
+  pthread_mutex_unlock(&s_lock);
+}
+
+int stub_server_connections(void) {
+  pthread_mutex_lock(&s_lock);
+  const int n = s_connections;
+  pthread_mutex_unlock(&s_lock);
+  return n;
+}
+
+int stub_server_requests(void) {
+  pthread_mutex_lock(&s_lock);
+  const int n = s_requests;
+  pthread_mutex_unlock(&s_lock);
+  return n;
+}
+
+const char *stub_server_last_head(void) { return s_head; }
+
+const uint8_t *stub_server_last_body(size_t *len) {
+  *len = s_body_len;
+  return s_body;
+}
+
+bool stub_server_last_was_chunked(void) { return s_chunked; }
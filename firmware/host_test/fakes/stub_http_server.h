@@ -0,0 +1,32 @@
+#pragma once
+/* Servidor HTTP/1.1 minimo em 127.0.0.1 para testar o ai_client de ponta a
+ * ponta: aceita corpo com Content-Length ou chunked, guarda a ultima
+ * requisicao e responde com bytes prontos. Atende uma conexao por vez,
+ * varias requisicoes por conexao (keep-alive). */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Sobe o servidor numa porta livre; retorna a porta (0 em erro). */
+uint16_t stub_server_start(void);
+void stub_server_stop(void);
+
+/* Resposta HTTP completa (status, cabecalhos e corpo) para as proximas
+ * requisicoes. close_after: fecha a conexao depois de responder. */
+void stub_server_set_response(const char *raw, size_t len, bool close_after);
+
+/* Monta uma resposta 200 text/event-stream chunked com um chunk por
+ * evento. Retorna buffer alocado (free). */
+char *stub_sse_response(const char *const *events, size_t n, size_t *len);
+
+/* A proxima requisicao e lida e a conexao fechada sem resposta (servidor
+ * que descartou a conexao ociosa no meio do caminho). */
+void stub_server_drop_next(void);
+
+int stub_server_connections(void);
+int stub_server_requests(void);
+/* Ultima requisicao: cabecalhos (terminados em '\0') e corpo ja sem o
+ * framing chunked. */
+const char *stub_server_last_head(void);
+const uint8_t *stub_server_last_body(size_t *len);
+bool stub_server_last_was_chunked(void);
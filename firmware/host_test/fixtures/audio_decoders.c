@@ -0,0 +1,466 @@
+#include "audio_decoders.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FAIL(...)                                                            \
+  do {                                                                       \
+    fprintf(stderr, "decoder: " __VA_ARGS__);                                \
+    fputc('\n', stderr);                                                     \
+    return -1;                                                               \
+  } while (0)
+
+/* ---- FLAC ---------------------------------------------------------------- */
+
+typedef struct {
+  const uint8_t *p;
+  size_t len;
+  size_t bit; /* posicao em bits */
+  bool err;
+} bitreader_t;
+
+static uint32_t br_bits(bitreader_t *br, unsigned n) {
+  uint32_t v = 0;
+  for (unsigned i = 0; i < n; i++) {
+    const size_t byte = br->bit >> 3;
+    if (byte >= br->len) {
+      br->err = true;
+      return 0;
+    }
+    v = (v << 1) | ((br->p[byte] >> (7 - (br->bit & 7))) & 1U);
+    br->bit++;
+  }
+  return v;
+}
+
+static int32_t br_signed(bitreader_t *br, unsigned n) {
+  const uint32_t v = br_bits(br, n);
+  if (n == 0) {
+    return 0;
+  }
+  /* extensao de sinal */
+  return (v & (1U << (n - 1))) ? (int32_t)(v | ~((1U << (n - 1)) * 2 - 1))
+                               : (int32_t)v;
+}
+
+static uint32_t br_unary(bitreader_t *br) {
+  uint32_t zeros = 0;
+  while (!br->err && br_bits(br, 1) == 0) {
+    zeros++;
+  }
+  return zeros;
+}
+
+static uint8_t crc8_ref(const uint8_t *p, size_t n) {
+  unsigned crc = 0;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc << 1) ^ ((crc & 0x80) ? 0x107 : 0);
+    }
+  }
+  return (uint8_t)crc;
+}
+
+static uint16_t crc16_ref(const uint8_t *p, size_t n) {
+  unsigned crc = 0;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= (unsigned)p[i] << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc << 1) ^ ((crc & 0x8000) ? 0x18005 : 0);
+    }
+  }
+  return (uint16_t)crc;
+}
+
+static bool read_utf8_number(bitreader_t *br, uint64_t *v) {
+  uint32_t first = br_bits(br, 8);
+  unsigned extra = 0;
+  while (extra < 7 && (first & (0x80U >> extra))) {
+    extra++;
+  }
+  if (extra == 1 || extra > 7) {
+    return false; /* byte de continuacao no inicio */
+  }
+  if (extra == 0) {
+    *v = first;
+    return true;
+  }
+  uint64_t val = first & (0x7FU >> extra);
+  for (unsigned i = 1; i < extra; i++) {
+    const uint32_t c = br_bits(br, 8);
+    if ((c & 0xC0) != 0x80) {
+      return false;
+    }
+    val = (val << 6) | (c & 0x3F);
+  }
+  *v = val;
+  return !br->err;
+}
+
+static int decode_residual(bitreader_t *br, unsigned order, size_t n,
+                           int32_t *res) {
+  const unsigned method = br_bits(br, 2);
+  if (method > 1) {
+    FAIL("reserved residual coding method %u", method);
+  }
+  const unsigned pbits = method ? 5 : 4;
+  const uint32_t escape = method ? 31 : 15;
+  const unsigned porder = br_bits(br, 4);
+  const size_t parts = (size_t)1 << porder;
+  if ((n % parts) != 0 || (n >> porder) < order) {
+    FAIL("bad partition order %u for %zu samples", porder, n);
+  }
+  size_t o = 0;
+  for (size_t p = 0; p < parts; p++) {
+    const size_t count = (n >> porder) - ((p == 0) ? order : 0);
+    const uint32_t k = br_bits(br, pbits);
+    if (k == escape) {
+      const unsigned raw = br_bits(br, 5);
+      for (size_t i = 0; i < count; i++) {
+        res[o++] = br_signed(br, raw);
+      }
+      continue;
+    }
+    for (size_t i = 0; i < count; i++) {
+      const uint32_t q = br_unary(br);
+      const uint32_t u = (q << k) | br_bits(br, k);
+      res[o++] = (u & 1) ? -(int32_t)(u >> 1) - 1 : (int32_t)(u >> 1);
+    }
+  }
+  return br->err ? -1 : 0;
+}
+
+static int decode_subframe(bitreader_t *br, size_t n, int32_t *x,
+                           flac_dec_info_t *info) {
+  if (br_bits(br, 1) != 0) {
+    FAIL("subframe padding bit set");
+  }
+  const unsigned type = br_bits(br, 6);
+  unsigned wasted = 0;
+  if (br_bits(br, 1)) {
+    wasted = br_unary(br) + 1;
+  }
+  const unsigned bps = 16 - wasted;
+
+  if (type == 0) {
+    info->subframes[0]++;
+    const int32_t v = br_signed(br, bps);
+    for (size_t i = 0; i < n; i++) {
+      x[i] = v;
+    }
+  } else if (type == 1) {
+    info->subframes[1]++;
+    for (size_t i = 0; i < n; i++) {
+      x[i] = br_signed(br, bps);
+    }
+  } else if (type >= 8 && type <= 12) {
+    info->subframes[2]++;
+    const unsigned order = type - 8;
+    for (unsigned i = 0; i < order; i++) {
+      x[i] = br_signed(br, bps);
+    }
+    if (decode_residual(br, order, n, x + order) != 0) {
+      return -1;
+    }
+    /* preditores fixos do formato: diferencas de ordem 0..4 */
+    static const int c[5][4] = {
+        {0, 0, 0, 0}, {1, 0, 0, 0}, {2, -1, 0, 0}, {3, -3, 1, 0},
+        {4, -6, 4, -1}};
+    for (size_t i = order; i < n; i++) {
+      int64_t pred = 0;
+      for (unsigned j = 0; j < order; j++) {
+        pred += (int64_t)c[order][j] * x[i - 1 - j];
+      }
+      x[i] += (int32_t)pred;
+    }
+  } else if (type >= 32) {
+    info->subframes[3]++;
+    const unsigned order = type - 31;
+    for (unsigned i = 0; i < order; i++) {
+      x[i] = br_signed(br, bps);
+    }
+    const unsigned precision = br_bits(br, 4) + 1;
+    if (precision == 16) {
+      FAIL("invalid QLP precision");
+    }
+    const int shift = br_signed(br, 5);
+    if (shift < 0) {
+      FAIL("negative QLP shift");
+    }
+    int32_t qlp[32];
+    for (unsigned j = 0; j < order; j++) {
+      qlp[j] = br_signed(br, precision);
+    }
+    if (decode_residual(br, order, n, x + order) != 0) {
+      return -1;
+    }
+    for (size_t i = order; i < n; i++) {
+      int64_t sum = 0;
+      for (unsigned j = 0; j < order; j++) {
+        sum += (int64_t)qlp[j] * x[i - 1 - j];
+      }
+      x[i] += (int32_t)(sum >> shift);
+    }
+  } else {
+    FAIL("reserved subframe type %u", type);
+  }
+  for (size_t i = 0; i < n; i++) {
+    x[i] = (int32_t)((uint32_t)x[i] << wasted);
+  }
+  return br->err ? -1 : 0;
+}
+
+static unsigned block_size_of(unsigned code, bitreader_t *br) {
+  if (code == 1) {
+    return 192;
+  }
+  if (code >= 2 && code <= 5) {
+    return 576U << (code - 2);
+  }
+  if (code == 6) {
+    return br_bits(br, 8) + 1;
+  }
+  if (code == 7) {
+    return br_bits(br, 16) + 1;
+  }
+  if (code >= 8) {
+    return 256U << (code - 8);
+  }
+  return 0;
+}
+
+long flac_dec_decode(const uint8_t *in, size_t len, int16_t *out,
+                     size_t out_cap, flac_dec_info_t *info) {
+  static const uint32_t rates[12] = {0,     88200, 176400, 192000,
+                                     8000,  16000, 22050,  24000,
+                                     32000, 44100, 48000,  96000};
+  memset(info, 0, sizeof(*info));
+  if (len < 8 || memcmp(in, "fLaC", 4) != 0) {
+    FAIL("missing fLaC marker");
+  }
+  size_t pos = 4;
+  bool have_streaminfo = false;
+  for (;;) {
+    if (pos + 4 > len) {
+      FAIL("truncated metadata");
+    }
+    const bool last = in[pos] & 0x80;
+    const unsigned type = in[pos] & 0x7F;
+    const size_t blen = ((size_t)in[pos + 1] << 16) |
+                        ((size_t)in[pos + 2] << 8) | in[pos + 3];
+    pos += 4;
+    if (pos + blen > len) {
+      FAIL("truncated metadata block");
+    }
+    if (type == 0) {
+      if (blen != 34) {
+        FAIL("STREAMINFO length %zu", blen);
+      }
+      bitreader_t br = {.p = in + pos, .len = 34};
+      info->min_block = br_bits(&br, 16);
+      info->max_block = br_bits(&br, 16);
+      info->min_frame = br_bits(&br, 24);
+      info->max_frame = br_bits(&br, 24);
+      info->sample_rate_hz = br_bits(&br, 20);
+      const unsigned channels = br_bits(&br, 3) + 1;
+      const unsigned bps = br_bits(&br, 5) + 1;
+      info->total_samples = ((uint64_t)br_bits(&br, 4) << 32) |
+                            br_bits(&br, 32);
+      if (channels != 1 || bps != 16) {
+        FAIL("only mono 16-bit is supported (%u ch, %u bits)", channels, bps);
+      }
+      have_streaminfo = true;
+    }
+    pos += blen;
+    if (last) {
+      break;
+    }
+  }
+  if (!have_streaminfo) {
+    FAIL("no STREAMINFO");
+  }
+
+  static int32_t x[65536];
+  size_t total = 0;
+  uint64_t expect_frame = 0;
+  info->frame_min_seen = SIZE_MAX;
+  while (pos < len) {
+    const size_t frame_start = pos;
+    bitreader_t br = {.p = in + pos, .len = len - pos};
+    if (br_bits(&br, 14) != 0x3FFE) {
+      FAIL("lost frame sync at byte %zu", pos);
+    }
+    if (br_bits(&br, 1) != 0 || br_bits(&br, 1) != 0) {
+      FAIL("reserved bit or variable blocking");
+    }
+    const unsigned bs_code = br_bits(&br, 4);
+    const unsigned sr_code = br_bits(&br, 4);
+    const unsigned ch = br_bits(&br, 4);
+    const unsigned ss = br_bits(&br, 3);
+    if (br_bits(&br, 1) != 0 || bs_code == 0 || sr_code == 15 || ch != 0 ||
+        (ss != 4 && ss != 0)) {
+      FAIL("unsupported frame header at byte %zu", pos);
+    }
+    uint64_t frame_num = 0;
+    if (!read_utf8_number(&br, &frame_num) || frame_num != expect_frame) {
+      FAIL("frame number %llu, expected %llu",
+           (unsigned long long)frame_num, (unsigned long long)expect_frame);
+    }
+    expect_frame++;
+    const unsigned n = block_size_of(bs_code, &br);
+    uint32_t rate = (sr_code < 12) ? rates[sr_code] : 0;
+    if (sr_code == 12) {
+      rate = br_bits(&br, 8) * 1000;
+    } else if (sr_code == 13) {
+      rate = br_bits(&br, 16);
+    } else if (sr_code == 14) {
+      rate = br_bits(&br, 16) * 10;
+    }
+    if (rate != 0 && rate != info->sample_rate_hz) {
+      FAIL("frame rate %u != STREAMINFO %u", rate, info->sample_rate_hz);
+    }
+    const size_t hdr_len = br.bit / 8;
+    if (br_bits(&br, 8) != crc8_ref(in + pos, hdr_len)) {
+      FAIL("header CRC-8 mismatch in frame %llu",
+           (unsigned long long)frame_num);
+    }
+    if (n == 0 || n > 65535 || total + n > out_cap) {
+      FAIL("bad block size %u", n);
+    }
+    if (decode_subframe(&br, n, x, info) != 0) {
+      FAIL("subframe error in frame %llu", (unsigned long long)frame_num);
+    }
+    br.bit = (br.bit + 7) & ~(size_t)7;
+    const size_t body = br.bit / 8;
+    const uint16_t crc = (uint16_t)br_bits(&br, 16);
+    if (br.err || crc != crc16_ref(in + pos, body)) {
+      FAIL("frame CRC-16 mismatch in frame %llu",
+           (unsigned long long)frame_num);
+    }
+    for (unsigned i = 0; i < n; i++) {
+      if (x[i] < INT16_MIN || x[i] > INT16_MAX) {
+        FAIL("sample out of range");
+      }
+      out[total + i] = (int16_t)x[i];
+    }
+    total += n;
+    pos += body + 2;
+    const size_t flen = pos - frame_start;
+    info->frames++;
+    if (flen < info->frame_min_seen) {
+      info->frame_min_seen = flen;
+    }
+    if (flen > info->frame_max_seen) {
+      info->frame_max_seen = flen;
+    }
+  }
+  return (long)total;
+}
+
+/* ---- IMA-ADPCM ----------------------------------------------------------- */
+
+static uint32_t le16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+static uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+/* Tabela de passos da especificacao IMA (step[i] ~ 7 * 1.1^i). */
+static const int k_steps[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static int16_t ima_nibble(unsigned code, int *pred, int *index) {
+  const int step = k_steps[*index];
+  int diff = step >> 3;
+  if (code & 1) {
+    diff += step >> 2;
+  }
+  if (code & 2) {
+    diff += step >> 1;
+  }
+  if (code & 4) {
+    diff += step;
+  }
+  int p = *pred + ((code & 8) ? -diff : diff);
+  p = p > 32767 ? 32767 : (p < -32768 ? -32768 : p);
+  *pred = p;
+  static const int adj[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+  int i = *index + adj[code & 7];
+  *index = i < 0 ? 0 : (i > 88 ? 88 : i);
+  return (int16_t)p;
+}
+
+long ima_dec_wav_decode(const uint8_t *in, size_t len, int16_t *out,
+                        size_t out_cap, uint32_t *sample_rate_hz) {
+  if (len < 12 || memcmp(in, "RIFF", 4) != 0 || memcmp(in + 8, "WAVE", 4)) {
+    FAIL("not a RIFF/WAVE file");
+  }
+  if (le32(in + 4) != len - 8) {
+    FAIL("RIFF size %u != %zu", le32(in + 4), len - 8);
+  }
+  const uint8_t *fmt = NULL;
+  const uint8_t *data = NULL;
+  size_t data_len = 0;
+  long fact = -1;
+  for (size_t pos = 12; pos + 8 <= len;) {
+    const uint32_t clen = le32(in + pos + 4);
+    if (pos + 8 + clen > len) {
+      FAIL("truncated chunk");
+    }
+    if (memcmp(in + pos, "fmt ", 4) == 0 && clen >= 20) {
+      fmt = in + pos + 8;
+    } else if (memcmp(in + pos, "fact", 4) == 0 && clen >= 4) {
+      fact = (long)le32(in + pos + 8);
+    } else if (memcmp(in + pos, "data", 4) == 0) {
+      data = in + pos + 8;
+      data_len = clen;
+    }
+    pos += 8 + clen + (clen & 1);
+  }
+  if (!fmt || !data || fact < 0) {
+    FAIL("missing fmt/fact/data chunk");
+  }
+  const unsigned align = le16(fmt + 12);
+  const unsigned spb = le16(fmt + 18);
+  if (le16(fmt) != 0x0011 || le16(fmt + 2) != 1 || le16(fmt + 14) != 4 ||
+      le16(fmt + 16) != 2 || spb != (align - 4) * 2 + 1) {
+    FAIL("unexpected IMA fmt chunk");
+  }
+  if (le32(fmt + 8) != (uint32_t)(((uint64_t)le32(fmt + 4) * align) / spb)) {
+    FAIL("bad byte rate");
+  }
+  if (data_len % align != 0 || (size_t)fact > (data_len / align) * spb ||
+      (size_t)fact > out_cap) {
+    FAIL("data length %zu does not fit fact %ld", data_len, fact);
+  }
+  *sample_rate_hz = le32(fmt + 4);
+
+  size_t o = 0;
+  for (const uint8_t *b = data; b < data + data_len && o < (size_t)fact;
+       b += align) {
+    int pred = (int16_t)le16(b);
+    int index = b[2];
+    if (index > 88 || b[3] != 0) {
+      FAIL("bad block header");
+    }
+    out[o++] = (int16_t)pred;
+    for (unsigned i = 4; i < align && o < (size_t)fact; i++) {
+      out[o++] = ima_nibble(b[i] & 0x0F, &pred, &index);
+      if (o < (size_t)fact) {
+        out[o++] = ima_nibble(b[i] >> 4, &pred, &index);
+      }
+    }
+  }
+  return (long)o;
+}
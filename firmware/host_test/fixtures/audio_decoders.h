@@ -0,0 +1,32 @@
+#pragma once
+/* Decodificadores de referencia para os testes do audio_codec, escritos a
+ * partir das especificacoes (FLAC format, IMA/DVI ADPCM) e independentes
+ * dos codificadores: nenhuma tabela ou funcao e compartilhada. */
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  /* STREAMINFO */
+  uint32_t sample_rate_hz;
+  uint64_t total_samples;
+  unsigned min_block;
+  unsigned max_block;
+  uint32_t min_frame; /* 0 = desconhecido */
+  uint32_t max_frame;
+  /* observado nos frames */
+  size_t frames;
+  size_t frame_min_seen;
+  size_t frame_max_seen;
+  unsigned subframes[4]; /* CONSTANT, VERBATIM, FIXED, LPC */
+} flac_dec_info_t;
+
+/* Stream FLAC mono 16 bits com blocos fixos. Confere CRC-8 de cada
+ * cabecalho, CRC-16 de cada frame e a sequencia dos numeros de frame.
+ * Retorna amostras decodificadas, ou -1 (motivo em stderr). */
+long flac_dec_decode(const uint8_t *in, size_t len, int16_t *out,
+                     size_t out_cap, flac_dec_info_t *info);
+
+/* WAV IMA-ADPCM mono (wFormatTag 0x0011). Percorre os chunks RIFF e
+ * devolve as amostras do chunk fact. Retorna amostras, ou -1. */
+long ima_dec_wav_decode(const uint8_t *in, size_t len, int16_t *out,
+                        size_t out_cap, uint32_t *sample_rate_hz);
@@ -0,0 +1,99 @@
+#include "audio_signals.h"
+
+#include <math.h>
+
+const char *audio_sig_name(audio_sig_t sig) {
+  static const char *const names[] = {"silence", "speech", "noise", "sine",
+                                      "clipped"};
+  return (sig < AUDIO_SIG_COUNT) ? names[sig] : "?";
+}
+
+static uint32_t sig_rand(uint32_t *s) {
+  uint32_t x = *s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *s = x;
+  return x;
+}
+
+/* Uniforme em [-1, 1). */
+static double sig_uniform(uint32_t *s) {
+  return (double)(sig_rand(s) >> 8) / (double)(1U << 23) - 1.0;
+}
+
+static int16_t sig_clamp(double v) {
+  if (v > 32767.0) {
+    return 32767;
+  }
+  if (v < -32768.0) {
+    return -32768;
+  }
+  return (int16_t)lrint(v);
+}
+
+/* Silabas de 220 ms (fundamental deslizando entre 110 e 220 Hz, 8
+ * harmonicos com queda de 1/k e envelope), fricativas de 80 ms e pausas
+ * de 150 ms; ruido de fundo de ~30 RMS o tempo todo. */
+static void sig_speech(int16_t *out, size_t n, uint32_t rate, uint32_t seed,
+                       double gain) {
+  const size_t syl = rate * 220 / 1000;
+  const size_t fric = rate * 80 / 1000;
+  const size_t pause = rate * 150 / 1000;
+  const size_t period = syl + fric + pause;
+  double phase = 0.0;
+  double lp = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    const size_t k = i / period;
+    const size_t t = i % period;
+    double v = sig_uniform(&seed) * 52.0; /* fundo: RMS ~30 */
+    if (t < syl) {
+      const double x = (double)t / (double)syl;
+      const double f0 = 110.0 + 110.0 * fmod(0.37 * (double)k + 0.5 * x, 1.0);
+      phase += 2.0 * M_PI * f0 / rate;
+      double h = 0.0;
+      for (int m = 1; m <= 8 && m * f0 < rate / 2.0; m++) {
+        h += sin(m * phase) / m;
+      }
+      const double env = sin(M_PI * x);
+      v += gain * (2500.0 + 1500.0 * (double)(k % 3)) * env * h;
+    } else if (t < syl + fric) {
+      /* ruido passa-alta: diferenca de amostras */
+      const double w = sig_uniform(&seed);
+      v += gain * 600.0 * (w - lp);
+      lp = w;
+    }
+    out[i] = sig_clamp(v);
+  }
+}
+
+void audio_sig_fill(audio_sig_t sig, int16_t *out, size_t n,
+                    uint32_t sample_rate_hz, uint32_t seed) {
+  if (seed == 0) {
+    seed = 1;
+  }
+  switch (sig) {
+  case AUDIO_SIG_SPEECH:
+    sig_speech(out, n, sample_rate_hz, seed, 1.0);
+    break;
+  case AUDIO_SIG_CLIPPED:
+    sig_speech(out, n, sample_rate_hz, seed, 12.0);
+    break;
+  case AUDIO_SIG_NOISE:
+    for (size_t i = 0; i < n; i++) {
+      out[i] = (int16_t)(sig_rand(&seed) >> 16);
+    }
+    break;
+  case AUDIO_SIG_SINE:
+    for (size_t i = 0; i < n; i++) {
+      out[i] =
+          sig_clamp(16384.0 * sin(2.0 * M_PI * 440.0 * i / sample_rate_hz));
+    }
+    break;
+  default:
+    for (size_t i = 0; i < n; i++) {
+      out[i] = 0;
+    }
+    break;
+  }
+}
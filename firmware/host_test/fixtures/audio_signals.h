@@ -0,0 +1,21 @@
+#pragma once
+/* Sinais sinteticos deterministicos para os testes e benchmarks de audio.
+ * Nao substituem gravacoes reais: servem para exercitar cada caminho dos
+ * codificadores/filtros e dar numeros comparaveis entre execucoes. */
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  AUDIO_SIG_SILENCE, /* zeros (subframes CONSTANT) */
+  AUDIO_SIG_SPEECH,  /* silabas sonoras, fricativas, pausas com ruido */
+  AUDIO_SIG_NOISE,   /* ruido branco de escala cheia (VERBATIM) */
+  AUDIO_SIG_SINE,    /* 440 Hz a -6 dBFS */
+  AUDIO_SIG_CLIPPED, /* fala saturada nos limites do int16 */
+  AUDIO_SIG_COUNT,
+} audio_sig_t;
+
+const char *audio_sig_name(audio_sig_t sig);
+
+/* Preenche out com n amostras do sinal na taxa dada. */
+void audio_sig_fill(audio_sig_t sig, int16_t *out, size_t n,
+                    uint32_t sample_rate_hz, uint32_t seed);
@@ -0,0 +1,117 @@
+#include "scaler_ref.h"
+
+static uint32_t ref_rand(uint32_t *s) {
+  uint32_t x = *s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *s = x;
+  return x;
+}
+
+void scaler_ref_fill_frame(uint8_t *frame, uint32_t w, uint32_t h,
+                           uint32_t stride, uint32_t bpp, uint32_t seed) {
+  for (uint32_t y = 0; y < h; y++) {
+    uint8_t *line = frame + (size_t)y * stride;
+    for (uint32_t i = 0; i < stride; i++) {
+      const uint32_t x = i / bpp;
+      const uint32_t noise = ref_rand(&seed) & 0x1F;
+      line[i] = (uint8_t)(x < w ? (x * 7 + y * 3 + (i % bpp) * 85 + noise)
+                                : ref_rand(&seed));
+    }
+  }
+}
+
+/* Copia do laco de bsp.c antes do bsp_scaler. */
+void scaler_ref_old_loop(const uint8_t *src, uint32_t w, uint32_t h,
+                         uint32_t stride, uint32_t bpp, uint8_t *dst,
+                         uint32_t size) {
+  const uint32_t src_side = (w < h) ? w : h;
+  const uint32_t crop_x = (w - src_side) / 2;
+  const uint32_t crop_y = (h - src_side) / 2;
+
+  for (uint32_t y = 0; y < size; y++) {
+    uint8_t *dst_line = dst + y * size * 2;
+    const uint32_t src_y = crop_y + (((uint64_t)y * src_side) / size);
+    const uint8_t *src_line = src + src_y * stride;
+
+    if (bpp == 2) {
+      for (uint32_t x = 0; x < size; x++) {
+        const uint32_t src_x = crop_x + (((uint64_t)x * src_side) / size);
+        const uint8_t *src_pixel = src_line + src_x * 2;
+        dst_line[x * 2] = src_pixel[0];
+        dst_line[x * 2 + 1] = src_pixel[1];
+      }
+    } else {
+      for (uint32_t x = 0; x < size; x++) {
+        const uint32_t src_x = crop_x + (((uint64_t)x * src_side) / size);
+        const uint8_t *src_pixel = src_line + src_x * 3;
+        uint8_t r = src_pixel[0];
+        uint8_t g = src_pixel[1];
+        uint8_t b = src_pixel[2];
+        uint16_t rgb565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        dst_line[x * 2] = (uint8_t)(rgb565 & 0xFF);
+        dst_line[x * 2 + 1] = (uint8_t)(rgb565 >> 8);
+      }
+    }
+  }
+}
+
+void scaler_ref_swap(uint16_t *buf, size_t pixel_count) {
+  for (size_t i = 0; i < pixel_count; i++) {
+    uint16_t v = buf[i];
+    buf[i] = (uint16_t)((v >> 8) | (v << 8));
+  }
+}
+
+/* Canais de um pixel da origem: campos 5/6/5 no RGB565, bytes no RGB24
+ * (o bsp_scaler tira a media em 8 bits e so depois converte). */
+static void ref_pixel(const uint8_t *p, uint32_t bpp, uint32_t c[3]) {
+  if (bpp == 2) {
+    const uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+    c[0] = v >> 11;
+    c[1] = (v >> 5) & 0x3F;
+    c[2] = v & 0x1F;
+  } else {
+    c[0] = p[0];
+    c[1] = p[1];
+    c[2] = p[2];
+  }
+}
+
+void scaler_ref_box(const uint8_t *src, uint32_t w, uint32_t h,
+                    uint32_t stride, uint32_t bpp, uint8_t *dst,
+                    uint32_t size) {
+  const uint32_t side = (w < h) ? w : h;
+  const uint32_t crop_x = (w - side) / 2;
+  const uint32_t crop_y = (h - side) / 2;
+  for (uint32_t y = 0; y < size; y++) {
+    const uint32_t sy0 = crop_y + (y * side) / size;
+    const uint32_t sy1 = sy0 < crop_y + side - 1 ? sy0 + 1 : sy0;
+    for (uint32_t x = 0; x < size; x++) {
+      const uint32_t sx0 = crop_x + (x * side) / size;
+      const uint32_t sx1 = sx0 < crop_x + side - 1 ? sx0 + 1 : sx0;
+      const uint32_t xs[4] = {sx0, sx1, sx0, sx1};
+      const uint32_t ys[4] = {sy0, sy0, sy1, sy1};
+      uint32_t sum[3] = {0, 0, 0};
+      for (int k = 0; k < 4; k++) {
+        uint32_t c[3];
+        ref_pixel(src + (size_t)ys[k] * stride + xs[k] * bpp, bpp, c);
+        for (int i = 0; i < 3; i++) {
+          sum[i] += c[i];
+        }
+      }
+      uint32_t r = (sum[0] + 2) >> 2;
+      uint32_t g = (sum[1] + 2) >> 2;
+      uint32_t b = (sum[2] + 2) >> 2;
+      if (bpp == 3) {
+        r >>= 3;
+        g >>= 2;
+        b >>= 3;
+      }
+      const uint32_t v = (r << 11) | (g << 5) | b;
+      dst[2 * ((size_t)y * size + x)] = (uint8_t)(v & 0xFF);
+      dst[2 * ((size_t)y * size + x) + 1] = (uint8_t)(v >> 8);
+    }
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+/* Referencias do crop/scale da preview do P4 (bsp_scaler): o laco que
+ * bsp_camera_capture_preview_rgb565() usava antes das tabelas, a troca de
+ * bytes que o gui.c fazia depois dele e um filtro 2x2 campo a campo. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Quadro sintetico: gradientes com ruido, bytes de stride alem da linha
+ * preenchidos com lixo. */
+void scaler_ref_fill_frame(uint8_t *frame, uint32_t w, uint32_t h,
+                           uint32_t stride, uint32_t bpp, uint32_t seed);
+
+/* Crop quadrado central e amostragem para size x size em RGB565, uma
+ * divisao de 64 bits por pixel, bytes na ordem da camera. */
+void scaler_ref_old_loop(const uint8_t *src, uint32_t w, uint32_t h,
+                         uint32_t stride, uint32_t bpp, uint8_t *dst,
+                         uint32_t size);
+
+/* gui_swap_rgb565_bytes(): RGB565 na ordem do LCD. */
+void scaler_ref_swap(uint16_t *buf, size_t pixel_count);
+
+/* Media arredondada do bloco 2x2 de origem, canal por canal. */
+void scaler_ref_box(const uint8_t *src, uint32_t w, uint32_t h,
+                    uint32_t stride, uint32_t bpp, uint8_t *dst,
+                    uint32_t size);
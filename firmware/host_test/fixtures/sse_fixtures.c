@@ -0,0 +1,191 @@
+#include "sse_fixtures.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Tokens em UTF-8, como o modelo os emitiria. */
+static const char *const k_tokens[] = {
+    "Cla",  "ro",      "!",       " A",     " tem", "pe",     "ratura",
+    " em",  " S\xc3\xa3o", " Paulo", " \xc3\xa9", " de", " 23", "\xc2\xb0",
+    "C",    ".",       "\n\n",    "Dica",   ":",    " leve",  " um",
+    " \"",  "guarda",  "-chuva",  "\"",     " \xf0\x9f\x8c\x82", " \xe2\x80\x94",
+    " a",   " tarde",  " pode",   " ter",   " garoa", ".",
+};
+#define TOKEN_COUNT (sizeof(k_tokens) / sizeof(k_tokens[0]))
+
+const char *sse_fixture_name(sse_fixture_t f) {
+  static const char *const names[] = {"openai", "groq", "ollama"};
+  return (f < SSE_FIXTURE_COUNT) ? names[f] : "?";
+}
+
+/* Escape JSON; ascii_only gera \uXXXX (com surrogates) para nao-ASCII. */
+static size_t json_escape(const char *in, char *out, int ascii_only) {
+  size_t o = 0;
+  const unsigned char *p = (const unsigned char *)in;
+  while (*p) {
+    unsigned c = *p;
+    if (c == '"' || c == '\\') {
+      out[o++] = '\\';
+      out[o++] = (char)c;
+      p++;
+    } else if (c == '\n') {
+      out[o++] = '\\';
+      out[o++] = 'n';
+      p++;
+    } else if (c < 0x80 || !ascii_only) {
+      out[o++] = (char)c;
+      p++;
+    } else {
+      unsigned cp;
+      int n;
+      if (c >= 0xF0) {
+        cp = c & 0x07;
+        n = 3;
+      } else if (c >= 0xE0) {
+        cp = c & 0x0F;
+        n = 2;
+      } else {
+        cp = c & 0x1F;
+        n = 1;
+      }
+      p++;
+      for (int i = 0; i < n; i++) {
+        cp = (cp << 6) | (*p++ & 0x3F);
+      }
+      if (cp >= 0x10000) {
+        cp -= 0x10000;
+        o += (size_t)sprintf(out + o, "\\u%04x\\u%04x", 0xD800 + (cp >> 10),
+                             0xDC00 + (cp & 0x3FF));
+      } else {
+        o += (size_t)sprintf(out + o, "\\u%04x", cp);
+      }
+    }
+  }
+  out[o] = '\0';
+  return o;
+}
+
+static int append(char **buf, size_t *len, size_t *cap, const char *s) {
+  const size_t n = strlen(s);
+  if (*len + n + 1 > *cap) {
+    *cap = (*len + n + 1) * 2;
+    *buf = realloc(*buf, *cap);
+  }
+  memcpy(*buf + *len, s, n + 1);
+  *len += n;
+  return 0;
+}
+
+static void event_json(sse_fixture_t f, size_t i, const char *delta,
+                       const char *finish, char *out, size_t cap) {
+  switch (f) {
+  case SSE_FIXTURE_OPENAI:
+    snprintf(out, cap,
+             "{\"id\":\"chatcmpl-B9MBs8CjcvOU2jLn4n570S5qMJKcT\","
+             "\"object\":\"chat.completion.chunk\",\"created\":1741569952,"
+             "\"model\":\"gpt-4o-mini-2024-07-18\","
+             "\"service_tier\":\"default\","
+             "\"system_fingerprint\":\"fp_06737a9306\",\"choices\":[{"
+             "\"index\":0,\"delta\":{%s},\"logprobs\":null,"
+             "\"finish_reason\":%s}],\"usage\":null}",
+             delta, finish);
+    break;
+  case SSE_FIXTURE_GROQ:
+    snprintf(out, cap,
+             "{\"id\":\"chatcmpl-5e1f0a3b-7c2d-4e8f-9a6b-%012zu\","
+             "\"object\":\"chat.completion.chunk\",\"created\":1741569953,"
+             "\"model\":\"llama-3.1-8b-instant\","
+             "\"system_fingerprint\":\"fp_a491995411\",\"choices\":[{"
+             "\"index\":0,\"delta\":{%s},\"logprobs\":null,"
+             "\"finish_reason\":%s}],"
+             "\"x_groq\":{\"id\":\"req_01jnx4c2v8e9trs0q7cmbz0k3h\"}}",
+             i, delta, finish);
+    break;
+  default:
+    snprintf(out, cap,
+             "{\"id\":\"chatcmpl-%zu\",\"object\":\"chat.completion.chunk\","
+             "\"created\":1741569954,\"model\":\"llama3.2:3b\","
+             "\"system_fingerprint\":\"fp_ollama\",\"choices\":[{"
+             "\"index\":0,\"delta\":{%s},\"finish_reason\":%s}]}",
+             i % 1000, delta, finish);
+    break;
+  }
+}
+
+char *sse_fixture_build(sse_fixture_t f, int reps, size_t *len,
+                        size_t *events) {
+  char *buf = NULL;
+  size_t cap = 0;
+  *len = 0;
+  *events = 0;
+  char esc[64];
+  char delta[128];
+  char json[1024];
+  const int ascii_only = (f == SSE_FIXTURE_GROQ);
+
+  /* primeiro chunk: so o role */
+  if (f == SSE_FIXTURE_OPENAI) {
+    snprintf(delta, sizeof(delta),
+             "\"role\":\"assistant\",\"content\":\"\",\"refusal\":null");
+  } else {
+    snprintf(delta, sizeof(delta), "\"role\":\"assistant\",\"content\":\"\"");
+  }
+  event_json(f, 0, delta, "null", json, sizeof(json));
+  append(&buf, len, &cap, "data: ");
+  append(&buf, len, &cap, json);
+  append(&buf, len, &cap, "\n\n");
+  (*events)++;
+
+  size_t i = 1;
+  for (int r = 0; r < reps; r++) {
+    for (size_t t = 0; t < TOKEN_COUNT; t++, i++) {
+      json_escape(k_tokens[t], esc, ascii_only);
+      if (f == SSE_FIXTURE_OLLAMA) {
+        snprintf(delta, sizeof(delta),
+                 "\"role\":\"assistant\",\"content\":\"%s\"", esc);
+      } else {
+        snprintf(delta, sizeof(delta), "\"content\":\"%s\"", esc);
+      }
+      event_json(f, i, delta, "null", json, sizeof(json));
+      append(&buf, len, &cap, "data: ");
+      append(&buf, len, &cap, json);
+      append(&buf, len, &cap, "\n\n");
+      (*events)++;
+    }
+  }
+
+  /* fim: delta vazio com finish_reason; OpenAI manda ainda o usage */
+  event_json(f, i, "", "\"stop\"", json, sizeof(json));
+  append(&buf, len, &cap, "data: ");
+  append(&buf, len, &cap, json);
+  append(&buf, len, &cap, "\n\n");
+  (*events)++;
+  if (f == SSE_FIXTURE_OPENAI) {
+    append(&buf, len, &cap,
+           "data: {\"id\":\"chatcmpl-B9MBs8CjcvOU2jLn4n570S5qMJKcT\","
+           "\"object\":\"chat.completion.chunk\",\"created\":1741569952,"
+           "\"model\":\"gpt-4o-mini-2024-07-18\",\"choices\":[],"
+           "\"usage\":{\"prompt_tokens\":412,\"completion_tokens\":36,"
+           "\"total_tokens\":448,\"prompt_tokens_details\":{"
+           "\"cached_tokens\":0,\"audio_tokens\":0}}}\n\n");
+    (*events)++;
+  }
+  append(&buf, len, &cap, "data: [DONE]\n\n");
+  return buf;
+}
+
+char *sse_fixture_text(int reps) {
+  size_t cap = 1;
+  for (size_t t = 0; t < TOKEN_COUNT; t++) {
+    cap += strlen(k_tokens[t]) * (size_t)reps;
+  }
+  char *out = malloc(cap);
+  out[0] = '\0';
+  for (int r = 0; r < reps; r++) {
+    for (size_t t = 0; t < TOKEN_COUNT; t++) {
+      strcat(out, k_tokens[t]);
+    }
+  }
+  return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+/* Streams SSE no formato de chunk de cada provedor (OpenAI, Groq, Ollama
+ * /v1), reconstruidos a partir da documentacao/observacao do formato - nao
+ * sao gravacoes. Mesmo texto nos tres: tokens curtos, acentos, aspas,
+ * quebra de linha e um emoji (par surrogate quando escapado). */
+#include <stddef.h>
+
+typedef enum {
+  SSE_FIXTURE_OPENAI, /* role, refusal:null, logprobs, usage com choices [] */
+  SSE_FIXTURE_GROQ,   /* x_groq por chunk, ASCII com \uXXXX */
+  SSE_FIXTURE_OLLAMA, /* fp_ollama, UTF-8 cru */
+  SSE_FIXTURE_COUNT,
+} sse_fixture_t;
+
+const char *sse_fixture_name(sse_fixture_t f);
+
+/* Monta o stream (com "data: [DONE]") repetindo o texto base reps vezes.
+ * Retorna buffer alocado (free); *events recebe o numero de eventos
+ * "data:" com JSON. */
+char *sse_fixture_build(sse_fixture_t f, int reps, size_t *len,
+                        size_t *events);
+
+/* Texto esperado (UTF-8) para reps repeticoes. Buffer alocado (free). */
+char *sse_fixture_text(int reps);
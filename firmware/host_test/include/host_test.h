@@ -0,0 +1,85 @@
+#pragma once
+/* Mini framework dos testes no host: CHECKs que contam falhas sem abortar
+ * e um relogio monotonico para os benchmarks. */
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static int host_test_failures;
+
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,       \
+              #cond);                                                        \
+      host_test_failures++;                                                  \
+    }                                                                        \
+  } while (0)
+
+#define CHECK_EQ_INT(a, b)                                                   \
+  do {                                                                       \
+    const long long a_ = (long long)(a);                                     \
+    const long long b_ = (long long)(b);                                     \
+    if (a_ != b_) {                                                          \
+      fprintf(stderr, "%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__,   \
+              __LINE__, #a, #b, a_, b_);                                     \
+      host_test_failures++;                                                  \
+    }                                                                        \
+  } while (0)
+
+#define CHECK_STR_EQ(a, b)                                                   \
+  do {                                                                       \
+    const char *a_ = (a);                                                    \
+    const char *b_ = (b);                                                    \
+    if (strcmp(a_, b_) != 0) {                                               \
+      fprintf(stderr, "%s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, a_,   \
+              b_);                                                           \
+      host_test_failures++;                                                  \
+    }                                                                        \
+  } while (0)
+
+/* Compara buffers e mostra o primeiro byte diferente. */
+#define CHECK_MEM_EQ(a, alen, b, blen)                                       \
+  do {                                                                       \
+    const uint8_t *a_ = (const uint8_t *)(a);                                \
+    const uint8_t *b_ = (const uint8_t *)(b);                                \
+    const size_t al_ = (alen);                                               \
+    const size_t bl_ = (blen);                                               \
+    size_t i_ = 0;                                                           \
+    while (i_ < al_ && i_ < bl_ && a_[i_] == b_[i_]) {                       \
+      i_++;                                                                  \
+    }                                                                        \
+    if (i_ != al_ || al_ != bl_) {                                           \
+      fprintf(stderr,                                                        \
+              "%s:%d: %s != %s (len %zu vs %zu, first diff at %zu)\n",       \
+              __FILE__, __LINE__, #a, #b, al_, bl_, i_);                     \
+      host_test_failures++;                                                  \
+    }                                                                        \
+  } while (0)
+
+#define HOST_TEST_RUN(fn)                                                    \
+  do {                                                                       \
+    const int before_ = host_test_failures;                                  \
+    fn();                                                                    \
+    printf("%-44s %s\n", #fn, host_test_failures == before_ ? "ok" : "FAIL"); \
+  } while (0)
+
+#define HOST_TEST_EXIT()                                                     \
+  (printf("%d failure(s)\n", host_test_failures), host_test_failures ? 1 : 0)
+
+static inline double host_test_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/* PRNG deterministico (xorshift32) para entradas sinteticas. */
+static inline uint32_t host_test_rand(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
@@ -0,0 +1,20 @@
+#pragma once
+/* Duble do cJSON para hosts sem libcjson: cJSON_Parse sempre falha, entao
+ * o caminho de fallback do ai_client nao produz texto. Os testes que
+ * dependem do cJSON real so sao compilados com HOST_TEST_HAVE_CJSON. */
+#include <stdbool.h>
+
+typedef struct cJSON {
+  struct cJSON *next;
+  struct cJSON *child;
+  int type;
+  char *valuestring;
+  char *string;
+} cJSON;
+
+cJSON *cJSON_Parse(const char *value);
+void cJSON_Delete(cJSON *item);
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *key);
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index);
+bool cJSON_IsArray(const cJSON *item);
+bool cJSON_IsString(const cJSON *item);
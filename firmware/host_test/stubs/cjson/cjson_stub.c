@@ -0,0 +1,26 @@
+#include "cJSON.h"
+
+#include <stddef.h>
+
+cJSON *cJSON_Parse(const char *value) {
+  (void)value;
+  return NULL;
+}
+
+void cJSON_Delete(cJSON *item) { (void)item; }
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *key) {
+  (void)object;
+  (void)key;
+  return NULL;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index) {
+  (void)array;
+  (void)index;
+  return NULL;
+}
+
+bool cJSON_IsArray(const cJSON *item) { return item != NULL; }
+
+bool cJSON_IsString(const cJSON *item) { return item != NULL; }
@@ -0,0 +1,7 @@
+#pragma once
+/* Sem memoria RTC no host: variaveis comuns. */
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
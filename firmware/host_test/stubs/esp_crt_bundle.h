@@ -0,0 +1,6 @@
+#pragma once
+/* Bundle de CAs do ESP-IDF: no host cada teste de TLS fornece o seu
+ * esp_crt_bundle_attach(), com a CA do servidor local. */
+#include "esp_err.h"
+
+esp_err_t esp_crt_bundle_attach(void *conf);
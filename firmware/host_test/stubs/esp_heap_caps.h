@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps) {
+  (void)caps;
+  return malloc(size);
+}
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+  (void)caps;
+  return calloc(n, size);
+}
+static inline void *heap_caps_realloc(void *p, size_t size, uint32_t caps) {
+  (void)caps;
+  return realloc(p, size);
+}
+static inline void *heap_caps_aligned_alloc(size_t align, size_t size,
+                                            uint32_t caps) {
+  (void)caps;
+  void *p = NULL;
+  return posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align,
+                        size) == 0
+             ? p
+             : NULL;
+}
+static inline void heap_caps_free(void *p) { free(p); }
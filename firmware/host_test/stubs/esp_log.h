@@ -0,0 +1,16 @@
+#pragma once
+/* ESP_LOGx no host: erros e avisos em stderr; info/debug so com
+ * HOST_TEST_VERBOSE=1 no ambiente. */
+#include <stdio.h>
+
+int host_log_verbose(void);
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)                                              \
+  do {                                                                       \
+    if (host_log_verbose())                                                  \
+      fprintf(stderr, "I %s: " fmt "\n", tag, ##__VA_ARGS__);                \
+  } while (0)
+#define ESP_LOGD(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
@@ -0,0 +1,5 @@
+#pragma once
+/* CRC32 da ROM do ESP32 (mesmo resultado do crc32() da zlib). */
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
@@ -0,0 +1,5 @@
+#pragma once
+/* Nomes dos dispositivos do esp_video (abertos pelo fake_v4l2). */
+#define ESP_VIDEO_MIPI_CSI_DEVICE_NAME "/dev/video0"
+#define ESP_VIDEO_ISP_DVP_DEVICE_NAME "/dev/video1"
+#define ESP_VIDEO_DVP_DEVICE_NAME "/dev/video2"
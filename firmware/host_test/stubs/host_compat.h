@@ -0,0 +1,6 @@
+#pragma once
+/* Incluido antes de cada fonte (-include): o que a newlib do ESP-IDF tem e
+ * a glibc do host nao. */
+#include <stddef.h>
+
+size_t strlcpy(char *dst, const char *src, size_t size);
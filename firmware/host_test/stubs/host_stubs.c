@@ -0,0 +1,319 @@
+/* Implementacao host dos stubs ESP-IDF/FreeRTOS/mbedTLS usados pelos
+ * componentes em teste. */
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mbedtls/base64.h"
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+  case ESP_OK: return "ESP_OK";
+  case ESP_FAIL: return "ESP_FAIL";
+  case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+  case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+  case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+  case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+  case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+  case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+  case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+  case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+  case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+  default: return "UNKNOWN";
+  }
+}
+
+int host_log_verbose(void) {
+  static int verbose = -1;
+  if (verbose < 0) {
+    const char *env = getenv("HOST_TEST_VERBOSE");
+    verbose = (env && env[0] == '1');
+  }
+  return verbose;
+}
+
+size_t strlcpy(char *dst, const char *src, size_t size) {
+  const size_t len = strlen(src);
+  if (size > 0) {
+    const size_t n = (len < size - 1) ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+int64_t esp_timer_get_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+/* ---- tasks ---- */
+
+typedef struct {
+  TaskFunction_t fn;
+  void *arg;
+} host_task_t;
+
+static void *host_task_main(void *p) {
+  host_task_t t = *(host_task_t *)p;
+  free(p);
+  t.fn(t.arg);
+  return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle,
+                                   BaseType_t core) {
+  (void)name;
+  (void)stack;
+  (void)prio;
+  (void)core;
+  host_task_t *t = malloc(sizeof(*t));
+  if (!t) {
+    return pdFAIL;
+  }
+  t->fn = fn;
+  t->arg = arg;
+  pthread_t th;
+  if (pthread_create(&th, NULL, host_task_main, t) != 0) {
+    free(t);
+    return pdFAIL;
+  }
+  pthread_detach(th);
+  if (handle) {
+    *handle = (TaskHandle_t)(uintptr_t)th;
+  }
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == NULL) {
+    pthread_exit(NULL);
+  }
+}
+
+void vTaskDelay(TickType_t ticks) { usleep((useconds_t)ticks * 1000); }
+
+/* Contadores de notificacao por thread, numa tabela fixa: as tasks sao
+ * destacadas e o handle pode ser notificado depois de a task terminar. */
+#define HOST_NOTIFY_SLOTS 16
+
+static struct {
+  pthread_t thread;
+  uint32_t count;
+  bool used;
+} s_notify[HOST_NOTIFY_SLOTS];
+static pthread_mutex_t s_notify_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_notify_cond = PTHREAD_COND_INITIALIZER;
+
+/* s_notify_lock */
+static uint32_t *host_notify_count(pthread_t thread) {
+  for (int i = 0; i < HOST_NOTIFY_SLOTS; i++) {
+    if (s_notify[i].used && pthread_equal(s_notify[i].thread, thread)) {
+      return &s_notify[i].count;
+    }
+  }
+  for (int i = 0; i < HOST_NOTIFY_SLOTS; i++) {
+    if (!s_notify[i].used) {
+      s_notify[i].used = true;
+      s_notify[i].thread = thread;
+      s_notify[i].count = 0;
+      return &s_notify[i].count;
+    }
+  }
+  abort(); /* mais tasks notificadas do que os testes usam */
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+  pthread_mutex_lock(&s_notify_lock);
+  (*host_notify_count((pthread_t)(uintptr_t)task))++;
+  pthread_cond_broadcast(&s_notify_cond);
+  pthread_mutex_unlock(&s_notify_lock);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += ticks / 1000;
+  deadline.tv_nsec += (long)(ticks % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+  pthread_mutex_lock(&s_notify_lock);
+  uint32_t *count = host_notify_count(pthread_self());
+  int rc = 0;
+  while (*count == 0 && rc != ETIMEDOUT) {
+    rc = (ticks == portMAX_DELAY)
+             ? pthread_cond_wait(&s_notify_cond, &s_notify_lock)
+             : pthread_cond_timedwait(&s_notify_cond, &s_notify_lock,
+                                      &deadline);
+  }
+  const uint32_t value = *count;
+  if (value > 0) {
+    *count = clear_on_exit ? 0 : value - 1;
+  }
+  pthread_mutex_unlock(&s_notify_lock);
+  return value;
+}
+
+/* ---- semaphores ---- */
+
+struct host_sem {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int count;
+};
+
+static SemaphoreHandle_t host_sem_create(int count) {
+  SemaphoreHandle_t s = calloc(1, sizeof(*s));
+  if (s) {
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    s->count = count;
+  }
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return host_sem_create(0); }
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return host_sem_create(1); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += ticks / 1000;
+  deadline.tv_nsec += (long)(ticks % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+  pthread_mutex_lock(&s->lock);
+  int rc = 0;
+  while (s->count == 0 && rc != ETIMEDOUT) {
+    rc = (ticks == portMAX_DELAY)
+             ? pthread_cond_wait(&s->cond, &s->lock)
+             : pthread_cond_timedwait(&s->cond, &s->lock, &deadline);
+  }
+  const bool got = s->count > 0;
+  if (got) {
+    s->count--;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return got ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  pthread_mutex_lock(&s->lock);
+  s->count = 1;
+  pthread_cond_signal(&s->cond);
+  pthread_mutex_unlock(&s->lock);
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s) {
+  pthread_mutex_destroy(&s->lock);
+  pthread_cond_destroy(&s->cond);
+  free(s);
+}
+
+/* ---- base64 (RFC 4648, como mbedtls_base64_*) ---- */
+
+static const char k_b64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen,
+                          const unsigned char *src, size_t slen) {
+  const size_t need = ((slen + 2) / 3) * 4;
+  *olen = need + 1;
+  if (dlen < need + 1) {
+    return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+  }
+  unsigned char *p = dst;
+  size_t i = 0;
+  for (; i + 3 <= slen; i += 3) {
+    const uint32_t v = (uint32_t)src[i] << 16 | (uint32_t)src[i + 1] << 8 |
+                       src[i + 2];
+    *p++ = k_b64[v >> 18];
+    *p++ = k_b64[(v >> 12) & 63];
+    *p++ = k_b64[(v >> 6) & 63];
+    *p++ = k_b64[v & 63];
+  }
+  if (i < slen) {
+    uint32_t v = (uint32_t)src[i] << 16;
+    if (i + 1 < slen) {
+      v |= (uint32_t)src[i + 1] << 8;
+    }
+    *p++ = k_b64[v >> 18];
+    *p++ = k_b64[(v >> 12) & 63];
+    *p++ = (i + 1 < slen) ? k_b64[(v >> 6) & 63] : '=';
+    *p++ = '=';
+  }
+  *p = '\0';
+  *olen = need;
+  return 0;
+}
+
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen,
+                          const unsigned char *src, size_t slen) {
+  size_t n = 0;
+  uint32_t acc = 0;
+  int bits = 0;
+  size_t pad = 0;
+  for (size_t i = 0; i < slen; i++) {
+    const unsigned char c = src[i];
+    if (c == '=') {
+      pad++;
+      continue;
+    }
+    const char *q = (c != '\0') ? strchr(k_b64, c) : NULL;
+    if (!q || pad > 0) {
+      return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    }
+    acc = (acc << 6) | (uint32_t)(q - k_b64);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      if (dst) {
+        if (n >= dlen) {
+          return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+        }
+        dst[n] = (unsigned char)(acc >> bits);
+      }
+      n++;
+    }
+  }
+  if (pad > 2) {
+    return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+  }
+  *olen = n;
+  return 0;
+}
@@ -0,0 +1,239 @@
+/* Corpo da requisicao em streaming (ai_request_* + ai_client_write_request)
+ * comparado byte a byte com o JSON de referencia com os blobs inline, nos
+ * modos Content-Length e chunked. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "ai_client.h"
+#include "fake_ai_conn.h"
+#include "host_test.h"
+
+static const ai_client_cfg_t k_cfg = {
+    .url = "https://api.example.com/v1/chat/completions",
+    .token = "sk-test",
+    .timeout_ms = 1000,
+};
+
+/* JSON como o app imprime: o historico repete o texto do marcador, a
+ * requisicao deve usar a ultima ocorrencia. */
+static const char k_json[] =
+    "{\"model\":\"gpt-4o-mini\",\"messages\":["
+    "{\"role\":\"user\",\"content\":\"o que e @@AI_BLOB_0@@?\"},"
+    "{\"role\":\"user\",\"content\":["
+    "{\"type\":\"input_audio\",\"input_audio\":"
+    "{\"data\":\"@@AI_BLOB_0@@\",\"format\":\"wav\"}},"
+    "{\"type\":\"image_url\",\"image_url\":"
+    "{\"url\":\"data:image/jpeg;base64,@@AI_BLOB_1@@\"}}]}],"
+    "\"stream\":true}";
+
+/* Codificador de referencia, independente do usado pelo cliente. */
+static size_t ref_b64(const uint8_t *src, size_t len, char *dst) {
+  static const char tbl[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t o = 0;
+  for (size_t i = 0; i < len; i += 3) {
+    const size_t n = (len - i < 3) ? len - i : 3;
+    uint8_t b[3] = {0, 0, 0};
+    memcpy(b, src + i, n);
+    dst[o++] = tbl[b[0] >> 2];
+    dst[o++] = tbl[((b[0] & 3) << 4) | (b[1] >> 4)];
+    dst[o++] = (n > 1) ? tbl[((b[1] & 15) << 2) | (b[2] >> 6)] : '=';
+    dst[o++] = (n > 2) ? tbl[b[2] & 63] : '=';
+  }
+  return o;
+}
+
+/* Substitui a ultima ocorrencia de cada marcador pelo conteudo inline. */
+static char *inline_json(const char *json, const char *const *values) {
+  static const char *const markers[2] = {AI_REQUEST_BLOB0_MARKER,
+                                         AI_REQUEST_BLOB1_MARKER};
+  size_t cap = strlen(json) + 1;
+  for (int i = 0; i < 2; i++) {
+    cap += strlen(values[i]);
+  }
+  char *out = malloc(cap);
+  out[0] = '\0';
+  const char *text = json;
+  for (int i = 0; i < 2; i++) {
+    const char *last = NULL;
+    for (const char *p = strstr(text, markers[i]); p;
+         p = strstr(p + 1, markers[i])) {
+      last = p;
+    }
+    strncat(out, text, (size_t)(last - text));
+    strcat(out, values[i]);
+    text = last + strlen(markers[i]);
+  }
+  strcat(out, text);
+  return out;
+}
+
+static void fill(uint8_t *buf, size_t len, uint32_t seed) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = (uint8_t)host_test_rand(&seed);
+  }
+}
+
+/* Remove o framing chunked, validando cada linha de tamanho. */
+static size_t dechunk(const char *in, size_t len, char *out) {
+  size_t o = 0;
+  size_t i = 0;
+  for (;;) {
+    char *end = NULL;
+    const unsigned long n = strtoul(in + i, &end, 16);
+    CHECK(end && end[0] == '\r' && end[1] == '\n');
+    i = (size_t)(end - in) + 2;
+    if (n == 0) {
+      CHECK(i + 2 == len && memcmp(in + i, "\r\n", 2) == 0);
+      return o;
+    }
+    CHECK(i + n + 2 <= len);
+    memcpy(out + o, in + i, n);
+    o += n;
+    i += n;
+    CHECK(memcmp(in + i, "\r\n", 2) == 0);
+    i += 2;
+  }
+}
+
+/* Envia req e devolve o corpo sem cabecalhos (e sem framing chunked). */
+static char *send_body(const ai_request_t *req, bool chunked, size_t *len) {
+  fake_ai_conn_reset(NULL);
+  const size_t content_len = ai_request_content_length(req);
+  CHECK_EQ_INT(ai_client_begin(&k_cfg, chunked ? -1 : (int)content_len),
+               ESP_OK);
+  CHECK_EQ_INT(ai_client_write_request(req, chunked), ESP_OK);
+
+  size_t tx_len = 0;
+  const char *tx = (const char *)fake_ai_conn_tx(&tx_len);
+  char *copy = calloc(1, tx_len + 1);
+  memcpy(copy, tx, tx_len);
+  ai_client_abort();
+
+  char *body = strstr(copy, "\r\n\r\n");
+  CHECK(body != NULL);
+  body[2] = '\0';
+  body += 4;
+  const size_t body_len = tx_len - (size_t)(body - copy);
+  CHECK(strncmp(copy, "POST /v1/chat/completions HTTP/1.1\r\n", 36) == 0);
+  CHECK(strstr(copy, "\r\nHost: api.example.com\r\n") != NULL);
+  CHECK(strstr(copy, "\r\nAuthorization: Bearer sk-test\r\n") != NULL);
+
+  char *out = malloc(body_len + 1);
+  if (chunked) {
+    CHECK(strstr(copy, "\r\nTransfer-Encoding: chunked\r\n") != NULL);
+    CHECK(strstr(copy, "Content-Length") == NULL);
+    *len = dechunk(body, body_len, out);
+  } else {
+    char expect[48];
+    snprintf(expect, sizeof(expect), "\r\nContent-Length: %zu\r\n",
+             content_len);
+    CHECK(strstr(copy, expect) != NULL);
+    CHECK(strstr(copy, "Transfer-Encoding") == NULL);
+    memcpy(out, body, body_len);
+    *len = body_len;
+  }
+  free(copy);
+  return out;
+}
+
+/* blob 0 de tamanho len (contiguo, em pedacos ou raw) + imagem fixa. */
+static void check_case(size_t len, int kind) {
+  uint8_t *audio = malloc(len + 1);
+  uint8_t image[1000];
+  fill(audio, len, 0x1234u + (uint32_t)len);
+  fill(image, sizeof(image), 0xBEEF);
+
+  char *audio_b64 = malloc(len * 2 + 8);
+  char *image_b64 = malloc(sizeof(image) * 2);
+  audio_b64[ref_b64(audio, len, audio_b64)] = '\0';
+  image_b64[ref_b64(image, sizeof(image), image_b64)] = '\0';
+
+  ai_iov_t iov[8];
+  ai_blob_t blobs[2] = {
+      {.data = audio, .len = len},
+      {.data = image, .len = sizeof(image)},
+  };
+  const char *values[2] = {audio_b64, image_b64};
+  if (kind == 1) {
+    /* pedacos de tamanhos que nao sao multiplos de 3 */
+    static const size_t cuts[] = {1, 2, 767, 769, 4, 1000};
+    size_t off = 0;
+    size_t n = 0;
+    for (; n < 7 && off < len; n++) {
+      size_t piece = (n < 6) ? cuts[n] : len - off;
+      if (piece > len - off) {
+        piece = len - off;
+      }
+      iov[n] = (ai_iov_t){.data = audio + off, .len = piece};
+      off += piece;
+    }
+    blobs[0] = (ai_blob_t){.iov = iov, .iov_count = n, .len = len};
+  } else if (kind == 2) {
+    /* raw: dado ja no formato do JSON */
+    blobs[0] = (ai_blob_t){.data = (const uint8_t *)audio_b64,
+                           .len = strlen(audio_b64),
+                           .raw = true};
+  }
+
+  char *expected = inline_json(k_json, values);
+  for (int chunked = 0; chunked < 2; chunked++) {
+    ai_request_t req;
+    CHECK_EQ_INT(ai_request_init(&req, strdup(k_json), blobs, 2), ESP_OK);
+    CHECK_EQ_INT(ai_request_content_length(&req), strlen(expected));
+    size_t body_len = 0;
+    char *body = send_body(&req, chunked, &body_len);
+    CHECK_MEM_EQ(body, body_len, expected, strlen(expected));
+    free(body);
+    ai_request_free(&req);
+  }
+  free(expected);
+  free(audio);
+  free(audio_b64);
+  free(image_b64);
+}
+
+static void test_contiguous_blobs(void) {
+  static const size_t sizes[] = {0, 1, 2, 3, 767, 768, 769, 2305, 44 + 16000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    check_case(sizes[i], 0);
+  }
+}
+
+static void test_iov_blobs(void) {
+  static const size_t sizes[] = {1, 770, 2543, 9001};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    check_case(sizes[i], 1);
+  }
+}
+
+static void test_raw_blob(void) { check_case(1234, 2); }
+
+static void test_no_blobs(void) {
+  static const char json[] = "{\"model\":\"x\",\"messages\":[]}";
+  ai_request_t req;
+  CHECK_EQ_INT(ai_request_init(&req, strdup(json), NULL, 0), ESP_OK);
+  for (int chunked = 0; chunked < 2; chunked++) {
+    size_t len = 0;
+    char *body = send_body(&req, chunked, &len);
+    CHECK_MEM_EQ(body, len, json, strlen(json));
+    free(body);
+  }
+  ai_request_free(&req);
+}
+
+static void test_missing_marker(void) {
+  const ai_blob_t blob = {.data = (const uint8_t *)"x", .len = 1};
+  ai_request_t req;
+  CHECK_EQ_INT(ai_request_init(&req, strdup("{\"a\":1}"), &blob, 1),
+               ESP_FAIL);
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_contiguous_blobs);
+  HOST_TEST_RUN(test_iov_blobs);
+  HOST_TEST_RUN(test_raw_blob);
+  HOST_TEST_RUN(test_no_blobs);
+  HOST_TEST_RUN(test_missing_marker);
+  return HOST_TEST_EXIT();
+}
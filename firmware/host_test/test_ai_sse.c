@@ -0,0 +1,288 @@
+/* Parser SSE do ai_client (white-box: inclui ai_client.c para chegar em
+ * ai_sse_feed/ai_sse_scan_delta): streams dos tres provedores em qualquer
+ * fatiamento, linhas longas descartadas com erro, JSON truncado ou invalido
+ * nunca aceito pelo scanner e, com libcjson, equivalencia com o cJSON. */
+#include "ai_client.c"
+
+#include "fake_ai_conn.h"
+#include "host_test.h"
+#include "sse_fixtures.h"
+
+static ai_sse_ctx_t *sse_new(char *text, size_t cap) {
+  ai_sse_ctx_t *ctx = calloc(1, sizeof(*ctx));
+  ctx->text = text;
+  ctx->text_cap = cap;
+  text[0] = '\0';
+  return ctx;
+}
+
+/* Alimenta o stream em pedacos de tamanho step (0 = aleatorio). */
+static void feed_split(ai_sse_ctx_t *ctx, const char *s, size_t len,
+                       size_t step) {
+  uint32_t seed = 99;
+  for (size_t off = 0; off < len;) {
+    size_t n = step ? step : 1 + host_test_rand(&seed) % 700;
+    if (n > len - off) {
+      n = len - off;
+    }
+    ai_sse_feed(ctx, s + off, (int)n);
+    off += n;
+  }
+}
+
+static void test_provider_streams(void) {
+  static const size_t steps[] = {0, 1, 7, 512, 1 << 20};
+  char *expected = sse_fixture_text(3);
+  char text[4096];
+  for (int f = 0; f < SSE_FIXTURE_COUNT; f++) {
+    size_t len = 0;
+    size_t events = 0;
+    char *stream = sse_fixture_build((sse_fixture_t)f, 3, &len, &events);
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+      ai_sse_ctx_t *ctx = sse_new(text, sizeof(text));
+      feed_split(ctx, stream, len, steps[i]);
+      CHECK(ctx->done);
+      CHECK_STR_EQ(text, expected);
+      /* todas as formas reais sao reconhecidas pelo scanner */
+      CHECK_EQ_INT(ctx->events_cjson, 0);
+      CHECK_EQ_INT(ctx->events_scanned, events);
+      CHECK_EQ_INT(ctx->events_dropped, 0);
+      free(ctx);
+    }
+    free(stream);
+  }
+  free(expected);
+}
+
+/* Uma linha so; retorna o texto extraido. */
+static const char *scan_line(const char *line, char *text, size_t cap) {
+  ai_sse_ctx_t *ctx = sse_new(text, cap);
+  ai_sse_feed(ctx, line, (int)strlen(line));
+  free(ctx);
+  return text;
+}
+
+static void test_escapes_and_framing(void) {
+  char text[256];
+  /* sem espaco depois de "data:", CRLF */
+  CHECK_STR_EQ(scan_line("data:{\"choices\":[{\"delta\":{\"content\":\"a\"}}]}"
+                         "\r\n",
+                         text, sizeof(text)),
+               "a");
+  /* par surrogate e surrogate isolado */
+  CHECK_STR_EQ(
+      scan_line("data: {\"choices\":[{\"delta\":{\"content\":"
+                "\"\\ud83d\\ude00|\\ud83d|\\u00e7\\t\\/\"}}]}\n",
+                text, sizeof(text)),
+      "\xf0\x9f\x98\x80|\xef\xbf\xbd|\xc3\xa7\t/");
+  /* audio preview: delta.audio.transcript */
+  CHECK_STR_EQ(scan_line("data: {\"choices\":[{\"delta\":{\"audio\":{"
+                         "\"id\":\"a1\",\"transcript\":\"oi\"}}}]}\n",
+                         text, sizeof(text)),
+               "oi");
+  /* comentarios e outros campos SSE sao ignorados */
+  CHECK_STR_EQ(scan_line(": keep-alive\nevent: x\nid: 3\n\n", text,
+                         sizeof(text)),
+               "");
+}
+
+/* Entradas que o scanner antigo aceitava (validava so ate a chave). */
+static void test_rejects_invalid_json(void) {
+  static const char *const bad[] = {
+      /* truncado depois do content */
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"}}\n",
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"},\"x\":\n",
+      /* literais e numeros invalidos */
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"},"
+      "\"finish_reason\":nul}]}\n",
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"},\"index\":01x}]}\n",
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"},\"n\":-}]}\n",
+      /* lixo depois do documento */
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"}}]}}\n",
+      "data: {\"choices\":[{\"delta\":{\"content\":\"oi\"}}]} x\n",
+      /* escape invalido */
+      "data: {\"choices\":[{\"delta\":{\"content\":\"o\\qi\"}}]}\n",
+  };
+  char text[64];
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    char *data = strdup(bad[i] + 6);
+    data[strlen(data) - 1] = '\0';
+    const char *frag = NULL;
+    size_t fl = 0;
+    CHECK_EQ_INT(ai_sse_scan_delta(data, &frag, &fl), AI_SSE_SCAN_UNKNOWN);
+    free(data);
+    /* cJSON (real ou duble) tambem rejeita: nenhum texto */
+    CHECK_STR_EQ(scan_line(bad[i], text, sizeof(text)), "");
+  }
+  /* numeros validos continuam aceitos */
+  char ok[] = "{\"choices\":[{\"index\":-0.5e+3,\"delta\":{\"content\":\"k\"},"
+              "\"n\":[1,2.25,true,false,null]}]}";
+  const char *frag = NULL;
+  size_t fl = 0;
+  CHECK_EQ_INT(ai_sse_scan_delta(ok, &frag, &fl), AI_SSE_SCAN_TEXT);
+}
+
+/* "data: {...\"content\":\"" + "\"}}]}" em volta do conteudo */
+#define LONG_EVENT_OVERHEAD 44
+
+static char *long_event(size_t content_len) {
+  char *line = malloc(content_len + 128);
+  int n = sprintf(line, "data: {\"choices\":[{\"delta\":{\"content\":\"");
+  memset(line + n, 'x', content_len);
+  n += (int)content_len;
+  strcpy(line + n, "\"}}]}\n\n");
+  return line;
+}
+
+static void test_long_line_dropped(void) {
+  static const char before[] =
+      "data: {\"choices\":[{\"delta\":{\"content\":\"A\"}}]}\n\n";
+  static const char after[] =
+      "data: {\"choices\":[{\"delta\":{\"content\":\"B\"}}]}\n\n"
+      "data: [DONE]\n\n";
+  char text[8192];
+
+  /* cabe exatamente no buffer: aceito */
+  char *fits = long_event(AI_SSE_LINE_BUF - 1 - LONG_EVENT_OVERHEAD);
+  CHECK_EQ_INT(strlen(fits) - 2, AI_SSE_LINE_BUF - 1);
+  ai_sse_ctx_t *ctx = sse_new(text, sizeof(text));
+  ai_sse_feed(ctx, fits, (int)strlen(fits));
+  CHECK_EQ_INT(ctx->events_dropped, 0);
+  CHECK_EQ_INT(strlen(text), AI_SSE_LINE_BUF - 1 - LONG_EVENT_OVERHEAD);
+  free(ctx);
+  free(fits);
+
+  /* um byte a mais: descartado inteiro, o stream segue */
+  static const size_t sizes[] = {AI_SSE_LINE_BUF - LONG_EVENT_OVERHEAD,
+                                 3 * AI_SSE_LINE_BUF};
+  for (size_t i = 0; i < 2; i++) {
+    char *big = long_event(sizes[i]);
+    ctx = sse_new(text, sizeof(text));
+    ai_sse_feed(ctx, before, (int)strlen(before));
+    feed_split(ctx, big, strlen(big), 0);
+    ai_sse_feed(ctx, after, (int)strlen(after));
+    CHECK_EQ_INT(ctx->events_dropped, 1);
+    CHECK_STR_EQ(text, "AB");
+    CHECK(ctx->done);
+    free(ctx);
+    free(big);
+  }
+}
+
+/* Pelo caminho completo: finish devolve erro com o texto parcial. */
+static void test_finish_reports_truncated_event(void) {
+  static const char head[] = "HTTP/1.1 200 OK\r\n"
+                             "Content-Type: text/event-stream\r\n"
+                             "Connection: close\r\n\r\n"
+                             "data: {\"choices\":[{\"delta\":{\"content\":"
+                             "\"A\"}}]}\n\n";
+  char *big = long_event(2 * AI_SSE_LINE_BUF);
+  char *resp = malloc(strlen(head) + strlen(big) + 32);
+  sprintf(resp, "%s%sdata: [DONE]\n\n", head, big);
+  fake_ai_conn_reset(resp);
+
+  const ai_client_cfg_t cfg = {.url = "http://h/v1", .timeout_ms = 1000};
+  ai_request_t req;
+  CHECK_EQ_INT(ai_request_init(&req, strdup("{}"), NULL, 0), ESP_OK);
+  char text[64];
+  int code = 0;
+  CHECK_EQ_INT(ai_client_post(&cfg, &req, text, sizeof(text), &code, NULL,
+                              NULL),
+               ESP_ERR_INVALID_SIZE);
+  CHECK_EQ_INT(code, 200);
+  CHECK_STR_EQ(text, "A");
+  ai_request_free(&req);
+  free(resp);
+  free(big);
+}
+
+typedef struct {
+  char buf[1024];
+  size_t len;
+  bool consistent; /* text/text_len do callback = o que foi repassado */
+} delta_sink_t;
+
+static void collect_delta(const char *frag, size_t frag_len, const char *text,
+                          size_t text_len, void *user_ctx) {
+  delta_sink_t *sink = user_ctx;
+  if (sink->len + frag_len < sizeof(sink->buf)) {
+    memcpy(sink->buf + sink->len, frag, frag_len);
+    sink->len += frag_len;
+    sink->buf[sink->len] = '\0';
+  }
+  sink->consistent &= (text_len == sink->len && strcmp(text, sink->buf) == 0);
+}
+
+/* Buffer do chamador menor que a resposta (o limite do app, menor que o da
+ * GUI): o texto para no primeiro fragmento que nao cabe, sem buracos, e
+ * on_delta recebe exatamente o que ficou no texto. */
+static void test_small_buffer_stops_stream(void) {
+  static const size_t caps[] = {1, 2, 17, 100, 512};
+  char *expected = sse_fixture_text(8);
+  for (int f = 0; f < SSE_FIXTURE_COUNT; f++) {
+    size_t len = 0;
+    size_t events = 0;
+    char *stream = sse_fixture_build((sse_fixture_t)f, 8, &len, &events);
+    for (size_t i = 0; i < sizeof(caps) / sizeof(caps[0]); i++) {
+      char text[512];
+      delta_sink_t sink = {.consistent = true};
+      ai_sse_ctx_t *ctx = sse_new(text, caps[i]);
+      ctx->on_delta = collect_delta;
+      ctx->user_ctx = &sink;
+      feed_split(ctx, stream, len, 0);
+      CHECK(ctx->done);
+      CHECK(ctx->text_full);
+      CHECK(sink.consistent);
+      CHECK_STR_EQ(sink.buf, text);
+      CHECK(strlen(text) < caps[i]);
+      CHECK(strncmp(text, expected, strlen(text)) == 0);
+      free(ctx);
+    }
+    free(stream);
+  }
+  free(expected);
+}
+
+#ifdef HOST_TEST_HAVE_CJSON
+/* Cada evento: scanner e cJSON extraem o mesmo fragmento. */
+static void test_scanner_matches_cjson(void) {
+  for (int f = 0; f < SSE_FIXTURE_COUNT; f++) {
+    size_t len = 0;
+    size_t events = 0;
+    char *stream = sse_fixture_build((sse_fixture_t)f, 1, &len, &events);
+    for (char *line = strtok(stream, "\n"); line; line = strtok(NULL, "\n")) {
+      if (strncmp(line, "data: {", 7) != 0) {
+        continue;
+      }
+      cJSON *chunk = cJSON_Parse(line + 6);
+      const char *ref = chunk ? ai_sse_cjson_delta(chunk) : NULL;
+      const char *frag = NULL;
+      size_t fl = 0;
+      const ai_sse_scan_result_t r = ai_sse_scan_delta(line + 6, &frag, &fl);
+      if (ref) {
+        CHECK_EQ_INT(r, AI_SSE_SCAN_TEXT);
+        CHECK_MEM_EQ(frag, fl, ref, strlen(ref));
+      } else {
+        CHECK_EQ_INT(r, AI_SSE_SCAN_EMPTY);
+      }
+      cJSON_Delete(chunk);
+    }
+    free(stream);
+  }
+}
+#endif
+
+int main(void) {
+  HOST_TEST_RUN(test_provider_streams);
+  HOST_TEST_RUN(test_escapes_and_framing);
+  HOST_TEST_RUN(test_rejects_invalid_json);
+  HOST_TEST_RUN(test_long_line_dropped);
+  HOST_TEST_RUN(test_finish_reports_truncated_event);
+  HOST_TEST_RUN(test_small_buffer_stops_stream);
+#ifdef HOST_TEST_HAVE_CJSON
+  HOST_TEST_RUN(test_scanner_matches_cjson);
+#else
+  printf("test_scanner_matches_cjson                   skipped (no libcjson)\n");
+#endif
+  return HOST_TEST_EXIT();
+}
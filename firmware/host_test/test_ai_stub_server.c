@@ -0,0 +1,242 @@
+/* ai_client de ponta a ponta contra um servidor local (fakes/
+ * stub_http_server): upload chunked com ai_b64_stream_* como no pipeline
+ * do S3, pre-warm + post, Content-Length, keep-alive (com a nova tentativa
+ * quando a conexao reutilizada morre) e respostas de erro. */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ai_client.h"
+#include "host_test.h"
+#include "mbedtls/base64.h"
+#include "stub_http_server.h"
+
+static char s_url[64];
+static ai_client_cfg_t s_cfg;
+
+static const char *const k_events[] = {
+    "data: {\"choices\":[{\"delta\":{\"role\":\"assistant\"}}]}\n\n",
+    "data: {\"choices\":[{\"delta\":{\"content\":\"Ol\\u00e1, \"}}]}\n\n",
+    "data: {\"choices\":[{\"delta\":{\"content\":\"tudo bem?\"}}]}\n\n",
+    "data: [DONE]\n\n",
+};
+
+static void set_sse_response(bool close_after) {
+  size_t len = 0;
+  char *raw = stub_sse_response(k_events, 4, &len);
+  stub_server_set_response(raw, len, close_after);
+  free(raw);
+}
+
+static void fill(uint8_t *buf, size_t len, uint32_t seed) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = (uint8_t)host_test_rand(&seed);
+  }
+}
+
+/* Confere prefixo + base64(data) + sufixo no corpo recebido. */
+static void check_body(const char *prefix, const uint8_t *data, size_t len,
+                       const char *suffix) {
+  size_t body_len = 0;
+  const uint8_t *body = stub_server_last_body(&body_len);
+  const size_t pre = strlen(prefix);
+  const size_t suf = strlen(suffix);
+  const size_t b64_len = ((len + 2) / 3) * 4;
+  CHECK_EQ_INT(body_len, pre + b64_len + suf);
+  if (body_len != pre + b64_len + suf) {
+    return;
+  }
+  CHECK(memcmp(body, prefix, pre) == 0);
+  CHECK(memcmp(body + body_len - suf, suffix, suf) == 0);
+
+  uint8_t *decoded = malloc(len + 4);
+  size_t decoded_len = 0;
+  CHECK_EQ_INT(mbedtls_base64_decode(decoded, len + 4, &decoded_len,
+                                     body + pre, b64_len),
+               0);
+  CHECK_MEM_EQ(decoded, decoded_len, data, len);
+  free(decoded);
+}
+
+typedef struct {
+  int calls;
+  size_t last_len;
+} delta_log_t;
+
+static void on_delta(const char *frag, size_t frag_len, const char *text,
+                     size_t text_len, void *user_ctx) {
+  delta_log_t *log = user_ctx;
+  (void)frag;
+  CHECK(frag_len > 0);
+  CHECK(text_len > log->last_len);
+  CHECK_EQ_INT(strlen(text), text_len);
+  log->calls++;
+  log->last_len = text_len;
+}
+
+/* Como app_upload_pipe_task: abre chunked, envia o prefixo, empurra o PCM
+ * em janelas irregulares pelo ai_b64_stream_t e fecha com o sufixo. */
+static void test_pipelined_chunked_upload(void) {
+  static const char prefix[] = "{\"audio\":\"";
+  static const char suffix[] = "\",\"stream\":true}";
+  const size_t pcm_len = 44 + 3 * 16000 + 7;
+  uint8_t *pcm = malloc(pcm_len);
+  fill(pcm, pcm_len, 42);
+  set_sse_response(false);
+  const int conns = stub_server_connections();
+
+  CHECK_EQ_INT(ai_client_begin(&s_cfg, -1), ESP_OK);
+  CHECK_EQ_INT(ai_client_write_chunk(prefix, strlen(prefix)), ESP_OK);
+  ai_b64_stream_t *b64 = calloc(1, sizeof(*b64));
+  uint32_t seed = 7;
+  for (size_t off = 0; off < pcm_len;) {
+    size_t n = 1 + host_test_rand(&seed) % 3300;
+    if (n > pcm_len - off) {
+      n = pcm_len - off;
+    }
+    CHECK_EQ_INT(ai_b64_stream_push(b64, pcm + off, n), ESP_OK);
+    off += n;
+  }
+  CHECK_EQ_INT(ai_b64_stream_flush(b64), ESP_OK);
+  CHECK_EQ_INT(ai_client_write_chunk(suffix, strlen(suffix)), ESP_OK);
+  CHECK_EQ_INT(ai_client_end_chunked(), ESP_OK);
+  free(b64);
+
+  char text[128];
+  int http_code = 0;
+  delta_log_t log = {0};
+  CHECK_EQ_INT(ai_client_finish(text, sizeof(text), &http_code, on_delta,
+                                &log),
+               ESP_OK);
+  CHECK_EQ_INT(http_code, 200);
+  CHECK_STR_EQ(text, "Ol\xc3\xa1, tudo bem?");
+  CHECK_EQ_INT(log.calls, 2);
+  CHECK(stub_server_last_was_chunked());
+  CHECK(strstr(stub_server_last_head(), "Transfer-Encoding: chunked") != NULL);
+  CHECK(strstr(stub_server_last_head(), "Authorization: Bearer tk\r\n") !=
+        NULL);
+  check_body(prefix, pcm, pcm_len, suffix);
+  CHECK_EQ_INT(stub_server_connections(), conns + 1);
+  free(pcm);
+}
+
+/* Blob em pedacos (segmentos do pool) via ai_client_post, com e sem
+ * pre-warm; a segunda requisicao reaproveita a conexao. */
+static void post_iov(bool prewarm) {
+  static const char json[] = "{\"audio\":\"@@AI_BLOB_0@@\",\"n\":1}";
+  uint8_t seg[3][5000];
+  fill(&seg[0][0], sizeof(seg), prewarm ? 3 : 4);
+  const ai_iov_t iov[3] = {
+      {seg[0], 4097}, {seg[1], 1}, {seg[2], 5000}};
+  const ai_blob_t blob = {.iov = iov, .iov_count = 3, .len = 9098};
+  uint8_t flat[9098];
+  memcpy(flat, seg[0], 4097);
+  memcpy(flat + 4097, seg[1], 1);
+  memcpy(flat + 4098, seg[2], 5000);
+
+  ai_request_t req;
+  CHECK_EQ_INT(ai_request_init(&req, strdup(json), &blob, 1), ESP_OK);
+  if (prewarm) {
+    ai_client_prewarm_start(&s_cfg);
+  }
+  char text[128];
+  int http_code = 0;
+  CHECK_EQ_INT(ai_client_post(&s_cfg, &req, text, sizeof(text), &http_code,
+                              NULL, NULL),
+               ESP_OK);
+  CHECK_STR_EQ(text, "Ol\xc3\xa1, tudo bem?");
+  CHECK(stub_server_last_was_chunked() == prewarm);
+  if (!prewarm) {
+    char expect[40];
+    snprintf(expect, sizeof(expect), "Content-Length: %zu\r\n",
+             ai_request_content_length(&req));
+    CHECK(strstr(stub_server_last_head(), expect) != NULL);
+  }
+  check_body("{\"audio\":\"", flat, sizeof(flat), "\",\"n\":1}");
+  ai_request_free(&req);
+}
+
+static void test_post_keep_alive(void) {
+  set_sse_response(false);
+  ai_client_abort();
+  const int conns = stub_server_connections();
+  post_iov(false);
+  post_iov(true);
+  post_iov(false);
+  CHECK_EQ_INT(stub_server_connections(), conns + 1);
+}
+
+static void test_server_closes(void) {
+  set_sse_response(true);
+  ai_client_abort();
+  const int conns = stub_server_connections();
+  post_iov(false);
+  usleep(50 * 1000); /* FIN do servidor chega com a conexao ociosa */
+  post_iov(false);
+  /* fechada pelo servidor: cada requisicao abre uma conexao nova */
+  CHECK_EQ_INT(stub_server_connections(), conns + 2);
+}
+
+/* Conexao reutilizada morre sem resposta: ai_client_post repete uma vez
+ * numa conexao nova. */
+static void test_reused_connection_retry(void) {
+  set_sse_response(false);
+  ai_client_abort();
+  const int conns = stub_server_connections();
+  const int reqs = stub_server_requests();
+  post_iov(false);
+  stub_server_drop_next();
+  post_iov(false);
+  CHECK_EQ_INT(stub_server_connections(), conns + 2);
+  CHECK_EQ_INT(stub_server_requests(), reqs + 3);
+}
+
+static void test_error_status_keeps_connection(void) {
+  static const char body[] = "{\"error\":{\"message\":\"bad key\"}}";
+  char resp[256];
+  const int len = snprintf(resp, sizeof(resp),
+                           "HTTP/1.1 401 Unauthorized\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: %zu\r\n\r\n%s",
+                           strlen(body), body);
+  stub_server_set_response(resp, (size_t)len, false);
+  ai_client_abort();
+  const int conns = stub_server_connections();
+
+  ai_request_t req;
+  CHECK_EQ_INT(ai_request_init(&req, strdup("{\"a\":1}"), NULL, 0), ESP_OK);
+  char text[64];
+  int http_code = 0;
+  CHECK_EQ_INT(ai_client_post(&s_cfg, &req, text, sizeof(text), &http_code,
+                              NULL, NULL),
+               ESP_FAIL);
+  CHECK_EQ_INT(http_code, 401);
+
+  set_sse_response(false);
+  CHECK_EQ_INT(ai_client_post(&s_cfg, &req, text, sizeof(text), &http_code,
+                              NULL, NULL),
+               ESP_OK);
+  CHECK_EQ_INT(stub_server_connections(), conns + 1);
+  ai_request_free(&req);
+}
+
+int main(void) {
+  const uint16_t port = stub_server_start();
+  if (port == 0) {
+    fprintf(stderr, "stub server did not start\n");
+    return 1;
+  }
+  snprintf(s_url, sizeof(s_url), "http://127.0.0.1:%u/v1/chat/completions",
+           (unsigned)port);
+  s_cfg = (ai_client_cfg_t){.url = s_url, .token = "tk", .timeout_ms = 3000};
+
+  HOST_TEST_RUN(test_pipelined_chunked_upload);
+  HOST_TEST_RUN(test_post_keep_alive);
+  HOST_TEST_RUN(test_server_closes);
+  HOST_TEST_RUN(test_reused_connection_retry);
+  HOST_TEST_RUN(test_error_status_keeps_connection);
+
+  ai_client_abort();
+  stub_server_stop();
+  return HOST_TEST_EXIT();
+}
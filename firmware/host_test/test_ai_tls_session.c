@@ -0,0 +1,394 @@
+/* Cache de sessao TLS do ai_conn (white-box: ai_conn.c compilado com
+ * AI_CONN_TLS=1 contra o mbedTLS do host) contra um servidor mbedTLS local
+ * em TLS 1.2 que emite tickets:
+ *   - cold (full), depois resumed com o ticket guardado;
+ *   - reboot com a RTC intacta e power-on com a RTC perdida (volta do NVS);
+ *   - rejected depois de o servidor trocar a chave dos tickets;
+ *   - full de novo com sessao expirada ou CRC danificado.
+ * O certificado (EC P-256, CN=localhost) e gerado na hora, nada de chave
+ * privada no repositorio. */
+#define AI_CONN_TLS 1
+#include "ai_conn.c"
+
+#include <arpa/inet.h>
+#include <pthread.h>
+
+#include "fake_nvs.h"
+#include "host_test.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/x509_crt.h"
+#if defined(MBEDTLS_PSA_CRYPTO_C)
+#include "psa/crypto.h"
+#endif
+
+#define TICKET_LIFETIME_S (24 * 60 * 60)
+
+typedef struct {
+  int listen_fd;
+  uint16_t port;
+  pthread_t thread;
+  pthread_mutex_t lock; /* uma conexao por vez; troca de chave entre elas */
+  int handshakes;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context drbg;
+  mbedtls_pk_context key;
+  mbedtls_x509_crt cert;
+  mbedtls_ssl_config conf;
+  mbedtls_ssl_ticket_context ticket;
+} tls_server_t;
+
+static tls_server_t s_srv;
+
+/* Bundle do ESP-IDF no firmware; aqui so a CA autoassinada do servidor. */
+esp_err_t esp_crt_bundle_attach(void *conf) {
+  mbedtls_ssl_conf_ca_chain((mbedtls_ssl_config *)conf, &s_srv.cert, NULL);
+  return ESP_OK;
+}
+
+static int server_make_cert(void) {
+  mbedtls_pk_init(&s_srv.key);
+  mbedtls_x509_crt_init(&s_srv.cert);
+  int ret = mbedtls_pk_setup(&s_srv.key,
+                             mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+  if (ret == 0) {
+    ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1,
+                              mbedtls_pk_ec(s_srv.key),
+                              mbedtls_ctr_drbg_random, &s_srv.drbg);
+  }
+  if (ret != 0) {
+    return ret;
+  }
+
+  mbedtls_x509write_cert crt;
+  mbedtls_x509write_crt_init(&crt);
+  mbedtls_x509write_crt_set_version(&crt, MBEDTLS_X509_CRT_VERSION_3);
+  mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+  mbedtls_x509write_crt_set_subject_key(&crt, &s_srv.key);
+  mbedtls_x509write_crt_set_issuer_key(&crt, &s_srv.key);
+  ret = mbedtls_x509write_crt_set_subject_name(&crt, "CN=localhost");
+  if (ret == 0) {
+    ret = mbedtls_x509write_crt_set_issuer_name(&crt, "CN=localhost");
+  }
+  if (ret == 0) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03040000
+    unsigned char serial[] = {0x01};
+    ret = mbedtls_x509write_crt_set_serial_raw(&crt, serial, sizeof(serial));
+#else
+    mbedtls_mpi serial;
+    mbedtls_mpi_init(&serial);
+    ret = mbedtls_mpi_lset(&serial, 1);
+    if (ret == 0) {
+      ret = mbedtls_x509write_crt_set_serial(&crt, &serial);
+    }
+    mbedtls_mpi_free(&serial);
+#endif
+  }
+  if (ret == 0) {
+    ret = mbedtls_x509write_crt_set_validity(&crt, "20240101000000",
+                                             "20991231235959");
+  }
+  if (ret == 0) {
+    ret = mbedtls_x509write_crt_set_basic_constraints(&crt, 1, 0);
+  }
+  unsigned char der[2048];
+  int len = ret;
+  if (ret == 0) {
+    len = mbedtls_x509write_crt_der(&crt, der, sizeof(der),
+                                    mbedtls_ctr_drbg_random, &s_srv.drbg);
+  }
+  mbedtls_x509write_crt_free(&crt);
+  if (len <= 0) {
+    return len ? len : -1;
+  }
+  /* o DER e escrito no fim do buffer */
+  return mbedtls_x509_crt_parse_der(&s_srv.cert, der + sizeof(der) - len,
+                                    (size_t)len);
+}
+
+static int server_ticket_setup(void) {
+  mbedtls_ssl_ticket_init(&s_srv.ticket);
+  return mbedtls_ssl_ticket_setup(&s_srv.ticket, mbedtls_ctr_drbg_random,
+                                  &s_srv.drbg, MBEDTLS_CIPHER_AES_256_GCM,
+                                  TICKET_LIFETIME_S);
+}
+
+/* Chave nova: os tickets ja emitidos deixam de abrir. */
+static void server_rotate_ticket_key(void) {
+  pthread_mutex_lock(&s_srv.lock);
+  mbedtls_ssl_ticket_free(&s_srv.ticket);
+  CHECK_EQ_INT(server_ticket_setup(), 0);
+  pthread_mutex_unlock(&s_srv.lock);
+}
+
+static void server_serve(int fd) {
+  mbedtls_net_context net;
+  mbedtls_net_init(&net);
+  net.fd = fd;
+  mbedtls_ssl_context ssl;
+  mbedtls_ssl_init(&ssl);
+  int ret = mbedtls_ssl_setup(&ssl, &s_srv.conf);
+  if (ret == 0) {
+    mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, mbedtls_net_recv, NULL);
+    do {
+      ret = mbedtls_ssl_handshake(&ssl);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+             ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+  }
+  if (ret == 0) {
+    s_srv.handshakes++;
+    /* ate o close_notify (ou o FIN) do cliente */
+    unsigned char buf[64];
+    do {
+      ret = mbedtls_ssl_read(&ssl, buf, sizeof(buf));
+    } while (ret > 0 || ret == MBEDTLS_ERR_SSL_WANT_READ ||
+             ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+  }
+  mbedtls_ssl_free(&ssl);
+  mbedtls_net_free(&net); /* fecha o fd */
+}
+
+static void *server_main(void *arg) {
+  (void)arg;
+  for (;;) {
+    const int fd = accept(s_srv.listen_fd, NULL, NULL);
+    if (fd < 0) {
+      break; /* shutdown() no fim do teste */
+    }
+    pthread_mutex_lock(&s_srv.lock);
+    server_serve(fd);
+    pthread_mutex_unlock(&s_srv.lock);
+  }
+  return NULL;
+}
+
+static bool server_start(void) {
+  pthread_mutex_init(&s_srv.lock, NULL);
+  mbedtls_entropy_init(&s_srv.entropy);
+  mbedtls_ctr_drbg_init(&s_srv.drbg);
+  mbedtls_ssl_config_init(&s_srv.conf);
+  int ret = mbedtls_ctr_drbg_seed(&s_srv.drbg, mbedtls_entropy_func,
+                                  &s_srv.entropy, NULL, 0);
+  if (ret == 0) {
+    ret = server_make_cert();
+  }
+  if (ret == 0) {
+    ret = server_ticket_setup();
+  }
+  if (ret == 0) {
+    ret = mbedtls_ssl_config_defaults(&s_srv.conf, MBEDTLS_SSL_IS_SERVER,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret == 0) {
+    ret = mbedtls_ssl_conf_own_cert(&s_srv.conf, &s_srv.cert, &s_srv.key);
+  }
+  if (ret != 0) {
+    fprintf(stderr, "TLS server setup failed: -0x%04x\n", (unsigned)-ret);
+    return false;
+  }
+  mbedtls_ssl_conf_rng(&s_srv.conf, mbedtls_ctr_drbg_random, &s_srv.drbg);
+  /* como o firmware (TLS 1.3 desligado no ESP-IDF): ticket no handshake */
+  mbedtls_ssl_conf_max_tls_version(&s_srv.conf, MBEDTLS_SSL_VERSION_TLS1_2);
+  mbedtls_ssl_conf_session_tickets_cb(&s_srv.conf, mbedtls_ssl_ticket_write,
+                                      mbedtls_ssl_ticket_parse, &s_srv.ticket);
+
+  s_srv.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {
+      .sin_family = AF_INET,
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+  };
+  socklen_t addr_len = sizeof(addr);
+  if (s_srv.listen_fd < 0 ||
+      bind(s_srv.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(s_srv.listen_fd, 4) != 0 ||
+      getsockname(s_srv.listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+    fprintf(stderr, "listen on loopback failed (errno %d)\n", errno);
+    return false;
+  }
+  s_srv.port = ntohs(addr.sin_port);
+  return pthread_create(&s_srv.thread, NULL, server_main, NULL) == 0;
+}
+
+static void server_stop(void) {
+  shutdown(s_srv.listen_fd, SHUT_RDWR);
+  pthread_join(s_srv.thread, NULL);
+  close(s_srv.listen_fd);
+  mbedtls_ssl_config_free(&s_srv.conf);
+  mbedtls_ssl_ticket_free(&s_srv.ticket);
+  mbedtls_x509_crt_free(&s_srv.cert);
+  mbedtls_pk_free(&s_srv.key);
+  mbedtls_ctr_drbg_free(&s_srv.drbg);
+  mbedtls_entropy_free(&s_srv.entropy);
+  pthread_mutex_destroy(&s_srv.lock);
+}
+
+/* ---- dispositivo ------------------------------------------------------- */
+
+/* Reset por software ou wake do deep sleep: a RTC sobrevive. */
+static void device_reboot(void) { s_tls_cache_checked = false; }
+
+/* Corte de energia: RTC_NOINIT volta com lixo, o NVS fica. */
+static void device_power_on(void) {
+  memset(&s_tls_cache, 0xA5, sizeof(s_tls_cache));
+  s_tls_cache_checked = false;
+}
+
+/* Placa nova: nada na RTC nem no NVS, contadores zerados. */
+static void device_factory(void) {
+  fake_nvs_reset();
+  device_power_on();
+  memset(&s_tls_stats, 0, sizeof(s_tls_stats));
+}
+
+/* Um connect + handshake + close; devolve o resultado da sessao. */
+static ai_conn_session_t device_connect(void) {
+  const ai_conn_cfg_t cfg = {
+      .host = "localhost",
+      .port = s_srv.port,
+      .tls = true,
+      .timeout_ms = 5000,
+  };
+  ai_conn_info_t info;
+  memset(&info, 0xA5, sizeof(info));
+  CHECK_EQ_INT(ai_conn_open(&cfg, &info), ESP_OK);
+  ai_conn_close();
+  return info.session;
+}
+
+static void set_saved_at(int64_t saved_at) {
+  s_tls_cache.saved_at = saved_at;
+  s_tls_cache.crc = ai_tls_cache_crc(&s_tls_cache);
+}
+
+/* ---- casos ------------------------------------------------------------- */
+
+static void test_full_then_resumed(void) {
+  device_factory();
+  const int handshakes = s_srv.handshakes;
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+  CHECK(ai_tls_cache_valid(&s_tls_cache));
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  ai_conn_tls_stats_t st;
+  ai_conn_get_tls_stats(&st);
+  CHECK_EQ_INT(st.full, 1);
+  CHECK_EQ_INT(st.resumed, 2);
+  CHECK_EQ_INT(st.rejected, 0);
+  CHECK(st.session_len > 0 && st.session_len <= AI_TLS_SESSION_MAX_LEN);
+  CHECK_EQ_INT(st.session_len, s_tls_cache.len);
+  CHECK_STR_EQ(s_tls_cache.host, "localhost");
+  CHECK_EQ_INT(s_tls_cache.port, s_srv.port);
+  CHECK_EQ_INT(s_srv.handshakes - handshakes, 3);
+}
+
+/* Reboot: sessao da RTC. Power-on: RTC invalida pelo CRC, volta do NVS
+ * gravado por ai_conn_session_persist(). Sem NVS: full. */
+static void test_rtc_then_nvs_fallback(void) {
+  device_factory();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+  ai_conn_session_persist();
+  CHECK_EQ_INT(fake_nvs_commits(), 1);
+  size_t blob_len = 0;
+  CHECK(fake_nvs_blob(AI_TLS_NVS_NAMESPACE, AI_TLS_NVS_KEY, &blob_len));
+  CHECK_EQ_INT(blob_len, AI_TLS_CACHE_HDR_LEN + s_tls_cache.len);
+
+  device_reboot();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  device_power_on();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  fake_nvs_reset();
+  device_power_on();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+}
+
+/* Chave de ticket trocada: a sessao e oferecida, o servidor faz o
+ * handshake completo; o ticket novo volta a ser aceito. */
+static void test_rotated_key_rejected(void) {
+  device_factory();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+  server_rotate_ticket_key();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_REJECTED);
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  ai_conn_tls_stats_t st;
+  ai_conn_get_tls_stats(&st);
+  CHECK_EQ_INT(st.full, 1);
+  CHECK_EQ_INT(st.rejected, 1);
+  CHECK_EQ_INT(st.resumed, 2);
+}
+
+/* Com relogio valido uma sessao velha nem e oferecida (full); sem relogio
+ * na gravacao o servidor decide (aqui aceita). */
+static void test_expired_session(void) {
+  device_factory();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+  set_saved_at((int64_t)time(NULL) - AI_TLS_SESSION_MAX_AGE_S - 60);
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+  CHECK(ai_tls_cache_valid(&s_tls_cache)); /* a do handshake novo */
+
+  set_saved_at((int64_t)time(NULL) - AI_TLS_SESSION_MAX_AGE_S + 60);
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  set_saved_at(1000); /* gravada antes do SNTP */
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  ai_conn_tls_stats_t st;
+  ai_conn_get_tls_stats(&st);
+  CHECK_EQ_INT(st.full, 2);
+  CHECK_EQ_INT(st.resumed, 2);
+}
+
+/* Bit trocado na RTC: descartada no boot, vale a copia do NVS. Os dois
+ * danificados: handshake completo. */
+static void test_crc_damage(void) {
+  device_factory();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+  ai_conn_session_persist();
+
+  s_tls_cache.data[s_tls_cache.len / 2] ^= 0x01;
+  device_reboot();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_RESUMED);
+
+  ai_conn_session_persist();
+  size_t blob_len = 0;
+  uint8_t *blob = fake_nvs_blob(AI_TLS_NVS_NAMESPACE, AI_TLS_NVS_KEY,
+                                &blob_len);
+  CHECK(blob && blob_len > AI_TLS_CACHE_HDR_LEN);
+  if (blob) {
+    blob[blob_len - 1] ^= 0x80;
+  }
+  s_tls_cache.host[0] ^= 0x20;
+  device_reboot();
+  CHECK_EQ_INT(device_connect(), AI_CONN_SESSION_NONE);
+
+  ai_conn_tls_stats_t st;
+  ai_conn_get_tls_stats(&st);
+  CHECK_EQ_INT(st.full, 2);
+  CHECK_EQ_INT(st.resumed, 1);
+  CHECK_EQ_INT(st.rejected, 0);
+}
+
+int main(void) {
+#if defined(MBEDTLS_PSA_CRYPTO_C)
+  if (psa_crypto_init() != PSA_SUCCESS) {
+    fprintf(stderr, "psa_crypto_init failed\n");
+    return 1;
+  }
+#endif
+  if (!server_start()) {
+    return 1;
+  }
+  HOST_TEST_RUN(test_full_then_resumed);
+  HOST_TEST_RUN(test_rtc_then_nvs_fallback);
+  HOST_TEST_RUN(test_rotated_key_rejected);
+  HOST_TEST_RUN(test_expired_session);
+  HOST_TEST_RUN(test_crc_damage);
+  server_stop();
+  return HOST_TEST_EXIT();
+}
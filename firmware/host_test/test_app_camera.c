@@ -0,0 +1,243 @@
+/* Mailbox de frames do live view do P4 (app_camera.c) sob concorrencia: um
+ * produtor publicando sem pausa, o leitor da GUI (app_camera_take_latest) e
+ * um leitor de snapshots (app_camera_snapshot), cada um numa thread. Cada
+ * frame e preenchido com o proprio numero; um frame rasgado, repetido ou
+ * fora de ordem denuncia uma troca errada no triple buffer. White-box: o
+ * teste inclui app_camera.c e faz o papel da task da camera. */
+#include <pthread.h>
+#include <sched.h>
+
+#include "app_camera.c"
+
+#include "host_test.h"
+
+#define STRESS_FRAMES 10000
+#define FRAME_WORDS (APP_CAMERA_FRAME_BYTES / 4)
+
+/* Dubles do bsp e da GUI: a task da camera nao roda neste teste. */
+esp_err_t bsp_camera_capture_preview_into(uint8_t *dst, uint16_t width,
+                                          uint16_t height, uint32_t flags,
+                                          int64_t *timestamp_us) {
+  return ESP_ERR_NOT_SUPPORTED;
+}
+bool bsp_camera_session_is_active(void) { return false; }
+void bsp_camera_session_stop(void) {}
+esp_err_t gui_camera_preview_set_source(gui_preview_source_t source) {
+  return ESP_OK;
+}
+
+static bool s_producer_done;
+
+/* Troca de bytes que o snapshot aplica em modo camera_order. */
+static uint32_t swap16x2(uint32_t w) {
+  return ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+}
+
+/* Indice da primeira palavra diferente de @p want, ou -1. */
+static long first_mismatch(const uint32_t *frame, uint32_t want) {
+  for (size_t i = 0; i < FRAME_WORDS; i++) {
+    if (frame[i] != want) {
+      return (long)i;
+    }
+  }
+  return -1;
+}
+
+static void mailbox_reset(void) {
+  for (int i = 0; i < 3; i++) {
+    free(s_frames[i]);
+    s_frames[i] = calloc(1, APP_CAMERA_FRAME_BYTES);
+  }
+  s_write_idx = 0;
+  s_slot = 1;
+  s_read_idx = 2;
+  s_newest = 0;
+  s_active = true;
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_producer_done = false;
+}
+
+static void mailbox_free(void) {
+  for (int i = 0; i < 3; i++) {
+    free(s_frames[i]);
+    s_frames[i] = NULL;
+  }
+}
+
+/* Como app_camera_task: escreve no proprio frame e publica. */
+static void *producer_main(void *arg) {
+  (void)arg;
+  for (uint32_t seq = 1; seq <= STRESS_FRAMES; seq++) {
+    uint32_t *frame = (uint32_t *)s_frames[s_write_idx];
+    for (size_t i = 0; i < FRAME_WORDS; i++) {
+      frame[i] = seq;
+    }
+    app_camera_publish(esp_timer_get_time(), seq);
+  }
+  __atomic_store_n(&s_producer_done, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+typedef struct {
+  uint32_t taken;
+  uint32_t torn;
+  uint32_t out_of_order;
+  uint32_t after_done; /* frames ainda entregues com o produtor parado */
+} gui_result_t;
+
+/* Como o canvas do LVGL: o frame devolvido fica em uso ate a proxima
+ * chamada, entao e conferido de novo depois de ceder a CPU. */
+static void *gui_main(void *arg) {
+  gui_result_t *res = arg;
+  uint32_t last = 0;
+  for (;;) {
+    const bool done = __atomic_load_n(&s_producer_done, __ATOMIC_ACQUIRE);
+    const uint32_t *frame = (const uint32_t *)app_camera_take_latest();
+    if (frame && done && ++res->after_done > 1) {
+      break; // o slot nao esvazia: a troca do leitor esta quebrada
+    }
+    if (frame) {
+      const uint32_t seq = frame[0];
+      res->taken++;
+      if (seq <= last) {
+        res->out_of_order++;
+      }
+      last = seq;
+      sched_yield();
+      if (first_mismatch(frame, seq) >= 0) {
+        res->torn++;
+      }
+    } else if (done) {
+      break;
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+typedef struct {
+  uint32_t ok;
+  uint32_t timeouts;
+  uint32_t torn;
+  uint32_t out_of_order;
+  esp_err_t other;
+} snapshot_result_t;
+
+static void *snapshot_main(void *arg) {
+  snapshot_result_t *res = arg;
+  uint32_t *copy = malloc(APP_CAMERA_FRAME_BYTES);
+  uint32_t last = 0;
+  while (!__atomic_load_n(&s_producer_done, __ATOMIC_ACQUIRE)) {
+    uint32_t seq = 0;
+    const esp_err_t err = app_camera_snapshot(
+        (uint8_t *)copy, APP_CAMERA_FRAME_BYTES, true, &seq);
+    if (err == ESP_ERR_TIMEOUT) {
+      res->timeouts++;
+      continue;
+    }
+    if (err == ESP_ERR_NOT_FOUND && last == 0) {
+      continue; // nada publicado ainda
+    }
+    if (err != ESP_OK) {
+      res->other = err;
+      break;
+    }
+    res->ok++;
+    if (seq < last) {
+      res->out_of_order++;
+    }
+    last = seq;
+    if (first_mismatch(copy, swap16x2(seq)) >= 0) {
+      res->torn++;
+    }
+  }
+  free(copy);
+  return NULL;
+}
+
+static void test_publish_take_snapshot_stress(void) {
+  mailbox_reset();
+  gui_result_t gui = {0};
+  snapshot_result_t snap = {0};
+  pthread_t producer, gui_thread, snap_thread;
+  pthread_create(&gui_thread, NULL, gui_main, &gui);
+  pthread_create(&snap_thread, NULL, snapshot_main, &snap);
+  pthread_create(&producer, NULL, producer_main, NULL);
+  pthread_join(producer, NULL);
+  pthread_join(gui_thread, NULL);
+  pthread_join(snap_thread, NULL);
+
+  CHECK_EQ_INT(gui.torn, 0);
+  CHECK_EQ_INT(gui.out_of_order, 0);
+  CHECK(gui.after_done <= 1);
+  CHECK(gui.taken > 0);
+  CHECK_EQ_INT(snap.torn, 0);
+  CHECK_EQ_INT(snap.out_of_order, 0);
+  CHECK_EQ_INT(snap.other, ESP_OK);
+  CHECK(snap.ok > 0);
+
+  /* Todo frame publicado foi mostrado ou substituido: o ultimo ja foi
+   * retirado pela GUI, que so sai com o slot vazio. */
+  app_camera_stats_t st;
+  app_camera_get_stats(&st);
+  CHECK_EQ_INT(st.published, STRESS_FRAMES);
+  CHECK_EQ_INT(st.shown, gui.taken);
+  CHECK_EQ_INT(st.shown + st.dropped, st.published);
+  printf("  published=%u shown=%u dropped=%u snapshots=%u timeouts=%u\n",
+         (unsigned)st.published, (unsigned)st.shown, (unsigned)st.dropped,
+         (unsigned)snap.ok, (unsigned)snap.timeouts);
+  mailbox_free();
+}
+
+/* Sem leitor, cada publicacao substitui a anterior; a GUI pega so a
+ * ultima e um snapshot ve a mesma. */
+static void test_unread_frames_dropped(void) {
+  mailbox_reset();
+  uint32_t snap_seq = 0;
+  uint8_t *copy = malloc(APP_CAMERA_FRAME_BYTES);
+  CHECK_EQ_INT(app_camera_snapshot(copy, APP_CAMERA_FRAME_BYTES, false,
+                                   &snap_seq),
+               ESP_ERR_NOT_FOUND);
+  CHECK(app_camera_take_latest() == NULL);
+
+  for (uint32_t seq = 1; seq <= 5; seq++) {
+    uint32_t *frame = (uint32_t *)s_frames[s_write_idx];
+    for (size_t i = 0; i < FRAME_WORDS; i++) {
+      frame[i] = seq;
+    }
+    app_camera_publish(esp_timer_get_time(), seq);
+  }
+  const uint32_t *shown = (const uint32_t *)app_camera_take_latest();
+  CHECK(shown != NULL);
+  CHECK_EQ_INT(shown ? first_mismatch(shown, 5) : 0, -1);
+  CHECK(app_camera_take_latest() == NULL);
+
+  CHECK_EQ_INT(app_camera_snapshot(copy, APP_CAMERA_FRAME_BYTES, false,
+                                   &snap_seq),
+               ESP_OK);
+  CHECK_EQ_INT(snap_seq, 5);
+  CHECK_EQ_INT(first_mismatch((const uint32_t *)copy, 5), -1);
+  CHECK_EQ_INT(app_camera_snapshot(copy, APP_CAMERA_FRAME_BYTES - 1, false,
+                                   NULL),
+               ESP_ERR_INVALID_ARG);
+
+  /* Preview desligado: a GUI nao troca mais de frame. */
+  app_camera_publish(esp_timer_get_time(), 6);
+  s_active = false;
+  CHECK(app_camera_take_latest() == NULL);
+
+  app_camera_stats_t st;
+  app_camera_get_stats(&st);
+  CHECK_EQ_INT(st.published, 6);
+  CHECK_EQ_INT(st.shown, 1);
+  CHECK_EQ_INT(st.dropped, 4);
+  free(copy);
+  mailbox_free();
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_unread_frames_dropped);
+  HOST_TEST_RUN(test_publish_take_snapshot_stress);
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,438 @@
+/* audio_codec: ida e volta do FLAC (decodificador de referencia em
+ * fixtures/ e, se houver, a libFLAC) e do IMA-ADPCM (decodificador da
+ * especificacao), em tamanhos nas bordas de bloco, taxas com e sem codigo
+ * no cabecalho do frame e sinais que forcam cada tipo de subframe. */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_codec.h"
+#include "audio_decoders.h"
+#include "audio_signals.h"
+#include "host_test.h"
+
+#ifdef HOST_TEST_HAVE_LIBFLAC
+#include <FLAC/stream_decoder.h>
+#endif
+
+static const size_t k_sizes[] = {16,   17,   255,  256,  257,
+                                 4095, 4096, 4097, 8193, 20000};
+static const uint32_t k_rates[] = {8000, 16000, 11025, 44100};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+/* ---- FLAC ---------------------------------------------------------------- */
+
+#ifdef HOST_TEST_HAVE_LIBFLAC
+typedef struct {
+  const uint8_t *in;
+  size_t len;
+  size_t pos;
+  int16_t *out;
+  size_t n;
+  size_t cap;
+  bool err;
+} libflac_ctx_t;
+
+static FLAC__StreamDecoderReadStatus libflac_read(const FLAC__StreamDecoder *d,
+                                                  FLAC__byte buf[],
+                                                  size_t *bytes, void *c) {
+  libflac_ctx_t *ctx = c;
+  (void)d;
+  size_t n = ctx->len - ctx->pos;
+  if (n == 0) {
+    *bytes = 0;
+    return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+  }
+  if (n > *bytes) {
+    n = *bytes;
+  }
+  memcpy(buf, ctx->in + ctx->pos, n);
+  ctx->pos += n;
+  *bytes = n;
+  return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+}
+
+static FLAC__StreamDecoderWriteStatus
+libflac_write(const FLAC__StreamDecoder *d, const FLAC__Frame *frame,
+              const FLAC__int32 *const buffer[], void *c) {
+  libflac_ctx_t *ctx = c;
+  (void)d;
+  for (unsigned i = 0; i < frame->header.blocksize; i++) {
+    if (ctx->n < ctx->cap) {
+      ctx->out[ctx->n++] = (int16_t)buffer[0][i];
+    } else {
+      ctx->err = true;
+    }
+  }
+  return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void libflac_error(const FLAC__StreamDecoder *d,
+                          FLAC__StreamDecoderErrorStatus status, void *c) {
+  (void)d;
+  fprintf(stderr, "libFLAC: %s\n", FLAC__StreamDecoderErrorStatusString[status]);
+  ((libflac_ctx_t *)c)->err = true;
+}
+
+static long libflac_decode(const uint8_t *in, size_t len, int16_t *out,
+                           size_t cap) {
+  libflac_ctx_t ctx = {.in = in, .len = len, .out = out, .cap = cap};
+  FLAC__StreamDecoder *dec = FLAC__stream_decoder_new();
+  if (!dec) {
+    return -1;
+  }
+  bool ok = FLAC__stream_decoder_init_stream(
+                dec, libflac_read, NULL, NULL, NULL, NULL, libflac_write,
+                NULL, libflac_error, &ctx) ==
+            FLAC__STREAM_DECODER_INIT_STATUS_OK;
+  ok = ok && FLAC__stream_decoder_process_until_end_of_stream(dec);
+  FLAC__stream_decoder_finish(dec);
+  FLAC__stream_decoder_delete(dec);
+  return (ok && !ctx.err) ? (long)ctx.n : -1;
+}
+#endif
+
+static unsigned s_subframes[4];
+
+/* Codifica, decodifica e compara amostra a amostra. */
+static void flac_round_trip(const int16_t *pcm, size_t n, uint32_t rate) {
+  const size_t cap = audio_flac_max_len(n);
+  uint8_t *enc = malloc(cap);
+  const size_t len = audio_flac_encode(pcm, n, rate, enc, cap);
+  CHECK(len > 0 && len <= cap);
+  if (len == 0) {
+    free(enc);
+    return;
+  }
+
+  int16_t *dec = malloc(n * sizeof(int16_t));
+  flac_dec_info_t info;
+  const long got = flac_dec_decode(enc, len, dec, n, &info);
+  CHECK_EQ_INT(got, n);
+  if (got == (long)n) {
+    CHECK_MEM_EQ(dec, n * 2, pcm, n * 2);
+  }
+  const unsigned block = (n < AUDIO_FLAC_BLOCK_SIZE) ? n : AUDIO_FLAC_BLOCK_SIZE;
+  CHECK_EQ_INT(info.sample_rate_hz, rate);
+  CHECK_EQ_INT(info.total_samples, n);
+  CHECK_EQ_INT(info.min_block, block);
+  CHECK_EQ_INT(info.max_block, block);
+  CHECK_EQ_INT(info.frames, (n + AUDIO_FLAC_BLOCK_SIZE - 1) /
+                                AUDIO_FLAC_BLOCK_SIZE);
+  CHECK_EQ_INT(info.min_frame, info.frame_min_seen);
+  CHECK_EQ_INT(info.max_frame, info.frame_max_seen);
+  for (int i = 0; i < 4; i++) {
+    s_subframes[i] += info.subframes[i];
+  }
+
+#ifdef HOST_TEST_HAVE_LIBFLAC
+  memset(dec, 0, n * sizeof(int16_t));
+  CHECK_EQ_INT(libflac_decode(enc, len, dec, n), n);
+  CHECK_MEM_EQ(dec, n * 2, pcm, n * 2);
+#endif
+  free(dec);
+  free(enc);
+}
+
+static void test_flac_round_trip(void) {
+  int16_t *pcm = malloc(20000 * sizeof(int16_t));
+  for (size_t r = 0; r < COUNT(k_rates); r++) {
+    for (int s = 0; s < AUDIO_SIG_COUNT; s++) {
+      for (size_t i = 0; i < COUNT(k_sizes); i++) {
+        audio_sig_fill((audio_sig_t)s, pcm, k_sizes[i], k_rates[r],
+                       (uint32_t)(i + 1));
+        flac_round_trip(pcm, k_sizes[i], k_rates[r]);
+      }
+    }
+  }
+  free(pcm);
+  /* silencio -> CONSTANT, ruido -> VERBATIM, fala/seno -> FIXED e LPC */
+  for (int i = 0; i < 4; i++) {
+    CHECK(s_subframes[i] > 0);
+  }
+}
+
+/* Mais de 127 frames: numero de frame com 2 bytes no "UTF-8" do FLAC. */
+static void test_flac_long_stream(void) {
+  const size_t n = 140 * AUDIO_FLAC_BLOCK_SIZE + 5;
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  audio_sig_fill(AUDIO_SIG_SPEECH, pcm, n, 8000, 77);
+  flac_round_trip(pcm, n, 8000);
+  free(pcm);
+}
+
+static void test_flac_rejects(void) {
+  int16_t pcm[4096];
+  audio_sig_fill(AUDIO_SIG_NOISE, pcm, 4096, 8000, 5);
+  uint8_t out[256];
+  CHECK_EQ_INT(audio_flac_encode(pcm, 15, 8000, out, sizeof(out)), 0);
+  CHECK_EQ_INT(audio_flac_encode(pcm, 4096, 0, out, sizeof(out)), 0);
+  CHECK_EQ_INT(audio_flac_encode(pcm, 4096, 1U << 20, out, sizeof(out)), 0);
+  /* buffer curto: falha sem escrever alem do fim (ASan) */
+  uint8_t *small = malloc(1000);
+  CHECK_EQ_INT(audio_flac_encode(pcm, 4096, 8000, small, 1000), 0);
+  free(small);
+}
+
+/* ---- IMA-ADPCM ----------------------------------------------------------- */
+
+static double snr_db(const int16_t *ref, const int16_t *x, size_t n) {
+  double sig = 0.0;
+  double err = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    const double d = (double)x[i] - (double)ref[i];
+    sig += (double)ref[i] * ref[i];
+    err += d * d;
+  }
+  return (err == 0.0) ? INFINITY : 10.0 * log10(sig / err);
+}
+
+static void adpcm_round_trip(audio_sig_t sig, size_t n, uint32_t rate) {
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  audio_sig_fill(sig, pcm, n, rate, (uint32_t)n);
+  const size_t cap = audio_ima_adpcm_wav_len(n, rate);
+  uint8_t *enc = malloc(cap);
+  CHECK_EQ_INT(audio_ima_adpcm_wav_encode(pcm, n, rate, enc, cap), cap);
+
+  int16_t *dec = malloc(n * sizeof(int16_t));
+  uint32_t dec_rate = 0;
+  CHECK_EQ_INT(ima_dec_wav_decode(enc, cap, dec, n, &dec_rate), n);
+  CHECK_EQ_INT(dec_rate, rate);
+
+  /* a primeira amostra de cada bloco vai sem codificar */
+  const size_t spb = (audio_ima_adpcm_block_align(rate) - 4U) * 2U + 1U;
+  for (size_t i = 0; i < n; i += spb) {
+    CHECK_EQ_INT(dec[i], pcm[i]);
+  }
+  const double snr = snr_db(pcm, dec, n);
+  switch (sig) {
+  case AUDIO_SIG_SILENCE:
+    CHECK_MEM_EQ(dec, n * 2, pcm, n * 2);
+    break;
+  case AUDIO_SIG_SPEECH:
+  case AUDIO_SIG_SINE:
+    if (n > 1000) {
+      CHECK(snr > 20.0);
+    }
+    break;
+  default:
+    /* ruido branco e saturacao: so precisa acompanhar o sinal */
+    if (n > 1000) {
+      CHECK(snr > 5.0);
+    }
+    break;
+  }
+  free(dec);
+  free(enc);
+  free(pcm);
+}
+
+static void test_adpcm_round_trip(void) {
+  static const size_t sizes[] = {1,    2,    504,  505,  506,
+                                 1010, 1011, 4096, 24007};
+  static const uint32_t rates[] = {8000, 16000, 44100}; /* 256/512/1024 */
+  for (size_t r = 0; r < COUNT(rates); r++) {
+    for (int s = 0; s < AUDIO_SIG_COUNT; s++) {
+      for (size_t i = 0; i < COUNT(sizes); i++) {
+        adpcm_round_trip((audio_sig_t)s, sizes[i], rates[r]);
+      }
+    }
+  }
+}
+
+static void test_adpcm_rejects(void) {
+  int16_t pcm[600] = {0};
+  const size_t need = audio_ima_adpcm_wav_len(600, 8000);
+  uint8_t *out = malloc(need - 1);
+  CHECK_EQ_INT(audio_ima_adpcm_wav_encode(pcm, 600, 8000, out, need - 1), 0);
+  CHECK_EQ_INT(audio_ima_adpcm_wav_encode(pcm, 0, 8000, out, need - 1), 0);
+  free(out);
+}
+
+/* ---- interface de alto nivel --------------------------------------------- */
+
+static void test_codec_encode(void) {
+  const size_t n = 12345;
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  audio_sig_fill(AUDIO_SIG_SPEECH, pcm, n, 16000, 9);
+
+  static const audio_codec_format_t fmts[] = {AUDIO_CODEC_FLAC,
+                                              AUDIO_CODEC_WAV_IMA_ADPCM};
+  for (size_t f = 0; f < COUNT(fmts); f++) {
+    uint8_t *out = NULL;
+    size_t len = 0;
+    CHECK_EQ_INT(audio_codec_encode(fmts[f], pcm, n, 16000, &out, &len),
+                 ESP_OK);
+    const size_t cap = (fmts[f] == AUDIO_CODEC_FLAC)
+                           ? audio_flac_max_len(n)
+                           : audio_ima_adpcm_wav_len(n, 16000);
+    uint8_t *direct = malloc(cap);
+    const size_t direct_len =
+        (fmts[f] == AUDIO_CODEC_FLAC)
+            ? audio_flac_encode(pcm, n, 16000, direct, cap)
+            : audio_ima_adpcm_wav_encode(pcm, n, 16000, direct, cap);
+    CHECK_MEM_EQ(out, len, direct, direct_len);
+    free(direct);
+    free(out);
+  }
+
+  uint8_t *out = NULL;
+  size_t len = 0;
+  CHECK_EQ_INT(
+      audio_codec_encode(AUDIO_CODEC_WAV_PCM16, pcm, n, 16000, &out, &len),
+      ESP_ERR_NOT_SUPPORTED);
+  CHECK_EQ_INT(audio_codec_encode(AUDIO_CODEC_FLAC, pcm, 0, 16000, &out, &len),
+               ESP_ERR_INVALID_ARG);
+  CHECK_EQ_INT(audio_codec_from_name("flac"), AUDIO_CODEC_FLAC);
+  CHECK_EQ_INT(audio_codec_from_name("adpcm"), AUDIO_CODEC_WAV_IMA_ADPCM);
+  CHECK_EQ_INT(audio_codec_from_name("mp3"), AUDIO_CODEC_WAV_PCM16);
+  CHECK_STR_EQ(audio_codec_api_format(AUDIO_CODEC_WAV_IMA_ADPCM), "wav");
+  free(pcm);
+}
+
+/* ---- stream --------------------------------------------------------------- */
+
+typedef struct {
+  uint8_t *buf;
+  size_t len;
+  size_t cap;
+  size_t calls;
+} sink_buf_t;
+
+static bool sink_append(void *ctx, const uint8_t *data, size_t len) {
+  sink_buf_t *b = ctx;
+  b->calls++;
+  if (len > b->cap - b->len) {
+    return false;
+  }
+  memcpy(b->buf + b->len, data, len);
+  b->len += len;
+  return true;
+}
+
+/* Pedacos de tamanho aleatorio, como os segmentos de uma gravacao: a saida
+ * e a do codificador de uma vez (no FLAC, a menos dos tamanhos de frame do
+ * STREAMINFO, zerados no stream) e decodifica de volta. */
+static void stream_matches_one_shot(audio_codec_format_t fmt, size_t n,
+                                    uint32_t rate, uint32_t seed) {
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  audio_sig_fill(AUDIO_SIG_SPEECH, pcm, n, rate, seed);
+  const size_t cap = (fmt == AUDIO_CODEC_FLAC)
+                         ? audio_flac_max_len(n)
+                         : audio_ima_adpcm_wav_len(n, rate);
+  uint8_t *direct = malloc(cap);
+  const size_t direct_len =
+      (fmt == AUDIO_CODEC_FLAC)
+          ? audio_flac_encode(pcm, n, rate, direct, cap)
+          : audio_ima_adpcm_wav_encode(pcm, n, rate, direct, cap);
+
+  audio_codec_stream_t *st = malloc(sizeof(*st));
+  sink_buf_t sink = {.buf = malloc(cap), .cap = cap};
+  CHECK_EQ_INT(audio_codec_stream_begin(st, fmt, n, rate, sink_append, &sink),
+               ESP_OK);
+  for (size_t pos = 0; pos < n;) {
+    size_t c = 1 + host_test_rand(&seed) % 6000;
+    if (c > n - pos) {
+      c = n - pos;
+    }
+    CHECK_EQ_INT(audio_codec_stream_write(st, pcm + pos, c), ESP_OK);
+    pos += c;
+  }
+  size_t len = 0;
+  CHECK_EQ_INT(audio_codec_stream_end(st, &len), ESP_OK);
+  CHECK_EQ_INT(len, sink.len);
+
+  if (fmt == AUDIO_CODEC_FLAC && direct_len >= AUDIO_FLAC_HEADER_LEN) {
+    memset(direct + 12, 0, 6); /* min/max frame do STREAMINFO */
+  }
+  CHECK_MEM_EQ(sink.buf, sink.len, direct, direct_len);
+
+  int16_t *dec = malloc(n * sizeof(int16_t));
+  long got;
+  if (fmt == AUDIO_CODEC_FLAC) {
+    flac_dec_info_t info;
+    got = flac_dec_decode(sink.buf, sink.len, dec, n, &info);
+    CHECK_EQ_INT(info.min_frame, 0);
+    CHECK_EQ_INT(info.max_frame, 0);
+    CHECK(got == (long)n && memcmp(dec, pcm, n * 2) == 0);
+  } else {
+    uint32_t dec_rate = 0;
+    got = ima_dec_wav_decode(sink.buf, sink.len, dec, n, &dec_rate);
+    CHECK_EQ_INT(got, n);
+    CHECK_EQ_INT(dec_rate, rate);
+  }
+  free(dec);
+  free(sink.buf);
+  free(st);
+  free(direct);
+  free(pcm);
+}
+
+static void test_codec_stream(void) {
+  static const size_t sizes[] = {16,   504,  505,  506,  4095,
+                                 4096, 4097, 8192, 12345, 20000};
+  for (size_t i = 0; i < COUNT(sizes); i++) {
+    stream_matches_one_shot(AUDIO_CODEC_FLAC, sizes[i], 8000, (uint32_t)i + 1);
+    stream_matches_one_shot(AUDIO_CODEC_WAV_IMA_ADPCM, sizes[i], 8000,
+                            (uint32_t)i + 1);
+    stream_matches_one_shot(AUDIO_CODEC_WAV_IMA_ADPCM, sizes[i], 16000,
+                            (uint32_t)i + 7);
+  }
+  stream_matches_one_shot(AUDIO_CODEC_FLAC, 140 * AUDIO_FLAC_BLOCK_SIZE + 5,
+                          16000, 3);
+}
+
+static void test_codec_stream_errors(void) {
+  int16_t pcm[5000] = {0};
+  audio_codec_stream_t *st = malloc(sizeof(*st));
+  uint8_t buf[1024];
+  sink_buf_t sink = {.buf = buf, .cap = sizeof(buf)};
+
+  CHECK_EQ_INT(audio_codec_stream_begin(st, AUDIO_CODEC_WAV_PCM16, 100, 8000,
+                                        sink_append, &sink),
+               ESP_ERR_NOT_SUPPORTED);
+  CHECK_EQ_INT(audio_codec_stream_begin(st, AUDIO_CODEC_FLAC, 15, 8000,
+                                        sink_append, &sink),
+               ESP_ERR_INVALID_ARG);
+  CHECK_EQ_INT(audio_codec_stream_begin(st, AUDIO_CODEC_FLAC, 100, 8000, NULL,
+                                        NULL),
+               ESP_ERR_INVALID_ARG);
+
+  /* mais amostras que o declarado; fim antes do total */
+  sink.len = 0;
+  CHECK_EQ_INT(audio_codec_stream_begin(st, AUDIO_CODEC_WAV_IMA_ADPCM, 100,
+                                        8000, sink_append, &sink),
+               ESP_OK);
+  CHECK_EQ_INT(audio_codec_stream_write(st, pcm, 101), ESP_ERR_INVALID_SIZE);
+  CHECK_EQ_INT(audio_codec_stream_write(st, pcm, 60), ESP_OK);
+  CHECK_EQ_INT(audio_codec_stream_end(st, NULL), ESP_ERR_INVALID_STATE);
+  CHECK_EQ_INT(audio_codec_stream_write(st, pcm, 40), ESP_OK);
+  CHECK_EQ_INT(audio_codec_stream_end(st, NULL), ESP_OK);
+
+  /* destino cheio: o sink recusa e o stream falha de vez */
+  sink.len = 0;
+  sink.cap = 600;
+  CHECK_EQ_INT(audio_codec_stream_begin(st, AUDIO_CODEC_WAV_IMA_ADPCM, 5000,
+                                        8000, sink_append, &sink),
+               ESP_OK);
+  CHECK_EQ_INT(audio_codec_stream_write(st, pcm, 5000), ESP_FAIL);
+  CHECK_EQ_INT(audio_codec_stream_write(st, pcm, 0), ESP_FAIL);
+  CHECK_EQ_INT(audio_codec_stream_end(st, NULL), ESP_FAIL);
+  free(st);
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_flac_round_trip);
+  HOST_TEST_RUN(test_flac_long_stream);
+  HOST_TEST_RUN(test_flac_rejects);
+  HOST_TEST_RUN(test_adpcm_round_trip);
+  HOST_TEST_RUN(test_adpcm_rejects);
+  HOST_TEST_RUN(test_codec_encode);
+  HOST_TEST_RUN(test_codec_stream);
+  HOST_TEST_RUN(test_codec_stream_errors);
+#ifndef HOST_TEST_HAVE_LIBFLAC
+  printf("libFLAC cross-check                          skipped (no libFLAC)\n");
+#endif
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,174 @@
+/* Kernels de audio_dsp: desempacotamento e pack exatos contra o BSP, o
+ * biquad de audio_dsp_highpass_coefs() contra a recursao de 1a ordem, o
+ * despacho contra a referencia e o autoteste do boot ("dsp_bench"). No
+ * host o despacho e a referencia; no S3 os mesmos limites valem para o
+ * esp-dsp (o autoteste usa as mesmas tolerancias). */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_dsp.h"
+#include "audio_signals.h"
+#include "host_test.h"
+
+#define N 4000
+
+/* Copia de bsp_audio_decode_default (bsp.c). */
+static int16_t bsp_decode_one(int32_t raw_l, int32_t raw_r) {
+  int32_t l = raw_l >> 15;
+  int32_t r = raw_r >> 15;
+  int32_t s = (abs(l) >= abs(r)) ? l : r;
+  if (s > INT16_MAX) {
+    s = INT16_MAX;
+  } else if (s < INT16_MIN) {
+    s = INT16_MIN;
+  }
+  return (int16_t)s;
+}
+
+static void test_unpack_matches_bsp(void) {
+  int32_t *raw = malloc(2 * N * sizeof(int32_t));
+  float *f = malloc(N * sizeof(float));
+  uint32_t seed = 99;
+  for (size_t i = 0; i < 2 * N; i++) {
+    raw[i] = (int32_t)host_test_rand(&seed);
+  }
+  /* extremos: satura nos dois lados, empate de |L| e |R| */
+  raw[0] = INT32_MAX;
+  raw[1] = 0;
+  raw[2] = INT32_MIN;
+  raw[3] = 0;
+  raw[4] = -(1000 << 15);
+  raw[5] = 1000 << 15;
+  audio_dsp_i2s_to_f32(raw, N, f);
+  bool same = true;
+  for (size_t i = 0; i < N; i++) {
+    same &= (f[i] == (float)bsp_decode_one(raw[2 * i], raw[2 * i + 1]));
+  }
+  CHECK(same);
+  CHECK(f[0] == 32767.0f);
+  CHECK(f[1] == -32768.0f);
+  CHECK(f[2] == -1000.0f);
+  free(f);
+  free(raw);
+}
+
+/* Mesmo resultado que (int16_t) depois de limitar. */
+static void test_pack_saturates_and_truncates(void) {
+  const float in[] = {1.9f,     -1.9f,    0.0f,     32767.5f,
+                      40000.0f, -40000.0f, -32768.0f, -32768.9f};
+  const int16_t want[] = {1, -1, 0, 32767, 32767, -32768, -32768, -32768};
+  int16_t out[8];
+  audio_dsp_pack_s16(in, out, 8);
+  CHECK_MEM_EQ(out, sizeof(out), want, sizeof(want));
+}
+
+/* O biquad com audio_dsp_highpass_coefs() e o filtro
+ * y[n] = alpha * (y[n-1] + x[n] - x[n-1]) partindo de estado zero, e o
+ * estado levado entre chamadas da o mesmo resultado de uma chamada so. */
+static void test_biquad_matches_recursion(void) {
+  int16_t pcm[N];
+  audio_sig_fill(AUDIO_SIG_SPEECH, pcm, N, 8000, 5);
+  float x[N], y[N], y_split[N];
+  for (size_t i = 0; i < N; i++) {
+    x[i] = (float)pcm[i];
+  }
+  const float alpha = 0.927f;
+  float coef[5];
+  audio_dsp_highpass_coefs(alpha, coef);
+
+  float w[2] = {0.0f, 0.0f};
+  audio_dsp_biquad_f32(x, y, N, coef, w);
+
+  float max_err = 0.0f;
+  float prev_x = 0.0f;
+  float prev_y = 0.0f;
+  for (size_t i = 0; i < N; i++) {
+    const float r = alpha * (prev_y + x[i] - prev_x);
+    prev_x = x[i];
+    prev_y = r;
+    if (fabsf(y[i] - r) > max_err) {
+      max_err = fabsf(y[i] - r);
+    }
+  }
+  CHECK(max_err < 0.05f);
+
+  float w2[2] = {0.0f, 0.0f};
+  size_t pos = 0;
+  uint32_t seed = 11;
+  while (pos < N) {
+    size_t c = 1 + host_test_rand(&seed) % 300;
+    if (c > N - pos) {
+      c = N - pos;
+    }
+    audio_dsp_biquad_f32(x + pos, y_split + pos, c, coef, w2);
+    pos += c;
+  }
+  CHECK_MEM_EQ(y_split, sizeof(y_split), y, sizeof(y));
+
+  /* in-place */
+  float w3[2] = {0.0f, 0.0f};
+  audio_dsp_biquad_f32(x, x, N, coef, w3);
+  CHECK_MEM_EQ(x, sizeof(x), y, sizeof(y));
+}
+
+static void test_dispatch_matches_reference(void) {
+  static const audio_sig_t sigs[] = {AUDIO_SIG_SPEECH, AUDIO_SIG_NOISE,
+                                     AUDIO_SIG_SINE, AUDIO_SIG_CLIPPED};
+  float coef[5];
+  audio_dsp_highpass_coefs(0.927f, coef);
+  for (size_t s = 0; s < sizeof(sigs) / sizeof(sigs[0]); s++) {
+    int16_t pcm[N];
+    float x[N], y_ref[N], y_dsp[N];
+    audio_sig_fill(sigs[s], pcm, N, 8000, 3);
+    int64_t exact = 0;
+    for (size_t i = 0; i < N; i++) {
+      x[i] = (float)pcm[i];
+      exact += (int64_t)pcm[i] * pcm[i];
+    }
+
+    float w_ref[2] = {0.0f, 0.0f};
+    float w_dsp[2] = {0.0f, 0.0f};
+    audio_dsp_ref_biquad_f32(x, y_ref, N, coef, w_ref);
+    audio_dsp_biquad_f32(x, y_dsp, N, coef, w_dsp);
+    float max_err = 0.0f;
+    for (size_t i = 0; i < N; i++) {
+      if (fabsf(y_dsp[i] - y_ref[i]) > max_err) {
+        max_err = fabsf(y_dsp[i] - y_ref[i]);
+      }
+    }
+    CHECK(max_err <= 0.5f);
+
+    /* energia em float: arredondada, nao a soma inteira exata */
+    const float e_ref = audio_dsp_ref_energy_f32(x, N);
+    const float e_dsp = audio_dsp_energy_f32(x, N);
+    if (exact > 0) {
+      CHECK(fabs((double)e_ref - (double)exact) / (double)exact < 1e-4);
+      CHECK(fabs((double)e_dsp - (double)e_ref) / (double)e_ref < 1e-4);
+    } else {
+      CHECK(e_ref == 0.0f && e_dsp == 0.0f);
+    }
+  }
+  CHECK(audio_dsp_energy_f32(NULL, 0) == 0.0f);
+}
+
+static void test_self_test(void) {
+  audio_dsp_report_t rep;
+  memset(&rep, 0xA5, sizeof(rep));
+  CHECK(audio_dsp_self_test(&rep));
+  CHECK(rep.ok);
+  CHECK_STR_EQ(rep.backend, audio_dsp_backend());
+  CHECK_EQ_INT(rep.samples, 1024);
+  CHECK(rep.biquad_max_err <= 0.5f);
+  CHECK(rep.energy_rel_err <= 1e-4f);
+  CHECK(audio_dsp_self_test(NULL));
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_unpack_matches_bsp);
+  HOST_TEST_RUN(test_pack_saturates_and_truncates);
+  HOST_TEST_RUN(test_biquad_matches_recursion);
+  HOST_TEST_RUN(test_dispatch_matches_reference);
+  HOST_TEST_RUN(test_self_test);
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,189 @@
+/* Front-end de captura do S3 (audio_frontend_decode) contra o caminho sem
+ * fusao: decodificacao do BSP (bsp_audio_decode_default) seguida de
+ * audio_highpass_process() no stream inteiro. As amostras devem ser
+ * identicas bit a bit, em qualquer fatiamento do DMA, inclusive com o
+ * filtro saturando, e as estatisticas de janela exatas. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_signals.h"
+#include "audio_utils.h"
+#include "host_test.h"
+
+#define RATE 8000
+#define WINDOW 800
+
+/* Copia de bsp_audio_decode_default (bsp.c). */
+static void bsp_decode_ref(const int32_t *raw, size_t frames, int16_t *out) {
+  for (size_t i = 0; i < frames; i++) {
+    int32_t sample_l = raw[2 * i] >> 15;
+    int32_t sample_r = raw[2 * i + 1] >> 15;
+    int32_t sample = (abs(sample_l) >= abs(sample_r)) ? sample_l : sample_r;
+    if (sample > INT16_MAX) {
+      sample = INT16_MAX;
+    } else if (sample < INT16_MIN) {
+      sample = INT16_MIN;
+    }
+    out[i] = (int16_t)sample;
+  }
+}
+
+/* Frames I2S de 24 bits em slots de 32: amostra do sinal no canal
+ * esquerdo com bits baixos aleatorios, direito com outro nivel. gain > 1
+ * passa do int16 depois do >>15 (satura na decodificacao). */
+static int32_t *make_raw(audio_sig_t sig, size_t n, double gain,
+                         uint32_t seed) {
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  audio_sig_fill(sig, pcm, n, RATE, seed);
+  int32_t *raw = malloc(n * 2 * sizeof(int32_t));
+  for (size_t i = 0; i < n; i++) {
+    const uint32_t lo = host_test_rand(&seed) & 0x7F00;
+    double l = (double)pcm[i] * gain * 32768.0 + lo;
+    if (l > INT32_MAX) {
+      l = INT32_MAX;
+    } else if (l < INT32_MIN) {
+      l = INT32_MIN;
+    }
+    double r = l * (((i / 1000) % 2) ? 1.5 : -0.25);
+    if (r > INT32_MAX) {
+      r = INT32_MAX;
+    } else if (r < INT32_MIN) {
+      r = INT32_MIN;
+    }
+    raw[2 * i] = (int32_t)l;
+    raw[2 * i + 1] = (int32_t)r;
+  }
+  free(pcm);
+  return raw;
+}
+
+typedef struct {
+  int16_t *out;
+  audio_window_stats_t *windows;
+  size_t nwin;
+} fe_run_t;
+
+/* Como a task de audio: pedacos de DMA de tamanho aleatorio (max_chunk),
+ * estatisticas fechadas a cada janela como em app_do_interaction. */
+static fe_run_t run_frontend(const int32_t *raw, size_t n, size_t max_chunk,
+                             uint32_t seed) {
+  fe_run_t r = {
+      .out = malloc(n * sizeof(int16_t)),
+      .windows = calloc(n / WINDOW + 1, sizeof(audio_window_stats_t)),
+  };
+  audio_frontend_t *fe = malloc(sizeof(*fe));
+  audio_frontend_init(fe, 100.0f, (float)RATE);
+  for (size_t win = 0; win * WINDOW < n; win++) {
+    audio_frontend_window_reset(fe);
+    const size_t end = (win + 1) * WINDOW < n ? (win + 1) * WINDOW : n;
+    for (size_t pos = win * WINDOW; pos < end;) {
+      size_t c = 1 + host_test_rand(&seed) % max_chunk;
+      if (c > end - pos) {
+        c = end - pos;
+      }
+      audio_frontend_decode(raw + 2 * pos, c, r.out + pos, fe);
+      pos += c;
+    }
+    r.windows[r.nwin++] = fe->window;
+  }
+  free(fe);
+  return r;
+}
+
+static void check_case(audio_sig_t sig, size_t n, double gain,
+                       size_t max_chunk) {
+  int32_t *raw = make_raw(sig, n, gain, (uint32_t)(n + max_chunk));
+
+  /* referencia: BSP + HPF em um passo so */
+  int16_t *ref = malloc(n * sizeof(int16_t));
+  bsp_decode_ref(raw, n, ref);
+  audio_apply_highpass(ref, n, 100.0f, (float)RATE);
+
+  fe_run_t r = run_frontend(raw, n, max_chunk, 7);
+  CHECK_MEM_EQ(r.out, n * 2, ref, n * 2);
+
+  /* estatisticas por janela, recalculadas na saida de referencia */
+  int16_t last = 0;
+  for (size_t w = 0; w < r.nwin; w++) {
+    const size_t start = w * WINDOW;
+    const size_t end = start + WINDOW < n ? start + WINDOW : n;
+    int64_t sum_sq = 0;
+    int32_t peak = 0;
+    uint32_t crossings = 0;
+    for (size_t i = start; i < end; i++) {
+      const int32_t v = ref[i];
+      sum_sq += v * v;
+      if ((v < 0 ? -v : v) > peak) {
+        peak = v < 0 ? -v : v;
+      }
+      crossings += ((last < 0) != (ref[i] < 0));
+      last = ref[i];
+    }
+    CHECK_EQ_INT(r.windows[w].count, end - start);
+    CHECK_EQ_INT(r.windows[w].peak, peak);
+    CHECK_EQ_INT(r.windows[w].crossings, crossings);
+    CHECK_EQ_INT(r.windows[w].sum_sq, sum_sq);
+  }
+  free(r.out);
+  free(r.windows);
+  free(ref);
+  free(raw);
+}
+
+static void test_bit_exact_speech(void) {
+  static const size_t chunks[] = {1, 3, 255, 256, 257, 800, 4096};
+  for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+    check_case(AUDIO_SIG_SPEECH, 5 * RATE + 13, 1.0, chunks[i]);
+  }
+}
+
+/* Sinais que saturam: no decode (ganho 3) e no filtro (degraus de escala
+ * cheia), onde o valor limitado volta para a recursao. */
+static void test_bit_exact_saturating(void) {
+  check_case(AUDIO_SIG_CLIPPED, 3 * RATE, 1.0, 300);
+  check_case(AUDIO_SIG_CLIPPED, 3 * RATE, 3.0, 511);
+  check_case(AUDIO_SIG_NOISE, 2 * RATE + 1, 1.0, 97);
+  check_case(AUDIO_SIG_SINE, 2 * RATE, 4.0, 256);
+
+  /* onda quadrada de escala cheia: cada borda satura o HPF */
+  const size_t n = 4000;
+  int32_t *raw = malloc(n * 2 * sizeof(int32_t));
+  for (size_t i = 0; i < n; i++) {
+    raw[2 * i] = ((i / 40) % 2) ? INT32_MAX : INT32_MIN;
+    raw[2 * i + 1] = 0;
+  }
+  int16_t *ref = malloc(n * sizeof(int16_t));
+  bsp_decode_ref(raw, n, ref);
+  audio_apply_highpass(ref, n, 100.0f, (float)RATE);
+  fe_run_t r = run_frontend(raw, n, 333, 3);
+  CHECK_MEM_EQ(r.out, n * 2, ref, n * 2);
+  bool saturated = false;
+  for (size_t i = 0; i < n; i++) {
+    saturated |= (ref[i] == INT16_MIN || ref[i] == INT16_MAX);
+  }
+  CHECK(saturated);
+  free(r.out);
+  free(r.windows);
+  free(ref);
+  free(raw);
+}
+
+/* A primeira amostra passa direto e inicializa o filtro. */
+static void test_first_sample(void) {
+  const int32_t raw[4] = {1234 << 15, 0, 1234 << 15, 0};
+  int16_t out[2];
+  audio_frontend_t *fe = malloc(sizeof(*fe));
+  audio_frontend_init(fe, 100.0f, (float)RATE);
+  audio_frontend_decode(raw, 1, out, fe);
+  audio_frontend_decode(raw + 2, 1, out + 1, fe);
+  CHECK_EQ_INT(out[0], 1234);
+  CHECK_EQ_INT(out[1], (int16_t)(fe->hpf.alpha * 1234.0f));
+  free(fe);
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_bit_exact_speech);
+  HOST_TEST_RUN(test_bit_exact_saturating);
+  HOST_TEST_RUN(test_first_sample);
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,283 @@
+/* VAD do S3 (audio_utils): limiares nas bordas (piso minimo 40, razoes
+ * 3.0/1.8, ZCR 0.25) e endpointing em sinais sinteticos passados pelo
+ * mesmo front-end da captura (I2S 32 bits -> HPF -> estatisticas por
+ * janela de 100 ms a 8 kHz), como em app_do_interaction. */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_utils.h"
+#include "host_test.h"
+
+#define RATE 8000
+#define WINDOW 800 /* 100 ms */
+
+static const audio_vad_cfg_t k_cfg = {
+    .sample_rate_hz = RATE,
+    .silence_ms = 1200,
+    .pre_margin_ms = 300,
+    .post_margin_ms = 300,
+};
+
+/* ---- limiares sobre estatisticas montadas ------------------------------- */
+
+static audio_window_stats_t stats_of(double rms, double zcr) {
+  audio_window_stats_t s = {0};
+  s.count = WINDOW;
+  s.sum_sq = (int64_t)llround(rms * rms * WINDOW);
+  s.crossings = (uint32_t)lround(zcr * WINDOW);
+  return s;
+}
+
+/* Detector novo, iniciado com uma janela de silencio (piso no minimo). */
+static void vad_quiet(audio_vad_t *vad) {
+  audio_vad_init(vad, &k_cfg);
+  const audio_window_stats_t zero = stats_of(0, 0);
+  CHECK(!audio_vad_process_stats(vad, &zero, WINDOW));
+  CHECK(vad->noise_floor == 40.0f);
+}
+
+static bool classify(double rms, double zcr) {
+  audio_vad_t vad;
+  vad_quiet(&vad);
+  const audio_window_stats_t s = stats_of(rms, zcr);
+  return audio_vad_process_stats(&vad, &s, WINDOW);
+}
+
+static void test_thresholds(void) {
+  /* energia: 3.0 x 40 = 120, qualquer ZCR */
+  CHECK(classify(121, 0.0));
+  CHECK(!classify(119, 0.0));
+  CHECK(!classify(119, 0.2));
+  /* fricativa: 1.8 x 40 = 72 com ZCR acima de 0.25 */
+  CHECK(classify(73, 0.26));
+  CHECK(!classify(73, 0.24));
+  CHECK(!classify(71, 0.5));
+  /* o piso nunca fica abaixo de 40 */
+  audio_vad_t vad;
+  vad_quiet(&vad);
+  for (int i = 0; i < 20; i++) {
+    const audio_window_stats_t s = stats_of(5, 0.5);
+    audio_vad_process_stats(&vad, &s, WINDOW);
+  }
+  CHECK(vad.noise_floor == 40.0f);
+}
+
+/* Usuario ja falando na primeira janela: o piso inicial e limitado a 160
+ * para que a propria fala continue sonora. */
+static void test_initial_floor_capped(void) {
+  audio_vad_t vad;
+  audio_vad_init(&vad, &k_cfg);
+  const audio_window_stats_t loud = stats_of(2000, 0.1);
+  audio_vad_process_stats(&vad, &loud, WINDOW);
+  CHECK(vad.noise_floor <= 160.0f * 1.01f + 0.01f);
+  CHECK(audio_vad_process_stats(&vad, &loud, WINDOW));
+  size_t start = 1;
+  size_t end = 0;
+  CHECK(audio_vad_get_segment(&vad, &start, &end));
+  CHECK_EQ_INT(start, 0);
+}
+
+/* ---- sinais sinteticos pelo front-end ----------------------------------- */
+
+typedef enum { SIG_NOISE, SIG_VOWEL, SIG_FRICATIVE, SIG_HUM } sig_t;
+
+typedef struct {
+  sig_t kind;
+  int ms;
+  double level; /* RMS aproximado */
+} seg_t;
+
+#define MS(x) ((size_t)(x) * RATE / 1000)
+
+/* Gera o trecho como frames I2S (amostra << 15 nos dois canais). */
+static size_t synth(const seg_t *segs, size_t n, int32_t **raw_out) {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += MS(segs[i].ms);
+  }
+  int32_t *raw = malloc(total * 2 * sizeof(int32_t));
+  uint32_t seed = 1234;
+  size_t k = 0;
+  for (size_t i = 0; i < n; i++) {
+    const size_t len = MS(segs[i].ms);
+    for (size_t j = 0; j < len; j++, k++) {
+      const double t = (double)k / RATE;
+      const double u = (double)(host_test_rand(&seed) & 0xFFFF) / 65535.0;
+      double v = 0;
+      switch (segs[i].kind) {
+      case SIG_NOISE:
+      case SIG_FRICATIVE:
+        /* ruido branco uniforme: RMS = amplitude / sqrt(3), ZCR ~0.5 */
+        v = (2 * u - 1) * segs[i].level * sqrt(3.0);
+        break;
+      case SIG_VOWEL: {
+        /* vogal: fundamental de 180 Hz com harmonicos, ZCR baixo; rampas
+         * de 10 ms nas bordas (um corte seco deixaria um degrau que o HPF
+         * espalha pela janela seguinte) */
+        const double ramp = (double)(j < len - j ? j : len - j) / MS(10);
+        v = segs[i].level * (ramp < 1.0 ? ramp : 1.0) *
+            (1.0 * sin(2 * M_PI * 180 * t) + 0.5 * sin(2 * M_PI * 360 * t) +
+             0.25 * sin(2 * M_PI * 540 * t)) /
+            0.81;
+        break;
+      }
+      case SIG_HUM:
+        /* tom grave de mesmo nivel de uma fricativa, ZCR ~0.1 */
+        v = segs[i].level * sqrt(2.0) * sin(2 * M_PI * 400 * t);
+        break;
+      }
+      const int32_t s = (int32_t)lrint(v);
+      raw[2 * k] = s * (1 << 15);
+      raw[2 * k + 1] = (s / 2) * (1 << 15);
+    }
+  }
+  *raw_out = raw;
+  return total;
+}
+
+typedef struct {
+  size_t endpoint_at; /* amostras quando o endpoint disparou (0 = nunca) */
+  bool has_segment;
+  size_t start;
+  size_t end;
+} run_result_t;
+
+/* Loop de captura do app: janela -> front-end -> VAD, parando no
+ * endpoint. Confere a cada janela que o segmento so cresce e nunca passa
+ * do que ja foi capturado. */
+static run_result_t run_capture(const seg_t *segs, size_t n,
+                                const audio_vad_cfg_t *cfg) {
+  int32_t *raw = NULL;
+  const size_t total = synth(segs, n, &raw);
+  int16_t *pcm = malloc(total * sizeof(int16_t));
+  audio_frontend_t *fe = malloc(sizeof(*fe));
+  audio_frontend_init(fe, 100.0f, (float)RATE);
+  audio_vad_t vad;
+  audio_vad_init(&vad, cfg);
+
+  run_result_t r = {0};
+  size_t last_end = 0;
+  for (size_t pos = 0; pos + WINDOW <= total; pos += WINDOW) {
+    audio_frontend_window_reset(fe);
+    /* DMA em pedacos que nao casam com a janela */
+    audio_frontend_decode(raw + 2 * pos, 300, pcm + pos, fe);
+    audio_frontend_decode(raw + 2 * (pos + 300), WINDOW - 300,
+                          pcm + pos + 300, fe);
+    audio_vad_process_stats(&vad, &fe->window, WINDOW);
+    size_t s = 0;
+    size_t e = 0;
+    if (audio_vad_get_segment(&vad, &s, &e)) {
+      CHECK(e <= pos + WINDOW);
+      CHECK(e >= last_end);
+      last_end = e;
+    }
+    if (audio_vad_endpoint(&vad)) {
+      r.endpoint_at = pos + WINDOW;
+      break;
+    }
+  }
+  r.has_segment = audio_vad_get_segment(&vad, &r.start, &r.end);
+  free(fe);
+  free(pcm);
+  free(raw);
+  return r;
+}
+
+/* 1 s de ruido de fundo, 1.5 s de fala, silencio: o endpoint dispara
+ * 1200 ms depois da ultima janela sonora e o segmento tem 300 ms de margem
+ * de cada lado. */
+static void test_endpoint_after_utterance(void) {
+  const seg_t segs[] = {
+      {SIG_NOISE, 1000, 15},
+      {SIG_VOWEL, 700, 2500},
+      {SIG_NOISE, 100, 15}, /* pausa curta entre palavras */
+      {SIG_VOWEL, 700, 1800},
+      {SIG_NOISE, 3000, 15},
+  };
+  const run_result_t r = run_capture(segs, 5, &k_cfg);
+  CHECK(r.has_segment);
+  CHECK_EQ_INT(r.start, MS(1000 - 300));
+  CHECK_EQ_INT(r.end, MS(2500 + 300));
+  CHECK_EQ_INT(r.endpoint_at, MS(2500 + 1200));
+}
+
+/* Fricativa fraca (RMS ~100, ZCR alto) no fim da fala estende o segmento;
+ * um tom grave do mesmo nivel nao. */
+static void test_fricative_tail(void) {
+  const seg_t fric[] = {
+      {SIG_NOISE, 500, 10},
+      {SIG_VOWEL, 1000, 2000},
+      {SIG_FRICATIVE, 300, 100},
+      {SIG_NOISE, 2000, 10},
+  };
+  run_result_t r = run_capture(fric, 4, &k_cfg);
+  CHECK(r.has_segment);
+  CHECK_EQ_INT(r.end, MS(1800 + 300));
+  CHECK_EQ_INT(r.endpoint_at, MS(1800 + 1200));
+
+  const seg_t hum[] = {
+      {SIG_NOISE, 500, 10},
+      {SIG_VOWEL, 1000, 2000},
+      {SIG_HUM, 300, 100},
+      {SIG_NOISE, 2000, 10},
+  };
+  r = run_capture(hum, 4, &k_cfg);
+  CHECK(r.has_segment);
+  CHECK_EQ_INT(r.end, MS(1500 + 300));
+  CHECK_EQ_INT(r.endpoint_at, MS(1500 + 1200));
+}
+
+/* Um clique (uma janela alta) nao e fala: sem segmento, sem endpoint. */
+static void test_click_is_not_speech(void) {
+  const seg_t segs[] = {
+      {SIG_NOISE, 800, 15},
+      {SIG_VOWEL, 100, 5000},
+      {SIG_NOISE, 2000, 15},
+  };
+  const run_result_t r = run_capture(segs, 3, &k_cfg);
+  CHECK(!r.has_segment);
+  CHECK_EQ_INT(r.endpoint_at, 0);
+}
+
+/* Ruido ambiente mais alto que o piso minimo: o piso acompanha e so a
+ * fala conta. */
+static void test_noisy_background(void) {
+  const seg_t segs[] = {
+      {SIG_NOISE, 1000, 150},
+      {SIG_VOWEL, 1000, 3000},
+      {SIG_NOISE, 2000, 150},
+  };
+  const run_result_t r = run_capture(segs, 3, &k_cfg);
+  CHECK(r.has_segment);
+  CHECK_EQ_INT(r.start, MS(1000 - 300));
+  CHECK_EQ_INT(r.end, MS(2000 + 300));
+  CHECK_EQ_INT(r.endpoint_at, MS(2000 + 1200));
+}
+
+/* silence_ms = 0: so corta, a gravacao segue ate o botao. */
+static void test_silence_zero_only_trims(void) {
+  audio_vad_cfg_t cfg = k_cfg;
+  cfg.silence_ms = 0;
+  const seg_t segs[] = {
+      {SIG_NOISE, 600, 15},
+      {SIG_VOWEL, 800, 2000},
+      {SIG_NOISE, 3000, 15},
+  };
+  const run_result_t r = run_capture(segs, 3, &cfg);
+  CHECK_EQ_INT(r.endpoint_at, 0);
+  CHECK(r.has_segment);
+  CHECK_EQ_INT(r.start, MS(600 - 300));
+  CHECK_EQ_INT(r.end, MS(1400 + 300));
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_thresholds);
+  HOST_TEST_RUN(test_initial_floor_capped);
+  HOST_TEST_RUN(test_endpoint_after_utterance);
+  HOST_TEST_RUN(test_fricative_tail);
+  HOST_TEST_RUN(test_click_is_not_speech);
+  HOST_TEST_RUN(test_noisy_background);
+  HOST_TEST_RUN(test_silence_zero_only_trims);
+  return HOST_TEST_EXIT();
+}
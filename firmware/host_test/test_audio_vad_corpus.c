@@ -0,0 +1,352 @@
+/* VAD do S3 sobre gravacoes: cada WAV (8 kHz, mono, PCM16) listado em
+ * manifest.txt passa pelo mesmo loop de captura de app_do_interaction
+ * (frames I2S -> audio_frontend_decode -> audio_vad_process_stats por
+ * janela de 100 ms, parando no endpoint) e o segmento resultante e
+ * conferido contra a fala marcada a mao no manifesto.
+ *
+ * O corpus fica em fixtures/vad_corpus (HOST_TEST_VAD_CORPUS aponta para
+ * outro diretorio). O repositorio nao traz gravacoes: o motivo e o formato
+ * do manifesto estao em fixtures/vad_corpus/README.md. Os dois primeiros
+ * casos conferem o proprio replay com WAVs gerados aqui, para que o
+ * caminho de leitura e comparacao nao fique sem teste enquanto o corpus
+ * estiver vazio. */
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "audio_codec.h"
+#include "audio_utils.h"
+#include "host_test.h"
+
+#define RATE 8000
+#define WINDOW 800             /* 100 ms, APP_CAPTURE_CHUNK_MS */
+#define TOLERANCE (2 * WINDOW) /* marcacao a mao vs janelas de 100 ms */
+#define MS(x) ((size_t)(x) * RATE / 1000)
+
+/* Mesmos valores do app (APP_VAD_*_MARGIN_MS e o padrao de config). */
+static const audio_vad_cfg_t k_cfg = {
+    .sample_rate_hz = RATE,
+    .silence_ms = 1200,
+    .pre_margin_ms = 300,
+    .post_margin_ms = 300,
+};
+
+/* ---- leitura do WAV ----------------------------------------------------- */
+
+static uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/* Le um WAV PCM16 mono de 8 kHz. Aceita chunks extras (LIST etc.) e o
+ * tamanho indefinido do envio em pipeline (data limitado ao arquivo). */
+static int16_t *wav_load(const char *path, size_t *n_out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  const long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *buf = len > 0 ? malloc((size_t)len) : NULL;
+  const bool read_ok = buf && fread(buf, 1, (size_t)len, f) == (size_t)len;
+  fclose(f);
+  if (!read_ok || len < 12 || memcmp(buf, "RIFF", 4) != 0 ||
+      memcmp(buf + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: nao e um WAV\n", path);
+    free(buf);
+    return NULL;
+  }
+
+  bool fmt_ok = false;
+  int16_t *pcm = NULL;
+  size_t pos = 12;
+  while (pos + 8 <= (size_t)len) {
+    const uint8_t *chunk = buf + pos;
+    size_t size = le32(chunk + 4);
+    if (size > (size_t)len - pos - 8) {
+      size = (size_t)len - pos - 8;
+    }
+    if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+      fmt_ok = le16(chunk + 8) == 1 && le16(chunk + 10) == 1 &&
+               le32(chunk + 12) == RATE && le16(chunk + 22) == 16;
+    } else if (memcmp(chunk, "data", 4) == 0 && fmt_ok) {
+      *n_out = size / 2;
+      pcm = malloc(*n_out * sizeof(int16_t) + 1);
+      for (size_t i = 0; i < *n_out; i++) {
+        pcm[i] = (int16_t)le16(chunk + 8 + 2 * i);
+      }
+      break;
+    }
+    pos += 8 + size + (size & 1);
+  }
+  if (!pcm) {
+    fprintf(stderr, "%s: precisa ser PCM16 mono de %d Hz\n", path, RATE);
+  }
+  free(buf);
+  return pcm;
+}
+
+/* ---- replay ------------------------------------------------------------- */
+
+typedef struct {
+  size_t endpoint_at; /* amostras quando o endpoint disparou (0 = nunca) */
+  bool has_segment;
+  size_t start;
+  size_t end;
+} replay_result_t;
+
+/* Loop de captura do app sobre o PCM da gravacao, reconstruindo os frames
+ * I2S de 32 bits (amostra << 15 no canal esquerdo, direito mudo). */
+static replay_result_t replay(const int16_t *pcm, size_t n) {
+  int32_t *raw = malloc(WINDOW * 2 * sizeof(int32_t));
+  int16_t *out = malloc(WINDOW * sizeof(int16_t));
+  audio_frontend_t *fe = malloc(sizeof(*fe));
+  audio_frontend_init(fe, 100.0f, (float)RATE);
+  audio_vad_t vad;
+  audio_vad_init(&vad, &k_cfg);
+
+  replay_result_t r = {0};
+  for (size_t pos = 0; pos + WINDOW <= n; pos += WINDOW) {
+    for (size_t i = 0; i < WINDOW; i++) {
+      raw[2 * i] = (int32_t)pcm[pos + i] * (1 << 15);
+      raw[2 * i + 1] = 0;
+    }
+    audio_frontend_window_reset(fe);
+    audio_frontend_decode(raw, WINDOW, out, fe);
+    audio_vad_process_stats(&vad, &fe->window, WINDOW);
+    if (audio_vad_endpoint(&vad)) {
+      r.endpoint_at = pos + WINDOW;
+      break;
+    }
+  }
+  r.has_segment = audio_vad_get_segment(&vad, &r.start, &r.end);
+  free(fe);
+  free(out);
+  free(raw);
+  return r;
+}
+
+static bool near(size_t got, size_t want) {
+  return (got > want ? got - want : want - got) <= TOLERANCE;
+}
+
+/* Confere uma gravacao contra a fala marcada [ini_ms, fim_ms] (ini_ms < 0:
+ * so ruido). Retorna o numero de divergencias, ja impressas. */
+static int check_recording(const char *name, const int16_t *pcm, size_t n,
+                           long ini_ms, long fim_ms) {
+  const replay_result_t r = replay(pcm, n);
+  int bad = 0;
+  if (ini_ms < 0) {
+    if (r.has_segment || r.endpoint_at) {
+      fprintf(stderr, "%s: so ruido, mas VAD deu fala %zu..%zu ms\n", name,
+              r.start / MS(1), r.end / MS(1));
+      bad++;
+    }
+    return bad;
+  }
+
+  const size_t ini = MS(ini_ms);
+  const size_t fim = MS(fim_ms);
+  const size_t pre = MS(k_cfg.pre_margin_ms);
+  const size_t want_start = ini > pre ? ini - pre : 0;
+  const size_t want_end = fim + MS(k_cfg.post_margin_ms);
+  const size_t want_ep = fim + MS(k_cfg.silence_ms);
+  if (!r.has_segment) {
+    fprintf(stderr, "%s: fala em %ld..%ld ms nao detectada\n", name, ini_ms,
+            fim_ms);
+    return 1;
+  }
+  if (!near(r.start, want_start) || !near(r.end, want_end)) {
+    fprintf(stderr, "%s: segmento %zu..%zu ms, esperado %zu..%zu ms\n", name,
+            r.start / MS(1), r.end / MS(1), want_start / MS(1),
+            want_end / MS(1));
+    bad++;
+  }
+  /* endpoint: so e cobrado se a gravacao tem silencio suficiente depois */
+  if (want_ep + TOLERANCE <= n && !near(r.endpoint_at, want_ep)) {
+    fprintf(stderr, "%s: endpoint em %zu ms, esperado %zu ms\n", name,
+            r.endpoint_at / MS(1), want_ep / MS(1));
+    bad++;
+  } else if (want_ep > n && r.endpoint_at) {
+    fprintf(stderr, "%s: endpoint em %zu ms antes do fim do silencio\n", name,
+            r.endpoint_at / MS(1));
+    bad++;
+  }
+  return bad;
+}
+
+/* Le dir/manifest.txt ("arquivo ini_ms fim_ms", "- -" para so ruido, '#'
+ * comenta) e confere cada gravacao. Retorna as divergencias; *files recebe
+ * quantas gravacoes foram conferidas (-1 sem manifesto). */
+static int replay_corpus(const char *dir, int *files) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/manifest.txt", dir);
+  FILE *f = fopen(path, "r");
+  *files = -1;
+  if (!f) {
+    return 0;
+  }
+  *files = 0;
+  int bad = 0;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char name[128];
+    char ini[16];
+    char fim[16];
+    if (line[0] == '#' || sscanf(line, "%127s %15s %15s", name, ini, fim) != 3) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    size_t n = 0;
+    int16_t *pcm = wav_load(path, &n);
+    if (!pcm) {
+      bad++;
+      continue;
+    }
+    const bool noise = strcmp(ini, "-") == 0;
+    bad += check_recording(name, pcm, n, noise ? -1 : atol(ini),
+                           noise ? -1 : atol(fim));
+    (*files)++;
+    free(pcm);
+  }
+  fclose(f);
+  return bad;
+}
+
+/* ---- conferencia do proprio replay -------------------------------------- */
+
+/* Ruido de fundo com uma "frase" sonora (180 Hz e harmonicos) em
+ * [ini_ms, fim_ms); ini_ms < 0 gera so ruido. */
+static void write_wav(const char *path, int total_ms, int ini_ms, int fim_ms) {
+  const size_t n = MS(total_ms);
+  uint8_t *buf = malloc(AUDIO_WAV_HEADER_LEN + 2 * n);
+  audio_wav_pcm16_header(buf, (uint32_t)(2 * n), RATE, 1);
+  uint32_t seed = 99;
+  for (size_t k = 0; k < n; k++) {
+    const double t = (double)k / RATE;
+    const double u = (double)(host_test_rand(&seed) & 0xFFFF) / 65535.0;
+    double v = (2 * u - 1) * 15 * sqrt(3.0);
+    if (ini_ms >= 0 && k >= MS(ini_ms) && k < MS(fim_ms)) {
+      v += 2500 * (sin(2 * M_PI * 180 * t) + 0.5 * sin(2 * M_PI * 360 * t)) /
+           0.81;
+    }
+    const int16_t s = (int16_t)lrint(v);
+    buf[AUDIO_WAV_HEADER_LEN + 2 * k] = (uint8_t)s;
+    buf[AUDIO_WAV_HEADER_LEN + 2 * k + 1] = (uint8_t)((uint16_t)s >> 8);
+  }
+  FILE *f = fopen(path, "wb");
+  CHECK(f != NULL);
+  if (f) {
+    CHECK_EQ_INT(fwrite(buf, 1, AUDIO_WAV_HEADER_LEN + 2 * n, f),
+                 AUDIO_WAV_HEADER_LEN + 2 * n);
+    fclose(f);
+  }
+  free(buf);
+}
+
+static void write_text(const char *path, const char *text) {
+  FILE *f = fopen(path, "w");
+  CHECK(f != NULL);
+  if (f) {
+    fputs(text, f);
+    fclose(f);
+  }
+}
+
+static void remove_dir(const char *dir) {
+  DIR *d = opendir(dir);
+  if (!d) {
+    return;
+  }
+  struct dirent *e;
+  char path[512];
+  while ((e = readdir(d)) != NULL) {
+    if (e->d_name[0] != '.') {
+      snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+      unlink(path);
+    }
+  }
+  closedir(d);
+  rmdir(dir);
+}
+
+/* Corpus temporario com marcacoes certas: tudo confere. */
+static void test_replay_matches_labels(void) {
+  char dir[] = "/tmp/vad_corpus_XXXXXX";
+  CHECK(mkdtemp(dir) != NULL);
+  char path[512];
+  snprintf(path, sizeof(path), "%s/fala.wav", dir);
+  write_wav(path, 5000, 1000, 2000);
+  snprintf(path, sizeof(path), "%s/ruido.wav", dir);
+  write_wav(path, 3000, -1, -1);
+  snprintf(path, sizeof(path), "%s/curta.wav", dir); /* acaba antes do endpoint */
+  write_wav(path, 2500, 500, 1800);
+  snprintf(path, sizeof(path), "%s/manifest.txt", dir);
+  write_text(path, "# arquivo ini_ms fim_ms\n"
+                   "fala.wav   1000 2000\n"
+                   "ruido.wav  -    -\n"
+                   "curta.wav  500  1800\n");
+  int files = 0;
+  CHECK_EQ_INT(replay_corpus(dir, &files), 0);
+  CHECK_EQ_INT(files, 3);
+  remove_dir(dir);
+}
+
+/* Marcacoes erradas, arquivo ausente e formato errado sao contados. */
+static void test_replay_reports_mismatches(void) {
+  char dir[] = "/tmp/vad_corpus_XXXXXX";
+  CHECK(mkdtemp(dir) != NULL);
+  char path[512];
+  snprintf(path, sizeof(path), "%s/fala.wav", dir);
+  write_wav(path, 5000, 1000, 2000);
+  snprintf(path, sizeof(path), "%s/estereo.wav", dir);
+  write_wav(path, 1000, -1, -1);
+  FILE *f = fopen(path, "r+b");
+  CHECK(f != NULL);
+  if (f) {
+    fseek(f, 22, SEEK_SET); /* numChannels = 2 */
+    fputc(2, f);
+    fclose(f);
+  }
+  snprintf(path, sizeof(path), "%s/manifest.txt", dir);
+  write_text(path, "fala.wav     1500 2000\n" /* inicio 500 ms depois */
+                   "fala.wav     -    -\n"    /* fala onde so havia ruido */
+                   "sumiu.wav    -    -\n"
+                   "estereo.wav  -    -\n");
+  int files = 0;
+  CHECK_EQ_INT(replay_corpus(dir, &files), 4);
+  CHECK_EQ_INT(files, 2);
+  remove_dir(dir);
+}
+
+/* O corpus de verdade. */
+static void test_corpus(void) {
+  const char *dir = getenv("HOST_TEST_VAD_CORPUS");
+  if (!dir || !dir[0]) {
+    dir = HOST_TEST_VAD_CORPUS_DIR;
+  }
+  int files = 0;
+  CHECK_EQ_INT(replay_corpus(dir, &files), 0);
+  CHECK(files >= 0);
+  if (files <= 0) {
+    printf("%s: nenhuma gravacao (ver fixtures/vad_corpus/README.md)\n", dir);
+  } else {
+    printf("%s: %d gravacao(oes) conferidas\n", dir, files);
+  }
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_replay_matches_labels);
+  HOST_TEST_RUN(test_replay_reports_mismatches);
+  HOST_TEST_RUN(test_corpus);
+  return HOST_TEST_EXIT();
+}
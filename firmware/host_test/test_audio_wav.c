@@ -0,0 +1,104 @@
+/* audio_wav_pcm16_header: layout byte a byte (little-endian em qualquer
+ * host), campos derivados de taxa/canais e o tamanho indefinido
+ * (UINT32_MAX) do envio em pipeline, que satura o RIFF em vez de dar a
+ * volta. */
+#include <string.h>
+
+#include "audio_codec.h"
+#include "host_test.h"
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+#define GUARD 8
+
+static uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/* Escreve com bytes de guarda em volta: nada fora dos 44 bytes. */
+static void write_header(uint8_t *buf, uint32_t pcm_bytes, uint32_t rate,
+                         uint16_t channels) {
+  memset(buf, 0xA5, AUDIO_WAV_HEADER_LEN + 2 * GUARD);
+  audio_wav_pcm16_header(buf + GUARD, pcm_bytes, rate, channels);
+  for (size_t i = 0; i < GUARD; i++) {
+    CHECK(buf[i] == 0xA5);
+    CHECK(buf[GUARD + AUDIO_WAV_HEADER_LEN + i] == 0xA5);
+  }
+}
+
+/* 1 s de 8 kHz mono, como gravado pelo S3. */
+static void test_golden(void) {
+  static const uint8_t want[AUDIO_WAV_HEADER_LEN] = {
+      'R',  'I',  'F',  'F',  0xA4, 0x3E, 0x00, 0x00, 'W',  'A',  'V',
+      'E',  'f',  'm',  't',  ' ',  0x10, 0x00, 0x00, 0x00, 0x01, 0x00,
+      0x01, 0x00, 0x40, 0x1F, 0x00, 0x00, 0x80, 0x3E, 0x00, 0x00, 0x02,
+      0x00, 0x10, 0x00, 'd',  'a',  't',  'a',  0x80, 0x3E, 0x00, 0x00};
+  uint8_t buf[AUDIO_WAV_HEADER_LEN + 2 * GUARD];
+  write_header(buf, 16000, 8000, 1);
+  CHECK_MEM_EQ(buf + GUARD, AUDIO_WAV_HEADER_LEN, want, sizeof(want));
+}
+
+static void test_fields(void) {
+  static const uint32_t sizes[] = {0, 1, 2, 16000, 320000, 0x7FFFFFFFu};
+  static const uint32_t rates[] = {8000, 11025, 16000, 44100, 48000};
+  static const uint16_t channels[] = {1, 2};
+  uint8_t buf[AUDIO_WAV_HEADER_LEN + 2 * GUARD];
+  for (size_t s = 0; s < COUNT(sizes); s++) {
+    for (size_t r = 0; r < COUNT(rates); r++) {
+      for (size_t c = 0; c < COUNT(channels); c++) {
+        write_header(buf, sizes[s], rates[r], channels[c]);
+        const uint8_t *h = buf + GUARD;
+        CHECK(memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WAVE", 4) == 0);
+        CHECK(memcmp(h + 12, "fmt ", 4) == 0 && memcmp(h + 36, "data", 4) == 0);
+        CHECK_EQ_INT(le32(h + 4), 36 + sizes[s]);
+        CHECK_EQ_INT(le32(h + 16), 16);
+        CHECK_EQ_INT(le16(h + 20), 1);
+        CHECK_EQ_INT(le16(h + 22), channels[c]);
+        CHECK_EQ_INT(le32(h + 24), rates[r]);
+        CHECK_EQ_INT(le32(h + 28), rates[r] * 2 * channels[c]);
+        CHECK_EQ_INT(le16(h + 32), 2 * channels[c]);
+        CHECK_EQ_INT(le16(h + 34), 16);
+        CHECK_EQ_INT(le32(h + 40), sizes[s]);
+      }
+    }
+  }
+}
+
+/* Tamanho indefinido e a borda do RIFF: 36 + pcm_bytes so cabe ate
+ * UINT32_MAX - 36; acima disso satura em UINT32_MAX. */
+static void test_size_saturation(void) {
+  static const struct {
+    uint32_t pcm_bytes;
+    uint32_t riff;
+  } cases[] = {
+      {UINT32_MAX - 37, UINT32_MAX - 1},
+      {UINT32_MAX - 36, UINT32_MAX},
+      {UINT32_MAX - 35, UINT32_MAX},
+      {UINT32_MAX - 1, UINT32_MAX},
+      {UINT32_MAX, UINT32_MAX},
+  };
+  uint8_t buf[AUDIO_WAV_HEADER_LEN + 2 * GUARD];
+  for (size_t i = 0; i < COUNT(cases); i++) {
+    write_header(buf, cases[i].pcm_bytes, 8000, 1);
+    CHECK_EQ_INT(le32(buf + GUARD + 4), cases[i].riff);
+    CHECK_EQ_INT(le32(buf + GUARD + 40), cases[i].pcm_bytes);
+  }
+
+  /* o cabecalho do pipeline (app.c) */
+  write_header(buf, UINT32_MAX, 8000, 1);
+  static const uint8_t ff[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+  CHECK_MEM_EQ(buf + GUARD + 4, 4, ff, 4);
+  CHECK_MEM_EQ(buf + GUARD + 40, 4, ff, 4);
+  CHECK_EQ_INT(le32(buf + GUARD + 24), 8000);
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_golden);
+  HOST_TEST_RUN(test_fields);
+  HOST_TEST_RUN(test_size_saturation);
+  return HOST_TEST_EXIT();
+}
@@ -0,0 +1,323 @@
+/* Sessao de camera do P4 (bsp_camera.c) contra o fake_v4l2: abertura do
+ * dispositivo e queda de formato (RGB565, depois RGB24), REQBUFS com menos
+ * buffers que o pedido, limpeza depois de falha no QUERYBUF ou no mmap,
+ * descarte dos quadros de aquecimento do ISP, entrega do quadro mais novo
+ * com os antigos devolvidos a fila, DQBUF sem quadro (timeout, sessao
+ * mantida) contra erro do driver (sessao fechada e reaberta), release e
+ * stop. */
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "fake_v4l2.h"
+
+/* As chamadas de sistema do fonte vao para o dispositivo falso. Os
+ * cabecalhos do sistema ja foram incluidos acima, entao so o codigo de
+ * bsp_camera.c e afetado. */
+#define open fake_v4l2_open
+#define close fake_v4l2_close
+#define ioctl fake_v4l2_ioctl
+#define mmap fake_v4l2_mmap
+#define munmap fake_v4l2_munmap
+#include "bsp_camera.c"
+#undef open
+#undef close
+#undef ioctl
+#undef mmap
+#undef munmap
+
+#include "host_test.h"
+
+static int s_ready_calls;
+
+/* bsp.c: init do esp_video */
+esp_err_t bsp_camera_ensure_ready(void) {
+  s_ready_calls++;
+  return ESP_OK;
+}
+
+/* Fecha a sessao do caso anterior e troca o dispositivo. */
+static void setup(const fake_v4l2_cfg_t *cfg) {
+  bsp_camera_session_stop();
+  fake_v4l2_reset(cfg);
+}
+
+/* Nada aberto, mapeado ou meio inicializado. */
+static void check_torn_down(void) {
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  CHECK(!bsp_camera_session_is_active());
+  CHECK_EQ_INT(s_cam.fd, -1);
+  CHECK_EQ_INT(s_cam.buf_count, 0);
+  for (int i = 0; i < BSP_CAMERA_MMAP_BUFFERS; i++) {
+    CHECK(s_cam.ptrs[i] == NULL);
+  }
+  CHECK_EQ_INT(st->open_fds, 0);
+  CHECK_EQ_INT(st->live_maps, 0);
+  CHECK_EQ_INT(st->munmaps, st->mmaps);
+}
+
+static void test_open_prefers_rgb565(void) {
+  /* video0 ausente, video1 sem captura: fica o video2 */
+  fake_v4l2_cfg_t cfg = fake_v4l2_defaults();
+  cfg.present[0] = false;
+  cfg.present[1] = true;
+  cfg.present[2] = true;
+  cfg.capture[2] = true;
+  setup(&cfg);
+  const int ready_before = s_ready_calls;
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  CHECK(bsp_camera_session_is_active());
+  CHECK(s_ready_calls > ready_before);
+  CHECK_STR_EQ(st->last_dev, "/dev/video2");
+  CHECK_EQ_INT(st->opens, 2);
+  CHECK_EQ_INT(st->closes, 1);
+  CHECK_EQ_INT(st->nonblock_opens, st->opens);
+  CHECK_EQ_INT(s_cam.pixel_format, V4L2_PIX_FMT_RGB565);
+  CHECK_EQ_INT(s_cam.width, 1920); /* resolucao corrente mantida */
+  CHECK_EQ_INT(s_cam.height, 1080);
+  CHECK_EQ_INT(s_cam.bytesperline, 1920 * 2);
+  CHECK_EQ_INT(s_cam.buf_count, BSP_CAMERA_MMAP_BUFFERS);
+  CHECK_EQ_INT(st->mmaps, BSP_CAMERA_MMAP_BUFFERS);
+  CHECK_EQ_INT(st->streamon, 1);
+
+  /* start de novo com a sessao no ar: nada muda */
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  CHECK_EQ_INT(st->opens, 2);
+
+  /* nenhum no de captura */
+  cfg.capture[2] = false;
+  setup(&cfg);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_FAIL);
+  check_torn_down();
+}
+
+static void test_format_falls_back_to_rgb24(void) {
+  /* sem RGB565, G_FMT falha e o driver so aceita 1280x720, sem informar
+   * bytesperline */
+  fake_v4l2_cfg_t cfg = fake_v4l2_defaults();
+  cfg.rgb565 = false;
+  cfg.cur_w = 0;
+  cfg.only_w = 1280;
+  cfg.only_h = 720;
+  cfg.zero_bytesperline = true;
+  setup(&cfg);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  CHECK_EQ_INT(s_cam.pixel_format, V4L2_PIX_FMT_RGB24);
+  CHECK_EQ_INT(s_cam.width, 1280);
+  CHECK_EQ_INT(s_cam.height, 720);
+  CHECK_EQ_INT(s_cam.bytesperline, 1280 * 3);
+
+  bsp_camera_frame_t frame;
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+  CHECK_EQ_INT(frame.pixel_format, V4L2_PIX_FMT_RGB24);
+  CHECK_EQ_INT(frame.bytesperline, 1280 * 3);
+  bsp_camera_frame_release(&frame);
+
+  /* nenhum dos dois formatos */
+  cfg.rgb24 = false;
+  setup(&cfg);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_FAIL);
+  CHECK_EQ_INT(fake_v4l2_stats()->mmaps, 0);
+  check_torn_down();
+}
+
+static void test_reqbufs_grants_fewer(void) {
+  fake_v4l2_cfg_t cfg = fake_v4l2_defaults();
+  cfg.grant = 2;
+  setup(&cfg);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  CHECK_EQ_INT(s_cam.buf_count, 2);
+  CHECK_EQ_INT(st->mmaps, 2);
+  CHECK(s_cam.ptrs[2] == NULL);
+  CHECK_EQ_INT(st->queued, 2);
+  for (int i = 0; i < 4; i++) {
+    bsp_camera_frame_t frame;
+    CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+    CHECK(frame.index < 2);
+    CHECK(frame.data == s_cam.ptrs[frame.index]);
+    bsp_camera_frame_release(&frame);
+  }
+
+  /* nenhum buffer */
+  cfg.grant = 0;
+  setup(&cfg);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_FAIL);
+  check_torn_down();
+}
+
+static void test_cleanup_after_querybuf_or_mmap_failure(void) {
+  for (int i = 0; i < BSP_CAMERA_MMAP_BUFFERS; i++) {
+    for (int mmap_fails = 0; mmap_fails <= 1; mmap_fails++) {
+      fake_v4l2_cfg_t cfg = fake_v4l2_defaults();
+      if (mmap_fails) {
+        cfg.fail_mmap = i;
+      } else {
+        cfg.fail_querybuf = i;
+      }
+      setup(&cfg);
+      CHECK_EQ_INT(bsp_camera_session_start(), ESP_FAIL);
+      const fake_v4l2_stats_t *st = fake_v4l2_stats();
+      CHECK_EQ_INT(st->mmaps, i); /* os anteriores foram mapeados... */
+      check_torn_down();          /* ...e desfeitos */
+      CHECK_EQ_INT(st->reqbufs_free, 1);
+      CHECK_EQ_INT(st->streamon, 0);
+    }
+  }
+
+  /* com o dispositivo bom, a proxima sessao abre do zero */
+  setup(NULL);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  CHECK_EQ_INT(s_cam.buf_count, BSP_CAMERA_MMAP_BUFFERS);
+}
+
+static void test_warmup_skips_frames(void) {
+  setup(NULL);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  CHECK_EQ_INT(st->dqbufs, BSP_CAMERA_PREVIEW_SKIP_FRAMES);
+  CHECK_EQ_INT(st->qbufs,
+               BSP_CAMERA_MMAP_BUFFERS + BSP_CAMERA_PREVIEW_SKIP_FRAMES);
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS);
+
+  bsp_camera_frame_t frame;
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+  CHECK_EQ_INT(fake_v4l2_frame_id(frame.data),
+               BSP_CAMERA_PREVIEW_SKIP_FRAMES + 1);
+  CHECK_EQ_INT(frame.sequence, 1);
+  bsp_camera_frame_release(&frame);
+
+  /* so uma vez por sessao */
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+  CHECK_EQ_INT(fake_v4l2_frame_id(frame.data),
+               BSP_CAMERA_PREVIEW_SKIP_FRAMES + 2);
+  bsp_camera_frame_release(&frame);
+
+  /* falha do driver no aquecimento: sessao desfeita */
+  setup(NULL);
+  fake_v4l2_fail_next_dqbuf(EIO);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_FAIL);
+  CHECK_EQ_INT(st->streamoff, 1);
+  check_torn_down();
+}
+
+static void test_newest_frame_selected(void) {
+  setup(NULL);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  fake_v4l2_set_auto(false);
+  const uint32_t first = st->frames + 1;
+
+  /* o anel inteiro completou enquanto ninguem lia */
+  CHECK_EQ_INT(fake_v4l2_produce(BSP_CAMERA_MMAP_BUFFERS),
+               BSP_CAMERA_MMAP_BUFFERS);
+  bsp_camera_frame_t frame;
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+  CHECK_EQ_INT(fake_v4l2_frame_id(frame.data),
+               first + BSP_CAMERA_MMAP_BUFFERS - 1);
+  CHECK_EQ_INT(s_cam.dropped, BSP_CAMERA_MMAP_BUFFERS - 1);
+  CHECK_EQ_INT(st->done, 0);
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS - 1); /* antigos de volta */
+  bsp_camera_frame_release(&frame);
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS);
+
+  /* dois prontos: o segundo */
+  CHECK_EQ_INT(fake_v4l2_produce(2), 2);
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+  CHECK_EQ_INT(fake_v4l2_frame_id(frame.data),
+               first + BSP_CAMERA_MMAP_BUFFERS + 1);
+  CHECK_EQ_INT(s_cam.dropped, BSP_CAMERA_MMAP_BUFFERS);
+  bsp_camera_frame_release(&frame);
+
+  /* um so: nada descartado */
+  CHECK_EQ_INT(fake_v4l2_produce(1), 1);
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 50), ESP_OK);
+  CHECK_EQ_INT(s_cam.dropped, BSP_CAMERA_MMAP_BUFFERS);
+  CHECK_EQ_INT(frame.sequence, 3);
+  bsp_camera_frame_release(&frame);
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS);
+}
+
+static void test_dqbuf_timeout_vs_error(void) {
+  setup(NULL);
+  CHECK_EQ_INT(bsp_camera_session_start(), ESP_OK);
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  fake_v4l2_set_auto(false);
+
+  /* sem quadro: timeout, sessao e lock intactos */
+  bsp_camera_frame_t frame;
+  const double t0 = host_test_now_ms();
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 30), ESP_ERR_TIMEOUT);
+  CHECK(host_test_now_ms() - t0 >= 30);
+  CHECK(frame.data == NULL);
+  CHECK(bsp_camera_session_is_active());
+  CHECK_EQ_INT(st->opens, 1);
+  CHECK_EQ_INT(st->closes, 0);
+  CHECK_EQ_INT(fake_v4l2_produce(1), 1);
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 30), ESP_OK);
+  bsp_camera_frame_release(&frame);
+
+  /* erro do driver: sessao desfeita... */
+  fake_v4l2_fail_next_dqbuf(EIO);
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 30), ESP_FAIL);
+  CHECK(frame.data == NULL);
+  CHECK_EQ_INT(st->streamoff, 1);
+  CHECK_EQ_INT(st->reqbufs_free, 1);
+  check_torn_down();
+
+  /* ...e reaberta na proxima chamada */
+  fake_v4l2_set_auto(true);
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 30), ESP_OK);
+  CHECK_EQ_INT(st->opens, 2);
+  CHECK_EQ_INT(frame.sequence, 1);
+  CHECK(frame.data == s_cam.ptrs[frame.index]);
+  bsp_camera_frame_release(&frame);
+}
+
+static void test_release_and_stop(void) {
+  setup(NULL);
+  const fake_v4l2_stats_t *st = fake_v4l2_stats();
+  bsp_camera_frame_t frame;
+  CHECK_EQ_INT(bsp_camera_frame_acquire(NULL, 30), ESP_ERR_INVALID_ARG);
+  /* acquire abre a sessao sob demanda */
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 30), ESP_OK);
+  CHECK(bsp_camera_session_is_active());
+  CHECK_EQ_INT(frame.width, 1920);
+  CHECK_EQ_INT(frame.height, 1080);
+  CHECK(frame.timestamp_us > 0);
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS - 1); /* o entregue */
+  bsp_camera_frame_release(&frame);
+  CHECK(frame.data == NULL);
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS);
+  bsp_camera_frame_release(&frame); /* de novo: nada */
+  CHECK_EQ_INT(st->queued, BSP_CAMERA_MMAP_BUFFERS);
+
+  /* lock devolvido: stop nao trava */
+  bsp_camera_session_stop();
+  CHECK_EQ_INT(st->streamoff, 1);
+  CHECK_EQ_INT(st->reqbufs_free, 1);
+  CHECK_EQ_INT(st->closes, 1);
+  check_torn_down();
+  bsp_camera_session_stop();
+  CHECK_EQ_INT(st->closes, 1);
+
+  CHECK_EQ_INT(bsp_camera_frame_acquire(&frame, 30), ESP_OK);
+  CHECK_EQ_INT(st->opens, 2);
+  bsp_camera_frame_release(&frame);
+}
+
+int main(void) {
+  CHECK_EQ_INT(bsp_camera_session_init(), ESP_OK);
+  HOST_TEST_RUN(test_open_prefers_rgb565);
+  HOST_TEST_RUN(test_format_falls_back_to_rgb24);
+  HOST_TEST_RUN(test_reqbufs_grants_fewer);
+  HOST_TEST_RUN(test_cleanup_after_querybuf_or_mmap_failure);
+  HOST_TEST_RUN(test_warmup_skips_frames);
+  HOST_TEST_RUN(test_newest_frame_selected);
+  HOST_TEST_RUN(test_dqbuf_timeout_vs_error);
+  HOST_TEST_RUN(test_release_and_stop);
+  setup(NULL);
+  return HOST_TEST_EXIT();
+}
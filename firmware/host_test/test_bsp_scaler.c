@@ -0,0 +1,154 @@
+/* bsp_scaler (preview do P4): o vizinho mais proximo identico byte a byte ao
+ * laco antigo de bsp.c (com e sem a troca de bytes que o gui.c fazia), o
+ * filtro 2x2 contra a media canal a canal, e o cache de tabelas de
+ * bsp_scaler_configure() comparando a configuracao campo a campo. */
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_scaler.h"
+#include "host_test.h"
+#include "scaler_ref.h"
+
+#define SIZE 240
+
+static const struct {
+  uint32_t w;
+  uint32_t h;
+} k_res[] = {
+    {640, 480}, {1280, 720}, {1920, 1080}, {480, 640}, {240, 240}, {241, 255},
+};
+
+typedef void (*ref_fn_t)(const uint8_t *src, uint32_t w, uint32_t h,
+                         uint32_t stride, uint32_t bpp, uint8_t *dst,
+                         uint32_t size);
+
+static void check_against(ref_fn_t ref_fn, bsp_scale_mode_t mode) {
+  uint8_t *want = malloc(SIZE * SIZE * 2);
+  uint32_t *got = malloc(SIZE * SIZE * 2);
+  for (size_t r = 0; r < sizeof(k_res) / sizeof(k_res[0]); r++) {
+    for (uint32_t bpp = 2; bpp <= 3; bpp++) {
+      const uint32_t w = k_res[r].w;
+      const uint32_t h = k_res[r].h;
+      const uint32_t stride = w * bpp + (r % 2 ? 64 : 0);
+      uint8_t *frame = malloc((size_t)stride * h);
+      scaler_ref_fill_frame(frame, w, h, stride, bpp, (uint32_t)(r + 1));
+      ref_fn(frame, w, h, stride, bpp, want, SIZE);
+
+      for (int swap = 0; swap <= 1; swap++) {
+        bsp_scaler_t scaler = {0};
+        const bsp_scaler_cfg_t cfg = {
+            .src_w = w,
+            .src_h = h,
+            .src_stride = stride,
+            .src_bpp = bpp,
+            .dst_w = SIZE,
+            .dst_h = SIZE,
+            .mode = mode,
+            .swap_bytes = swap,
+        };
+        CHECK_EQ_INT(bsp_scaler_configure(&scaler, &cfg), ESP_OK);
+        bsp_scaler_run(&scaler, frame, (uint8_t *)got);
+        if (swap) {
+          scaler_ref_swap((uint16_t *)want, SIZE * SIZE);
+        }
+        CHECK_MEM_EQ(got, SIZE * SIZE * 2, want, SIZE * SIZE * 2);
+        if (swap) {
+          scaler_ref_swap((uint16_t *)want, SIZE * SIZE);
+        }
+        bsp_scaler_deinit(&scaler);
+      }
+      free(frame);
+    }
+  }
+  free(got);
+  free(want);
+}
+
+static void test_nearest_matches_old_loop(void) {
+  check_against(scaler_ref_old_loop, BSP_SCALE_NEAREST);
+}
+
+static void test_box_matches_reference(void) {
+  check_against(scaler_ref_box, BSP_SCALE_BOX2X2);
+}
+
+/* Mesma configuracao com bytes de padding diferentes: tabelas mantidas.
+ * A marca no fim de y1 so sobrevive se nada foi reconstruido. */
+static void test_configure_reuses_tables(void) {
+  bsp_scaler_cfg_t *a = malloc(sizeof(*a));
+  bsp_scaler_cfg_t *b = malloc(sizeof(*b));
+  memset(a, 0xA5, sizeof(*a));
+  memset(b, 0x00, sizeof(*b));
+  for (int i = 0; i < 2; i++) {
+    bsp_scaler_cfg_t *c = i ? b : a;
+    c->src_w = 640;
+    c->src_h = 480;
+    c->src_stride = 1280;
+    c->src_bpp = 2;
+    c->dst_w = SIZE;
+    c->dst_h = SIZE;
+    c->mode = BSP_SCALE_NEAREST;
+    c->swap_bytes = true;
+  }
+
+  bsp_scaler_t scaler = {0};
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, a), ESP_OK);
+  const uint32_t mark = 0xDEADBEEFu;
+  scaler.y1[SIZE - 1] = mark;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, b), ESP_OK);
+  CHECK_EQ_INT(scaler.y1[SIZE - 1], mark);
+
+  /* qualquer campo diferente reconstroi */
+  b->swap_bytes = false;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, b), ESP_OK);
+  CHECK(!scaler.cfg.swap_bytes);
+  CHECK(scaler.y1[SIZE - 1] != mark);
+  scaler.y1[SIZE - 1] = mark;
+  b->src_stride = 1344;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, b), ESP_OK);
+  CHECK_EQ_INT(scaler.cfg.src_stride, 1344);
+  CHECK(scaler.y1[SIZE - 1] != mark);
+
+  bsp_scaler_deinit(&scaler);
+  CHECK(scaler.x0 == NULL);
+  free(b);
+  free(a);
+}
+
+static void test_configure_rejects(void) {
+  const bsp_scaler_cfg_t ok = {
+      .src_w = 640,
+      .src_h = 480,
+      .src_stride = 1280,
+      .src_bpp = 2,
+      .dst_w = SIZE,
+      .dst_h = SIZE,
+  };
+  bsp_scaler_t scaler = {0};
+  bsp_scaler_cfg_t c = ok;
+  c.dst_w = 239;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, &c), ESP_ERR_INVALID_ARG);
+  c = ok;
+  c.dst_h = 0;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, &c), ESP_ERR_INVALID_ARG);
+  c = ok;
+  c.src_h = 200;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, &c), ESP_ERR_INVALID_ARG);
+  c = ok;
+  c.src_bpp = 4;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, &c), ESP_ERR_INVALID_ARG);
+  c = ok;
+  c.src_stride = 1279;
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, &c), ESP_ERR_INVALID_ARG);
+  CHECK(scaler.x0 == NULL);
+  CHECK_EQ_INT(bsp_scaler_configure(NULL, &ok), ESP_ERR_INVALID_ARG);
+  CHECK_EQ_INT(bsp_scaler_configure(&scaler, NULL), ESP_ERR_INVALID_ARG);
+}
+
+int main(void) {
+  HOST_TEST_RUN(test_nearest_matches_old_loop);
+  HOST_TEST_RUN(test_box_matches_reference);
+  HOST_TEST_RUN(test_configure_reuses_tables);
+  HOST_TEST_RUN(test_configure_rejects);
+  return HOST_TEST_EXIT();
+}